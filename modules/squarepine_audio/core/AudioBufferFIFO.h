@@ -1,17 +1,28 @@
-/** The AudioBufferFIFO implements an actual sample buffer using AbstractFIFO.
+/** The AudioBufferFIFO implements a wait-free, single-producer and single-consumer sample buffer.
 
     You can add samples from the various kind of formats,
     like float pointers or AudioBuffers.
 
-    @see juce::AudioBuffer, juce::AudioSourceChannelInfo, juce::AudioSource
+    Besides copying samples in and out, the producer and the consumer can work on
+    the FIFO's buffer directly: acquireWrite() and acquireRead() hand out a Span
+    over the region of the buffer that is free or ready, which is then handed back
+    with commitWrite() and commitRead() once it was filled or used up.
+
+    The read and write positions live on separate cache lines, and each side keeps
+    its own copy of the other side's position so as to rarely touch the other side's
+    cache line.
+
+    @warning Only one thread may ever write to the FIFO, and only one thread may ever read from it.
+             setSize() and clear() must not be called while either of them is using the FIFO.
+
+    @see juce::AudioBuffer, juce::AudioSourceChannelInfo, juce::AudioSource, AudioBufferView
 */
 template<typename FloatType>
-class AudioBufferFIFO final : public AbstractFifo
+class AudioBufferFIFO final
 {
 public:
     /** Creates a FIFO with a buffer of given number of channels and samples. */
-    AudioBufferFIFO (int channels = 2, int buffersize = 8192) :
-        AbstractFifo (buffersize)
+    AudioBufferFIFO (int channels = 2, int buffersize = 8192)
     {
         setSize (channels, buffersize);
     }
@@ -20,34 +31,114 @@ public:
     /** @returns the number of channels of the underlying buffer. */
     int getNumChannels() const noexcept { return buffer.getNumChannels(); }
 
+    /** @returns the number of samples that the FIFO can hold. */
+    int getTotalSize() const noexcept { return capacity; }
+
+    /** @returns the number of samples that can be read. */
+    int getNumReady() const noexcept { return getDistance (writer.position.load (std::memory_order_acquire), reader.position.load (std::memory_order_acquire)); }
+
+    /** @returns the number of samples that can be written. */
+    int getFreeSpace() const noexcept { return capacity - getNumReady(); }
+
     //==============================================================================
-    /** Resize the buffer with new number of channels and new number of samples. */
+    /** Resize the buffer with new number of channels and new number of samples.
+        This also empties the FIFO.
+    */
     void setSize (int channels, int newBufferSize)
     {
-        buffer.setSize (channels, newBufferSize, false, true, true);
-        setTotalSize (newBufferSize);
+        capacity = jmax (1, newBufferSize);
+        buffer.setSize (jmax (1, channels), capacity, false, true, true);
+
+        for (auto* pointers : { &writer.block1, &writer.block2, &reader.block1, &reader.block2 })
+            pointers->calloc ((size_t) getNumChannels());
+
+        clear();
+    }
+
+    //==============================================================================
+    /** A region of the FIFO's buffer, which wraps around into a second block at the end of the buffer.
+
+        The views are only valid until the next time the same side acquires another span.
+    */
+    struct Span final
+    {
+        AudioBufferView<FloatType> block1;  //< The first part of the region.
+        AudioBufferView<FloatType> block2;  //< The rest of the region, from the start of the buffer.
+
+        /** @returns the number of samples in the region. */
+        int getNumSamples() const noexcept { return block1.getNumSamples() + block2.getNumSamples(); }
+    };
+
+    /** Hands out up to numSamples of free space to write into, without copying anything.
+
+        Call commitWrite() once the samples were written to make them readable.
+        The span may be shorter than requested if the FIFO doesn't have enough free space.
+    */
+    Span acquireWrite (int numSamples) noexcept
+    {
+        auto free = capacity - getDistance (writer.position.load (std::memory_order_relaxed), writer.otherPosition);
+
+        // Only looking at the reader's side when the last known free space isn't enough:
+        if (free < numSamples)
+        {
+            writer.otherPosition = reader.position.load (std::memory_order_acquire);
+            free = capacity - getDistance (writer.position.load (std::memory_order_relaxed), writer.otherPosition);
+        }
+
+        return createSpan (writer, writer.position.load (std::memory_order_relaxed), jlimit (0, free, numSamples));
+    }
+
+    /** Makes numSamples of the last span acquired by acquireWrite() readable. */
+    void commitWrite (int numSamples) noexcept
+    {
+        jassert (isPositiveAndNotGreaterThan (numSamples, capacity - getDistance (writer.position.load (std::memory_order_relaxed), writer.otherPosition)));
+        writer.position.store (advance (writer.position.load (std::memory_order_relaxed), numSamples), std::memory_order_release);
+    }
+
+    /** Hands out up to numSamples of the samples that are ready, without copying anything.
+
+        Call commitRead() once the samples were used up to free their space.
+        The span may be shorter than requested if the FIFO doesn't have enough samples ready.
+    */
+    Span acquireRead (int numSamples) noexcept
+    {
+        auto ready = getDistance (reader.otherPosition, reader.position.load (std::memory_order_relaxed));
+
+        // Only looking at the writer's side when the last known samples ready aren't enough:
+        if (ready < numSamples)
+        {
+            reader.otherPosition = writer.position.load (std::memory_order_acquire);
+            ready = getDistance (reader.otherPosition, reader.position.load (std::memory_order_relaxed));
+        }
+
+        return createSpan (reader, reader.position.load (std::memory_order_relaxed), jlimit (0, ready, numSamples));
+    }
+
+    /** Frees numSamples of the last span acquired by acquireRead(). */
+    void commitRead (int numSamples) noexcept
+    {
+        jassert (isPositiveAndNotGreaterThan (numSamples, getDistance (reader.otherPosition, reader.position.load (std::memory_order_relaxed))));
+        reader.position.store (advance (reader.position.load (std::memory_order_relaxed), numSamples), std::memory_order_release);
     }
 
     //==============================================================================
     /** Push samples into the FIFO from raw float arrays. */
     void push (const FloatType** samples, int numSamples)
     {
-        numSamples = jmin (getFreeSpace(), numSamples);
-        if (numSamples <= 0)
-            return;
+        const auto span = acquireWrite (numSamples);
 
-        int start1, size1, start2, size2;
-        prepareToWrite (numSamples, start1, size1, start2, size2);
+        if (span.getNumSamples() <= 0)
+            return;
 
-        if (size1 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                buffer.copyFrom (channel, start1, samples[channel], size1);
+        const auto size1 = span.block1.getNumSamples();
 
-        if (size2 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                buffer.copyFrom (channel, start2, samples[channel] + size1, size2);
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            FloatVectorOperations::copy (span.block1.getChannel (channel), samples[channel], size1);
+            FloatVectorOperations::copy (span.block2.getChannel (channel), samples[channel] + size1, span.block2.getNumSamples());
+        }
 
-        finishedWrite (size1 + size2);
+        commitWrite (span.getNumSamples());
     }
 
     /** Push samples into the FIFO from an AudioBuffer. */
@@ -61,46 +152,38 @@ public:
     /** Add silence to the FIFO. */
     void pushSilence (int numSamples)
     {
-        numSamples = jmin (getFreeSpace(), numSamples);
-        if (numSamples <= 0)
-            return;
+        const auto span = acquireWrite (numSamples);
 
-        int start1, size1, start2, size2;
-        prepareToWrite (numSamples, start1, size1, start2, size2);
-
-        if (size1 > 0)
-            buffer.clear (start1, size1);
+        if (span.getNumSamples() <= 0)
+            return;
 
-        if (size2 > 0)
-            buffer.clear (start2, size2);
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            FloatVectorOperations::clear (span.block1.getChannel (channel), span.block1.getNumSamples());
+            FloatVectorOperations::clear (span.block2.getChannel (channel), span.block2.getNumSamples());
+        }
 
-        finishedWrite (size1 + size2);
+        commitWrite (span.getNumSamples());
     }
 
     //==============================================================================
     /** Read samples from the FIFO into raw float arrays. */
     void readTo (FloatType** samples, int numSamples)
     {
-        numSamples = jmin (getNumReady(), numSamples);
-        if (numSamples <= 0)
-            return;
+        const auto span = acquireRead (numSamples);
 
-        int start1, size1, start2, size2;
-        prepareToRead (numSamples, start1, size1, start2, size2);
+        if (span.getNumSamples() <= 0)
+            return;
 
-        if (size1 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                FloatVectorOperations::copy (samples[channel],
-                                             buffer.getReadPointer (channel, start1),
-                                             size1);
+        const auto size1 = span.block1.getNumSamples();
 
-        if (size2 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                FloatVectorOperations::copy (samples[channel] + size1,
-                                             buffer.getReadPointer (channel, start2),
-                                             size2);
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            FloatVectorOperations::copy (samples[channel], span.block1.getChannel (channel), size1);
+            FloatVectorOperations::copy (samples[channel] + size1, span.block2.getChannel (channel), span.block2.getNumSamples());
+        }
 
-        finishedRead (size1 + size2);
+        commitRead (span.getNumSamples());
     }
 
     /** Read samples from the FIFO into an AudioBuffer. */
@@ -121,71 +204,117 @@ public:
     /** Read samples from the FIFO and add it to raw float arrays. */
     void readToAdding (FloatType** samples, int numSamples, FloatType gain = FloatType (1))
     {
-        numSamples = jmin (getNumReady(), numSamples);
-        if (numSamples <= 0)
-            return;
+        const auto span = acquireRead (numSamples);
 
-        int start1, size1, start2, size2;
-        prepareToRead (numSamples, start1, size1, start2, size2);
+        if (span.getNumSamples() <= 0)
+            return;
 
-        if (size1 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                FloatVectorOperations::addWithMultiply (samples[channel],
-                                                        buffer.getReadPointer (channel, start1),
-                                                        gain,
-                                                        size1);
+        const auto size1 = span.block1.getNumSamples();
 
-        if (size2 > 0)
-            for (int channel = 0; channel < getNumChannels(); ++channel)
-                FloatVectorOperations::addWithMultiply (samples[channel] + size1,
-                                                        buffer.getReadPointer (channel, start2),
-                                                        gain,
-                                                        size2);
+        for (int channel = 0; channel < getNumChannels(); ++channel)
+        {
+            FloatVectorOperations::addWithMultiply (samples[channel], span.block1.getChannel (channel), gain, size1);
+            FloatVectorOperations::addWithMultiply (samples[channel] + size1, span.block2.getChannel (channel), gain, span.block2.getNumSamples());
+        }
 
-        finishedRead (size1 + size2);
+        commitRead (span.getNumSamples());
     }
 
     /** Read samples from the FIFO adding it to the AudioBuffers */
     void readToAdding (juce::AudioBuffer<FloatType>& samples, int numSamples = -1, FloatType gain = FloatType (1))
     {
-        readFromFifoAdding (samples.getArrayOfWritePointers(),
-                            numSamples < 0 ? samples.getNumSamples() : numSamples,
-                            gain);
+        readToAdding (samples.getArrayOfWritePointers(),
+                      numSamples < 0 ? samples.getNumSamples() : numSamples,
+                      gain);
     }
 
     /** Read samples from the FIFO into AudioSourceChannelInfo buffers to be used in AudioSources getNextAudioBlock */
     void readToAdding (const AudioSourceChannelInfo& info,
-                             int numSamples = -1,
-                             FloatType gain = FloatType (1))
+                       int numSamples = -1,
+                       FloatType gain = FloatType (1))
     {
         if (auto* buff = info.buffer)
-            readFromFifoAdding (*buff, numSamples, gain);
+            readToAdding (*buff, numSamples, gain);
     }
 
     //==============================================================================
     /** Pop (consume/remove) samples from the FIFO, ignoring them. */
     void pop (int numSamples)
     {
-        numSamples = jmin (getNumReady(), numSamples);
-        if (numSamples <= 0)
-            return;
-
-        int start1, size1, start2, size2;
-        prepareToRead (numSamples, start1, size1, start2, size2);
-        finishedRead (size1 + size2);
+        commitRead (acquireRead (numSamples).getNumSamples());
     }
 
     /** Clears all samples and sets the FIFO state to empty. */
     void clear()
     {
         buffer.clear();
+
+        // NB: Fetching these after clearing so the buffer doesn't think it's still clear,
+        //     and so that neither side has to touch the buffer's state while running.
+        channels = buffer.getArrayOfWritePointers();
         reset();
     }
 
 private:
+    //==============================================================================
+    static constexpr size_t cacheLineSize = 64;
+
+   JUCE_BEGIN_IGNORE_WARNINGS_MSVC (4324)
+
+    /** Everything that only one of the sides touches, on a cache line of its own. */
+    struct alignas (cacheLineSize) Side final
+    {
+        std::atomic<int> position { 0 };    //< Where this side is at, as published to the other side.
+        int otherPosition = 0;              //< The last known position of the other side.
+        HeapBlock<FloatType*> block1, block2; //< The channel pointers of the last span handed out.
+    };
+
     /** The actual audio buffer */
     juce::AudioBuffer<FloatType> buffer;
+    FloatType* const* channels = nullptr;
+    int capacity = 0;
+    Side writer, reader;
 
+   JUCE_END_IGNORE_WARNINGS_MSVC
+
+    //==============================================================================
+    // The positions run up to twice the capacity so that a full FIFO can be told apart from an empty one.
+    int getDistance (int from, int to) const noexcept
+    {
+        const auto distance = from - to;
+        return distance < 0 ? distance + 2 * capacity : distance;
+    }
+
+    int advance (int position, int numSamples) const noexcept
+    {
+        position += numSamples;
+        return position >= 2 * capacity ? position - 2 * capacity : position;
+    }
+
+    Span createSpan (Side& side, int position, int numSamples) noexcept
+    {
+        const auto start = position < capacity ? position : position - capacity;
+        const auto size1 = jmin (numSamples, capacity - start);
+        const auto numChannels = getNumChannels();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            side.block1[channel] = channels[channel] + start;
+            side.block2[channel] = channels[channel];
+        }
+
+        return { AudioBufferView<FloatType> (side.block1.get(), numChannels, size1),
+                 AudioBufferView<FloatType> (side.block2.get(), numChannels, numSamples - size1) };
+    }
+
+    void reset() noexcept
+    {
+        writer.position.store (0);
+        writer.otherPosition = 0;
+        reader.position.store (0);
+        reader.otherPosition = 0;
+    }
+
+    //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioBufferFIFO)
 };
-
@@ -133,6 +133,9 @@ public:
     };
 
     //==============================================================================
+    /** Creates an empty view. */
+    AudioBufferView() noexcept = default;
+
     /** */
     AudioBufferView (FloatType** channels_, int numChannels_, int numSamples_) noexcept :
         channels (channels_),
@@ -166,6 +169,13 @@ public:
         return *this;
     }
 
+    /** @returns the number of channels in view. */
+    int getNumChannels() const noexcept                     { return numChannels; }
+    /** @returns the number of samples in view. */
+    int getNumSamples() const noexcept                      { return numSamples; }
+    /** @returns a pointer to the first sample of a channel. */
+    FloatType* getChannel (int chan) const noexcept         { return channels[chan]; }
+
     /** */
     FloatType& operator() (int chan, int samp)              { return channels[chan][samp]; }
     /** */
@@ -0,0 +1,135 @@
+/** A multichannel delay line of whole samples, meant for compensating the latency of processors.
+
+    All of the memory is allocated up front in prepare(), so the delay can then be
+    changed at any time, up to the maximum it was prepared for, without allocating.
+    This makes it safe to use on the audio thread.
+*/
+template<typename FloatType>
+class AudioDelayLine final
+{
+public:
+    /** Constructor. */
+    AudioDelayLine() = default;
+
+    //==============================================================================
+    /** Allocates enough space for the given maximum delay and block size, and clears the delay line.
+
+        The delay is kept as is, but clamped to the new maximum.
+    */
+    void prepare (int numChannels, int maximumDelaySamples, int maximumBlockSize)
+    {
+        maximumDelay = jmax (0, maximumDelaySamples);
+        delay = jmin (delay, maximumDelay);
+
+        ring.setSize (jmax (1, numChannels), maximumDelay + jmax (1, maximumBlockSize), false, true, false);
+        clear();
+    }
+
+    /** Clears the contents of the delay line. */
+    void clear() noexcept
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    //==============================================================================
+    /** @returns the number of channels that the delay line was prepared for. */
+    int getNumChannels() const noexcept { return ring.getNumChannels(); }
+
+    /** @returns the largest delay that the delay line was prepared for. */
+    int getMaximumDelay() const noexcept { return maximumDelay; }
+
+    /** @returns the current delay, in samples. */
+    int getDelay() const noexcept { return delay; }
+
+    /** Changes the delay, clamping it to the maximum.
+
+        @returns false if the delay had to be clamped.
+    */
+    bool setDelay (int newDelay) noexcept
+    {
+        delay = jlimit (0, maximumDelay, newDelay);
+        return delay == newDelay;
+    }
+
+    //==============================================================================
+    /** Delays the first numChannels and numSamples of the buffer, in place. */
+    void process (juce::AudioBuffer<FloatType>& buffer, int numChannels, int numSamples) noexcept
+    {
+        jassert (numChannels <= buffer.getNumChannels() && numSamples <= buffer.getNumSamples());
+        processInternal (buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), numChannels, numSamples);
+    }
+
+    /** Delays all of the buffer, in place. */
+    void process (juce::AudioBuffer<FloatType>& buffer) noexcept
+    {
+        process (buffer, buffer.getNumChannels(), buffer.getNumSamples());
+    }
+
+    /** Feeds the delay line without reading anything back out.
+
+        Use this to keep the delay line up to date while its output isn't needed.
+    */
+    void push (const juce::AudioBuffer<FloatType>& buffer, int numChannels, int numSamples) noexcept
+    {
+        jassert (numChannels <= buffer.getNumChannels() && numSamples <= buffer.getNumSamples());
+        processInternal (buffer.getArrayOfReadPointers(), nullptr, numChannels, numSamples);
+    }
+
+private:
+    //==============================================================================
+    juce::AudioBuffer<FloatType> ring;
+    int maximumDelay = 0, delay = 0, writePosition = 0;
+
+    //==============================================================================
+    void processInternal (const FloatType* const* source, FloatType* const* destination,
+                          int numChannels, int numSamples) noexcept
+    {
+        const auto ringSize = ring.getNumSamples();
+        jassert (numChannels <= getNumChannels());
+        numChannels = jmin (numChannels, getNumChannels());
+
+        // The ring always has room for the delay plus one block, but the host
+        // may exceed the block size it promised so this works in chunks:
+        const auto maxChunkSize = ringSize - delay;
+
+        for (int start = 0; start < numSamples;)
+        {
+            const auto chunkSize = jmin (maxChunkSize, numSamples - start);
+            const auto readPosition = (writePosition - delay + ringSize) % ringSize;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                // NB: Writing first so that delays shorter than a chunk read back what was just written.
+                copyIntoRing (i, writePosition, source[i] + start, chunkSize);
+
+                if (destination != nullptr)
+                    copyFromRing (i, readPosition, destination[i] + start, chunkSize);
+            }
+
+            writePosition = (writePosition + chunkSize) % ringSize;
+            start += chunkSize;
+        }
+    }
+
+    void copyIntoRing (int channel, int position, const FloatType* source, int numSamples) noexcept
+    {
+        const auto size1 = jmin (numSamples, ring.getNumSamples() - position);
+        auto* dest = ring.getWritePointer (channel);
+
+        FloatVectorOperations::copy (dest + position, source, size1);
+        FloatVectorOperations::copy (dest, source + size1, numSamples - size1);
+    }
+
+    void copyFromRing (int channel, int position, FloatType* destination, int numSamples) const noexcept
+    {
+        const auto size1 = jmin (numSamples, ring.getNumSamples() - position);
+        const auto* src = ring.getReadPointer (channel);
+
+        FloatVectorOperations::copy (destination, src + position, size1);
+        FloatVectorOperations::copy (destination + size1, src, numSamples - size1);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioDelayLine)
+};
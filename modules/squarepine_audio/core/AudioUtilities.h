@@ -15,13 +15,15 @@ inline void resetBuses (AudioProcessor& processor,
 //==============================================================================
 /** Properly denormalises an audio buffer if denormalisation occurred.
 
+    @returns true if the buffer had to be flushed of denormals.
+
     @see FPUFlags
 */
 template<typename FloatType>
-inline void zeroIfDenormalisationOccurred (juce::AudioBuffer<FloatType>& buffer)
+inline bool zeroIfDenormalisationOccurred (juce::AudioBuffer<FloatType>& buffer)
 {
     if (! FPUFlags::hasDenormalisationOccurred() || buffer.hasBeenCleared())
-        return;
+        return false;
 
     auto chans = buffer.getArrayOfWritePointers();
     const auto numSamples = buffer.getNumSamples();
@@ -34,6 +36,8 @@ inline void zeroIfDenormalisationOccurred (juce::AudioBuffer<FloatType>& buffer)
             FloatVectorOperations::add (c, -1.0f, numSamples);
         }
     }
+
+    return true;
 }
 
 //==============================================================================
@@ -42,14 +46,16 @@ inline void zeroIfDenormalisationOccurred (juce::AudioBuffer<FloatType>& buffer)
     Lots of dodgy third-party plugins use 'fast' float modes, which can subtly
     screw up the audio processing pipeline and cause grotesque glitches.
 
+    @returns true if the processor left denormals behind, which were then flushed.
+
     @see FPUFlags, zeroIfDenormalisationOccurred
 */
 template<typename FloatType>
-inline void processSafely (AudioProcessor& proc, juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
+inline bool processSafely (AudioProcessor& proc, juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
 {
     FPUFlags::clearIfDenormalised();
     proc.processBlock (buffer, midiMessages);
-    zeroIfDenormalisationOccurred (buffer);
+    return zeroIfDenormalisationOccurred (buffer);
 }
 
 //==============================================================================
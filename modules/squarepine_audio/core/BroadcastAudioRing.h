@@ -0,0 +1,222 @@
+/** A ring of audio that a single writer broadcasts to any number of readers.
+
+    The writer copies its audio into the ring once, no matter how many readers there are,
+    and never waits on any of them. Each reader keeps its own Reader cursor, and reads
+    at its own pace without locking anything.
+
+    A reader that falls more than a ring's worth of samples behind has missed out on
+    some of the audio: this gets detected, counted in the reader's cursor, and the reader
+    then carries on from the oldest audio that is still in the ring. Whatever a reader
+    gets handed back is guaranteed not to have been overwritten while it was being read.
+
+    @warning prepare() must not be called while the writer or any of the readers are using the ring.
+
+    @see AudioBufferFIFO
+*/
+template<typename FloatType>
+class BroadcastAudioRing final
+{
+public:
+    /** Constructor. */
+    BroadcastAudioRing() = default;
+
+    //==============================================================================
+    /** Allocates the ring, and empties it. */
+    void prepare (int numChannels, int numSamples)
+    {
+        capacity = jmax (1, numSamples);
+        ring.setSize (jmax (1, numChannels), capacity, false, true, false);
+        ring.clear();
+
+        // NB: Fetching these after clearing so the buffer doesn't think it's still clear.
+        channels = ring.getArrayOfWritePointers();
+
+        reservedPosition.store (0);
+        writtenPosition.store (0);
+    }
+
+    /** @returns the number of channels in the ring. */
+    int getNumChannels() const noexcept { return ring.getNumChannels(); }
+
+    /** @returns the number of samples that the ring holds on to. */
+    int getCapacity() const noexcept { return capacity; }
+
+    /** @returns the total number of samples that were written since the ring was prepared. */
+    int64 getNumSamplesWritten() const noexcept { return writtenPosition.load (std::memory_order_acquire); }
+
+    //==============================================================================
+    /** Appends audio to the ring, converting it if need be.
+
+        Any channel of the ring that the source doesn't have is filled with silence.
+        This is wait-free, and must only ever be called from a single thread.
+    */
+    template<typename SourceType>
+    void write (const juce::AudioBuffer<SourceType>& source, int numChannels, int numSamples) noexcept
+    {
+        jassert (numChannels <= source.getNumChannels() && numSamples <= source.getNumSamples());
+        numChannels = jmin (numChannels, getNumChannels());
+
+        // Writing more than the ring holds would only overwrite itself:
+        const auto startSample = jmax (0, numSamples - capacity);
+        numSamples -= startSample;
+
+        if (numSamples <= 0)
+            return;
+
+        const auto position = writtenPosition.load (std::memory_order_relaxed) + startSample;
+
+        // Letting the readers know which samples are about to be overwritten, before overwriting any of them:
+        reservedPosition.store (position + numSamples, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        const auto start = (int) (position % capacity);
+        const auto size1 = jmin (numSamples, capacity - start);
+
+        for (int i = 0; i < getNumChannels(); ++i)
+        {
+            if (i < numChannels)
+            {
+                const auto* src = source.getReadPointer (i, startSample);
+                copySamples (channels[i] + start, src, size1);
+                copySamples (channels[i], src + size1, numSamples - size1);
+            }
+            else
+            {
+                FloatVectorOperations::clear (channels[i] + start, size1);
+                FloatVectorOperations::clear (channels[i], numSamples - size1);
+            }
+        }
+
+        writtenPosition.store (position + numSamples, std::memory_order_release);
+    }
+
+    /** Appends all of the audio to the ring. */
+    template<typename SourceType>
+    void write (const juce::AudioBuffer<SourceType>& source) noexcept
+    {
+        write (source, source.getNumChannels(), source.getNumSamples());
+    }
+
+    //==============================================================================
+    /** Where a reader is at in the ring. Each reader must have its own. */
+    struct Reader final
+    {
+        int64 position = 0;             //< The position of the next sample to read.
+        int64 numOverruns = 0;          //< The number of times the reader fell so far behind that it missed some audio.
+        int64 numSamplesMissed = 0;     //< The total number of samples that the reader missed.
+    };
+
+    /** @returns a new reader cursor, which only reads the audio written from now on. */
+    Reader createReader() const noexcept
+    {
+        Reader reader;
+        reader.position = getNumSamplesWritten();
+        return reader;
+    }
+
+    /** @returns the number of samples that the reader has yet to read, which may be more than the ring holds. */
+    int64 getNumReady (const Reader& reader) const noexcept
+    {
+        return jmax ((int64) 0, getNumSamplesWritten() - reader.position);
+    }
+
+    /** Reads the oldest audio that the reader hasn't read yet.
+
+        This is lock-free, and can be called from any number of threads at once,
+        as long as each of them has its own reader.
+
+        @param reader       The reader's cursor, which gets moved past whatever was read.
+        @param destination  Where to copy the audio to. It must have as many channels as numChannels.
+        @param numChannels  The number of channels to read, which gets limited to the channels in the ring.
+        @param maxSamples   The largest number of samples to read.
+
+        @returns the number of samples read, which were copied to the start of the destination.
+    */
+    int read (Reader& reader, FloatType* const* destination, int numChannels, int maxSamples) noexcept
+    {
+        numChannels = jmin (numChannels, getNumChannels());
+
+        const auto written = writtenPosition.load (std::memory_order_acquire);
+
+        // The ring was prepared again:
+        if (reader.position > written)
+            reader.position = written;
+
+        skipOverwrittenSamples (reader, written - capacity);
+
+        const auto numSamples = (int) jmin ((int64) jmax (0, maxSamples), written - reader.position);
+
+        if (numSamples <= 0)
+            return 0;
+
+        const auto start = (int) (reader.position % capacity);
+        const auto size1 = jmin (numSamples, capacity - start);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            FloatVectorOperations::copy (destination[i], channels[i] + start, size1);
+            FloatVectorOperations::copy (destination[i] + size1, channels[i], numSamples - size1);
+        }
+
+        // Checking whether the writer started overwriting any of what was just read, in which case that part is torn:
+        std::atomic_thread_fence (std::memory_order_acquire);
+        const auto oldestIntact = reservedPosition.load (std::memory_order_relaxed) - capacity;
+        const auto numTorn = (int) jlimit ((int64) 0, (int64) numSamples, oldestIntact - reader.position);
+
+        skipOverwrittenSamples (reader, oldestIntact);
+
+        const auto numIntact = numSamples - numTorn;
+
+        if (numTorn > 0 && numIntact > 0)
+            for (int i = 0; i < numChannels; ++i)
+                std::memmove (destination[i], destination[i] + numTorn, sizeof (FloatType) * (size_t) numIntact);
+
+        reader.position += numIntact;
+        return numIntact;
+    }
+
+    /** Reads as much as fits into the destination buffer.
+
+        @returns the number of samples read, which were copied to the start of the buffer.
+    */
+    int read (Reader& reader, juce::AudioBuffer<FloatType>& destination) noexcept
+    {
+        return read (reader, destination.getArrayOfWritePointers(),
+                     destination.getNumChannels(), destination.getNumSamples());
+    }
+
+private:
+    //==============================================================================
+    juce::AudioBuffer<FloatType> ring;
+    FloatType* const* channels = nullptr;
+    int capacity = 0;
+
+    std::atomic<int64> reservedPosition { 0 };  //< Where the writer is writing up to.
+    std::atomic<int64> writtenPosition { 0 };   //< Where the writer has finished writing up to.
+
+    //==============================================================================
+    static void skipOverwrittenSamples (Reader& reader, int64 oldestIntact) noexcept
+    {
+        if (reader.position < oldestIntact)
+        {
+            ++reader.numOverruns;
+            reader.numSamplesMissed += oldestIntact - reader.position;
+            reader.position = oldestIntact;
+        }
+    }
+
+    static void copySamples (FloatType* dest, const FloatType* src, int numSamples) noexcept
+    {
+        FloatVectorOperations::copy (dest, src, numSamples);
+    }
+
+    template<typename SourceType>
+    static void copySamples (FloatType* dest, const SourceType* src, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = static_cast<FloatType> (src[i]);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BroadcastAudioRing)
+};
@@ -1,6 +1,7 @@
 EffectProcessor::EffectProcessor (std::shared_ptr<AudioPluginInstance> api,
                             const PluginDescription& pd) :
     isBypassed (false),
+    targetMixLevel (1.0f),
     mixLevel (1.0f),
     plugin (std::move (api)),
     description (pd)
@@ -12,11 +13,22 @@ EffectProcessor::EffectProcessor (std::shared_ptr<AudioPluginInstance> api,
         // Capture the plugin's state at start-up in case the developers
         // haven't implemented the getParameterDefaultValue interface
         plugin->getStateInformation (defaultState);
+        plugin->addListener (this);
+
+        // Only an InternalProcessor is known to keep nothing but its parameters in its state,
+        // and every change to those gets reported through the listener:
+        stateChangesReported = dynamic_cast<InternalProcessor*> (plugin.get()) != nullptr;
     }
 
     mixLevel.setCurrentAndTargetValue (1.0f);
 }
 
+EffectProcessor::~EffectProcessor()
+{
+    if (plugin != nullptr)
+        plugin->removeListener (this);
+}
+
 bool EffectProcessor::reloadFromStateIfValid()
 {
     if (! isMissing())
@@ -30,6 +42,7 @@ bool EffectProcessor::reloadFromStateIfValid()
             && stream.getDataSize() > 0)
         {
             plugin->setStateInformation (stream.getData(), (int) stream.getDataSize());
+            markStateDirty();
             wasValid = true;
         }
 
@@ -40,9 +53,105 @@ bool EffectProcessor::reloadFromStateIfValid()
     return true;
 }
 
+const MemoryBlock& EffectProcessor::getPluginState()
+{
+    jassert (! isMissing());
+
+    // NB: Clearing the flag first so that any change from here on gets picked up next time.
+    if (stateDirty.exchange (false) || ! stateChangesReported)
+    {
+        cachedState.reset();
+        plugin->getStateInformation (cachedState);
+    }
+
+    return cachedState;
+}
+
+const String& EffectProcessor::getDescriptionAsXml()
+{
+    if (cachedDescription.isEmpty())
+        cachedDescription = description.createXml()->toString (XmlElement::TextFormat().singleLine().withoutHeader());
+
+    return cachedDescription;
+}
+
 bool EffectProcessor::canBeProcessed() const noexcept
 {
     return ! isMissing()
         && ! isBypassed.load (std::memory_order_relaxed)
-        && mixLevel.getTargetValue() > 0.0f;
+        && getMixLevel() > 0.0f;
+}
+
+void EffectProcessor::setMixLevel (float newMixLevel) noexcept
+{
+    targetMixLevel.store (std::clamp (newMixLevel, 0.0f, 1.0f), std::memory_order_relaxed);
+}
+
+//==============================================================================
+EffectProcessorStatistics::EffectProcessorStatistics() noexcept
+{
+    for (auto& timing : timingsMs)
+        timing.store (0.0f, std::memory_order_relaxed);
+}
+
+void EffectProcessorStatistics::addBlock (double processingTimeMs, bool flushedDenormals, int latencySamples) noexcept
+{
+    const auto index = numBlocksWritten.load (std::memory_order_relaxed);
+    timingsMs[(size_t) (index % (uint32) windowSize)].store ((float) processingTimeMs, std::memory_order_relaxed);
+    numBlocksWritten.store (index + 1, std::memory_order_release);
+
+    if (flushedDenormals)
+        numDenormalFlushes.fetch_add (1, std::memory_order_relaxed);
+
+    lastLatencySamples.store (latencySamples, std::memory_order_relaxed);
+}
+
+void EffectProcessorStatistics::addSkippedBlock() noexcept
+{
+    numBlocksSkipped.fetch_add (1, std::memory_order_relaxed);
+}
+
+EffectProcessorStatistics::Summary EffectProcessorStatistics::getSummary() const
+{
+    Summary summary;
+    summary.latencySamples = lastLatencySamples.load (std::memory_order_relaxed);
+    summary.numDenormalFlushes = numDenormalFlushes.load (std::memory_order_relaxed)
+                               - numDenormalFlushesAtReset.load (std::memory_order_relaxed);
+    summary.numBlocksSkipped = numBlocksSkipped.load (std::memory_order_relaxed)
+                             - numBlocksSkippedAtReset.load (std::memory_order_relaxed);
+
+    const auto numWritten = numBlocksWritten.load (std::memory_order_acquire);
+    const auto numSinceReset = numWritten - numBlocksAtReset.load (std::memory_order_relaxed);
+    const auto numBlocks = (int) jmin (numSinceReset, (uint32) windowSize);
+
+    if (numBlocks <= 0)
+        return summary;
+
+    std::array<float, windowSize> sorted;
+
+    for (int i = 0; i < numBlocks; ++i)
+        sorted[(size_t) i] = timingsMs[(size_t) ((numWritten - 1 - (uint32) i) % (uint32) windowSize)].load (std::memory_order_relaxed);
+
+    std::sort (sorted.begin(), sorted.begin() + numBlocks);
+
+    const auto getPercentile = [&] (double percentile)
+    {
+        return (double) sorted[(size_t) roundToInt (percentile * (numBlocks - 1))];
+    };
+
+    summary.numBlocks = numBlocks;
+    summary.minMs = (double) sorted.front();
+    summary.maxMs = (double) sorted[(size_t) numBlocks - 1];
+    summary.meanMs = std::accumulate (sorted.begin(), sorted.begin() + numBlocks, 0.0) / numBlocks;
+    summary.p50Ms = getPercentile (0.5);
+    summary.p95Ms = getPercentile (0.95);
+    summary.p99Ms = getPercentile (0.99);
+    return summary;
+}
+
+void EffectProcessorStatistics::reset() noexcept
+{
+    numBlocksAtReset.store (numBlocksWritten.load (std::memory_order_acquire), std::memory_order_relaxed);
+    numDenormalFlushesAtReset.store (numDenormalFlushes.load (std::memory_order_relaxed), std::memory_order_relaxed);
+    numBlocksSkippedAtReset.store (numBlocksSkipped.load (std::memory_order_relaxed), std::memory_order_relaxed);
 }
@@ -1,12 +1,101 @@
+/** Keeps track of how an effect has been performing over a sliding window of blocks.
+
+    The audio thread records into this without waiting on anything,
+    and any other thread can take a summary of it at any time.
+*/
+class EffectProcessorStatistics final
+{
+public:
+    /** Constructor. */
+    EffectProcessorStatistics() noexcept;
+
+    //==============================================================================
+    /** The number of blocks that the timings are kept for. */
+    static constexpr int windowSize = 256;
+
+    /** A summary of an effect's performance over the last windowSize blocks. */
+    struct Summary final
+    {
+        int numBlocks = 0;              //< The number of blocks that the timings cover.
+        double minMs = 0.0;             //< The shortest time taken to process a block, in milliseconds.
+        double meanMs = 0.0;            //< The mean time taken to process a block, in milliseconds.
+        double maxMs = 0.0;             //< The longest time taken to process a block, in milliseconds.
+        double p50Ms = 0.0;             //< The median time taken to process a block, in milliseconds.
+        double p95Ms = 0.0;             //< The 95th percentile of the time taken to process a block, in milliseconds.
+        double p99Ms = 0.0;             //< The 99th percentile of the time taken to process a block, in milliseconds.
+        int64 numDenormalFlushes = 0;   //< The number of blocks that had to be flushed of denormals.
+        int64 numBlocksSkipped = 0;     //< The number of blocks that the effect slept through.
+        int latencySamples = 0;         //< The latency last reported by the plugin.
+    };
+
+    //==============================================================================
+    /** Records the result of processing a block.
+        This is wait-free, and must only be called from a single thread at a time.
+    */
+    void addBlock (double processingTimeMs, bool flushedDenormals, int latencySamples) noexcept;
+
+    /** Records that the effect slept through a block instead of processing it.
+        This is wait-free, and must only be called from a single thread at a time.
+    */
+    void addSkippedBlock() noexcept;
+
+    /** @returns a summary of the recorded blocks. This can be called from any thread. */
+    Summary getSummary() const;
+
+    /** Forgets about all of the blocks recorded so far. This can be called from any thread. */
+    void reset() noexcept;
+
+private:
+    //==============================================================================
+    std::array<std::atomic<float>, windowSize> timingsMs;
+    std::atomic<uint32> numBlocksWritten { 0 }, numBlocksAtReset { 0 };
+    std::atomic<int64> numDenormalFlushes { 0 }, numDenormalFlushesAtReset { 0 };
+    std::atomic<int64> numBlocksSkipped { 0 }, numBlocksSkippedAtReset { 0 };
+    std::atomic<int> lastLatencySamples { 0 };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectProcessorStatistics)
+};
+
+//==============================================================================
+/** The delay lines that an EffectProcessorChain uses to compensate for an effect's latency.
+
+    These line the dry signal up with the effect's delayed output when mixing,
+    and stand in for the effect's latency while it's bypassed.
+*/
+struct EffectLatencyCompensation final
+{
+    /** Allocates the delay lines for both single and double precision processing. */
+    EffectLatencyCompensation (int numChannels, int maximumDelaySamples, int blockSize) :
+        maximumBlockSize (blockSize)
+    {
+        floatDelay.prepare (numChannels, maximumDelaySamples, blockSize);
+        doubleDelay.prepare (numChannels, maximumDelaySamples, blockSize);
+    }
+
+    AudioDelayLine<float>& getDelayLine (float) noexcept    { return floatDelay; }
+    AudioDelayLine<double>& getDelayLine (double) noexcept  { return doubleDelay; }
+
+    AudioDelayLine<float> floatDelay;       //<
+    AudioDelayLine<double> doubleDelay;     //<
+    int maximumBlockSize = 0;               //< The block size the delay lines were prepared for.
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectLatencyCompensation)
+};
+
+//==============================================================================
 /** A flexible wrapper around a juce::AudioPluginInstance for use in an EffectProcessorChain.
 
     When created by an EffectProcessorChain, an instance of this is referencable in an
     assortment of ways so you can easily manage bypassing, mixing, state handling,
     and whatever else for the contained plugin.
 
+    The plugin's state is cached, and is only asked for again once the plugin
+    reports that one of its parameters or something else about it has changed.
+
     @see EffectProcessorChain
 */
-class EffectProcessor final
+class EffectProcessor final : private AudioProcessorListener
 {
 public:
     //==============================================================================
@@ -17,6 +106,9 @@ public:
     EffectProcessor (std::shared_ptr<AudioPluginInstance> plugin,
                      const PluginDescription& description);
 
+    /** Destructor. */
+    ~EffectProcessor() override;
+
     //==============================================================================
     /** @returns true if the contained plugin is null, which is interpreted as likely missing. */
     bool isMissing() const noexcept { return plugin == nullptr; }
@@ -26,20 +118,82 @@ public:
     */
     bool canBeProcessed() const noexcept;
 
+    /** Changes the normalised mix level that the audio thread will smooth towards. */
+    void setMixLevel (float newMixLevel) noexcept;
+
+    /** @returns the normalised mix level that was last requested. */
+    float getMixLevel() const noexcept { return targetMixLevel.load (std::memory_order_relaxed); }
+
     /** @returns true if the plugin was able to be restored from its last known state. */
     bool reloadFromStateIfValid();
 
+    /** @returns the plugin's state, which is only asked of the plugin
+                 if it may have changed since the last time it was asked.
+
+        Plugins can change their state without saying so, so only the ones that are known
+        to report every change get their state cached. All of the others get asked every time.
+
+        @warning This must not be called from multiple threads at once.
+    */
+    const MemoryBlock& getPluginState();
+
+    /** Forces the plugin's state to be asked for again the next time it's needed.
+
+        Use this if the plugin's state was changed in some way that the plugin doesn't report.
+    */
+    void markStateDirty() noexcept { stateDirty.store (true); }
+
+    /** @returns the description of the plugin as a single line of XML.
+
+        @warning This must not be called from multiple threads at once.
+    */
+    const String& getDescriptionAsXml();
+
+    /** Safely processes the plugin, keeping track of how long it took in the statistics.
+
+        @see processSafely
+    */
+    template<typename FloatType>
+    void process (juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
+    {
+        jassert (! isMissing());
+
+        const auto startTicks = Time::getHighResolutionTicks();
+        const auto flushedDenormals = processSafely (*plugin, buffer, midiMessages);
+        const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+
+        statistics.addBlock (Time::highResolutionTicksToSeconds (elapsedTicks) * 1000.0,
+                             flushedDenormals, plugin->getLatencySamples());
+    }
+
     //==============================================================================
     String name;                                    //<
     std::atomic<bool> isBypassed;                   //<
-    LinearSmoothedValue<float> mixLevel;            //< The normalised mix level.
+    std::atomic<float> targetMixLevel;              //< The normalised mix level, as requested by the user.
+    LinearSmoothedValue<float> mixLevel;            //< The normalised mix level, as smoothed on the audio thread.
     juce::Point<int> lastUIPosition;                //<
     std::shared_ptr<AudioPluginInstance> plugin;    //<
     const PluginDescription description;            //<
     MemoryBlock defaultState;                       //<
     String lastKnownBase64State;                    //<
+    int parallelGroup = -1;                         //< Neighbouring effects sharing a group of 0 or more get split into parallel branches.
+    int branchIndex = 0;                            //< The branch within the parallel group that this effect belongs to.
+    EffectProcessorStatistics statistics;           //< How the plugin has been performing lately.
+    std::shared_ptr<EffectLatencyCompensation> latencyCompensation; //< Managed by the owning chain, and only allocated for effects with latency.
+    int64 numSilentSamples = 0;                     //< Audio thread only: how long the effect's input has been silent for.
+    bool isAsleep = false;                          //< Audio thread only: true while the effect is skipped for lack of input.
 
 private:
+    //==============================================================================
+    std::atomic<bool> stateDirty { true };
+    bool stateChangesReported = false;      //< Whether the plugin's state can be cached, because it reports every change.
+    MemoryBlock cachedState;
+    String cachedDescription;
+
+    //==============================================================================
+    void audioProcessorParameterChanged (AudioProcessor*, int, float) override   { markStateDirty(); }
+    void audioProcessorChanged (AudioProcessor*, const ChangeDetails&) override  { markStateDirty(); }
+
     //==============================================================================
     EffectProcessor() = delete;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectProcessor)
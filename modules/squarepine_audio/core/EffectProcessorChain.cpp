@@ -1,9 +1,309 @@
 //==============================================================================
 EffectProcessorChain::EffectProcessorChain (std::shared_ptr<EffectProcessorFactory> epf) :
-    factory (epf)
+    factory (std::move (epf))
 {
     jassert (factory != nullptr);
     plugins.reserve (10);
+
+    const ScopedLock sl (editLock);
+    publishSnapshot();
+
+    // Keeps an eye out for latency changes, and cleans up after the audio thread:
+    startTimer (100);
+}
+
+EffectProcessorChain::~EffectProcessorChain()
+{
+    stopTimer();
+
+    const ScopedLock sl (editLock);
+    delete liveSnapshot.exchange (nullptr);
+    retiredSnapshots.clear();
+}
+
+//==============================================================================
+std::unique_ptr<EffectProcessorChain::ChainSnapshot> EffectProcessorChain::createSnapshot() const
+{
+    auto snapshot = std::make_unique<ChainSnapshot>();
+    snapshot->effects = plugins;
+    snapshot->stages = createRenderStages (plugins);
+    snapshot->requiredChannels = getRequiredNumChannels();
+
+    // Uses requiredChannels to ensure enough memory is allocated for the plugin to
+    // potentially read from/write to - avoids bad accesses.
+    const auto numChannels = jmax (snapshot->requiredChannels, getTotalNumInputChannels(), getTotalNumOutputChannels(), 1);
+    const auto numSamples = jmax (getBlockSize(), 1);
+
+    snapshot->floatBuffers.prepare (numChannels, numSamples);
+    snapshot->floatBuffers.prepareScratch (numChannels, numSamples);
+    snapshot->doubleBuffers.prepare (numChannels, numSamples);
+    snapshot->doubleBuffers.prepareScratch (numChannels, numSamples);
+    snapshot->chunkMidiMessages.ensureSize (2048);
+    snapshot->processedMidiMessages.ensureSize (2048);
+
+    // The effects' delay lines outlive the snapshot, but must stay alive for as long as the snapshot does:
+    for (const auto& effect : plugins)
+        if (effect != nullptr && effect->latencyCompensation != nullptr)
+            snapshot->latencyCompensations.push_back (effect->latencyCompensation);
+
+    // NB: Only publishSnapshot() replaces the live snapshot, and it holds the edit lock while calling this.
+    const auto* previousSnapshot = liveSnapshot.load();
+    std::vector<EffectLatencyCompensation*> takenAlignments;
+
+    // Carries on with the delay line that the branch already had, so that whatever's in it doesn't get dropped:
+    const auto findPreviousAlignment = [&] (const RenderStage& stage, const RenderBranch& branch) -> std::shared_ptr<EffectLatencyCompensation>
+    {
+        if (previousSnapshot == nullptr)
+            return {};
+
+        for (const auto& previousStage : previousSnapshot->stages)
+        {
+            if (previousStage.parallelGroup != stage.parallelGroup)
+                continue;
+
+            for (const auto& previousBranch : previousStage.branches)
+            {
+                const auto& alignment = previousBranch.alignment;
+
+                if (previousBranch.branchIndex == branch.branchIndex
+                    && alignment != nullptr
+                    && branch.alignmentSamples <= alignment->floatDelay.getMaximumDelay()
+                    && alignment->floatDelay.getNumChannels() == numChannels
+                    && alignment->maximumBlockSize == numSamples
+                    && std::find (takenAlignments.begin(), takenAlignments.end(), alignment.get()) == takenAlignments.end())
+                    return alignment;
+            }
+        }
+
+        return {};
+    };
+
+    for (auto& stage : snapshot->stages)
+    {
+        // Lining the shorter branches up with the longest one:
+        for (auto& branch : stage.branches)
+        {
+            branch.alignmentSamples = stage.latencySamples - branch.latencySamples;
+
+            if (branch.alignmentSamples <= 0)
+                continue;
+
+            branch.alignment = findPreviousAlignment (stage, branch);
+
+            // NB: As with the effects' delay lines, the headroom saves replacing this for every small change.
+            //     The audio thread sets the delay itself, since the previous snapshot might still be using it.
+            if (branch.alignment == nullptr)
+                branch.alignment = std::make_shared<EffectLatencyCompensation> (numChannels, branch.alignmentSamples * 2, numSamples);
+
+            takenAlignments.push_back (branch.alignment.get());
+        }
+
+        snapshot->latencySamples += stage.latencySamples;
+    }
+
+    size_t maxNumBranches = 1;
+    for (const auto& stage : snapshot->stages)
+        maxNumBranches = jmax (maxNumBranches, stage.branches.size());
+
+    for (size_t i = 1; i < maxNumBranches; ++i)
+    {
+        snapshot->floatBranchBuffers.push_back (std::make_unique<BufferPackage<float>>());
+        snapshot->floatBranchBuffers.back()->prepare (numChannels, numSamples);
+
+        snapshot->doubleBranchBuffers.push_back (std::make_unique<BufferPackage<double>>());
+        snapshot->doubleBranchBuffers.back()->prepare (numChannels, numSamples);
+
+        snapshot->branchMidiBuffers.emplace_back();
+        snapshot->branchMidiBuffers.back().ensureSize (2048);
+    }
+
+    return snapshot;
+}
+
+std::vector<EffectProcessorChain::RenderStage> EffectProcessorChain::createRenderStages (const std::vector<EffectProcessor::Ptr>& effects)
+{
+    std::vector<RenderStage> stages;
+
+    for (const auto& effect : effects)
+    {
+        if (effect == nullptr)
+            continue;
+
+        const auto group = jmax (-1, effect->parallelGroup);
+
+        // Neighbouring effects that are in series, or in the same parallel group, share a stage:
+        if (stages.empty() || stages.back().parallelGroup != group)
+        {
+            stages.emplace_back();
+            stages.back().parallelGroup = group;
+        }
+
+        auto& branches = stages.back().branches;
+        const auto branchIndex = group >= 0 ? effect->branchIndex : 0;
+
+        auto branch = std::find_if (branches.begin(), branches.end(),
+                                    [branchIndex] (const RenderBranch& b) { return b.branchIndex == branchIndex; });
+
+        if (branch == branches.end())
+        {
+            branches.emplace_back();
+            branch = branches.end() - 1;
+            branch->branchIndex = branchIndex;
+        }
+
+        RenderSlot slot;
+        slot.effect = effect.get();
+        slot.latencyCompensation = effect->latencyCompensation.get();
+
+        if (auto* plugin = effect->plugin.get())
+            slot.latencySamples = jmax (0, plugin->getLatencySamples());
+
+        branch->slots.push_back (slot);
+        branch->latencySamples += slot.latencySamples;
+    }
+
+    int timingSlot = 0;
+
+    for (auto& stage : stages)
+    {
+        std::sort (stage.branches.begin(), stage.branches.end(),
+                   [] (const RenderBranch& a, const RenderBranch& b) { return a.branchIndex < b.branchIndex; });
+
+        for (const auto& branch : stage.branches)
+            stage.latencySamples = jmax (stage.latencySamples, branch.latencySamples);
+
+        if (stage.parallelGroup >= 0)
+            for (auto& branch : stage.branches)
+                if (timingSlot < maxNumTimedBranches)
+                    branch.timingSlot = timingSlot++;
+    }
+
+    return stages;
+}
+
+void EffectProcessorChain::publishSnapshot()
+{
+    // Must be called with the edit lock held!
+    // NB: Clearing this first so that any latency change from here on gets picked up again.
+    latencyChanged.store (false);
+    updateLatencyCompensation();
+
+    auto snapshot = createSnapshot();
+    const auto latencySamples = snapshot->latencySamples;
+
+    const auto hasParallelStages = std::any_of (snapshot->stages.begin(), snapshot->stages.end(),
+                                                [] (const RenderStage& stage) { return stage.branches.size() > 1; });
+
+    if (hasParallelStages && workerPool == nullptr)
+        workerPool = std::make_unique<SharedResourcePointer<SharedWorkerPool>>();
+
+    snapshot->workerPool = workerPool != nullptr ? &workerPool->get() : nullptr;
+    resetBranchTimings();
+
+    auto* oldSnapshot = liveSnapshot.exchange (snapshot.release());
+
+    if (oldSnapshot != nullptr)
+        retiredSnapshots.push_back ({ std::unique_ptr<ChainSnapshot> (oldSnapshot), audioThreadEpoch.load() });
+
+    setLatencySamples (latencySamples);
+    purgeRetiredSnapshots();
+}
+
+int EffectProcessorChain::getRequiredNumChannels() const
+{
+    int requiredChannels = 0;
+
+    for (const auto& effect : plugins)
+        if (effect != nullptr)
+            requiredChannels = jmax (requiredChannels,
+                                     effect->description.numInputChannels,
+                                     effect->description.numOutputChannels);
+
+    return requiredChannels;
+}
+
+void EffectProcessorChain::updateLatencyCompensation()
+{
+    // Must be called with the edit lock held!
+    const auto numChannels = jmax (getRequiredNumChannels(), getTotalNumInputChannels(), getTotalNumOutputChannels(), 1);
+    const auto blockSize = jmax (getBlockSize(), 1);
+
+    for (auto& effect : plugins)
+    {
+        if (effect == nullptr || effect->isMissing())
+            continue;
+
+        const auto latency = jmax (0, effect->plugin->getLatencySamples());
+        if (latency <= 0)
+            continue;
+
+        // The audio thread follows latency changes on its own, but can't grow the delay lines,
+        // so they get replaced here whenever they're too small. The new ones have some headroom
+        // so that small changes in latency don't need to come back around here.
+        // NB: The existing delay lines may be in use by the audio thread, so they mustn't be changed!
+        const auto& existing = effect->latencyCompensation;
+
+        if (existing == nullptr
+            || latency > existing->floatDelay.getMaximumDelay()
+            || numChannels != existing->floatDelay.getNumChannels()
+            || blockSize != existing->maximumBlockSize)
+        {
+            auto compensation = std::make_shared<EffectLatencyCompensation> (numChannels, latency * 2, blockSize);
+            compensation->floatDelay.setDelay (latency);
+            compensation->doubleDelay.setDelay (latency);
+            effect->latencyCompensation = std::move (compensation);
+        }
+    }
+}
+
+void EffectProcessorChain::purgeRetiredSnapshots()
+{
+    // Must be called with the edit lock held!
+    const auto currentEpoch = audioThreadEpoch.load();
+
+    // A retired snapshot can be destroyed if the audio thread wasn't inside a block
+    // when it was swapped out, or if the audio thread has since left that block.
+    retiredSnapshots.erase (std::remove_if (retiredSnapshots.begin(), retiredSnapshots.end(),
+                                            [currentEpoch] (const RetiredSnapshot& retired)
+                                            {
+                                                return (retired.epoch & 1) == 0
+                                                    || retired.epoch != currentEpoch;
+                                            }),
+                            retiredSnapshots.end());
+
+    // NB: Anything the audio thread was still holding on to gets another go in the timer callback.
+}
+
+void EffectProcessorChain::timerCallback()
+{
+    const ScopedLock sl (editLock);
+
+    // An effect changed its latency while processing, so the compensation
+    // may need more room and the host needs to hear about the new latency:
+    if (latencyChanged.load())
+        publishSnapshot();
+    else
+        purgeRetiredSnapshots();
+}
+
+bool EffectProcessorChain::editEffects (std::function<bool (std::vector<EffectProcessor::Ptr>&)> edit)
+{
+    jassert (edit != nullptr);
+
+    bool changed = false;
+
+    {
+        const ScopedLock sl (editLock);
+        changed = edit (plugins);
+
+        if (changed)
+            publishSnapshot();
+    }
+
+    if (changed)
+        updateHostDisplay();
+
+    return changed;
 }
 
 //==============================================================================
@@ -18,32 +318,28 @@ EffectProcessor::Ptr EffectProcessorChain::insertInternal (const Type& valueOrRe
 
     if (auto pluginInstance = factory->createPlugin (valueOrRef))
     {
-        pluginInstance->setPlayHead (getPlayHead());
-        pluginInstance->prepareToPlay (getSampleRate(), getBlockSize());
-
         auto effect = std::make_shared<EffectProcessor> (std::move (pluginInstance), factory->createPluginDescription (valueOrRef));
+        prepareEffect (*effect);
 
+        editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
         {
-            const ScopedLock sl (getCallbackLock());
-
             if (insertionStyle == InsertionStyle::append
-                || ! isPositiveAndBelow (destinationIndex, getNumEffects()))
+                || ! isPositiveAndBelow (destinationIndex, (int) effects.size()))
             {
-                plugins.emplace_back (effect);
+                effects.emplace_back (effect);
             }
             else if (insertionStyle == InsertionStyle::insert)
             {
-                plugins.insert (plugins.begin() + (size_t) destinationIndex, effect);
+                effects.insert (effects.begin() + (size_t) destinationIndex, effect);
             }
             else
             {
-                plugins[(size_t) destinationIndex] = effect;
+                effects[(size_t) destinationIndex] = effect;
             }
 
-            updateLatency();
-        }
+            return true;
+        });
 
-        updateHostDisplay();
         return effect;
     }
 
@@ -58,20 +354,72 @@ EffectProcessor::Ptr EffectProcessorChain::insertNewEffect (const String& source
 EffectProcessor::Ptr EffectProcessorChain::replaceEffect (int source, int dest)             { return insertInternal (source, dest, InsertionStyle::replace); }
 EffectProcessor::Ptr EffectProcessorChain::replaceEffect (const String& source, int dest)   { return insertInternal (source, dest, InsertionStyle::replace); }
 
+void EffectProcessorChain::insertNewEffectsAsync (const Array<PluginDescription>& descriptions, int destinationIndex,
+                                                  EffectsInsertedCallback callback)
+{
+    if (factory == nullptr)
+    {
+        jassertfalse;
+        return;
+    }
+
+    const auto sampleRate = getSampleRate();
+    const auto blockSize = getBlockSize();
+    WeakReference<EffectProcessorChain> weakThis (this);
+
+    factory->createPluginsAsync (descriptions, sampleRate, blockSize,
+        [weakThis, descriptions, destinationIndex, callback, sampleRate, blockSize] (EffectProcessorFactory::PluginInstances instances)
+        {
+            auto* chain = weakThis.get();
+            if (chain == nullptr)
+                return;
+
+            // The plugins only need preparing again if the chain was re-prepared in the meantime:
+            const auto needsPreparing = chain->getSampleRate() != sampleRate || chain->getBlockSize() != blockSize;
+            std::vector<EffectProcessor::Ptr> newEffects;
+
+            for (size_t i = 0; i < instances.size(); ++i)
+            {
+                if (instances[i] != nullptr)
+                {
+                    auto effect = std::make_shared<EffectProcessor> (std::move (instances[i]), descriptions.getReference ((int) i));
+                    chain->prepareEffect (*effect, needsPreparing);
+                    newEffects.push_back (effect);
+                }
+            }
+
+            chain->editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
+            {
+                if (newEffects.empty())
+                    return false;
+
+                const auto index = isPositiveAndBelow (destinationIndex, (int) effects.size())
+                                    ? destinationIndex
+                                    : (int) effects.size();
+
+                effects.insert (effects.begin() + (size_t) index, newEffects.begin(), newEffects.end());
+                return true;
+            });
+
+            if (callback != nullptr)
+                callback (newEffects);
+        });
+}
+
 //==============================================================================
 bool EffectProcessorChain::moveEffect (int pluginIndex, int destinationIndex)
 {
-    bool changed = false;
-
+    return editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        const ScopedLock sl (getCallbackLock());
-        changed = moveItem (plugins, pluginIndex, std::clamp (destinationIndex, 0, getNumEffects()));
-    }
+        const auto numEffects = (int) effects.size();
 
-    if (changed)
-        updateHostDisplay();
+        if (! isPositiveAndBelow (pluginIndex, numEffects))
+            return false;
 
-    return changed;
+        destinationIndex = std::clamp (destinationIndex, 0, numEffects - 1);
+        return destinationIndex != pluginIndex
+            && moveItem (effects, pluginIndex, destinationIndex);
+    });
 }
 
 bool EffectProcessorChain::moveEffect (int pluginIndex, PluginPositionPreset destinationPosition)
@@ -83,73 +431,54 @@ bool EffectProcessorChain::moveEffect (int pluginIndex, PluginPositionPreset des
         default: break;
     };
 
-    bool changed = false;
-
+    return editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        const ScopedLock sl (getCallbackLock());
+        if (! isPositiveAndBelow (pluginIndex, (int) effects.size()))
+            return false;
 
         switch (destinationPosition)
         {
-            case PluginPositionPreset::shiftToFirst:    changed = moveItemToFront (plugins, pluginIndex); break;
-            case PluginPositionPreset::shiftToLast:     changed = moveItemToBack (plugins, pluginIndex); break;
+            case PluginPositionPreset::shiftToFirst:    return moveItemToFront (effects, pluginIndex);
+            case PluginPositionPreset::shiftToLast:     return moveItemToBack (effects, pluginIndex);
             default:                                    jassertfalse; break;
         };
-    }
-
-    if (changed)
-        updateHostDisplay();
 
-    return changed;
+        return false;
+    });
 }
 
 //==============================================================================
 int EffectProcessorChain::getNumEffects() const
 {
-    const ScopedLock sl (getCallbackLock());
+    const ScopedLock sl (editLock);
     return static_cast<int> (plugins.size());
 }
 
 bool EffectProcessorChain::removeEffect (int index)
 {
-    bool changed = false;
-
+    return editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        const ScopedLock sl (getCallbackLock());
-        changed = removeItem (plugins, index);
-        updateLatency();
-    }
-
-    if (changed)
-        updateHostDisplay();
-
-    return changed;
+        return isPositiveAndBelow (index, (int) effects.size())
+            && removeItem (effects, index);
+    });
 }
 
 bool EffectProcessorChain::clear()
 {
-    bool changed = false;
-
+    return editEffects ([] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        const ScopedLock sl (getCallbackLock());
-        changed = ! plugins.empty();
-
-        if (changed)
-        {
-            plugins.clear();
-            updateLatency(); // Doing this here to avoid doubly locking.
-        }
-    }
+        if (effects.empty())
+            return false;
 
-    if (changed)
-        updateHostDisplay();
-
-    return changed;
+        effects.clear();
+        return true;
+    });
 }
 
 //==============================================================================
 EffectProcessor::Ptr EffectProcessorChain::getEffectProcessor (int index) const
 {
-    const ScopedLock sl (getCallbackLock());
+    const ScopedLock sl (editLock);
 
     if (isPositiveAndBelow (index, getNumEffects()))
         return plugins[(size_t) index];
@@ -190,7 +519,7 @@ SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (bool) EffectProcessorChain::isBypassed (int
 
 SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (float) EffectProcessorChain::getMixLevel (int index) const
 {
-    return getEffectProperty<float> (index, [&] (EffectProcessor::Ptr e) { return e->mixLevel.getTargetValue(); });
+    return getEffectProperty<float> (index, [&] (EffectProcessor::Ptr e) { return e->getMixLevel(); });
 }
 
 SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (juce::Point<int>) EffectProcessorChain::getLastUIPosition (int index) const
@@ -205,22 +534,37 @@ SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (bool) EffectProcessorChain::isPluginMissing
 
 bool EffectProcessorChain::loadIfMissing (int index)
 {
-    const ScopedLock sl (getCallbackLock());
-
-    if (isPositiveAndBelow (index, getNumEffects())
-        && isPluginMissing (index))
+    auto effect = getEffectProcessor (index);
+
+    if (factory == nullptr || effect == nullptr || ! effect->isMissing())
+        return false;
+
+    auto pluginInstance = factory->createPlugin (effect->description);
+    if (pluginInstance == nullptr)
+        return false;
+
+    // The audio thread may still be looking at the missing effect,
+    // so swap in a brand new one rather than changing the existing one.
+    auto newEffect = std::make_shared<EffectProcessor> (std::move (pluginInstance), effect->description);
+    newEffect->name = effect->name;
+    newEffect->isBypassed = effect->isBypassed.load();
+    newEffect->setMixLevel (effect->getMixLevel());
+    prepareEffect (*newEffect);
+    newEffect->lastUIPosition = effect->lastUIPosition;
+    newEffect->lastKnownBase64State = effect->lastKnownBase64State;
+    newEffect->parallelGroup = effect->parallelGroup;
+    newEffect->branchIndex = effect->branchIndex;
+    newEffect->reloadFromStateIfValid();
+
+    return editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        if (auto effect = plugins[(size_t) index])
-        {
-            const InternalProcessor::ScopedBypass sb (*this);
+        if (! isPositiveAndBelow (index, (int) effects.size())
+            || effects[(size_t) index] != effect)
+            return false;
 
-            effect->plugin = factory->createPlugin (effect->description);
-            effect->reloadFromStateIfValid();
-            return true;
-        }
-    }
-
-    return false;
+        effects[(size_t) index] = newEffect;
+        return true;
+    });
 }
 
 //==============================================================================
@@ -228,7 +572,7 @@ bool EffectProcessorChain::setEffectProperty (int index, std::function<void (Eff
 {
     jassert (func != nullptr);
 
-    const ScopedLock sl (getCallbackLock());
+    const ScopedLock sl (editLock);
 
     if (auto effect = getEffectProcessor (index))
     {
@@ -251,75 +595,481 @@ bool EffectProcessorChain::setBypass (int index, bool bypass)
 
 bool EffectProcessorChain::setMixLevel (int index, float mixLevel)
 {
-    return setEffectProperty (index, [&] (EffectProcessor::Ptr e) { e->mixLevel = mixLevel; });
+    return setEffectProperty (index, [&] (EffectProcessor::Ptr e) { e->setMixLevel (mixLevel); });
 }
 
-//==============================================================================
-void EffectProcessorChain::prepareToPlay (const double sampleRate, const int estimatedSamplesPerBlock)
+SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (EffectProcessorStatistics::Summary) EffectProcessorChain::getEffectStatistics (int index) const
 {
-    setRateAndBufferSizeDetails (sampleRate, estimatedSamplesPerBlock);
+    return getEffectProperty<EffectProcessorStatistics::Summary> (index, [] (EffectProcessor::Ptr e) { return e->statistics.getSummary(); });
+}
 
-    const auto numChans = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels(), 1);
+void EffectProcessorChain::resetEffectStatistics()
+{
+    const ScopedLock sl (editLock);
 
-    const ScopedLock sl (getCallbackLock());
+    for (auto& effect : plugins)
+        if (effect != nullptr)
+            effect->statistics.reset();
+}
 
-    floatBuffers.prepare (numChans, estimatedSamplesPerBlock);
-    doubleBuffers.prepare (numChans, estimatedSamplesPerBlock);
+bool EffectProcessorChain::setParallelBranch (int index, int parallelGroup, int branchIndex)
+{
+    parallelGroup = jmax (-1, parallelGroup);
+    branchIndex = jmax (0, branchIndex);
 
-    for (auto effect : plugins)
+    return editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        if (effect != nullptr)
+        if (! isPositiveAndBelow (index, (int) effects.size()))
+            return false;
+
+        auto effect = effects[(size_t) index];
+
+        if (effect == nullptr
+            || (effect->parallelGroup == parallelGroup && effect->branchIndex == branchIndex))
+            return false;
+
+        effect->parallelGroup = parallelGroup;
+        effect->branchIndex = branchIndex;
+        return true;
+    });
+}
+
+SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (int) EffectProcessorChain::getParallelGroup (int index) const
+{
+    return getEffectProperty<int> (index, [] (EffectProcessor::Ptr e) { return e->parallelGroup; });
+}
+
+SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (int) EffectProcessorChain::getBranchIndex (int index) const
+{
+    return getEffectProperty<int> (index, [] (EffectProcessor::Ptr e) { return e->branchIndex; });
+}
+
+std::vector<EffectProcessorChain::BranchTiming> EffectProcessorChain::getBranchTimings() const
+{
+    std::vector<BranchTiming> timings;
+
+    const ScopedLock sl (editLock);
+
+    for (const auto& stage : createRenderStages (plugins))
+    {
+        for (const auto& branch : stage.branches)
         {
-            if (auto plugin = effect->plugin)
-            {
-                plugin->setPlayHead (getPlayHead());
-                plugin->prepareToPlay (sampleRate, estimatedSamplesPerBlock);
-            }
+            if (branch.timingSlot < 0)
+                continue;
+
+            const auto& timer = branchTimers[(size_t) branch.timingSlot];
+
+            BranchTiming timing;
+            timing.parallelGroup = stage.parallelGroup;
+            timing.branchIndex = branch.branchIndex;
+            timing.lastMs = Time::highResolutionTicksToSeconds (timer.lastTicks.load (std::memory_order_relaxed)) * 1000.0;
+            timing.peakMs = Time::highResolutionTicksToSeconds (timer.peakTicks.load (std::memory_order_relaxed)) * 1000.0;
+            timings.push_back (timing);
         }
     }
 
-    updateLatency();
+    return timings;
 }
 
-void EffectProcessorChain::updateLatency()
+void EffectProcessorChain::resetBranchTimings()
 {
-    updateChannelCount();
+    for (auto& timer : branchTimers)
+    {
+        timer.lastTicks.store (0, std::memory_order_relaxed);
+        timer.peakTicks.store (0, std::memory_order_relaxed);
+    }
+}
 
-    // N.B.: This probably isn't accurate at all (@todo ?)
-    for (auto effect : plugins)
-        if (auto plugin = effect->plugin)
-            setLatencySamples (getLatencySamples() + plugin->getLatencySamples());
+//==============================================================================
+void EffectProcessorChain::setSilenceThreshold (float newThresholdDecibels) noexcept
+{
+    silenceThreshold.store (Decibels::decibelsToGain (newThresholdDecibels), std::memory_order_relaxed);
 }
 
-void EffectProcessorChain::updateChannelCount()
+float EffectProcessorChain::getSilenceThreshold() const noexcept
 {
-    int newRequiredChannels = 0;
+    return Decibels::gainToDecibels (silenceThreshold.load (std::memory_order_relaxed));
+}
 
-    for (auto effect : plugins)
-        newRequiredChannels = jmax (newRequiredChannels, effect->description.numInputChannels, effect->description.numOutputChannels);
+//==============================================================================
+void EffectProcessorChain::prepareToPlay (const double sampleRate, const int estimatedSamplesPerBlock)
+{
+    setRateAndBufferSizeDetails (sampleRate, estimatedSamplesPerBlock);
 
-    requiredChannels = newRequiredChannels;
+    const ScopedLock sl (editLock);
+
+    // NB: The host won't be processing while this is happening,
+    //     so it's safe to touch the effects that are in use here.
+    for (auto& effect : plugins)
+        if (effect != nullptr)
+            prepareEffect (*effect);
+
+    // Republishing so as to size the snapshot's buffers to the new block size:
+    publishSnapshot();
+}
+
+void EffectProcessorChain::prepareEffect (EffectProcessor& effect, bool preparePlugin)
+{
+    effect.mixLevel.reset (getSampleRate(), 0.05);
+    effect.mixLevel.setCurrentAndTargetValue (effect.getMixLevel());
+    effect.numSilentSamples = 0;
+    effect.isAsleep = false;
+
+    if (auto plugin = effect.plugin)
+    {
+        plugin->setPlayHead (getPlayHead());
+        plugin->setNonRealtime (isNonRealtime());
+
+        if (preparePlugin)
+            plugin->prepareToPlay (getSampleRate(), getBlockSize());
+    }
 }
 
 //==============================================================================
+namespace ChainMixing
+{
+    /** Mixes a processed signal with its dry counterpart, in place and in a single pass. */
+    template<typename FloatType>
+    inline void mix (FloatType* wet, const FloatType* dry, const FloatType* gains, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            wet[i] = dry[i] + (wet[i] - dry[i]) * gains[i];
+    }
+
+    /** Mixes a processed signal with its dry counterpart, in place and in a single pass. */
+    template<typename FloatType>
+    inline void mix (FloatType* wet, const FloatType* dry, FloatType gain, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            wet[i] = dry[i] + (wet[i] - dry[i]) * gain;
+    }
+
+    /** @returns true if none of the buffer's samples go above the threshold. */
+    template<typename FloatType>
+    inline bool isSilent (const juce::AudioBuffer<FloatType>& buffer, FloatType threshold) noexcept
+    {
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+            if (buffer.getMagnitude (i, 0, buffer.getNumSamples()) > threshold)
+                return false;
+
+        return true;
+    }
+}
+
 template<typename FloatType>
-void EffectProcessorChain::processInternal (juce::AudioBuffer<FloatType>& source,
-                                            MidiBuffer& midiMessages,
-                                            BufferPackage<FloatType>& bufferPackage,
-                                            const int numChannels,
-                                            const int numSamples)
+void EffectProcessorChain::processEffect (EffectProcessor& effect,
+                                          juce::AudioBuffer<FloatType>& buffer,
+                                          BufferPackage<FloatType>& bufferPackage,
+                                          MidiBuffer& midiMessages,
+                                          AudioDelayLine<FloatType>* dryDelay)
+{
+    const auto numChannels = buffer.getNumChannels();
+    const auto numSamples = buffer.getNumSamples();
+
+    auto& mixLevel = effect.mixLevel;
+    mixLevel.setTargetValue (effect.getMixLevel());
+
+    // Fully wet effects don't need the dry signal at all,
+    // though its delay line must be kept going in case the mix level changes:
+    if (! mixLevel.isSmoothing() && mixLevel.getTargetValue() >= 1.0f)
+    {
+        if (dryDelay != nullptr)
+            dryDelay->push (buffer, numChannels, numSamples);
+
+        effect.process (buffer, midiMessages);
+        return;
+    }
+
+    auto& dryBuffer = bufferPackage.dryBuffer;
+    jassert (dryBuffer.getNumChannels() >= numChannels && dryBuffer.getNumSamples() >= numSamples);
+
+    for (int i = 0; i < numChannels; ++i)
+        dryBuffer.copyFrom (i, 0, buffer, i, 0, numSamples);
+
+    // Lining the dry signal up with the effect's delayed output, to avoid comb filtering:
+    if (dryDelay != nullptr)
+        dryDelay->process (dryBuffer, numChannels, numSamples);
+
+    effect.process (buffer, midiMessages);
+
+    if (mixLevel.isSmoothing())
+    {
+        auto* gains = bufferPackage.mixGains.data();
+
+        for (int i = 0; i < numSamples; ++i)
+            gains[i] = static_cast<FloatType> (mixLevel.getNextValue());
+
+        for (int i = 0; i < numChannels; ++i)
+            ChainMixing::mix (buffer.getWritePointer (i), dryBuffer.getReadPointer (i), gains, numSamples);
+    }
+    else
+    {
+        const auto gain = static_cast<FloatType> (mixLevel.getTargetValue());
+
+        for (int i = 0; i < numChannels; ++i)
+            ChainMixing::mix (buffer.getWritePointer (i), dryBuffer.getReadPointer (i), gain, numSamples);
+    }
+}
+
+template<typename FloatType>
+void EffectProcessorChain::processSlot (const RenderSlot& slot,
+                                        juce::AudioBuffer<FloatType>& buffer,
+                                        BufferPackage<FloatType>& bufferPackage,
+                                        MidiBuffer& midiMessages)
+{
+    auto& effect = *slot.effect;
+
+    if (effect.isMissing())
+        return;
+
+    const auto latency = jmax (0, effect.plugin->getLatencySamples());
+    AudioDelayLine<FloatType>* delay = nullptr;
+
+    if (slot.latencyCompensation != nullptr)
+    {
+        // NB: This gets clamped if the delay line is too short, until a bigger one gets published.
+        delay = &slot.latencyCompensation->getDelayLine (FloatType());
+        delay->setDelay (latency);
+    }
+
+    // Growing the delay lines and telling the host both have to happen away from the audio thread:
+    if (latency != slot.latencySamples)
+        latencyChanged.store (true, std::memory_order_relaxed);
+
+    if (! effect.canBeProcessed())
+    {
+        if (delay != nullptr)
+            delay->process (buffer); // Stands in for the bypassed effect so that the chain's latency stays put.
+
+        return;
+    }
+
+    if (updateSleepState (effect, buffer, midiMessages, latency, delay))
+    {
+        buffer.clear();
+        effect.statistics.addSkippedBlock();
+        return;
+    }
+
+    processEffect (effect, buffer, bufferPackage, midiMessages, delay);
+}
+
+template<typename FloatType>
+bool EffectProcessorChain::updateSleepState (EffectProcessor& effect,
+                                             const juce::AudioBuffer<FloatType>& buffer,
+                                             const MidiBuffer& midiMessages,
+                                             int latencySamples,
+                                             AudioDelayLine<FloatType>* delay)
+{
+    const auto threshold = silenceThreshold.load (std::memory_order_relaxed);
+
+    // Sleeping effects need a louder signal to wake them back up, so they don't flutter on and off around the threshold:
+    const auto wakeThreshold = effect.isAsleep ? threshold * 2.0f : threshold;
+
+    if (! sleepingEnabled.load (std::memory_order_relaxed)
+        || ! midiMessages.isEmpty()
+        || ! ChainMixing::isSilent (buffer, static_cast<FloatType> (wakeThreshold)))
+    {
+        effect.numSilentSamples = 0;
+        effect.isAsleep = false;
+        return false;
+    }
+
+    if (effect.isAsleep)
+        return true;
+
+    const auto tailSeconds = effect.plugin->getTailLengthSeconds();
+
+    if (! std::isfinite (tailSeconds))
+        return false;
+
+    // NB: Only the blocks before this one count, since this one may still hold the end of the tail.
+    const auto numSamplesToWait = (int64) std::ceil ((jmax (0.0, tailSeconds) + sleepHoldSeconds) * getSampleRate())
+                                + latencySamples;
+
+    if (effect.numSilentSamples < numSamplesToWait)
+    {
+        effect.numSilentSamples += buffer.getNumSamples();
+        return false;
+    }
+
+    // The dry signal must not come back from before the effect fell asleep:
+    if (delay != nullptr)
+        delay->clear();
+
+    effect.isAsleep = true;
+    return true;
+}
+
+template<typename FloatType>
+struct EffectProcessorChain::ParallelRenderContext final
+{
+    EffectProcessorChain& chain;
+    const RenderStage& stage;
+    ChainSnapshot& snapshot;
+    juce::AudioBuffer<FloatType>& buffer;
+    MidiBuffer& midiMessages;
+    BufferPackage<FloatType>& bufferPackage;
+};
+
+template<typename FloatType>
+void EffectProcessorChain::renderBranch (void* rawContext, int branchIndex)
+{
+    const auto startTicks = Time::getHighResolutionTicks();
+    const ScopedNoDenormals snd;
+
+    auto& context = *static_cast<ParallelRenderContext<FloatType>*> (rawContext);
+    const auto& branch = context.stage.branches[(size_t) branchIndex];
+
+    // The first branch works directly on the chain's buffer and MIDI:
+    auto* buffer = &context.buffer;
+    auto* bufferPackage = &context.bufferPackage;
+    auto* midiMessages = &context.midiMessages;
+
+    if (branchIndex > 0)
+    {
+        bufferPackage = context.snapshot.getBranchBuffers (FloatType())[(size_t) branchIndex - 1].get();
+        midiMessages = &context.snapshot.branchMidiBuffers[(size_t) branchIndex - 1];
+        buffer = &bufferPackage->mixingBuffer;
+    }
+
+    for (const auto& slot : branch.slots)
+        context.chain.processSlot (slot, *buffer, *bufferPackage, *midiMessages);
+
+    if (branch.alignment != nullptr)
+    {
+        auto& alignment = branch.alignment->getDelayLine (FloatType());
+        alignment.setDelay (branch.alignmentSamples);
+        alignment.process (*buffer);
+    }
+
+    if (isPositiveAndBelow (branch.timingSlot, maxNumTimedBranches))
+    {
+        auto& timer = context.chain.branchTimers[(size_t) branch.timingSlot];
+        const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+
+        timer.lastTicks.store (elapsedTicks, std::memory_order_relaxed);
+
+        if (elapsedTicks > timer.peakTicks.load (std::memory_order_relaxed))
+            timer.peakTicks.store (elapsedTicks, std::memory_order_relaxed);
+    }
+}
+
+template<typename FloatType>
+void EffectProcessorChain::renderParallelStage (const RenderStage& stage,
+                                                juce::AudioBuffer<FloatType>& buffer,
+                                                MidiBuffer& midiMessages,
+                                                ChainSnapshot& snapshot,
+                                                BufferPackage<FloatType>& bufferPackage)
+{
+    const auto numChannels = buffer.getNumChannels();
+    const auto numSamples = buffer.getNumSamples();
+    const auto numBranches = (int) stage.branches.size();
+    auto& branchBuffers = snapshot.getBranchBuffers (FloatType());
+
+    // Every branch gets the same input, so this must happen before the first branch starts changing it:
+    for (int b = 1; b < numBranches; ++b)
+    {
+        auto& branchBuffer = branchBuffers[(size_t) b - 1]->mixingBuffer;
+
+        // NB: Rather than referring to it, which allocates for more than 32 channels, the branch gets its buffer
+        //     shrunk down to the size of the block, which never reallocates.
+        branchBuffer.setSize (numChannels, numSamples, false, false, true);
+
+        for (int i = 0; i < numChannels; ++i)
+            branchBuffer.copyFrom (i, 0, buffer, i, 0, numSamples);
+
+        auto& branchMidi = snapshot.branchMidiBuffers[(size_t) b - 1];
+        branchMidi.clear();
+        branchMidi.addEvents (midiMessages, 0, -1, 0);
+    }
+
+    ParallelRenderContext<FloatType> context { *this, stage, snapshot, buffer, midiMessages, bufferPackage };
+
+    // NB: The workers are shared with every other chain, so this renders on its own whenever they're busy.
+    if (snapshot.workerPool == nullptr
+        || ! snapshot.workerPool->tryRun (&renderBranch<FloatType>, &context, numBranches))
+    {
+        for (int b = 0; b < numBranches; ++b)
+            renderBranch<FloatType> (&context, b);
+    }
+
+    // Merging the branches:
+    for (int b = 1; b < numBranches; ++b)
+        for (int i = 0; i < numChannels; ++i)
+            buffer.addFrom (i, 0, branchBuffers[(size_t) b - 1]->mixingBuffer, i, 0, numSamples);
+}
+
+template<typename FloatType>
+void EffectProcessorChain::processStages (juce::AudioBuffer<FloatType>& buffer,
+                                          MidiBuffer& midiMessages,
+                                          ChainSnapshot& snapshot,
+                                          BufferPackage<FloatType>& bufferPackage)
+{
+    for (const auto& stage : snapshot.stages)
+    {
+        if (stage.parallelGroup >= 0)
+        {
+            renderParallelStage (stage, buffer, midiMessages, snapshot, bufferPackage);
+            continue;
+        }
+
+        for (const auto& branch : stage.branches)
+            for (const auto& slot : branch.slots)
+                processSlot (slot, buffer, bufferPackage, midiMessages);
+    }
+}
+
+template<typename FloatType>
+void EffectProcessorChain::processInPlace (juce::AudioBuffer<FloatType>& source,
+                                           MidiBuffer& midiMessages,
+                                           ChainSnapshot& snapshot,
+                                           BufferPackage<FloatType>& bufferPackage)
+{
+    const auto numChannels = source.getNumChannels();
+    const auto numSamples = source.getNumSamples();
+
+    if (numChannels >= snapshot.requiredChannels)
+    {
+        processStages (source, midiMessages, snapshot, bufferPackage);
+        return;
+    }
+
+    // Some effect wants more channels than the host provided,
+    // so the whole chain gets processed in a scratch buffer instead.
+    // NB: This only ever shrinks it from the size it was prepared with, so it never reallocates.
+    auto& workBuffer = bufferPackage.workBuffer;
+    workBuffer.setSize (snapshot.requiredChannels, numSamples, false, false, true);
+    workBuffer.clear();
+
+    for (int i = 0; i < numChannels; ++i)
+        workBuffer.copyFrom (i, 0, source, i, 0, numSamples);
+
+    // Copying mono to stereo, as per addFrom():
+    if (numChannels == 1)
+        workBuffer.copyFrom (1, 0, source, 0, 0, numSamples);
+
+    processStages (workBuffer, midiMessages, snapshot, bufferPackage);
+
+    for (int i = 0; i < numChannels; ++i)
+        source.copyFrom (i, 0, workBuffer, i, 0, numSamples);
+}
+
+template<typename FloatType>
+void EffectProcessorChain::processCopying (juce::AudioBuffer<FloatType>& source,
+                                           MidiBuffer& midiMessages,
+                                           const ChainSnapshot& snapshot,
+                                           BufferPackage<FloatType>& bufferPackage,
+                                           const int numChannels,
+                                           const int numSamples)
 {
-    // Uses requiredChannels to ensure enough memory is allocated for the plugin to
-    // potentially read from/write to - avoids bad accesses.
-    // We only care about the main outputs, so still use the numChannels variable throughout
-    bufferPackage.prepare (requiredChannels, numSamples);
     bufferPackage.clear();
 
-    const auto channels = jmin (numChannels, requiredChannels.load());
+    const auto channels = jmin (numChannels, snapshot.requiredChannels);
 
     addFrom (bufferPackage.mixingBuffer, source, channels, numSamples);
 
-    for (auto effect : plugins)
+    for (const auto& effect : snapshot.effects)
     {
         if (effect == nullptr || ! effect->canBeProcessed())
             continue;
@@ -328,18 +1078,19 @@ void EffectProcessorChain::processInternal (juce::AudioBuffer<FloatType>& source
         bufferPackage.effectBuffer.clear();
         addFrom (bufferPackage.effectBuffer, bufferPackage.mixingBuffer, channels, numSamples);
 
-        processSafely (*effect->plugin, bufferPackage.effectBuffer, midiMessages);
+        effect->process (bufferPackage.effectBuffer, midiMessages);
 
         // Add the effect-saturated samples at the specified mix level:
-        const auto mixLevel = effect->mixLevel.getNextValue();
+        effect->mixLevel.setTargetValue (effect->getMixLevel());
+        const auto mixLevel = effect->mixLevel.skip (numSamples);
         jassert (isPositiveAndBelow (mixLevel, 1.00001f));
 
         bufferPackage.lastBuffer.clear();
         addFrom (bufferPackage.lastBuffer, bufferPackage.effectBuffer, channels, numSamples, mixLevel);
 
-        // Add the original samples, at a percentage of the original gain, if the effect level isn't 100%:
+        // Add the original samples, at the remaining percentage of the original gain, if the effect level isn't 100%:
         if (mixLevel < 1.0f)
-            addFrom (bufferPackage.lastBuffer, bufferPackage.mixingBuffer, channels, numSamples, mixLevel);
+            addFrom (bufferPackage.lastBuffer, bufferPackage.mixingBuffer, channels, numSamples, 1.0f - mixLevel);
 
         // Copy the result:
         bufferPackage.mixingBuffer.clear();
@@ -350,44 +1101,96 @@ void EffectProcessorChain::processInternal (juce::AudioBuffer<FloatType>& source
     addFrom (source, bufferPackage.mixingBuffer, channels, numSamples);
 }
 
-bool EffectProcessorChain::isWholeChainBypassed() const
+bool EffectProcessorChain::isWholeChainBypassed (const ChainSnapshot& snapshot) const
 {
-    size_t numBypassedPlugins = 0;
-
-    for (auto effect : plugins)
-        if (effect == nullptr || ! effect->canBeProcessed())
-            ++numBypassedPlugins;
+    for (const auto& effect : snapshot.effects)
+        if (effect != nullptr && effect->canBeProcessed())
+            return false;
 
-    return numBypassedPlugins == plugins.size();
+    return true;
 }
 
 template<typename FloatType>
-void EffectProcessorChain::process (juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages, BufferPackage<FloatType>& package)
+void EffectProcessorChain::process (juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
 {
     if (InternalProcessor::isBypassed())
         return;
 
-    const GenericScopedTryLock<CriticalSection> sl (getCallbackLock());
-    const auto numChannels = jmin ((int) 2, buffer.getNumChannels());
+    const ScopedSnapshotReader reader (*this);
+    const auto numChannels = buffer.getNumChannels();
     const auto numSamples = buffer.getNumSamples();
 
-    if (sl.isLocked()
-        && ! plugins.empty()
-        && numChannels > 0
-        && numSamples > 0
-        && ! isWholeChainBypassed())
+    if (reader.snapshot == nullptr
+        || reader.snapshot->effects.empty()
+        || numChannels <= 0
+        || numSamples <= 0
+        || (reader.snapshot->latencySamples == 0 && isWholeChainBypassed (*reader.snapshot)))
+    {
+        return;
+    }
+
+    auto& snapshot = *reader.snapshot;
+    auto& bufferPackage = snapshot.getBuffers (FloatType());
+    const auto maxNumChannels = bufferPackage.mixingBuffer.getNumChannels();
+    const auto maxNumSamples = bufferPackage.mixingBuffer.getNumSamples();
+
+    const auto processFitting = [&] (juce::AudioBuffer<FloatType>& fitting, MidiBuffer& fittingMidi)
+    {
+        if (getProcessingMode() == ProcessingMode::copying)
+            processCopying (fitting, fittingMidi, snapshot, bufferPackage, jmin ((int) 2, fitting.getNumChannels()), fitting.getNumSamples());
+        else
+            processInPlace (fitting, fittingMidi, snapshot, bufferPackage);
+    };
+
+    if (numChannels <= maxNumChannels && numSamples <= maxNumSamples)
     {
-        processInternal (buffer, midiMessages, package, numChannels, numSamples);
+        processFitting (buffer, midiMessages);
+        return;
+    }
+
+    // The buffers were all sized for what the host promised in prepareToPlay, and must not be reallocated here.
+    // So, any channels past the promised ones get left as they are...
+    jassert (numChannels <= maxNumChannels);
+
+    // ... and blocks that are larger than promised get split up into ones that fit:
+    auto& chunk = bufferPackage.chunkBuffer;
+    auto& chunkMidi = snapshot.chunkMidiMessages;
+    auto& processedMidi = snapshot.processedMidiMessages;
+    const auto numChunkChannels = jmin (numChannels, maxNumChannels);
+    processedMidi.clear();
+
+    for (int start = 0; start < numSamples; start += maxNumSamples)
+    {
+        const auto numChunkSamples = jmin (maxNumSamples, numSamples - start);
+
+        // NB: This only ever shrinks it from the size it was prepared with, so it never reallocates.
+        chunk.setSize (numChunkChannels, numChunkSamples, false, false, true);
+
+        for (int i = 0; i < numChunkChannels; ++i)
+            chunk.copyFrom (i, 0, buffer, i, start, numChunkSamples);
+
+        chunkMidi.clear();
+        chunkMidi.addEvents (midiMessages, start, numChunkSamples, -start);
+
+        processFitting (chunk, chunkMidi);
+
+        for (int i = 0; i < numChunkChannels; ++i)
+            buffer.copyFrom (i, start, chunk, i, 0, numChunkSamples);
+
+        processedMidi.addEvents (chunkMidi, 0, numChunkSamples, start);
     }
+
+    midiMessages.clear();
+    midiMessages.addEvents (processedMidi, 0, -1, 0);
 }
 
-void EffectProcessorChain::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer& midiMessages)  { process<float> (buffer, midiMessages, floatBuffers); }
-void EffectProcessorChain::processBlock (juce::AudioBuffer<double>& buffer, MidiBuffer& midiMessages) { process<double> (buffer, midiMessages, doubleBuffers); }
+void EffectProcessorChain::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer& midiMessages)  { process<float> (buffer, midiMessages); }
+void EffectProcessorChain::processBlock (juce::AudioBuffer<double>& buffer, MidiBuffer& midiMessages) { process<double> (buffer, midiMessages); }
 
 //==============================================================================
 double EffectProcessorChain::getTailLengthSeconds() const
 {
-    const ScopedLock sl (getCallbackLock());
+    const ScopedLock sl (editLock);
     auto largestTailLength = 0.0;
 
     for (auto effect : plugins)
@@ -399,6 +1202,17 @@ double EffectProcessorChain::getTailLengthSeconds() const
 }
 
 void EffectProcessorChain::releaseResources()           { loopThroughEffectsAndCall<&AudioProcessor::releaseResources>(); }
+
+void EffectProcessorChain::setNonRealtime (bool shouldBeNonRealtime) noexcept
+{
+    InternalProcessor::setNonRealtime (shouldBeNonRealtime);
+
+    const ScopedLock sl (editLock);
+
+    for (auto& effect : plugins)
+        if (effect != nullptr && effect->plugin != nullptr)
+            effect->plugin->setNonRealtime (shouldBeNonRealtime);
+}
 void EffectProcessorChain::reset()                      { loopThroughEffectsAndCall<&AudioProcessor::reset>(); }
 void EffectProcessorChain::numChannelsChanged()         { loopThroughEffectsAndCall<&AudioProcessor::numChannelsChanged>(); }
 void EffectProcessorChain::numBusesChanged()            { loopThroughEffectsAndCall<&AudioProcessor::numBusesChanged>(); }
@@ -422,121 +1236,286 @@ namespace ChainIds
     CREATE_ATTRIBUTE (effectUIX)
     CREATE_ATTRIBUTE (effectUIY)
     CREATE_ATTRIBUTE (effectState)
+    CREATE_ATTRIBUTE (effectParallelGroup)
+    CREATE_ATTRIBUTE (effectBranchIndex)
 
     #undef CREATE_ATTRIBUTE
 }
 
-void EffectProcessorChain::getStateInformation (MemoryBlock& destData)
+/** The chunks of the binary state format.
+
+    The state starts with the magic number and the version, followed by a series of chunks.
+    Each chunk is made of its identifier, its size in bytes as a 64-bit integer, and then its contents.
+    Every effect chunk is followed by a chunk with the raw state of its plugin.
+*/
+namespace ChainBinaryFormat
 {
-    XmlElement effectChainElement (getIdentifier().toString());
-    effectChainElement.setAttribute (ChainIds::rootBypassed, InternalProcessor::isBypassed() ? 1 : 0);
+    static constexpr int magicNumber    = 0x48435053; // "SPCH"
+    static constexpr int currentVersion = 1;
 
-    for (auto effect : plugins)
-        if (effect != nullptr)
-            effectChainElement.addChildElement (createElementForEffect (effect));
+    static constexpr int headerChunk    = 0x44414548; // "HEAD": root bypass, number of effects.
+    static constexpr int effectChunk    = 0x54434645; // "EFCT": name, bypass, mix, UI position, group, branch, description.
+    static constexpr int stateChunk     = 0x54415453; // "STAT": the raw state of the preceding effect's plugin.
 
-    AudioProcessor::copyXmlToBinary (effectChainElement, destData);
+    static constexpr int chunkHeaderSize        = 12; // The chunk ID, followed by the 64-bit size of the chunk.
+    static constexpr int minimumEffectChunkSize = 23; // 2 empty strings, a bool, a float and 4 ints.
 }
 
-XmlElement* EffectProcessorChain::createElementForEffect (EffectProcessor::Ptr effect)
+void EffectProcessorChain::writeState (OutputStream& output)
 {
-    if (effect == nullptr)
+    using namespace ChainBinaryFormat;
+
+    const auto writeChunk = [&output] (int chunkId, const void* data, size_t numBytes)
     {
-        jassertfalse;
-        return nullptr;
-    }
+        output.writeInt (chunkId);
+        output.writeInt64 ((int64) numBytes);
+        output.write (data, numBytes);
+    };
+
+    output.writeInt (magicNumber);
+    output.writeInt (currentVersion);
+
+    const ScopedLock sl (editLock);
 
-    auto* effectElement = new XmlElement (ChainIds::effectRoot);
-    effectElement->setAttribute (ChainIds::effectName, effect->name);
-    effectElement->setAttribute (ChainIds::effectBypassed, effect->isBypassed ? 1 : 0);
-    effectElement->setAttribute (ChainIds::effectMixLevel, std::clamp (effect->mixLevel.getTargetValue(), 0.0f, 1.0f));
-    effectElement->setAttribute (ChainIds::effectUIX, effect->lastUIPosition.x);
-    effectElement->setAttribute (ChainIds::effectUIY, effect->lastUIPosition.y);
-    effectElement->addChildElement (effect->description.createXml().release());
+    MemoryOutputStream chunk (256);
+    chunk.writeBool (InternalProcessor::isBypassed());
+    chunk.writeInt ((int) plugins.size());
+    writeChunk (headerChunk, chunk.getData(), chunk.getDataSize());
 
+    for (auto& effect : plugins)
     {
-        MemoryBlock m;
-        effect->plugin->getStateInformation (m);
-        effectElement->createNewChildElement (ChainIds::effectState)->addTextElement (Base64::toBase64 (m.getData(), m.getSize()));
+        if (effect == nullptr)
+            continue;
+
+        chunk.reset();
+        chunk.writeString (effect->name);
+        chunk.writeBool (effect->isBypassed.load());
+        chunk.writeFloat (std::clamp (effect->getMixLevel(), 0.0f, 1.0f));
+        chunk.writeInt (effect->lastUIPosition.x);
+        chunk.writeInt (effect->lastUIPosition.y);
+        chunk.writeInt (effect->parallelGroup);
+        chunk.writeInt (effect->branchIndex);
+        chunk.writeString (effect->getDescriptionAsXml());
+        writeChunk (effectChunk, chunk.getData(), chunk.getDataSize());
+
+        if (effect->isMissing())
+        {
+            // Holding on to whatever state the missing plugin was last known to have:
+            MemoryOutputStream lastKnownState;
+            Base64::convertFromBase64 (lastKnownState, effect->lastKnownBase64State);
+            writeChunk (stateChunk, lastKnownState.getData(), lastKnownState.getDataSize());
+        }
+        else
+        {
+            const auto& pluginState = effect->getPluginState();
+            writeChunk (stateChunk, pluginState.getData(), pluginState.getSize());
+        }
     }
+}
+
+void EffectProcessorChain::getStateInformation (MemoryBlock& destData)
+{
+    destData.reset();
 
-    return effectElement;
+    MemoryOutputStream output (destData, false);
+    writeState (output);
 }
 
 //==============================================================================
-void EffectProcessorChain::setStateInformation (const void* const data, const int sizeInBytes)
+bool EffectProcessorChain::readBinaryState (const void* const data, const int sizeInBytes,
+                                            bool& rootBypassed, std::vector<EffectState>& effectStates)
 {
-    clear();
-    InternalProcessor::setBypass (false); // To reset back to a normal state
+    using namespace ChainBinaryFormat;
+
+    if (data == nullptr || sizeInBytes < 8)
+        return false;
 
-    const ScopedBypass sb (*this);
+    MemoryInputStream input (data, (size_t) sizeInBytes, false);
 
-    if (! MessageManager::getInstance()->isThisTheMessageThread())
+    if (input.readInt() != magicNumber)
+        return false;
+
+    const auto version = input.readInt();
+
+    // Was this state saved by a newer version?
+    jassert (version <= currentVersion);
+    ignoreUnused (version);
+
+    while (input.getNumBytesRemaining() >= chunkHeaderSize)
     {
-        /** All supported 3rd-party plugin formats (ie: VST2, VST3, AU, RTAS),
-            for various reasons, require being created on the message thread!
-            Restructure your code to make it so!
-        */
-        jassertfalse;
-        return;
+        const auto chunkId = input.readInt();
+        const auto numBytes = input.readInt64();
+
+        if (numBytes < 0 || numBytes > input.getNumBytesRemaining())
+        {
+            jassertfalse; // Corrupt or truncated state!
+            break;
+        }
+
+        const auto* chunkData = static_cast<const char*> (data) + input.getPosition();
+        input.skipNextBytes (numBytes);
+
+        MemoryInputStream chunk (chunkData, (size_t) numBytes, false);
+
+        if (chunkId == headerChunk)
+        {
+            rootBypassed = chunk.readBool();
+
+            // NB: The number of effects can't be trusted any more than the rest of the data,
+            //     so this never reserves for more effects than the remaining bytes could hold.
+            const auto maxNumEffects = input.getNumBytesRemaining() / (chunkHeaderSize + minimumEffectChunkSize);
+            effectStates.reserve ((size_t) jlimit ((int64) 0, maxNumEffects, (int64) chunk.readInt()));
+        }
+        else if (chunkId == effectChunk)
+        {
+            EffectState state;
+            state.name = chunk.readString();
+            state.isBypassed = chunk.readBool();
+            state.mixLevel = chunk.readFloat();
+            state.lastUIPosition.x = chunk.readInt();
+            state.lastUIPosition.y = chunk.readInt();
+            state.parallelGroup = chunk.readInt();
+            state.branchIndex = chunk.readInt();
+
+            const auto description = parseXML (chunk.readString());
+
+            if (description == nullptr || ! state.description.loadFromXml (*description))
+            {
+                jassertfalse;
+                continue;
+            }
+
+            effectStates.push_back (std::move (state));
+        }
+        else if (chunkId == stateChunk)
+        {
+            if (! effectStates.empty())
+                effectStates.back().pluginState.replaceWith (chunkData, (size_t) numBytes);
+        }
+
+        // NB: Any other chunk must be from a newer version, so gets skipped.
     }
 
+    return true;
+}
+
+bool EffectProcessorChain::readXmlState (const void* const data, const int sizeInBytes,
+                                         bool& rootBypassed, std::vector<EffectState>& effectStates)
+{
     auto chainElement = AudioProcessor::getXmlFromBinary (data, sizeInBytes);
 
-    if (chainElement != nullptr && chainElement->getTagName() == getIdentifier().toString())
-    {
-        InternalProcessor::setBypass (chainElement->getBoolAttribute (ChainIds::rootBypassed));
+    if (chainElement == nullptr || chainElement->getTagName() != "EffectProcessorChain")
+        return false;
 
-        for (auto* e : chainElement->getChildWithTagNameIterator (ChainIds::effectRoot))
-            createEffectProcessorFromXML (e);
+    rootBypassed = chainElement->getBoolAttribute (ChainIds::rootBypassed);
 
-        updateLatency();
-    }
-    else
+    for (auto* e : chainElement->getChildWithTagNameIterator (ChainIds::effectRoot))
     {
-        jassertfalse;
+        EffectState state;
+        auto* pdState = e->getChildByName ("PLUGIN");
+
+        if (pdState == nullptr || ! state.description.loadFromXml (*pdState))
+        {
+            jassertfalse;
+            continue;
+        }
+
+        state.name = e->getStringAttribute (ChainIds::effectName, String()).trim();
+        state.isBypassed = e->getBoolAttribute (ChainIds::effectBypassed);
+        state.mixLevel = (float) e->getDoubleAttribute (ChainIds::effectMixLevel, 1.0);
+        state.lastUIPosition.x = e->getIntAttribute (ChainIds::effectUIX);
+        state.lastUIPosition.y = e->getIntAttribute (ChainIds::effectUIY);
+        state.parallelGroup = e->getIntAttribute (ChainIds::effectParallelGroup, -1);
+        state.branchIndex = e->getIntAttribute (ChainIds::effectBranchIndex, 0);
+
+        if (const auto* const pluginState = e->getChildByName (ChainIds::effectState))
+        {
+            MemoryOutputStream decoded (state.pluginState, false);
+            Base64::convertFromBase64 (decoded, pluginState->getAllSubText());
+        }
+
+        effectStates.push_back (std::move (state));
     }
+
+    return true;
 }
 
-EffectProcessor::Ptr EffectProcessorChain::createEffectProcessorFromXML (XmlElement* const effectXML)
+void EffectProcessorChain::setStateInformation (const void* const data, const int sizeInBytes)
 {
-    if (effectXML == nullptr)
-    {
-        jassertfalse;
-        return {};
-    }
+    bool rootBypassed = false;
+    std::vector<EffectState> effectStates;
 
-    auto* pdState = effectXML->getChildByName ("PLUGIN");
-    if (pdState == nullptr)
+    // Older versions of the chain saved their state as XML:
+    if (! readBinaryState (data, sizeInBytes, rootBypassed, effectStates)
+        && ! readXmlState (data, sizeInBytes, rootBypassed, effectStates))
     {
         jassertfalse;
-        return {};
+        return;
     }
 
-    PluginDescription description;
-    if (! description.loadFromXml (*pdState))
-    {
-        jassertfalse;
-        return {};
-    }
+    restoreEffects (effectStates, rootBypassed);
+}
+
+void EffectProcessorChain::restoreEffects (const std::vector<EffectState>& effectStates, bool rootBypassed)
+{
+    Array<PluginDescription> descriptions;
+
+    for (const auto& state : effectStates)
+        descriptions.add (state.description);
+
+    /** All of the plugins get created and prepared in one batch, concurrently where their formats allow it.
 
-    if (auto newEffect = insertInternal (description, -1, InsertionStyle::append))
+        All supported 3rd-party plugin formats (ie: VST2, VST3, AU, RTAS),
+        for various reasons, require being created on the message thread!
+        If this isn't the message thread, the factory waits on it to create those.
+    */
+    auto instances = factory != nullptr
+                        ? factory->createPlugins (descriptions, getSampleRate(), getBlockSize())
+                        : EffectProcessorFactory::PluginInstances (effectStates.size());
+
+    std::vector<EffectProcessor::Ptr> newEffects;
+    newEffects.reserve (effectStates.size());
+
+    for (size_t i = 0; i < effectStates.size(); ++i)
+        newEffects.push_back (createEffectProcessorFromState (effectStates[i], std::move (instances[i])));
+
+    // Swapping in all of the restored effects at once, so the audio thread never sees a partially restored chain:
+    editEffects ([&] (std::vector<EffectProcessor::Ptr>& effects)
     {
-        newEffect->plugin->getStateInformation (newEffect->defaultState);
+        effects = std::move (newEffects);
+        return true;
+    });
+
+    InternalProcessor::setBypass (rootBypassed);
+}
 
-        if (const auto* const state = effectXML->getChildByName (ChainIds::effectState))
+EffectProcessor::Ptr EffectProcessorChain::createEffectProcessorFromState (const EffectState& state,
+                                                                           std::shared_ptr<AudioPluginInstance> plugin)
+{
+    // NB: Effects whose plugin couldn't be created are kept around as missing effects.
+    auto newEffect = std::make_shared<EffectProcessor> (std::move (plugin), state.description);
+
+    if (state.pluginState.getSize() > 0)
+    {
+        if (newEffect->isMissing())
         {
-            newEffect->lastKnownBase64State = state->getAllSubText();
-            newEffect->reloadFromStateIfValid();
+            newEffect->lastKnownBase64State = Base64::toBase64 (state.pluginState.getData(), state.pluginState.getSize());
+        }
+        else
+        {
+            newEffect->plugin->setStateInformation (state.pluginState.getData(), (int) state.pluginState.getSize());
+            newEffect->markStateDirty();
         }
-
-        newEffect->name = effectXML->getStringAttribute (ChainIds::effectName, String()).trim();
-        newEffect->mixLevel = (float) std::clamp (effectXML->getDoubleAttribute (ChainIds::effectMixLevel, 1.0), 0.0, 1.0);
-        newEffect->isBypassed = effectXML->getBoolAttribute (ChainIds::effectBypassed);
-        newEffect->lastUIPosition.x = effectXML->getIntAttribute (ChainIds::effectUIX);
-        newEffect->lastUIPosition.y = effectXML->getIntAttribute (ChainIds::effectUIY);
-        return newEffect;
     }
 
-    return {};
+    newEffect->name = state.name.trim();
+    newEffect->setMixLevel (state.mixLevel);
+    newEffect->isBypassed = state.isBypassed;
+    newEffect->lastUIPosition = state.lastUIPosition;
+    newEffect->parallelGroup = jmax (-1, state.parallelGroup);
+    newEffect->branchIndex = jmax (0, state.branchIndex);
+
+    // The factory already prepared the plugin:
+    prepareEffect (*newEffect, false);
+    return newEffect;
 }
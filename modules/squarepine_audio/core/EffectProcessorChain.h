@@ -1,8 +1,30 @@
 /** Contains an array of effect plugins that connect to each other in series.
 
+    Edits to the chain (inserting, moving, removing, etc...) never block the audio thread.
+    Instead, every edit builds an immutable snapshot of the chain on the calling thread,
+    which then gets published to the audio thread with a single atomic pointer swap.
+    Snapshots that have been replaced are kept alive until the audio thread is known
+    to have stopped using them, and are then destroyed away from the audio thread.
+
+    The latency of the effects is compensated for: the dry signal of effects that
+    aren't fully wet gets delayed to line up with their output, bypassed effects
+    get replaced by a delay of the same length, and the shorter branches of
+    parallel groups get delayed to line up with the longest one.
+    When an effect changes its latency, the chain adapts to it right away using
+    delay lines that were allocated ahead of time, and then reports its new latency
+    to the host from the message thread.
+
+    Effects whose input has gone silent are put to sleep once their tail and latency
+    have played out, and are then skipped until their input comes back.
+    See setSleepingEnabled() for the details.
+
+    @warning This assumes that the processBlock methods are only ever called
+             from a single thread at a time, which is what any sane host does.
+
     @see EffectProcessor, EffectProcessorFactory
 */
-class EffectProcessorChain final : public InternalProcessor
+class EffectProcessorChain final : public InternalProcessor,
+                                   private Timer
 {
 public:
     //==============================================================================
@@ -19,6 +41,9 @@ public:
     */
     EffectProcessorChain (std::shared_ptr<EffectProcessorFactory> factory);
 
+    /** Destructor. */
+    ~EffectProcessorChain() override;
+
     //==============================================================================
     /** @returns the current number of effect processors in this chain. */
     int getNumEffects() const;
@@ -93,6 +118,23 @@ public:
     */
     EffectProcessor::Ptr replaceEffect (const String& fileOrIdentifier, int destinationIndex);
 
+    //==============================================================================
+    /** */
+    using EffectsInsertedCallback = std::function<void (std::vector<EffectProcessor::Ptr>)>;
+
+    /** Creates and prepares a batch of effects in the background, and then inserts all of them at once.
+
+        The effects that couldn't be created are left out.
+
+        @param descriptions     The plugins to create effects for.
+        @param destinationIndex Where to insert the effects, or -1 to append them.
+        @param callback         Called on the message thread with the effects that were inserted.
+
+        @see EffectProcessorFactory::createPluginsAsync
+    */
+    void insertNewEffectsAsync (const Array<PluginDescription>& descriptions, int destinationIndex,
+                                EffectsInsertedCallback callback = nullptr);
+
     //==============================================================================
     /** Enumeration that automates and simplifies reordering a plugin in a chain of plugins. */
     enum class PluginPositionPreset
@@ -183,9 +225,8 @@ public:
 
     /** Obtain the plugin instance of a contained effect.
 
-        This isn't very safe to use, unless you lock using the processor's callback lock
-        around the pointer instance to get anything out of it or change its properties.
-        But doing that should generate really ugly noise because it will block the audio thread!
+        This isn't very safe to use: the audio thread may be processing the
+        plugin instance at the same time as you're changing its properties!
 
         @param index Index of the desired plugin.
 
@@ -216,6 +257,65 @@ public:
     */
     SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (juce::Point<int>) getLastUIPosition (int index) const;
 
+    //==============================================================================
+    /** @returns a summary of how the effect at the specified index has been performing lately,
+                 including its processing times, denormal flushes and reported latency.
+                 This can be called from any thread.
+    */
+    SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (EffectProcessorStatistics::Summary) getEffectStatistics (int index) const;
+
+    /** Forgets about the performance of all of the effects up until now. */
+    void resetEffectStatistics();
+
+    //==============================================================================
+    /** Moves an effect into a branch of a parallel group.
+
+        Neighbouring effects that share the same parallel group get split into
+        branches by their branch index. Every branch of a group is fed the same input,
+        the branches are rendered concurrently on a pool of worker threads
+        that every chain shares, and the outputs of all of the branches are then summed together.
+        Whenever another chain has the workers, the branches get rendered one after the other.
+
+        Only the first branch of a group receives and produces MIDI;
+        the other branches are given a copy of the incoming MIDI.
+
+        @param index            Index within the array of plugins.
+        @param parallelGroup    The parallel group to join, or -1 to process the effect in series.
+        @param branchIndex      The branch within the parallel group.
+
+        @returns true if anything changed.
+    */
+    bool setParallelBranch (int index, int parallelGroup, int branchIndex);
+
+    /** @returns the parallel group of the effect at the specified index,
+                 which is -1 if it's processed in series.
+    */
+    SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (int) getParallelGroup (int index) const;
+
+    /** @returns the branch within its parallel group of the effect at the specified index. */
+    SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (int) getBranchIndex (int index) const;
+
+    /** The time taken to render a branch of a parallel group. */
+    struct BranchTiming final
+    {
+        int parallelGroup = -1;     //< The parallel group that the branch belongs to.
+        int branchIndex = 0;        //< The branch within the parallel group.
+        double lastMs = 0.0;        //< The time taken to render the last block, in milliseconds.
+        double peakMs = 0.0;        //< The longest time taken to render a block, in milliseconds.
+    };
+
+    /** @returns the timings of every branch of every parallel group, in the order they get rendered.
+
+        Only the first maxNumTimedBranches branches get timed.
+    */
+    std::vector<BranchTiming> getBranchTimings() const;
+
+    /** Resets the peak timings of all of the branches. */
+    void resetBranchTimings();
+
+    /** The maximum number of branches, across all parallel groups, that will be timed. */
+    static constexpr int maxNumTimedBranches = 32;
+
     //==============================================================================
     /** @returns true if the effect's plugin is missing.
 
@@ -228,11 +328,69 @@ public:
 
     /** Attempt loading an effect's plugin instance if it is known to be missing.
 
-        @note This will bypass the entire effect chain until the action of
-              attempting to load a plugin is complete!
+        If the plugin could be created, the effect at the provided index
+        will be replaced with a new one that shares the previous effect's properties.
     */
     bool loadIfMissing (int index);
 
+    //==============================================================================
+    /** The ways in which the chain can route audio through its effects. */
+    enum class ProcessingMode
+    {
+        /** Copies the incoming audio into internal buffers, and copies it
+            around between each effect before copying the result back out.
+            Only the first 2 channels get processed, parallel groups
+            are flattened and processed in series, and the latency
+            of the effects isn't compensated for.
+        */
+        copying,
+
+        /** Processes the effects directly on the incoming buffer, only keeping
+            a copy of the dry signal around for effects that aren't fully wet.
+            All of the incoming channels get processed, and parallel groups
+            are rendered concurrently.
+        */
+        inPlace
+    };
+
+    /** Changes the way audio is routed through the effects.
+        This can be safely called at any time, from any thread.
+    */
+    void setProcessingMode (ProcessingMode newMode) noexcept { processingMode.store (newMode, std::memory_order_relaxed); }
+
+    /** @returns the way audio is currently routed through the effects. */
+    ProcessingMode getProcessingMode() const noexcept { return processingMode.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Lets effects sleep while their input is silent, which is the default.
+
+        Once an effect's input has stayed below the silence threshold for as long as
+        the effect's tail, its latency and sleepHoldSeconds put together, the effect
+        stops being processed and its output is cleared instead. It wakes back up as
+        soon as its input rises 6 dB above the threshold, or when it receives MIDI.
+        Effects that report an infinite tail never sleep.
+
+        The number of blocks that each effect slept through gets counted in its statistics.
+        Only applies to ProcessingMode::inPlace.
+
+        This can be safely called at any time, from any thread.
+
+        @see getEffectStatistics, setSilenceThreshold
+    */
+    void setSleepingEnabled (bool shouldBeEnabled) noexcept { sleepingEnabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+
+    /** @returns true if effects are allowed to sleep while their input is silent. */
+    bool isSleepingEnabled() const noexcept { return sleepingEnabled.load (std::memory_order_relaxed); }
+
+    /** Changes the level, in decibels, below which an effect's input is considered silent. */
+    void setSilenceThreshold (float newThresholdDecibels) noexcept;
+
+    /** @returns the level, in decibels, below which an effect's input is considered silent. */
+    float getSilenceThreshold() const noexcept;
+
+    /** How long an effect's input must stay silent for, on top of its tail and latency, before it can sleep. */
+    static constexpr double sleepHoldSeconds = 0.1;
+
     //==============================================================================
     /** @internal */
     void reset() override;
@@ -247,6 +405,8 @@ public:
     /** @internal */
     void releaseResources() override;
     /** @internal */
+    void setNonRealtime (bool) noexcept override;
+    /** @internal */
     void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
     /** @internal */
     void processBlock (juce::AudioBuffer<double>&, MidiBuffer&) override;
@@ -262,9 +422,35 @@ public:
     bool acceptsMidi() const override;
     /** @internal */
     bool producesMidi() const override;
-    /** @internal */
+    /** Writes the chain's state to a stream, in a compact binary format.
+
+        The format is versioned, and is made of length-prefixed chunks so that
+        chunks unknown to older versions can be skipped. The plugins' states are
+        written as is, and each of them is only asked of its plugin if the plugin
+        reported a change since it was last asked.
+
+        @see getStateInformation, EffectProcessor::getPluginState
+    */
+    void writeState (OutputStream& output);
+
+    /** Gets the chain's state in the binary format used by writeState().
+
+        @see writeState
+    */
     void getStateInformation (MemoryBlock&) override;
-    /** @internal */
+    /** Restores the chain's effects from a state created by getStateInformation(),
+        or from the XML based format that older versions used.
+
+        All of the plugins are created and prepared first, concurrently where their
+        formats allow it, while the existing effects carry on processing.
+        The restored effects then replace the existing ones all at once.
+
+        This can be called from any thread, but plugins whose formats must be created
+        on the message thread get handed over to it, and this waits for them, so don't
+        call it from a thread that the message thread might be blocked on.
+
+        @see loadIfMissing
+    */
     void setStateInformation (const void*, int) override;
 
 private:
@@ -285,21 +471,187 @@ private:
             for (auto& buff : buffers)
                 buff->setSize (numChannels, numSamples, false, true, true);
 
+            mixGains.resize ((size_t) numSamples);
             clear();
         }
 
-        Buffer mixingBuffer, effectBuffer, lastBuffer;
-        std::array<Buffer*, 3> buffers = { &mixingBuffer, &effectBuffer, &lastBuffer };
+        /** Sets aside the room for the blocks that don't fit the chain as they are, which only the chain's own package needs. */
+        void prepareScratch (int numChannels, int numSamples)
+        {
+            workBuffer.setSize (numChannels, numSamples, false, true, true);
+            chunkBuffer.setSize (numChannels, numSamples, false, true, true);
+        }
+
+        Buffer mixingBuffer, effectBuffer, lastBuffer, dryBuffer;
+        std::array<Buffer*, 4> buffers = { &mixingBuffer, &effectBuffer, &lastBuffer, &dryBuffer };
+        std::vector<FloatType> mixGains;
+
+        // NB: Blocks get copied into these rather than referred to, since referring to more than 32 channels allocates.
+        Buffer workBuffer;  //< For blocks with fewer channels than the effects need.
+        Buffer chunkBuffer; //< For the pieces of blocks with more samples than the chain was prepared for.
     };
 
     //==============================================================================
-    std::shared_ptr<EffectProcessorFactory> factory;
-    std::vector<EffectProcessor::Ptr> plugins;
+    /** An effect, along with the delay lines that compensate for its latency. */
+    struct RenderSlot final
+    {
+        EffectProcessor* effect = nullptr;
+        EffectLatencyCompensation* latencyCompensation = nullptr;
+        int latencySamples = 0;             //< The latency of the effect when the snapshot was created.
+    };
 
-    std::atomic<int> requiredChannels { 0 };
+    /** A series of effects that get processed one after the other. */
+    struct RenderBranch final
+    {
+        std::vector<RenderSlot> slots;
+        int branchIndex = 0;
+        int timingSlot = -1;
+        int latencySamples = 0;             //< The total latency of the effects in the branch.
+        int alignmentSamples = 0;           //< How far the branch falls short of the longest branch of its stage.
+        std::shared_ptr<EffectLatencyCompensation> alignment; //< Lines the branch up with the longest branch of its stage.
+    };
+
+    /** A set of branches that are fed the same input, and whose outputs are summed.
+
+        Effects that are processed in series are gathered into a stage of a single branch.
+    */
+    struct RenderStage final
+    {
+        std::vector<RenderBranch> branches;
+        int parallelGroup = -1;
+        int latencySamples = 0;             //< The latency of the longest branch.
+    };
+
+    /** The worker threads that the parallel stages of every chain share.
+
+        Only one chain can have the workers at a time, so a chain that finds them busy
+        renders its branches on its own thread instead of waiting its turn.
+    */
+    struct SharedWorkerPool final
+    {
+        SharedWorkerPool() :
+            pool (jlimit (0, maxNumWorkers, SystemStats::getNumCpus() - 1))
+        {
+        }
+
+        /** @returns false if the workers were busy, in which case none of the jobs were performed. */
+        bool tryRun (RealtimeWorkerPool::Job job, void* context, int numJobs) noexcept
+        {
+            if (busy.exchange (true, std::memory_order_acquire))
+                return false;
+
+            pool.run (job, context, numJobs);
+            busy.store (false, std::memory_order_release);
+            return true;
+        }
+
+        static constexpr int maxNumWorkers = 8;
 
-    BufferPackage<float> floatBuffers;
-    BufferPackage<double> doubleBuffers;
+        RealtimeWorkerPool pool;
+        std::atomic<bool> busy { false };
+    };
+
+    /** The timings of a branch, which outlive any snapshot. */
+    struct BranchTimer final
+    {
+        std::atomic<int64> lastTicks { 0 }, peakTicks { 0 };
+    };
+
+    /** An immutable view of the chain, as used by the audio thread.
+
+        Everything the audio thread needs is allocated up front, so the
+        audio thread only ever reads from one of these and never has to
+        touch the reference counts of the contained effects.
+    */
+    struct ChainSnapshot final
+    {
+        template<typename FloatType>
+        using BranchBuffers = std::vector<std::unique_ptr<BufferPackage<FloatType>>>;
+
+        std::vector<EffectProcessor::Ptr> effects;
+        std::vector<RenderStage> stages;
+        std::vector<std::shared_ptr<EffectLatencyCompensation>> latencyCompensations;
+        int requiredChannels = 0;
+        int latencySamples = 0;
+        BufferPackage<float> floatBuffers;
+        BufferPackage<double> doubleBuffers;
+
+        // For splitting up the MIDI of any block that's larger than the buffers were prepared for:
+        MidiBuffer chunkMidiMessages, processedMidiMessages;
+
+        // Scratch space for every branch but the first one of a parallel group:
+        BranchBuffers<float> floatBranchBuffers;
+        BranchBuffers<double> doubleBranchBuffers;
+        std::vector<MidiBuffer> branchMidiBuffers;
+        SharedWorkerPool* workerPool = nullptr;
+
+        BufferPackage<float>& getBuffers (float) noexcept               { return floatBuffers; }
+        BufferPackage<double>& getBuffers (double) noexcept             { return doubleBuffers; }
+        BranchBuffers<float>& getBranchBuffers (float) noexcept         { return floatBranchBuffers; }
+        BranchBuffers<double>& getBranchBuffers (double) noexcept       { return doubleBranchBuffers; }
+    };
+
+    /** Everything needed to restore an effect, as read from either of the state formats. */
+    struct EffectState final
+    {
+        PluginDescription description;
+        String name;
+        bool isBypassed = false;
+        float mixLevel = 1.0f;
+        juce::Point<int> lastUIPosition;
+        int parallelGroup = -1;
+        int branchIndex = 0;
+        MemoryBlock pluginState;
+    };
+
+    /** A snapshot that was replaced, along with the audio thread's epoch at the time. */
+    struct RetiredSnapshot final
+    {
+        std::unique_ptr<ChainSnapshot> snapshot;
+        uint64 epoch = 0;
+    };
+
+    /** Marks the audio thread as using the live snapshot for the duration of a block.
+
+        The epoch is odd while the audio thread is inside a block, and even otherwise.
+    */
+    class ScopedSnapshotReader final
+    {
+    public:
+        ScopedSnapshotReader (EffectProcessorChain& c) noexcept :
+            chain (c)
+        {
+            chain.audioThreadEpoch.fetch_add (1);
+            snapshot = chain.liveSnapshot.load();
+        }
+
+        ~ScopedSnapshotReader() noexcept
+        {
+            chain.audioThreadEpoch.fetch_add (1);
+        }
+
+        ChainSnapshot* snapshot = nullptr;
+
+    private:
+        EffectProcessorChain& chain;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedSnapshotReader)
+    };
+
+    //==============================================================================
+    std::shared_ptr<EffectProcessorFactory> factory;
+
+    CriticalSection editLock;                           //< Guards the editable list of effects and the retired snapshots.
+    std::vector<EffectProcessor::Ptr> plugins;          //< The editable list of effects, which is never seen by the audio thread.
+    std::atomic<ChainSnapshot*> liveSnapshot { nullptr };
+    std::atomic<uint64> audioThreadEpoch { 0 };
+    std::vector<RetiredSnapshot> retiredSnapshots;
+    std::atomic<ProcessingMode> processingMode { ProcessingMode::inPlace };
+    std::unique_ptr<SharedResourcePointer<SharedWorkerPool>> workerPool; //< Only taken up once the chain has a parallel stage.
+    std::array<BranchTimer, maxNumTimedBranches> branchTimers;
+    std::atomic<bool> latencyChanged { false };        //< Set by the audio thread when an effect's latency no longer matches the snapshot.
+    std::atomic<bool> sleepingEnabled { true };
+    std::atomic<float> silenceThreshold { Decibels::decibelsToGain (-90.0f) }; //< As a gain.
 
     //==============================================================================
     enum class InsertionStyle
@@ -309,19 +661,62 @@ private:
         replace
     };
 
-    bool isWholeChainBypassed() const;
-    void updateLatency();
-    void updateChannelCount();
-    XmlElement* createElementForEffect (EffectProcessor::Ptr effect);
-    EffectProcessor::Ptr createEffectProcessorFromXML (XmlElement* state);
+    bool isWholeChainBypassed (const ChainSnapshot&) const;
+    int getRequiredNumChannels() const;
+    void updateLatencyCompensation();
+    std::unique_ptr<ChainSnapshot> createSnapshot() const;
+    void publishSnapshot();
+    void purgeRetiredSnapshots();
+    bool editEffects (std::function<bool (std::vector<EffectProcessor::Ptr>&)> edit);
+    static bool readBinaryState (const void* data, int sizeInBytes, bool& rootBypassed, std::vector<EffectState>& effectStates);
+    static bool readXmlState (const void* data, int sizeInBytes, bool& rootBypassed, std::vector<EffectState>& effectStates);
+    void restoreEffects (const std::vector<EffectState>& effectStates, bool rootBypassed);
+    EffectProcessor::Ptr createEffectProcessorFromState (const EffectState& state, std::shared_ptr<AudioPluginInstance> plugin);
     bool setEffectProperty (int index, std::function<void (EffectProcessor::Ptr)> func);
 
     template<typename FloatType>
-    void process (juce::AudioBuffer<FloatType>&, MidiBuffer&, BufferPackage<FloatType>&);
+    void process (juce::AudioBuffer<FloatType>&, MidiBuffer&);
+
+    void prepareEffect (EffectProcessor& effect, bool preparePlugin = true);
+    static std::vector<RenderStage> createRenderStages (const std::vector<EffectProcessor::Ptr>& effects);
+
+    template<typename FloatType>
+    struct ParallelRenderContext;
 
     template<typename FloatType>
-    void processInternal (juce::AudioBuffer<FloatType>& source, MidiBuffer& midiMessages,
-                          BufferPackage<FloatType>& bufferPackage, int numChannels, int numSamples);
+    static void renderBranch (void* context, int branchIndex);
+
+    template<typename FloatType>
+    void renderParallelStage (const RenderStage& stage, juce::AudioBuffer<FloatType>& buffer,
+                              MidiBuffer& midiMessages, ChainSnapshot& snapshot,
+                              BufferPackage<FloatType>& bufferPackage);
+
+    template<typename FloatType>
+    void processCopying (juce::AudioBuffer<FloatType>& source, MidiBuffer& midiMessages,
+                         const ChainSnapshot& snapshot, BufferPackage<FloatType>& bufferPackage,
+                         int numChannels, int numSamples);
+
+    template<typename FloatType>
+    void processInPlace (juce::AudioBuffer<FloatType>& source, MidiBuffer& midiMessages,
+                         ChainSnapshot& snapshot, BufferPackage<FloatType>& bufferPackage);
+
+    template<typename FloatType>
+    void processStages (juce::AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages,
+                        ChainSnapshot& snapshot, BufferPackage<FloatType>& bufferPackage);
+
+    template<typename FloatType>
+    void processSlot (const RenderSlot& slot, juce::AudioBuffer<FloatType>& buffer,
+                      BufferPackage<FloatType>& bufferPackage, MidiBuffer& midiMessages);
+
+    template<typename FloatType>
+    bool updateSleepState (EffectProcessor& effect, const juce::AudioBuffer<FloatType>& buffer,
+                           const MidiBuffer& midiMessages, int latencySamples,
+                           AudioDelayLine<FloatType>* delay);
+
+    template<typename FloatType>
+    static void processEffect (EffectProcessor& effect, juce::AudioBuffer<FloatType>& buffer,
+                               BufferPackage<FloatType>& bufferPackage, MidiBuffer& midiMessages,
+                               AudioDelayLine<FloatType>* dryDelay);
 
     template<typename Type>
     EffectProcessor::Ptr insertInternal (const Type& valueOrRef, int destinationIndex, InsertionStyle insertionStyle = InsertionStyle::insert);
@@ -329,7 +724,7 @@ private:
     template<typename Type>
     SQUAREPINE_OPTIONALLY_OPTIONAL_TYPE (Type) getEffectProperty (int index, std::function<Type (EffectProcessor::Ptr)> func) const
     {
-        const ScopedLock sl (getCallbackLock());
+        const ScopedLock sl (editLock);
 
         if (isPositiveAndBelow (index, getNumEffects()))
             if (auto effect = plugins[(size_t) index])
@@ -341,12 +736,19 @@ private:
     template<void (AudioProcessor::*function)()>
     void loopThroughEffectsAndCall()
     {
-        for (auto effect : plugins)
+        const ScopedLock sl (editLock);
+
+        for (auto& effect : plugins)
             if (effect != nullptr)
                 if (auto* plugin = effect->plugin.get())
                     (plugin->*function)();
     }
 
     //==============================================================================
+    /** @internal */
+    void timerCallback() override;
+
+    //==============================================================================
+    JUCE_DECLARE_WEAK_REFERENCEABLE (EffectProcessorChain)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectProcessorChain)
 };
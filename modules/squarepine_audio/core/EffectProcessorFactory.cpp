@@ -5,6 +5,19 @@ EffectProcessorFactory::EffectProcessorFactory (KnownPluginList& kpl) :
 
 EffectProcessorFactory::~EffectProcessorFactory()
 {
+    // The background jobs call into the subclass, which is already gone by now, so it's too late to stop them here
+    // without them reaching a pure virtual function. Subclasses must call stopCreatingPlugins() from their destructors!
+    jassert (creationThreads == nullptr);
+
+    stopCreatingPlugins();
+}
+
+void EffectProcessorFactory::stopCreatingPlugins()
+{
+    clearWarmPool();
+
+    const ScopedLock sl (creationThreadsLock);
+    creationThreads.reset();
 }
 
 //==============================================================================
@@ -33,8 +46,13 @@ std::shared_ptr<AudioPluginInstance> EffectProcessorFactory::createPlugin (const
     if (description.isInstrument)
         return nullptr;
 
-    String errorMessage;
-    return getAudioPluginFormatManager().createPluginInstance (description, 44100.0, 256, errorMessage);
+    if (auto instance = takeWarmInstance (description))
+        return instance;
+
+    if (canCreatePluginOnAnyThread (description))
+        return createPluginOnAnyThread (description);
+
+    return createPluginOnMessageThread (description);
 }
 
 std::shared_ptr<AudioPluginInstance> EffectProcessorFactory::createPlugin (const int listIndex) const
@@ -47,15 +65,128 @@ std::shared_ptr<AudioPluginInstance> EffectProcessorFactory::createPlugin (const
     return createPlugin (createPluginDescription (fileOrIdentifier));
 }
 
+std::shared_ptr<AudioPluginInstance> EffectProcessorFactory::createPluginOnMessageThread (const PluginDescription& description) const
+{
+    if (MessageManager::existsAndIsCurrentThread())
+    {
+        String errorMessage;
+        return getAudioPluginFormatManager().createPluginInstance (description, 44100.0, 256, errorMessage);
+    }
+
+    // Without a message thread to hand this over to, there's no way of creating the plugin at all!
+    if (MessageManager::getInstanceWithoutCreating() == nullptr)
+    {
+        jassertfalse;
+        return nullptr;
+    }
+
+    // NB: The state is shared with the message, in case the wait gets cut short by the message manager going away.
+    struct Creation final
+    {
+        std::shared_ptr<AudioPluginInstance> instance;
+        WaitableEvent finished;
+    };
+
+    auto creation = std::make_shared<Creation>();
+    WeakReference<EffectProcessorFactory> weakThis (const_cast<EffectProcessorFactory*> (this));
+
+    const auto posted = MessageManager::callAsync ([creation, weakThis, description]
+    {
+        if (weakThis != nullptr)
+            creation->instance = weakThis->createPluginOnMessageThread (description);
+
+        creation->finished.signal();
+    });
+
+    if (! posted)
+    {
+        jassertfalse;
+        return nullptr;
+    }
+
+    while (! creation->finished.wait (100))
+        if (MessageManager::getInstanceWithoutCreating() == nullptr)
+            return nullptr;
+
+    return creation->instance;
+}
+
+//==============================================================================
+AudioPluginFormat* EffectProcessorFactory::findFormatFor (const PluginDescription& description) const
+{
+    const auto& formatManager = getAudioPluginFormatManager();
+
+    for (int i = 0; i < formatManager.getNumFormats(); ++i)
+        if (auto* format = formatManager.getFormat (i))
+            if (format->getName() == description.pluginFormatName)
+                return format;
+
+    return nullptr;
+}
+
+bool EffectProcessorFactory::canCreatePluginOnAnyThread (const PluginDescription& description) const
+{
+    return dynamic_cast<InternalAudioPluginFormat*> (findFormatFor (description)) != nullptr;
+}
+
+std::unique_ptr<AudioPluginInstance> EffectProcessorFactory::createPluginOnAnyThread (const PluginDescription& description) const
+{
+    std::unique_ptr<AudioPluginInstance> result;
+
+    if (auto* format = dynamic_cast<InternalAudioPluginFormat*> (findFormatFor (description)))
+    {
+        // NB: The internal format calls back right away, on the calling thread.
+        format->createPluginInstance (description, 44100.0, 256,
+                                      [&result] (std::unique_ptr<AudioPluginInstance> instance, const String&)
+                                      {
+                                          result = std::move (instance);
+                                      });
+    }
+    else
+    {
+        // Override this for any other formats that can be created on any thread!
+        jassertfalse;
+    }
+
+    return result;
+}
+
+ThreadPool& EffectProcessorFactory::getCreationThreads() const
+{
+    const ScopedLock sl (creationThreadsLock);
+
+    if (creationThreads == nullptr)
+        creationThreads = std::make_unique<ThreadPool> (jlimit (1, 8, SystemStats::getNumCpus()));
+
+    return *creationThreads;
+}
+
+static void preparePluginInstance (AudioPluginInstance* instance, double sampleRate, int blockSize)
+{
+    if (instance != nullptr && sampleRate > 0.0 && blockSize > 0)
+        instance->prepareToPlay (sampleRate, blockSize);
+}
+
 //==============================================================================
 void EffectProcessorFactory::createPluginAsync (const PluginDescription& description, PluginCreationCallback callback)
 {
     if (description.isInstrument)
         return;
 
+    if (auto instance = takeWarmInstance (description))
+    {
+        MessageManager::callAsync ([instance, callback]
+        {
+            if (callback != nullptr)
+                callback (instance, {});
+        });
+
+        return;
+    }
+
     const_cast<AudioPluginFormatManager&> (getAudioPluginFormatManager())
         .createPluginInstanceAsync (description, 44100.0, 256,
-            [&] (std::unique_ptr<AudioPluginInstance> api, const String& s)
+            [callback] (std::unique_ptr<AudioPluginInstance> api, const String& s)
             {
                 if (callback != nullptr)
                     callback (std::move (api), s);
@@ -71,3 +202,252 @@ void EffectProcessorFactory::createPluginAsync (const String& fileOrIdentifier,
 {
     createPluginAsync (createPluginDescription (fileOrIdentifier), callback);
 }
+
+//==============================================================================
+EffectProcessorFactory::PluginInstances EffectProcessorFactory::createPlugins (const Array<PluginDescription>& descriptions,
+                                                                               double sampleRate, int blockSize)
+{
+    PluginInstances instances ((size_t) descriptions.size());
+
+    // This starts at 1 so that the batch can't finish before all of the jobs have been added:
+    std::atomic<int> numRemaining { 1 };
+    WaitableEvent finished;
+
+    for (int i = 0; i < descriptions.size(); ++i)
+    {
+        const auto& description = descriptions.getReference (i);
+
+        if (description.isInstrument)
+            continue;
+
+        auto instance = takeWarmInstance (description);
+
+        if (instance == nullptr && ! canCreatePluginOnAnyThread (description))
+        {
+            // Most plugin formats can only be created on the message thread, so this waits on it if need be:
+            instance = createPluginOnMessageThread (description);
+
+            if (instance == nullptr)
+                continue;
+        }
+
+        ++numRemaining;
+
+        // Whatever was created here still gets prepared in the background:
+        getCreationThreads().addJob ([&, i, instance]() mutable
+        {
+            if (instance == nullptr)
+                instance = createPluginOnAnyThread (descriptions.getReference (i));
+
+            preparePluginInstance (instance.get(), sampleRate, blockSize);
+            instances[(size_t) i] = std::move (instance);
+
+            if (--numRemaining == 0)
+                finished.signal();
+        });
+    }
+
+    if (--numRemaining > 0)
+        finished.wait();
+
+    return instances;
+}
+
+void EffectProcessorFactory::createPluginsAsync (const Array<PluginDescription>& descriptions, double sampleRate,
+                                                 int blockSize, BatchCreationCallback callback)
+{
+    struct Batch final
+    {
+        PluginInstances instances;
+        std::atomic<int> numRemaining { 1 };
+        BatchCreationCallback callback;
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->instances.resize ((size_t) descriptions.size());
+    batch->callback = std::move (callback);
+
+    const auto finishOne = [batch]
+    {
+        if (--batch->numRemaining == 0)
+        {
+            MessageManager::callAsync ([batch]
+            {
+                if (batch->callback != nullptr)
+                    batch->callback (std::move (batch->instances));
+            });
+        }
+    };
+
+    for (int i = 0; i < descriptions.size(); ++i)
+    {
+        const auto& description = descriptions.getReference (i);
+
+        if (description.isInstrument)
+            continue;
+
+        auto instance = takeWarmInstance (description);
+        ++batch->numRemaining;
+
+        if (instance == nullptr && ! canCreatePluginOnAnyThread (description))
+        {
+            const_cast<AudioPluginFormatManager&> (getAudioPluginFormatManager())
+                .createPluginInstanceAsync (description, 44100.0, 256,
+                    [batch, i, sampleRate, blockSize, finishOne] (std::unique_ptr<AudioPluginInstance> created, const String&)
+                    {
+                        std::shared_ptr<AudioPluginInstance> instance (std::move (created));
+                        preparePluginInstance (instance.get(), sampleRate, blockSize);
+                        batch->instances[(size_t) i] = std::move (instance);
+                        finishOne();
+                    });
+
+            continue;
+        }
+
+        getCreationThreads().addJob ([this, batch, i, description, instance, sampleRate, blockSize, finishOne]() mutable
+        {
+            if (instance == nullptr)
+                instance = createPluginOnAnyThread (description);
+
+            preparePluginInstance (instance.get(), sampleRate, blockSize);
+            batch->instances[(size_t) i] = std::move (instance);
+            finishOne();
+        });
+    }
+
+    finishOne();
+}
+
+//==============================================================================
+void EffectProcessorFactory::setWarmPoolSize (const PluginDescription& description, int numInstances)
+{
+    std::vector<std::shared_ptr<AudioPluginInstance>> surplus;
+
+    {
+        const ScopedLock sl (warmPoolLock);
+        const auto key = description.createIdentifierString();
+
+        if (numInstances <= 0)
+        {
+            auto pool = warmPools.find (key);
+
+            if (pool != warmPools.end())
+            {
+                surplus = std::move (pool->second.instances);
+                warmPools.erase (pool);
+            }
+        }
+        else
+        {
+            auto& pool = warmPools[key];
+            pool.targetSize = numInstances;
+
+            while ((int) pool.instances.size() > pool.targetSize)
+            {
+                surplus.push_back (std::move (pool.instances.back()));
+                pool.instances.pop_back();
+            }
+        }
+    }
+
+    refillWarmPool (description);
+}
+
+int EffectProcessorFactory::getNumWarmInstances (const PluginDescription& description) const
+{
+    const ScopedLock sl (warmPoolLock);
+
+    const auto pool = warmPools.find (description.createIdentifierString());
+    return pool != warmPools.end() ? (int) pool->second.instances.size() : 0;
+}
+
+void EffectProcessorFactory::clearWarmPool()
+{
+    std::map<String, WarmPool> pools;
+
+    {
+        const ScopedLock sl (warmPoolLock);
+        std::swap (pools, warmPools);
+    }
+
+    // NB: Destroying the instances outside of the lock.
+}
+
+std::shared_ptr<AudioPluginInstance> EffectProcessorFactory::takeWarmInstance (const PluginDescription& description) const
+{
+    std::shared_ptr<AudioPluginInstance> instance;
+
+    {
+        const ScopedLock sl (warmPoolLock);
+
+        auto pool = warmPools.find (description.createIdentifierString());
+        if (pool == warmPools.end() || pool->second.instances.empty())
+            return {};
+
+        instance = std::move (pool->second.instances.back());
+        pool->second.instances.pop_back();
+    }
+
+    refillWarmPool (description);
+    return instance;
+}
+
+void EffectProcessorFactory::addWarmInstance (const PluginDescription& description,
+                                              std::shared_ptr<AudioPluginInstance> instance) const
+{
+    const ScopedLock sl (warmPoolLock);
+
+    auto pool = warmPools.find (description.createIdentifierString());
+    if (pool == warmPools.end())
+        return; // The pool was cleared in the meantime.
+
+    auto& warmPool = pool->second;
+    warmPool.numPending = jmax (0, warmPool.numPending - 1);
+
+    if (instance != nullptr && (int) warmPool.instances.size() < warmPool.targetSize)
+        warmPool.instances.push_back (std::move (instance));
+}
+
+void EffectProcessorFactory::refillWarmPool (const PluginDescription& description) const
+{
+    int numToCreate = 0;
+
+    {
+        const ScopedLock sl (warmPoolLock);
+
+        auto pool = warmPools.find (description.createIdentifierString());
+        if (pool == warmPools.end())
+            return;
+
+        auto& warmPool = pool->second;
+        numToCreate = warmPool.targetSize - (int) warmPool.instances.size() - warmPool.numPending;
+
+        if (numToCreate <= 0)
+            return;
+
+        warmPool.numPending += numToCreate;
+    }
+
+    for (int i = 0; i < numToCreate; ++i)
+    {
+        if (canCreatePluginOnAnyThread (description))
+        {
+            getCreationThreads().addJob ([this, description]
+            {
+                addWarmInstance (description, createPluginOnAnyThread (description));
+            });
+        }
+        else
+        {
+            WeakReference<EffectProcessorFactory> weakThis (const_cast<EffectProcessorFactory*> (this));
+
+            const_cast<AudioPluginFormatManager&> (getAudioPluginFormatManager())
+                .createPluginInstanceAsync (description, 44100.0, 256,
+                    [weakThis, description] (std::unique_ptr<AudioPluginInstance> instance, const String&)
+                    {
+                        if (weakThis != nullptr)
+                            weakThis->addWarmInstance (description, std::move (instance));
+                    });
+        }
+    }
+}
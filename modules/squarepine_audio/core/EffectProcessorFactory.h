@@ -1,4 +1,14 @@
-/**
+/** Creates the plugins used by an EffectProcessorChain.
+
+    Besides creating plugins one at a time, the factory can create and prepare
+    whole batches of plugins at once, and can keep a warm pool of plugins that
+    were created ahead of time for the plugins that get used the most.
+
+    Plugins of the internal format can be safely created on any thread, so they get
+    created concurrently on a pool of background threads. Most other formats must be
+    created on the message thread, so they are. If you know of other formats that are
+    safe to create away from the message thread, override canCreatePluginOnAnyThread()
+    and createPluginOnAnyThread().
 
     @see EffectProcessorChain
 */
@@ -25,13 +35,13 @@ public:
     PluginDescription createPluginDescription (const PluginDescription& description) const;
 
     //==============================================================================
-    /** */
+    /** Creates a plugin, taking it from the warm pool if there's one available. */
     std::shared_ptr<AudioPluginInstance> createPlugin (int index) const;
 
-    /** */
+    /** Creates a plugin, taking it from the warm pool if there's one available. */
     std::shared_ptr<AudioPluginInstance> createPlugin (const String& fileOrIdentifier) const;
 
-    /** */
+    /** Creates a plugin, taking it from the warm pool if there's one available. */
     std::shared_ptr<AudioPluginInstance> createPlugin (const PluginDescription& description) const;
 
     //==============================================================================
@@ -47,6 +57,57 @@ public:
     /** */
     void createPluginAsync (const PluginDescription& description, PluginCreationCallback callback);
 
+    //==============================================================================
+    /** The plugins of a batch, in the same order as the descriptions they were created from.
+        Any plugin that couldn't be created is left as nullptr.
+    */
+    using PluginInstances = std::vector<std::shared_ptr<AudioPluginInstance>>;
+
+    /** Creates and prepares a batch of plugins, and waits for all of them to be ready.
+
+        The plugins that can be created on any thread are created and prepared concurrently
+        in the background. The rest get created on the message thread: when this is called
+        from some other thread, it waits on the message thread to create them.
+
+        @warning Calling this away from the message thread while the message thread is
+                 blocked waiting on the calling thread will deadlock!
+
+        @param descriptions The plugins to create.
+        @param sampleRate   The sample rate to prepare the plugins with, or 0 to leave them unprepared.
+        @param blockSize    The block size to prepare the plugins with.
+    */
+    PluginInstances createPlugins (const Array<PluginDescription>& descriptions, double sampleRate, int blockSize);
+
+    /** */
+    using BatchCreationCallback = std::function<void (PluginInstances)>;
+
+    /** Creates and prepares a batch of plugins without waiting for any of them.
+
+        @param descriptions The plugins to create.
+        @param sampleRate   The sample rate to prepare the plugins with, or 0 to leave them unprepared.
+        @param blockSize    The block size to prepare the plugins with.
+        @param callback     Called on the message thread once all of the plugins are ready.
+    */
+    void createPluginsAsync (const Array<PluginDescription>& descriptions, double sampleRate,
+                             int blockSize, BatchCreationCallback callback);
+
+    //==============================================================================
+    /** Keeps a number of instances of a plugin created ahead of time.
+
+        Whenever a plugin is created, an instance gets taken from the warm pool
+        if there's one available, and the pool then gets topped up in the background.
+
+        @param description  The plugin to keep instances of.
+        @param numInstances The number of instances to keep, or 0 to stop keeping any.
+    */
+    void setWarmPoolSize (const PluginDescription& description, int numInstances);
+
+    /** @returns the number of instances of a plugin that are ready to be handed out right away. */
+    int getNumWarmInstances (const PluginDescription& description) const;
+
+    /** Destroys all of the warm instances, and stops keeping any. */
+    void clearWarmPool();
+
 protected:
     //==============================================================================
     KnownPluginList& knownPluginList;
@@ -55,7 +116,48 @@ protected:
     /** */
     virtual const AudioPluginFormatManager& getAudioPluginFormatManager() const = 0;
 
+    /** @returns true if the plugin is safe to create on any thread, using createPluginOnAnyThread().
+
+        By default, this is only the case for plugins of the internal format.
+    */
+    virtual bool canCreatePluginOnAnyThread (const PluginDescription& description) const;
+
+    /** Creates a plugin on the calling thread, which may not be the message thread.
+
+        This is only ever called for plugins where canCreatePluginOnAnyThread() returns true.
+    */
+    virtual std::unique_ptr<AudioPluginInstance> createPluginOnAnyThread (const PluginDescription& description) const;
+
+    /** Clears the warm pool, and waits for anything being created in the background to finish.
+
+        Every subclass must call this from its destructor, since what's being created in the background
+        calls back into the subclass, and into its AudioPluginFormatManager, until then.
+    */
+    void stopCreatingPlugins();
+
 private:
     //==============================================================================
+    struct WarmPool final
+    {
+        int targetSize = 0;
+        int numPending = 0;
+        std::vector<std::shared_ptr<AudioPluginInstance>> instances;
+    };
+
+    // NB: These are mutable because handing out a warm instance from createPlugin() changes the pool.
+    mutable CriticalSection warmPoolLock, creationThreadsLock;
+    mutable std::map<String, WarmPool> warmPools;           //< Keyed by PluginDescription::createIdentifierString().
+    mutable std::unique_ptr<ThreadPool> creationThreads;    //< Created the first time something needs creating in the background.
+
+    //==============================================================================
+    ThreadPool& getCreationThreads() const;
+    AudioPluginFormat* findFormatFor (const PluginDescription& description) const;
+    std::shared_ptr<AudioPluginInstance> createPluginOnMessageThread (const PluginDescription& description) const;
+    std::shared_ptr<AudioPluginInstance> takeWarmInstance (const PluginDescription& description) const;
+    void addWarmInstance (const PluginDescription& description, std::shared_ptr<AudioPluginInstance> instance) const;
+    void refillWarmPool (const PluginDescription& description) const;
+
+    //==============================================================================
+    JUCE_DECLARE_WEAK_REFERENCEABLE (EffectProcessorFactory)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectProcessorFactory)
 };
@@ -0,0 +1,312 @@
+OfflineChainRenderer::OfflineChainRenderer (std::shared_ptr<EffectProcessorFactory> epf,
+                                            int numWorkersToUse,
+                                            int blockSizeToUse) :
+    factory (epf),
+    numWorkers (numWorkersToUse > 0 ? numWorkersToUse : SystemStats::getNumCpus()),
+    blockSize (jmax (1, blockSizeToUse)),
+    workers (numWorkers)
+{
+    jassert (factory != nullptr);
+}
+
+OfflineChainRenderer::~OfflineChainRenderer()
+{
+    workers.removeAllJobs (true, -1);
+}
+
+//==============================================================================
+/** Gets things done on the message thread for the workers.
+
+    When the jobs are rendered from some other thread, this just posts them to the message thread.
+    But when they're rendered from the message thread, it's stuck waiting on the workers, so it
+    has to run whatever they hand over to it while it waits.
+*/
+class OfflineChainRenderer::MessageThreadCalls final
+{
+public:
+    MessageThreadCalls() = default;
+
+    /** Runs the function on the message thread, and waits for it to be done. */
+    void call (const std::function<void()>& function)
+    {
+        if (! isWaitingOnMessageThread || MessageManager::existsAndIsCurrentThread())
+        {
+            callOnMessageThread (function);
+            return;
+        }
+
+        WaitableEvent done;
+
+        {
+            const ScopedLock sl (lock);
+            pendingCalls.push_back ({ &function, &done });
+        }
+
+        wakeUp.signal();
+        done.wait();
+    }
+
+    /** Stops waitUntilFinished() from waiting, once nothing's going to call() anymore. */
+    void finish()
+    {
+        isFinished.store (true);
+        wakeUp.signal();
+    }
+
+    /** Waits for finish() to be called, running anything handed over to call() in the meantime. */
+    void waitUntilFinished()
+    {
+        for (;;)
+        {
+            wakeUp.wait();
+            runPendingCalls();
+
+            if (isFinished.load())
+                return;
+        }
+    }
+
+private:
+    struct PendingCall final
+    {
+        const std::function<void()>* function = nullptr;
+        WaitableEvent* done = nullptr;
+    };
+
+    const bool isWaitingOnMessageThread = MessageManager::existsAndIsCurrentThread();
+    CriticalSection lock;
+    std::vector<PendingCall> pendingCalls;
+    WaitableEvent wakeUp;
+    std::atomic<bool> isFinished { false };
+
+    void runPendingCalls()
+    {
+        std::vector<PendingCall> calls;
+
+        {
+            const ScopedLock sl (lock);
+            std::swap (calls, pendingCalls);
+        }
+
+        for (const auto& pendingCall : calls)
+        {
+            (*pendingCall.function)();
+            pendingCall.done->signal();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (MessageThreadCalls)
+};
+
+//==============================================================================
+std::vector<OfflineChainRenderer::JobResult> OfflineChainRenderer::render (std::vector<Job>& jobs)
+{
+    std::vector<JobResult> results (jobs.size());
+    MessageThreadCalls messageThreadCalls;
+
+    // NB: Starting at 1 so that the jobs can't all finish before they've all been added.
+    std::atomic<int> numRemaining { 1 };
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        ++numRemaining;
+
+        workers.addJob ([&, i]()
+        {
+            results[i] = renderJob (jobs[i], messageThreadCalls);
+
+            if (--numRemaining == 0)
+                messageThreadCalls.finish();
+        });
+    }
+
+    if (--numRemaining == 0)
+        messageThreadCalls.finish();
+
+    messageThreadCalls.waitUntilFinished();
+    return results;
+}
+
+OfflineChainRenderer::JobResult OfflineChainRenderer::render (Job& job)
+{
+    MessageThreadCalls messageThreadCalls;
+    return renderJob (job, messageThreadCalls);
+}
+
+OfflineChainRenderer::JobResult OfflineChainRenderer::renderJob (Job& job, MessageThreadCalls& messageThreadCalls)
+{
+    JobResult jobResult;
+    EffectProcessorChain::Ptr chain;
+
+    // The chain only gets restored now that there's a worker to render it, and goes away as soon as it's done,
+    // so that the chains of the jobs that are still waiting don't take up any memory:
+    messageThreadCalls.call ([&] { chain = createChain (job, jobResult); });
+    renderWithChain (job, chain.get(), jobResult);
+
+    // The chain is a timer, so it has to go away on the same thread that it was started on:
+    messageThreadCalls.call ([&] { destroyChain (chain); });
+    return jobResult;
+}
+
+//==============================================================================
+void OfflineChainRenderer::callOnMessageThread (const std::function<void()>& function)
+{
+    // Without a message manager, there's no message thread to wait on, so this is as good as it gets:
+    if (MessageManager::getInstanceWithoutCreating() == nullptr
+        || MessageManager::existsAndIsCurrentThread())
+    {
+        function();
+        return;
+    }
+
+    WaitableEvent finished;
+
+    const auto posted = MessageManager::callAsync ([&]
+    {
+        function();
+        finished.signal();
+    });
+
+    jassert (posted);
+
+    if (posted)
+        finished.wait();
+}
+
+EffectProcessorChain::Ptr OfflineChainRenderer::createChain (const Job& job, JobResult& jobResult) const
+{
+    // Restoring the chain counts towards the time taken too:
+    const auto startTicks = Time::getHighResolutionTicks();
+    auto chain = createChainInternal (job, jobResult.result);
+    jobResult.renderSeconds += Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+    return chain;
+}
+
+EffectProcessorChain::Ptr OfflineChainRenderer::createChainInternal (const Job& job, Result& result) const
+{
+    const auto* reader = job.reader.get();
+    const auto* writer = job.writer.get();
+
+    if (reader == nullptr || writer == nullptr)
+    {
+        result = Result::fail ("Missing a source or a destination.");
+        return nullptr;
+    }
+
+    const auto sampleRate = reader->sampleRate;
+    const auto numChannels = jmax ((int) reader->numChannels, writer->getNumChannels());
+
+    if (sampleRate <= 0.0 || numChannels <= 0)
+    {
+        result = Result::fail ("The source has no audio.");
+        return nullptr;
+    }
+
+    // Nothing gets resampled here, so the destination must be at the same rate as the source!
+    jassert (approximatelyEqual (writer->getSampleRate(), sampleRate));
+
+    auto chain = std::make_shared<EffectProcessorChain> (factory);
+    chain->setNonRealtime (true);
+    chain->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    chain->prepareToPlay (sampleRate, blockSize);
+
+    if (job.chainState.getSize() > 0)
+        chain->setStateInformation (job.chainState.getData(), (int) job.chainState.getSize());
+
+    // NB: The chain gets handed back regardless, so that it still gets destroyed on the message thread.
+    for (int i = 0; i < chain->getNumEffects(); ++i)
+    {
+        if (chain->isPluginMissing (i) == true)
+        {
+            result = Result::fail ("Couldn't create the plugin of effect " + String (i + 1) + ".");
+            break;
+        }
+    }
+
+    return chain;
+}
+
+void OfflineChainRenderer::destroyChain (EffectProcessorChain::Ptr& chain)
+{
+    if (chain != nullptr)
+        chain->releaseResources();
+
+    chain.reset();
+}
+
+void OfflineChainRenderer::renderWithChain (Job& job, EffectProcessorChain* chain, JobResult& jobResult)
+{
+    const auto startTicks = Time::getHighResolutionTicks();
+
+    if (jobResult.result.wasOk())
+    {
+        jassert (chain != nullptr);
+        jobResult.result = renderInternal (job, *chain, jobResult.numSamplesWritten);
+    }
+
+    const auto sampleRate = job.reader != nullptr ? job.reader->sampleRate : 0.0;
+
+    // Deleting the writer is what finishes off the file, so it counts towards the time taken:
+    job.writer.reset();
+    job.reader.reset();
+
+    jobResult.renderSeconds += Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+    if (jobResult.renderSeconds > 0.0 && sampleRate > 0.0)
+        jobResult.realtimeFactor = ((double) jobResult.numSamplesWritten / sampleRate) / jobResult.renderSeconds;
+}
+
+Result OfflineChainRenderer::renderInternal (Job& job, EffectProcessorChain& chain, int64& numSamplesWritten)
+{
+    auto* reader = job.reader.get();
+    auto* writer = job.writer.get();
+
+    const auto sampleRate = reader->sampleRate;
+    const auto numChannels = chain.getTotalNumInputChannels();
+    const auto numOutputChannels = writer->getNumChannels();
+
+    const auto latencySamples = (int64) jmax (0, chain.getLatencySamples());
+    const auto tailSeconds = jlimit (0.0, jmax (0.0, job.maximumTailSeconds), chain.getTailLengthSeconds());
+    const auto numSourceSamples = reader->lengthInSamples;
+    const auto numSamplesToWrite = numSourceSamples + (int64) std::ceil (tailSeconds * sampleRate);
+    const auto numSamplesToProcess = numSamplesToWrite + latencySamples;
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    MidiBuffer midiMessages;
+
+    for (int64 position = 0; position < numSamplesToProcess; position += blockSize)
+    {
+        const auto numSamples = (int) jmin ((int64) blockSize, numSamplesToProcess - position);
+
+        // NB: Only ever shrinks for the last block, so this never reallocates.
+        buffer.setSize (numChannels, numSamples, false, false, true);
+        buffer.clear();
+
+        // Past the end of the source, the chain gets fed silence to flush out its latency and tail:
+        const auto numSamplesToRead = (int) jlimit ((int64) 0, (int64) numSamples, numSourceSamples - position);
+
+        if (numSamplesToRead > 0)
+            reader->read (&buffer, 0, numSamplesToRead, position, true, true);
+
+        midiMessages.clear();
+        chain.processBlock (buffer, midiMessages);
+
+        // Dropping the chain's latency from the start, so the result lines up with the source:
+        const auto numSamplesToSkip = (int) jlimit ((int64) 0, (int64) numSamples, latencySamples - position);
+        const auto numSamplesToWriteNow = numSamples - numSamplesToSkip;
+
+        if (numSamplesToWriteNow <= 0)
+            continue;
+
+        const juce::AudioBuffer<float> output (buffer.getArrayOfWritePointers(), numOutputChannels,
+                                               numSamplesToSkip, numSamplesToWriteNow);
+
+        if (! writer->writeFromAudioSampleBuffer (output, 0, numSamplesToWriteNow))
+            return Result::fail ("Couldn't write to the destination.");
+
+        numSamplesWritten += numSamplesToWriteNow;
+    }
+
+    return Result::ok();
+}
@@ -0,0 +1,101 @@
+/** Renders audio files through EffectProcessorChains faster than realtime.
+
+    Every job gets its own chain, restored from the job's chain state, and the jobs
+    are spread across a pool of worker threads so that as many files get rendered at
+    once as there are workers. The chains are put into non-realtime mode, and are
+    processed in large blocks.
+
+    A job's chain only gets created and restored once a worker gets round to the job, and gets
+    destroyed as soon as the job's done, so there are never more chains around than there are
+    workers, however many jobs there are.
+
+    The chains are created, restored and destroyed on the message thread, since that's the only
+    thread where every plugin format can be created, and the chains' timers have to be started
+    and stopped there. The worker threads only ever process them. When rendering from the message
+    thread itself, it does that for the workers while it waits on them.
+
+    Each worker only ever holds a single block of audio at a time: the audio is read,
+    processed and written out one block after the other, so the memory used stays the
+    same no matter how long the files are.
+
+    The chains' latency is compensated for, so the rendered audio lines up with the source.
+
+    @warning When rendering from some other thread, the renderer waits on the message thread
+             to restore and destroy the chains, so the message thread mustn't be blocked
+             waiting on the rendering thread, or neither will ever get anywhere!
+
+    @see EffectProcessorChain, EffectProcessorFactory
+*/
+class OfflineChainRenderer final
+{
+public:
+    /** Constructor
+
+        @param factory      The factory used to create the effects of every job's chain.
+        @param numWorkers   The number of files to render at once, or 0 to use all of the CPU cores.
+        @param blockSize    The number of samples to process at a time.
+    */
+    OfflineChainRenderer (std::shared_ptr<EffectProcessorFactory> factory,
+                          int numWorkers = 0,
+                          int blockSize = 8192);
+
+    /** Destructor. */
+    ~OfflineChainRenderer();
+
+    //==============================================================================
+    /** A file to render, along with the chain to render it through. */
+    struct Job final
+    {
+        std::unique_ptr<AudioFormatReader> reader;      //< The audio to render.
+        std::unique_ptr<AudioFormatWriter> writer;      //< Where the rendered audio goes. This gets flushed and deleted once the job's done.
+        MemoryBlock chainState;                         //< The chain to render through, as saved by EffectProcessorChain::getStateInformation().
+        double maximumTailSeconds = 0.0;                //< How much of the chain's tail to keep rendering past the end of the source, at most.
+    };
+
+    /** How a job went. */
+    struct JobResult final
+    {
+        Result result = Result::ok();                   //< Whether the job was rendered, or why it couldn't be.
+        int64 numSamplesWritten = 0;                    //< The number of samples written per channel.
+        double renderSeconds = 0.0;                     //< The time taken to render the job, including restoring its chain.
+        double realtimeFactor = 0.0;                    //< The duration of the written audio divided by renderSeconds.
+    };
+
+    //==============================================================================
+    /** Renders all of the jobs, and waits for them to be done.
+
+        @returns the results of the jobs, in the same order as the jobs.
+    */
+    std::vector<JobResult> render (std::vector<Job>& jobs);
+
+    /** Renders a single job on the calling thread, once its chain is restored on the message thread. */
+    JobResult render (Job& job);
+
+    //==============================================================================
+    /** @returns the number of files that get rendered at once. */
+    int getNumWorkers() const noexcept { return numWorkers; }
+
+    /** @returns the number of samples that get processed at a time. */
+    int getBlockSize() const noexcept { return blockSize; }
+
+private:
+    //==============================================================================
+    class MessageThreadCalls;
+
+    std::shared_ptr<EffectProcessorFactory> factory;
+    const int numWorkers, blockSize;
+    ThreadPool workers;
+
+    //==============================================================================
+    static void callOnMessageThread (const std::function<void()>& function);
+    static void destroyChain (EffectProcessorChain::Ptr& chain);
+
+    JobResult renderJob (Job& job, MessageThreadCalls& messageThreadCalls);
+    EffectProcessorChain::Ptr createChain (const Job& job, JobResult& jobResult) const;
+    EffectProcessorChain::Ptr createChainInternal (const Job& job, Result& result) const;
+    void renderWithChain (Job& job, EffectProcessorChain* chain, JobResult& jobResult);
+    Result renderInternal (Job& job, EffectProcessorChain& chain, int64& numSamplesWritten);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineChainRenderer)
+};
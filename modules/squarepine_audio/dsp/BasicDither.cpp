@@ -0,0 +1,173 @@
+namespace
+{
+    /** Rounds a number of steps down, towards negative infinity.
+
+        NB: Truncating and stepping down below zero, instead of calling std::floor,
+            like BitCrusherProcessor, so the loops around this vectorise without needing SSE4.1.
+    */
+    template<typename FloatType>
+    inline FloatType floorSteps (FloatType steps) noexcept
+    {
+        const auto truncated = (FloatType) (int) steps;
+        return truncated > steps ? truncated - (FloatType) 1 : truncated;
+    }
+}
+
+//==============================================================================
+BasicDither::BasicDither() noexcept
+{
+    setSeed ((uint32) Random().nextInt());
+    setBitDepth (bitDepth);
+    setNoiseShaping (noiseShaping);
+}
+
+//==============================================================================
+void BasicDither::reset() noexcept
+{
+    position = 0;
+    errors.fill (0.0);
+}
+
+void BasicDither::setSeed (uint32 newSeed) noexcept
+{
+    // Scrambling the seed, so that neighbouring ones don't give overlapping streams:
+    key = NoiseGenerator::scrambleBits (newSeed ^ 0x9e3779b9u);
+    reset();
+}
+
+void BasicDither::setBitDepth (int newBitDepth) noexcept
+{
+    jassert (isPositiveAndNotGreaterThan (newBitDepth, 24));
+
+    bitDepth = jlimit (1, 24, newBitDepth);
+    scale = std::ldexp (1.0, bitDepth - 1);
+    inverseScale = 1.0 / scale;
+}
+
+void BasicDither::setNoiseShaping (NoiseShaping newNoiseShaping) noexcept
+{
+    noiseShaping = newNoiseShaping;
+    coefficients.fill (0.0);
+    errors.fill (0.0);
+
+    switch (noiseShaping)
+    {
+        case NoiseShaping::none:            break;
+        case NoiseShaping::firstOrder:      coefficients = { 1.0 }; break;
+        case NoiseShaping::secondOrder:     coefficients = { 2.0, -1.0 }; break;
+        case NoiseShaping::wannamaker3:     coefficients = { 1.623, -0.982, 0.109 }; break;
+        case NoiseShaping::lipshitz5:       coefficients = { 2.033, -2.165, 1.959, -1.590, 0.6149 }; break;
+    }
+}
+
+//==============================================================================
+void BasicDither::generateTriangularNoise (uint32 streamKey, uint32 startPosition, float* destination, int numSamples) noexcept
+{
+    // The difference between two uniform 16-bit numbers, which are the two halves of the hash:
+    constexpr auto normaliser = 1.0f / 65536.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto bits = NoiseGenerator::scrambleBits ((startPosition + (uint32) i) ^ streamKey);
+        destination[i] = (float) ((int) (bits >> 16) - (int) (bits & 0xffffu)) * normaliser;
+    }
+}
+
+//==============================================================================
+void BasicDither::process (float* channel, int numSamples) noexcept
+{
+    if (channel == nullptr || numSamples <= 0)
+        return;
+
+    // NB: Past 16 bits, the loudest samples scaled up to steps leave a float too few bits
+    //     below the step to hold the noise, which would then get rounded to a coarser, non-triangular one.
+    if (bitDepth > 16)
+        processWith<double> (channel, numSamples);
+    else
+        processWith<float> (channel, numSamples);
+}
+
+template<typename FloatType>
+void BasicDither::processWith (float* channel, int numSamples) noexcept
+{
+    switch (noiseShaping)
+    {
+        case NoiseShaping::firstOrder:      processShaped<FloatType, 1> (channel, numSamples); return;
+        case NoiseShaping::secondOrder:     processShaped<FloatType, 2> (channel, numSamples); return;
+        case NoiseShaping::wannamaker3:     processShaped<FloatType, 3> (channel, numSamples); return;
+        case NoiseShaping::lipshitz5:       processShaped<FloatType, 5> (channel, numSamples); return;
+        case NoiseShaping::none:            break;
+    }
+
+    const auto localScale = (FloatType) scale, localInverseScale = (FloatType) inverseScale;
+    const auto lowest = -localScale, highest = localScale - (FloatType) 1;
+    constexpr int chunkSize = 256;
+    float noise[chunkSize];
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto numThisTime = jmin (chunkSize, numSamples - start);
+        auto* samples = channel + start;
+
+        generateTriangularNoise (key, position, noise, numThisTime);
+        position += (uint32) numThisTime;
+
+        // Rounding to the nearest step, by rounding down from half a step higher:
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            const auto wanted = jlimit (lowest - (FloatType) 1, highest + (FloatType) 1, (FloatType) samples[i] * localScale);
+            const auto rounded = floorSteps (wanted + (FloatType) noise[i] + (FloatType) 0.5);
+            samples[i] = (float) (jlimit (lowest, highest, rounded) * localInverseScale);
+        }
+    }
+}
+
+template<typename FloatType, int numTaps>
+void BasicDither::processShaped (float* channel, int numSamples) noexcept
+{
+    static_assert (numTaps <= maxNumTaps, "Too many taps for the error history!");
+
+    const auto localScale = (FloatType) scale, localInverseScale = (FloatType) inverseScale;
+    const auto lowest = -localScale, highest = localScale - (FloatType) 1;
+    constexpr int chunkSize = 256;
+    float noise[chunkSize];
+
+    // NB: Copying the state into locals, so that the loop can keep it all in registers.
+    std::array<FloatType, maxNumTaps> localErrors, localCoefficients;
+
+    for (size_t t = 0; t < (size_t) maxNumTaps; ++t)
+    {
+        localErrors[t] = (FloatType) errors[t];
+        localCoefficients[t] = (FloatType) coefficients[t];
+    }
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto numThisTime = jmin (chunkSize, numSamples - start);
+        auto* samples = channel + start;
+
+        generateTriangularNoise (key, position, noise, numThisTime);
+        position += (uint32) numThisTime;
+
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            auto feedback = FloatType();
+
+            for (int t = 0; t < numTaps; ++t)
+                feedback += localCoefficients[(size_t) t] * localErrors[(size_t) t];
+
+            // Keeping the errors small while clipping, which would otherwise feed back and blow up:
+            const auto wanted = jlimit (lowest - (FloatType) 1, highest + (FloatType) 1, (FloatType) samples[i] * localScale - feedback);
+            const auto rounded = floorSteps (wanted + (FloatType) noise[i] + (FloatType) 0.5);
+
+            for (int t = numTaps; --t > 0;)
+                localErrors[(size_t) t] = localErrors[(size_t) t - 1];
+
+            localErrors[0] = rounded - wanted;
+            samples[i] = (float) (jlimit (lowest, highest, rounded) * localInverseScale);
+        }
+    }
+
+    for (size_t t = 0; t < (size_t) maxNumTaps; ++t)
+        errors[t] = (double) localErrors[t];
+}
@@ -1,69 +1,75 @@
-/** This is a basic 1st order noise-shaping dither. */
+/** Quantises audio to a given bit depth, with TPDF dither and optional error feedback noise shaping.
+
+    The dither gets made a block at a time, by hashing positions the same way NoiseGenerator does,
+    so each seed gives its own uncorrelated stream.
+
+    @see NoiseGenerator
+*/
 class BasicDither final
 {
 public:
-    BasicDither() noexcept { reset(); }
-
-    //==============================================================================
-    void reset() noexcept
+    /** The curves that the quantisation noise can get pushed into,
+        where it's harder to hear, in exchange for there being more of it overall.
+    */
+    enum class NoiseShaping
     {
-        generator.setSeedRandomly();
+        none,           //< Flat, white noise.
+        firstOrder,     //< A gentle tilt towards the highs, which suits any sample rate.
+        secondOrder,    //< A steeper tilt towards the highs, which suits any sample rate.
+        wannamaker3,    //< Wannamaker's 3 tap, F-weighted curve, which is tuned for 44.1 kHz.
+        lipshitz5       //< Lipshitz's 5 tap, E-weighted curve, which is tuned for 44.1 kHz.
+    };
 
-        wordLen = std::pow (2.0f, 31.0f);
-        invWordLen = 1.0f / wordLen;
-        amp = invWordLen / (float) RAND_MAX;
-        offset = invWordLen / 2.0f;
-    }
+    /** Constructor, which picks a random seed. */
+    BasicDither() noexcept;
 
-    float generateNextSample (float inputSample) const noexcept
-    {
-        return inputSample + offset + amp * (float) (random1 - random2);
-    }
-
-    void processAdditiveDither (float& inputSample) const noexcept
-    {
-        dsp::util::snapToZero (inputSample);
-        inputSample += 0.5f * (s1 + s1 - s2);
-        dsp::util::snapToZero (inputSample);
-    }
+    //==============================================================================
+    /** Forgets the past quantisation errors, and starts the noise over. */
+    void reset() noexcept;
 
-    void process (float& inputSample, float& outSample) noexcept
-    {
-        processAdditiveDither (inputSample);
-        outSample = generateNextSample (inputSample);
-        dsp::util::snapToZero (outSample);
-    }
+    /** Picks the noise stream, and starts it over. */
+    void setSeed (uint32 newSeed) noexcept;
 
-    void process (float* channel, int numSamples) noexcept
-    {
-        if (channel == nullptr || numSamples <= 0)
-            return;
+    /** Sets the bit depth to quantise to, between 1 and 24. The default is 24. */
+    void setBitDepth (int newBitDepth) noexcept;
+    /** */
+    int getBitDepth() const noexcept { return bitDepth; }
 
-        while (--numSamples >= 0)
-        {
-            random2 = random1;
+    /** Sets the curve the noise gets shaped to. This forgets the past quantisation errors. */
+    void setNoiseShaping (NoiseShaping newNoiseShaping) noexcept;
+    /** */
+    NoiseShaping getNoiseShaping() const noexcept { return noiseShaping; }
 
-            // N.B.: This was using 'rand()', but that C function isn't multithreaded FFS!
-            random1 = generator.nextInt (RAND_MAX);
+    //==============================================================================
+    /** Dithers and quantises the samples, in place.
 
-            auto in = *channel;
-            float out;
-            process (in, out);
-            *channel++ = out;
+        The results land on the steps of the bit depth, and get clipped to the largest one below 1,
+        so that writing them out at that bit depth leaves them alone.
+    */
+    void process (float* channel, int numSamples) noexcept;
 
-            s2 = s1;
-            s1 = in - out;
-        }
-    }
+    /** Fills the destination with triangular noise between -1 and 1, from a stream's key,
+        starting at the given position in it.
+    */
+    static void generateTriangularNoise (uint32 key, uint32 position, float* destination, int numSamples) noexcept;
 
 private:
     //==============================================================================
-    Random generator; // The distribution of this Random class is questionable...
-    int random1 = 0, random2 = 0;
-    float wordLen = 0.0f, invWordLen = 0.0f, amp = 0.0f, offset = 0.0f;
-    float s1 = 0.0f, s2 = 0.0f;
+    static constexpr int maxNumTaps = 5;
+
+    uint32 key = 0, position = 0;
+    int bitDepth = 24;
+    double scale = 0.0, inverseScale = 0.0;
+    NoiseShaping noiseShaping = NoiseShaping::none;
+    std::array<double, maxNumTaps> coefficients, errors;  //< The errors are the latest ones, newest first.
+
+    //==============================================================================
+    template<typename FloatType>
+    void processWith (float* channel, int numSamples) noexcept;
+
+    template<typename FloatType, int numTaps>
+    void processShaped (float* channel, int numSamples) noexcept;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BasicDither)
 };
-
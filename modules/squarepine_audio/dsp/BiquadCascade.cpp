@@ -0,0 +1,92 @@
+namespace
+{
+    /** The angular frequency, kept clear of DC and Nyquist, where the formulas fall apart. */
+    double getOmega (double sampleRate, double frequency) noexcept
+    {
+        jassert (sampleRate > 0.0);
+
+        return MathConstants<double>::twoPi * jlimit (2.0, sampleRate * 0.49, frequency) / sampleRate;
+    }
+
+    /** NB: A gain factor of 0 would divide by 0 in the peak filter, so this stops at -120 dB instead. */
+    double getAmplitude (double gainFactor) noexcept
+    {
+        return std::sqrt (jmax (1.0e-6, gainFactor));
+    }
+
+    BiquadCoefficients makeNormalised (double b0, double b1, double b2,
+                                       double a0, double a1, double a2) noexcept
+    {
+        const auto a0Inverse = 1.0 / a0;
+        return { b0 * a0Inverse, b1 * a0Inverse, b2 * a0Inverse, a1 * a0Inverse, a2 * a0Inverse };
+    }
+}
+
+//==============================================================================
+BiquadCoefficients BiquadCoefficients::makePeakFilter (double sampleRate, double frequency,
+                                                       double q, double gainFactor) noexcept
+{
+    jassert (q > 0.0);
+
+    const auto A = getAmplitude (gainFactor);
+    const auto omega = getOmega (sampleRate, frequency);
+    const auto alpha = std::sin (omega) / (q * 2.0);
+    const auto c2 = -2.0 * std::cos (omega);
+    const auto alphaTimesA = alpha * A;
+    const auto alphaOverA = alpha / A;
+
+    return makeNormalised (1.0 + alphaTimesA, c2, 1.0 - alphaTimesA,
+                           1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+}
+
+BiquadCoefficients BiquadCoefficients::makeLowShelf (double sampleRate, double cutoff,
+                                                     double q, double gainFactor) noexcept
+{
+    jassert (q > 0.0);
+
+    const auto A = getAmplitude (gainFactor);
+    const auto aminus1 = A - 1.0;
+    const auto aplus1 = A + 1.0;
+    const auto omega = getOmega (sampleRate, cutoff);
+    const auto coso = std::cos (omega);
+    const auto beta = std::sin (omega) * std::sqrt (A) / q;
+    const auto aminus1TimesCoso = aminus1 * coso;
+
+    return makeNormalised (A * (aplus1 - aminus1TimesCoso + beta),
+                           A * 2.0 * (aminus1 - aplus1 * coso),
+                           A * (aplus1 - aminus1TimesCoso - beta),
+                           aplus1 + aminus1TimesCoso + beta,
+                           -2.0 * (aminus1 + aplus1 * coso),
+                           aplus1 + aminus1TimesCoso - beta);
+}
+
+BiquadCoefficients BiquadCoefficients::makeHighShelf (double sampleRate, double cutoff,
+                                                      double q, double gainFactor) noexcept
+{
+    jassert (q > 0.0);
+
+    const auto A = getAmplitude (gainFactor);
+    const auto aminus1 = A - 1.0;
+    const auto aplus1 = A + 1.0;
+    const auto omega = getOmega (sampleRate, cutoff);
+    const auto coso = std::cos (omega);
+    const auto beta = std::sin (omega) * std::sqrt (A) / q;
+    const auto aminus1TimesCoso = aminus1 * coso;
+
+    return makeNormalised (A * (aplus1 + aminus1TimesCoso + beta),
+                           A * -2.0 * (aminus1 + aplus1 * coso),
+                           A * (aplus1 + aminus1TimesCoso - beta),
+                           aplus1 - aminus1TimesCoso + beta,
+                           2.0 * (aminus1 - aplus1 * coso),
+                           aplus1 - aminus1TimesCoso - beta);
+}
+
+//==============================================================================
+double BiquadCoefficients::getMagnitudeForFrequency (double frequency, double sampleRate) const noexcept
+{
+    const auto z = std::polar (1.0, -MathConstants<double>::twoPi * frequency / sampleRate);
+    const auto numerator = b0 + z * (b1 + z * b2);
+    const auto denominator = 1.0 + z * (a1 + z * a2);
+
+    return std::abs (numerator / denominator);
+}
@@ -0,0 +1,297 @@
+/** The coefficients of a biquad filter, normalised such that a0 is 1.
+
+    These come out the same as the ones that juce::dsp::IIR::Coefficients makes,
+    which are from Robert Bristow-Johnson's Audio EQ Cookbook, but are worked out into
+    a plain struct instead of a newly allocated and reference-counted object,
+    so it's fine to make them on the audio thread.
+*/
+struct BiquadCoefficients final
+{
+    /** Boosts or cuts around the frequency, by the gain factor at the very centre. */
+    static BiquadCoefficients makePeakFilter (double sampleRate, double frequency,
+                                              double q, double gainFactor) noexcept;
+
+    /** Boosts or cuts below the cutoff, by the gain factor at DC. */
+    static BiquadCoefficients makeLowShelf (double sampleRate, double cutoff,
+                                            double q, double gainFactor) noexcept;
+
+    /** Boosts or cuts above the cutoff, by the gain factor at Nyquist. */
+    static BiquadCoefficients makeHighShelf (double sampleRate, double cutoff,
+                                             double q, double gainFactor) noexcept;
+
+    /** @returns the filter's gain at the given frequency. */
+    double getMagnitudeForFrequency (double frequency, double sampleRate) const noexcept;
+
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+};
+
+//==============================================================================
+/** A chain of biquad filters, which runs over several channels at once.
+
+    Each sample goes through every stage in one go, so the audio only
+    gets read and written once no matter how many stages there are.
+    The channels are run side by side, a few at a time, in lanes that the compiler
+    can put into a SIMD register: a biquad has to wait on its own last output
+    for each new one, so a single channel leaves most of the processor idle,
+    while a few of them cost hardly any more than one does.
+
+    New coefficients are glided to over a few milliseconds, rather than being jumped to,
+    which would click. The glide takes a step every subBlockSize samples of audio,
+    whatever size the blocks given to process() are. Gliding from one stable filter
+    to another stays stable along the way, because the feedback coefficients
+    that are stable make up a triangle, which any straight line between two
+    of its points stays inside of.
+
+    Nothing gets allocated outside of prepare(), so everything else is fine
+    to call from the audio thread.
+*/
+template<typename SampleType>
+class BiquadCascade final
+{
+public:
+    /** Constructor. */
+    BiquadCascade() = default;
+
+    //==============================================================================
+    /** The most stages a cascade can have. */
+    static constexpr int maxNumStages = 8;
+
+    /** How many channels get run side by side. */
+    static constexpr int numLanes = 4;
+
+    /** How many samples of audio go by between each step of a glide. */
+    static constexpr int subBlockSize = 32;
+
+    //==============================================================================
+    /** Allocates everything for the given number of stages and channels,
+        and starts over with the coefficients each stage is gliding to.
+    */
+    void prepare (double newSampleRate, int newNumStages, int newMaxNumChannels)
+    {
+        jassert (newSampleRate > 0.0);
+        jassert (isPositiveAndNotGreaterThan (newNumStages, maxNumStages));
+
+        sampleRate = newSampleRate;
+        numStages = jlimit (0, maxNumStages, newNumStages);
+        maxNumChannels = jmax (1, newMaxNumChannels);
+
+        const auto numGroups = (maxNumChannels + numLanes - 1) / numLanes;
+        state.calloc ((size_t) (numGroups * maxNumStages * 2 * numLanes));
+        lanes.calloc ((size_t) (subBlockSize * numLanes));
+
+        const auto glideSamples = glideMs * 0.001 * sampleRate;
+        numGlideSteps = jmax (1, roundToInt (glideSamples / subBlockSize));
+
+        reset();
+    }
+
+    /** Clears the filters, and jumps straight to the coefficients they were gliding to. */
+    void reset() noexcept
+    {
+        for (int s = 0; s < maxNumStages; ++s)
+        {
+            stages[s].current = stages[s].target;
+            stages[s].numStepsLeft = 0;
+        }
+
+        samplesUntilGlide = 0;
+
+        const auto numGroups = (maxNumChannels + numLanes - 1) / numLanes;
+        std::fill (state.get(), state.get() + numGroups * maxNumStages * 2 * numLanes, SampleType());
+    }
+
+    //==============================================================================
+    /** Sets the coefficients that a stage glides to. */
+    void setCoefficients (int stageIndex, const BiquadCoefficients& newCoefficients) noexcept
+    {
+        if (! isPositiveAndBelow (stageIndex, maxNumStages))
+        {
+            jassertfalse;
+            return;
+        }
+
+        auto& stage = stages[stageIndex];
+        stage.target = Coefficients::from (newCoefficients);
+
+        // NB: Gliding from wherever the stage has got to, in case it was already on its way somewhere else.
+        const auto numSteps = (SampleType) numGlideSteps;
+
+        for (int k = 0; k < Coefficients::numValues; ++k)
+            stage.step.values[k] = (stage.target.values[k] - stage.current.values[k]) / numSteps;
+
+        stage.numStepsLeft = numGlideSteps;
+    }
+
+    //==============================================================================
+    /** Filters the channels in place.
+
+        NB: There can't be more channels than prepare() was given; any extra ones get left alone.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        jassert (state != nullptr); // Did you forget to call prepare()?
+        jassert (numChannels <= maxNumChannels);
+
+        numChannels = jmin (numChannels, maxNumChannels);
+
+        if (channels == nullptr || numChannels <= 0 || numSamples <= 0 || numStages <= 0)
+            return;
+
+        for (int start = 0; start < numSamples;)
+        {
+            // NB: The count carries over from one call to the next, so that small or odd block sizes
+            //     don't step any more or less often than every subBlockSize samples.
+            if (samplesUntilGlide <= 0)
+            {
+                glide();
+                samplesUntilGlide = subBlockSize;
+            }
+
+            const auto num = jmin (samplesUntilGlide, numSamples - start);
+
+            for (int c = 0; c < numChannels; c += numLanes)
+            {
+                auto* groupState = state.get() + (c / numLanes) * maxNumStages * 2 * numLanes;
+                processGroup (channels + c, jmin (numLanes, numChannels - c), start, num, groupState);
+            }
+
+            samplesUntilGlide -= num;
+            start += num;
+        }
+
+        // Once the input goes quiet, the filters tail off into denormals, which can be very slow:
+        const auto numGroups = (numChannels + numLanes - 1) / numLanes;
+
+        for (int i = numGroups * maxNumStages * 2 * numLanes; --i >= 0;)
+            dsp::util::snapToZero (state[i]);
+    }
+
+private:
+    //==============================================================================
+    struct Coefficients final
+    {
+        enum { numValues = 5 };
+
+        static Coefficients from (const BiquadCoefficients& c) noexcept
+        {
+            return { { (SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2, (SampleType) c.a1, (SampleType) c.a2 } };
+        }
+
+        SampleType values[numValues] = { (SampleType) 1, (SampleType) 0, (SampleType) 0, (SampleType) 0, (SampleType) 0 };
+    };
+
+    struct Stage final
+    {
+        Coefficients current, target, step;
+        int numStepsLeft = 0;
+    };
+
+    static constexpr double glideMs = 20.0;
+
+    Stage stages[maxNumStages];
+    HeapBlock<SampleType> state, lanes;
+    double sampleRate = 44100.0;
+    int numStages = 0, maxNumChannels = 0, numGlideSteps = 1;
+    int samplesUntilGlide = 0;                  //< How much more audio to filter before the next step of any glides.
+
+    //==============================================================================
+    void glide() noexcept
+    {
+        for (int s = 0; s < numStages; ++s)
+        {
+            auto& stage = stages[s];
+
+            if (stage.numStepsLeft <= 0)
+                continue;
+
+            // NB: Landing exactly on the target, rather than wherever the rounding errors of the steps have added up to.
+            if (--stage.numStepsLeft == 0)
+            {
+                stage.current = stage.target;
+                continue;
+            }
+
+            for (int k = 0; k < Coefficients::numValues; ++k)
+                stage.current.values[k] += stage.step.values[k];
+        }
+    }
+
+    /** Runs a group of up to numLanes channels through every stage, in transposed direct form II.
+
+        The channels get interleaved into the lanes first, so that the loop over
+        the lanes reads and writes neighbouring samples, which is what vectorises.
+        Any lanes without a channel in them just filter silence.
+    */
+    void processGroup (SampleType* const* channels, int numChannels, int startSample,
+                       int numSamples, SampleType* groupState) noexcept
+    {
+        auto* interleaved = lanes.get();
+
+        for (int l = 0; l < numLanes; ++l)
+        {
+            if (l < numChannels)
+            {
+                const auto* source = channels[l] + startSample;
+
+                for (int i = 0; i < numSamples; ++i)
+                    interleaved[i * numLanes + l] = source[i];
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    interleaved[i * numLanes + l] = SampleType();
+            }
+        }
+
+        SampleType z1[maxNumStages][numLanes], z2[maxNumStages][numLanes];
+        SampleType b0[maxNumStages], b1[maxNumStages], b2[maxNumStages], a1[maxNumStages], a2[maxNumStages];
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            const auto* values = stages[s].current.values;
+            b0[s] = values[0];
+            b1[s] = values[1];
+            b2[s] = values[2];
+            a1[s] = values[3];
+            a2[s] = values[4];
+
+            std::copy (groupState + (s * 2) * numLanes, groupState + (s * 2 + 1) * numLanes, z1[s]);
+            std::copy (groupState + (s * 2 + 1) * numLanes, groupState + (s * 2 + 2) * numLanes, z2[s]);
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto* x = interleaved + i * numLanes;
+
+            for (int s = 0; s < numStages; ++s)
+            {
+                for (int l = 0; l < numLanes; ++l)
+                {
+                    const auto input = x[l];
+                    const auto output = b0[s] * input + z1[s][l];
+
+                    z1[s][l] = b1[s] * input - a1[s] * output + z2[s][l];
+                    z2[s][l] = b2[s] * input - a2[s] * output;
+                    x[l] = output;
+                }
+            }
+        }
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            std::copy (z1[s], z1[s] + numLanes, groupState + (s * 2) * numLanes);
+            std::copy (z2[s], z2[s] + numLanes, groupState + (s * 2 + 1) * numLanes);
+        }
+
+        for (int l = 0; l < numChannels; ++l)
+        {
+            auto* destination = channels[l] + startSample;
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = interleaved[i * numLanes + l];
+        }
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BiquadCascade)
+};
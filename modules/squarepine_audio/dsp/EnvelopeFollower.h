@@ -35,7 +35,7 @@ public:
     FloatType processDecibels (FloatType sample) noexcept
     {
         EnvelopeComponent& ec = sample > envelope ? attack : release;
-        envelope = ec.process (envelope, sample);
+        envelope = ec.process (sample, envelope);
         return envelope;
     }
 
@@ -73,3 +73,232 @@ private:
 
     JUCE_DECLARE_NON_COPYABLE (EnvelopeFollower)
 };
+
+//==============================================================================
+/** Follows the envelopes of any number of channels at once, a block at a time.
+
+    The smoothing is the same as EnvelopeFollower's, but the levels get detected,
+    linked and converted to decibels in separate passes over whole channels,
+    which leaves just the smoothing itself running a sample at a time.
+*/
+class BlockEnvelopeFollower final
+{
+public:
+    /** How the level of the audio gets measured. */
+    enum class Detection
+    {
+        peak,   //< The absolute level of each sample.
+        rms     //< The power of the audio, which follows loudness more closely.
+    };
+
+    /** Constructor. */
+    BlockEnvelopeFollower() noexcept
+    {
+        updateCoefficients();
+    }
+
+    //==============================================================================
+    /** Allocates the envelopes of up to the given number of channels, and clears them. */
+    void prepare (double newSampleRate, int newMaxNumChannels)
+    {
+        jassert (newSampleRate > 0.0);
+
+        sampleRate = newSampleRate;
+        maxNumChannels = jmax (1, newMaxNumChannels);
+        envelopes.calloc ((size_t) maxNumChannels);
+        updateCoefficients();
+    }
+
+    /** Lets go of whatever the envelopes were following. */
+    void reset() noexcept
+    {
+        for (int i = 0; i < maxNumChannels; ++i)
+            envelopes[i] = 0.0f;
+    }
+
+    //==============================================================================
+    /** */
+    void setAttackMs (float ms) noexcept                { attackMs = ms; updateCoefficients(); }
+    /** */
+    void setReleaseMs (float ms) noexcept               { releaseMs = ms; updateCoefficients(); }
+    /** */
+    void setDetection (Detection newDetection) noexcept { detection = newDetection; }
+
+    /** Sets whether the channels share one envelope, following the loudest of them
+        when detecting peaks, or all of them together when detecting RMS levels.
+    */
+    void setLinked (bool shouldBeLinked) noexcept       { linked = shouldBeLinked; }
+
+    /** @returns the number of envelopes that processing the given number of channels writes out. */
+    int getNumEnvelopes (int numChannels) const noexcept { return linked ? 1 : jmin (numChannels, maxNumChannels); }
+
+    //==============================================================================
+    /** Follows the channels' envelopes, writing out the levels in decibels.
+
+        @param input        The channels to follow, starting from startSample.
+        @param numChannels  The number of input channels.
+        @param startSample  Where in the input channels to start.
+        @param decibels     Where the envelopes go, from the start of each channel.
+                            There need to be as many as getNumEnvelopes() says.
+        @param numSamples   The number of samples to follow.
+    */
+    void process (const float* const* input, int numChannels, int startSample,
+                  float* const* decibels, int numSamples) noexcept
+    {
+        jassert (envelopes != nullptr); // Did you forget to call prepare()?
+
+        const auto numEnvelopes = getNumEnvelopes (numChannels);
+
+        if (numChannels <= 0 || numSamples <= 0)
+            return;
+
+        // NB: Levels never go below the floor, which keeps the envelopes away from denormals, and the logs finite.
+        const auto isRMS = detection == Detection::rms;
+        const auto floor = isRMS ? 1.0e-20f : 1.0e-10f;
+
+        if (linked)
+        {
+            auto* levels = decibels[0];
+            FloatVectorOperations::fill (levels, floor, numSamples);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const auto* samples = input[c] + startSample;
+
+                if (isRMS)
+                    for (int i = 0; i < numSamples; ++i)
+                        levels[i] += samples[i] * samples[i];
+                else
+                    for (int i = 0; i < numSamples; ++i)
+                        levels[i] = jmax (levels[i], std::abs (samples[i]));
+            }
+
+            if (isRMS)
+                FloatVectorOperations::multiply (levels, 1.0f / (float) numChannels, numSamples);
+        }
+        else
+        {
+            for (int c = 0; c < numEnvelopes; ++c)
+            {
+                const auto* samples = input[c] + startSample;
+                auto* levels = decibels[c];
+
+                if (isRMS)
+                    for (int i = 0; i < numSamples; ++i)
+                        levels[i] = jmax (floor, samples[i] * samples[i]);
+                else
+                    for (int i = 0; i < numSamples; ++i)
+                        levels[i] = jmax (floor, std::abs (samples[i]));
+            }
+        }
+
+        // Powers are squared levels, so need half as many decibels per doubling:
+        const auto decibelsPerOctave = isRMS ? 3.0102999566398f : 6.0205999132796f;
+
+        // NB: Smoothing several channels at a time, because each envelope depends on the last one,
+        //     so a single channel spends most of its time waiting on its own result.
+        int c = 0;
+
+        for (; c + smoothingGroupSize <= numEnvelopes; c += smoothingGroupSize)
+            smooth<smoothingGroupSize> (decibels + c, envelopes + c, numSamples);
+
+        for (; c < numEnvelopes; ++c)
+            smooth<1> (decibels + c, envelopes + c, numSamples);
+
+        for (c = 0; c < numEnvelopes; ++c)
+        {
+            auto* levels = decibels[c];
+
+            for (int i = 0; i < numSamples; ++i)
+                levels[i] = decibelsPerOctave * approximateLog2 (levels[i]);
+        }
+    }
+
+private:
+    //==============================================================================
+    HeapBlock<float> envelopes;
+    double sampleRate = 48000.0;
+    int maxNumChannels = 0;
+    float attackMs = 1.0f, releaseMs = 1.0f;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f;
+    Detection detection = Detection::peak;
+    bool linked = false;
+
+    //==============================================================================
+    /** The same as EnvelopeFollower's, getting 99% of the way there in the given time. */
+    float getCoefficient (float ms) const noexcept
+    {
+        const auto numSamples = jmax (1.0e-15, (double) ms) * sampleRate * 0.001;
+        return (float) std::exp (std::log (0.01) / numSamples);
+    }
+
+    void updateCoefficients() noexcept
+    {
+        attackCoefficient = getCoefficient (attackMs);
+        releaseCoefficient = getCoefficient (releaseMs);
+    }
+
+    /** How many envelopes get smoothed side by side. */
+    static constexpr int smoothingGroupSize = 8;
+
+    /** Smooths the levels of a few channels in place, carrying on from and updating their envelopes.
+
+        NB: Rising levels come out larger with the attack coefficient than with the release one,
+            and falling levels smaller, whenever the attack is the faster of the two, and the other
+            way around when it isn't. Picking between them with jmax or jmin instead of comparing
+            the level to the envelope leaves no branch for noisy audio to mispredict.
+    */
+    template<int numChannels>
+    void smooth (float* const* levels, float* channelEnvelopes, int numSamples) const noexcept
+    {
+        const auto attackIsFaster = attackCoefficient <= releaseCoefficient;
+        const auto attackInput = 1.0f - attackCoefficient;
+        const auto releaseInput = 1.0f - releaseCoefficient;
+
+        float envelope[numChannels];
+        std::copy (channelEnvelopes, channelEnvelopes + numChannels, envelope);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int c = 0; c < numChannels; ++c)
+            {
+                const auto level = levels[c][i];
+                const auto attacked = attackCoefficient * envelope[c] + attackInput * level;
+                const auto released = releaseCoefficient * envelope[c] + releaseInput * level;
+
+                envelope[c] = attackIsFaster ? jmax (attacked, released) : jmin (attacked, released);
+                levels[c][i] = envelope[c];
+            }
+        }
+
+        std::copy (envelope, envelope + numChannels, channelEnvelopes);
+    }
+
+    /** log2 of a positive, normal number, which is within 2e-6 of std::log2.
+
+        NB: Splitting off the exponent and using the series for the mantissa, instead of calling std::log2,
+            so that the loop around this vectorises.
+    */
+    static float approximateLog2 (float x) noexcept
+    {
+        uint32 bits;
+        std::memcpy (&bits, &x, sizeof (float));
+
+        const auto exponent = (float) ((int) (bits >> 23) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+        float mantissa;
+        std::memcpy (&mantissa, &bits, sizeof (float));
+
+        // 2 atanh (t) / ln (2), where t = (m - 1) / (m + 1), which stays below 1 / 3:
+        constexpr auto c1 = 2.8853900817779268f, c3 = 0.9617966939259756f, c5 = 0.5770780163555854f,
+                       c7 = 0.4121985831111324f, c9 = 0.3205988979753252f;
+
+        const auto t = (mantissa - 1.0f) / (mantissa + 1.0f);
+        const auto t2 = t * t;
+        return exponent + t * (c1 + t2 * (c3 + t2 * (c5 + t2 * (c7 + t2 * c9))));
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockEnvelopeFollower)
+};
@@ -109,11 +109,11 @@ double LFO::process (juce::AudioBuffer<float>& buffer,
 
         for (int f = numChannels; --f >= 0;)
         {
-            if (float* const channel = buffer.getWritePointer (i))
+            if (float* const channel = buffer.getWritePointer (f))
             {
-                auto sample = static_cast<double> (channel[f]);
+                auto sample = static_cast<double> (channel[i]);
                 processInternal (sample, phase);
-                channel[f] = static_cast<float> (sample);
+                channel[i] = static_cast<float> (sample);
             }
         }
     }
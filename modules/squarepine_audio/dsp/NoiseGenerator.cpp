@@ -0,0 +1,116 @@
+NoiseGenerator::NoiseGenerator (Type newType) noexcept :
+    type (newType)
+{
+    setSeed ((uint32) Random().nextInt());
+}
+
+//==============================================================================
+void NoiseGenerator::setType (Type newType) noexcept
+{
+    if (type != newType)
+    {
+        type = newType;
+        pink0 = pink1 = pink2 = brown = 0.0f;
+    }
+}
+
+void NoiseGenerator::setSeed (uint32 newSeed) noexcept
+{
+    // Scrambling the seed, so that neighbouring ones don't give overlapping streams:
+    key = scrambleBits (newSeed ^ 0x9e3779b9u);
+    reset();
+}
+
+void NoiseGenerator::reset() noexcept
+{
+    position = 0;
+    pink0 = pink1 = pink2 = brown = 0.0f;
+}
+
+//==============================================================================
+void NoiseGenerator::process (float* destination, int numSamples) noexcept
+{
+    if (destination == nullptr || numSamples <= 0)
+        return;
+
+    switch (type)
+    {
+        case Type::white:       generateWhite (destination, numSamples); break;
+        case Type::pink:        generateWhite (destination, numSamples); filterPink (destination, numSamples); break;
+        case Type::brown:       generateWhite (destination, numSamples); filterBrown (destination, numSamples); break;
+        case Type::gaussian:    generateGaussian (destination, numSamples); break;
+    }
+
+    position += (uint32) numSamples;
+}
+
+void NoiseGenerator::generateWhite (float* destination, int numSamples) noexcept
+{
+    // The top 24 bits of the hash, which is as many as a float can hold exactly:
+    constexpr auto normaliser = 1.0f / 8388608.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto bits = scrambleBits ((position + (uint32) i) ^ key);
+        destination[i] = (float) (int) (bits >> 8) * normaliser - 1.0f;
+    }
+}
+
+void NoiseGenerator::generateGaussian (float* destination, int numSamples) noexcept
+{
+    // Four uniform numbers between -0.5 and 0.5, from the halves of two hashes,
+    // whose sum has the same variance as a single one between -1 and 1:
+    constexpr auto normaliser = 1.0f / 65536.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto first = scrambleBits ((position + (uint32) i) ^ key);
+        const auto second = scrambleBits (first + 0x9e3779b9u);
+
+        const auto sum = (int) (first >> 16) + (int) (first & 0xffffu)
+                       + (int) (second >> 16) + (int) (second & 0xffffu);
+
+        destination[i] = (float) sum * normaliser - 2.0f;
+    }
+}
+
+void NoiseGenerator::filterPink (float* samples, int numSamples) noexcept
+{
+    // Paul Kellet's economy filter, which is within 0.5 dB of -3 dB per octave above 10 Hz or so.
+    // NB: The three one-poles don't depend on each other, so they overlap with each other nicely.
+    constexpr auto normaliser = 0.3356815f;
+
+    auto b0 = pink0, b1 = pink1, b2 = pink2;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto white = samples[i];
+
+        b0 = 0.99765f * b0 + white * 0.0990460f;
+        b1 = 0.96300f * b1 + white * 0.2965164f;
+        b2 = 0.57000f * b2 + white * 1.0526913f;
+
+        samples[i] = (b0 + b1 + b2 + white * 0.1848f) * normaliser;
+    }
+
+    pink0 = b0;
+    pink1 = b1;
+    pink2 = b2;
+}
+
+void NoiseGenerator::filterBrown (float* samples, int numSamples) noexcept
+{
+    // A leaky integrator, which stops the walk from wandering off, normalised by sqrt ((1 + a) / (1 - a)):
+    constexpr auto leak = 0.995f;
+    constexpr auto normaliser = 19.974984f;
+
+    auto b = brown;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        b = leak * b + (1.0f - leak) * samples[i];
+        samples[i] = b * normaliser;
+    }
+
+    brown = b;
+}
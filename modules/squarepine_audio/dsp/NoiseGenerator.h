@@ -0,0 +1,71 @@
+/** Makes noise, a block at a time.
+
+    The randomness comes from hashing each sample's position in the stream along with a key,
+    instead of from a generator that has to be stepped one sample at a time,
+    so the loops that make it vectorise. Each seed gives its own stream,
+    so giving every channel a different one keeps their noise uncorrelated.
+
+    Every type of noise comes out about as loud as white noise between -1 and 1,
+    which is an RMS level of 1 / sqrt (3), and is centred on 0.
+*/
+class NoiseGenerator final
+{
+public:
+    /** The colours of noise this can make. */
+    enum class Type
+    {
+        white,      //< Uniformly distributed and flat, between -1 and 1.
+        pink,       //< Falling by 3 dB per octave, which is the same energy in every octave.
+        brown,      //< Falling by 6 dB per octave, like a random walk.
+        gaussian    //< Flat, but close to normally distributed, from the sum of four uniform numbers.
+    };
+
+    /** Constructor, which picks a random seed. */
+    NoiseGenerator (Type type = Type::white) noexcept;
+
+    //==============================================================================
+    /** */
+    void setType (Type newType) noexcept;
+    /** */
+    Type getType() const noexcept { return type; }
+
+    /** Picks the noise stream, and starts it over. */
+    void setSeed (uint32 newSeed) noexcept;
+
+    /** Starts the noise stream over, and clears the filters that colour it. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Fills the destination with the next block of noise. */
+    void process (float* destination, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Scrambles a 32-bit number, such that neighbouring inputs come out unrelated.
+
+        This is Chris Wellons' "lowbias32", which only uses operations that vectorise.
+    */
+    static uint32 scrambleBits (uint32 x) noexcept
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+private:
+    //==============================================================================
+    Type type = Type::white;
+    uint32 key = 0, position = 0;
+    float pink0 = 0.0f, pink1 = 0.0f, pink2 = 0.0f, brown = 0.0f;
+
+    //==============================================================================
+    void generateWhite (float* destination, int numSamples) noexcept;
+    void generateGaussian (float* destination, int numSamples) noexcept;
+    void filterPink (float* samples, int numSamples) noexcept;
+    void filterBrown (float* samples, int numSamples) noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseGenerator)
+};
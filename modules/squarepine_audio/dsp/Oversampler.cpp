@@ -0,0 +1,518 @@
+//==============================================================================
+namespace
+{
+    /** How far the passband goes, relative to the original sample rate.
+        Anything between here and the original Nyquist is allowed to alias.
+    */
+    constexpr double passbandEdge = 0.45;
+
+    /** How far down anything that would alias into the passband gets pushed, in decibels. */
+    constexpr double stopbandAttenuation = 90.0;
+
+    /** The most doublings supported, for 8x oversampling. */
+    constexpr int maxNumStages = 3;
+
+    /** @returns the transition band of a stage, relative to its higher sample rate.
+        The first stage has to go from the passband to the stopband in a hurry,
+        while the later ones have everything in between the original Nyquist and their own to play with.
+    */
+    double getTransitionBand (int stageIndex) noexcept
+    {
+        const auto lowerRate = (double) (1 << stageIndex);
+        return (lowerRate - 2.0 * passbandEdge) / (2.0 * lowerRate);
+    }
+}
+
+//==============================================================================
+/** A single doubling of the sample rate, and halving back again. */
+class Oversampler::Stage
+{
+public:
+    virtual ~Stage() = default;
+
+    /** Allocates the state for the given number of channels, and samples at the lower rate. */
+    virtual void prepare (int numChannels, int maxNumSamples) = 0;
+    virtual void reset() noexcept = 0;
+
+    /** Writes twice as many samples as there are source samples to the destination. */
+    virtual void upsample (int channel, const float* source, float* dest, int numSamples) noexcept = 0;
+    /** Reads twice as many samples as there are destination samples from the source. */
+    virtual void downsample (int channel, const float* source, float* dest, int numSamples) noexcept = 0;
+
+    /** @returns how long upsampling and downsampling again takes, in samples at the lower rate. */
+    virtual double getLatency() const noexcept = 0;
+};
+
+//==============================================================================
+/** A Kaiser windowed half-band FIR, split into its two phases.
+
+    One phase is a single tap in the middle, so only the other, which has every odd tap,
+    needs any real work done.
+*/
+class Oversampler::FIRStage final : public Oversampler::Stage
+{
+public:
+    FIRStage (int stageIndex) :
+        design (getDesign (stageIndex))
+    {
+    }
+
+    //==============================================================================
+    void prepare (int numChannels, int maxNumSamples) override
+    {
+        const auto numTaps = (int) design.taps.size();
+
+        upHistory.setSize (numChannels, numTaps - 1 + maxNumSamples);
+        evenHistory.setSize (numChannels, numTaps - 1 + maxNumSamples);
+        oddHistory.setSize (numChannels, design.centreDelay + maxNumSamples);
+        convolved.calloc ((size_t) maxNumSamples);
+        reset();
+    }
+
+    void reset() noexcept override
+    {
+        upHistory.clear();
+        evenHistory.clear();
+        oddHistory.clear();
+    }
+
+    //==============================================================================
+    void upsample (int channel, const float* source, float* dest, int numSamples) noexcept override
+    {
+        const auto numTaps = (int) design.taps.size();
+        auto* history = upHistory.getWritePointer (channel);
+        FloatVectorOperations::copy (history + numTaps - 1, source, numSamples);
+
+        convolve (history, numSamples);
+
+        // The other phase is nothing but the middle tap, which is just a delay:
+        const auto* delayed = history + numTaps - design.centreDelay;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[2 * i] = convolved[i];
+            dest[2 * i + 1] = delayed[i];
+        }
+
+        std::memmove (history, history + numSamples, sizeof (float) * (size_t) (numTaps - 1));
+    }
+
+    void downsample (int channel, const float* source, float* dest, int numSamples) noexcept override
+    {
+        const auto numTaps = (int) design.taps.size();
+        auto* even = evenHistory.getWritePointer (channel);
+        auto* odd = oddHistory.getWritePointer (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            even[numTaps - 1 + i] = source[2 * i];
+            odd[design.centreDelay + i] = source[2 * i + 1];
+        }
+
+        convolve (even, numSamples);
+
+        FloatVectorOperations::add (convolved, odd, numSamples);
+        FloatVectorOperations::copyWithMultiply (dest, convolved, 0.5f, numSamples);
+
+        std::memmove (even, even + numSamples, sizeof (float) * (size_t) (numTaps - 1));
+        std::memmove (odd, odd + numSamples, sizeof (float) * (size_t) design.centreDelay);
+    }
+
+    //==============================================================================
+    double getLatency() const noexcept override
+    {
+        // Half the length of the whole filter, at the higher rate, on the way up and back down:
+        return 2.0 * design.centreDelay - 1.0;
+    }
+
+private:
+    //==============================================================================
+    struct Design final
+    {
+        Design (int stageIndex)
+        {
+            // Kaiser's estimates for the window's shape and length:
+            const auto beta = 0.1102 * (stopbandAttenuation - 8.7);
+            const auto transition = getTransitionBand (stageIndex);
+            const auto minLength = (stopbandAttenuation - 7.95) / (14.36 * transition) + 1.0;
+
+            // A half-band filter is only symmetric around a non-zero tap if its length is 4n + 3:
+            const auto n = jmax (0, (int) std::ceil ((minLength - 3.0) / 4.0));
+            const auto halfLength = 2 * n + 1;
+            centreDelay = n + 1;
+
+            taps.resize ((size_t) (2 * centreDelay));
+            double sum = 0.0;
+
+            for (int i = 0; i < (int) taps.size(); ++i)
+            {
+                // Only the odd distances from the middle have anything in them:
+                const auto distance = (double) (2 * i - halfLength);
+                const auto x = MathConstants<double>::halfPi * distance;
+                const auto window = besselI0 (beta * std::sqrt (1.0 - square (distance / (double) halfLength))) / besselI0 (beta);
+                const auto value = std::sin (x) / x * window;
+
+                taps[(size_t) i] = (float) value;
+                sum += value;
+            }
+
+            // NB: Normalising this phase to a gain of 1, so that DC passes through untouched.
+            for (auto& t : taps)
+                t = (float) (t / sum);
+        }
+
+        /** The zeroth-order modified Bessel function of the first kind, for the Kaiser window. */
+        static double besselI0 (double x) noexcept
+        {
+            auto sum = 1.0, term = 1.0;
+
+            for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+            {
+                term *= square (x / (2.0 * (double) k));
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        std::vector<float> taps;    //< Every odd tap, which is symmetric, so the order doesn't matter.
+        int centreDelay = 0;        //< How far behind the middle tap is, rounded up to samples at the lower rate.
+    };
+
+    const Design& design;
+    juce::AudioBuffer<float> upHistory, evenHistory, oddHistory;
+    HeapBlock<float> convolved;
+
+    //==============================================================================
+    static const Design& getDesign (int stageIndex)
+    {
+        static const Design designs[maxNumStages] = { Design (0), Design (1), Design (2) };
+        return designs[stageIndex];
+    }
+
+    /** Runs the taps over the history, and its new samples, into the convolved block.
+
+        NB: Going a tap at a time, across the whole block, keeps each pass a plain
+        multiply and add that vectorises, instead of a sum that the compiler can't reorder.
+    */
+    void convolve (const float* samples, int numSamples) noexcept
+    {
+        FloatVectorOperations::clear (convolved.get(), numSamples);
+
+        for (int i = 0; i < (int) design.taps.size(); ++i)
+            FloatVectorOperations::addWithMultiply (convolved.get(), samples + i, design.taps[(size_t) i], numSamples);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FIRStage)
+};
+
+//==============================================================================
+/** A half-band IIR, made of two chains of first-order allpass filters
+    that each run at the lower rate.
+
+    The coefficients come from the elliptic design in Laurent de Soras' HIIR,
+    which hits the attenuation with as few allpass filters as possible.
+*/
+class Oversampler::IIRStage final : public Oversampler::Stage
+{
+public:
+    IIRStage (int stageIndex) :
+        design (getDesign (stageIndex))
+    {
+    }
+
+    //==============================================================================
+    void prepare (int numChannels, int) override
+    {
+        states.resize ((size_t) numChannels * 4);
+        reset();
+    }
+
+    void reset() noexcept override
+    {
+        for (auto& s : states)
+        {
+            s.previousInputs.fill (0.0f);
+            s.previousOutputs.fill (0.0f);
+        }
+    }
+
+    //==============================================================================
+    void upsample (int channel, const float* source, float* dest, int numSamples) noexcept override
+    {
+        auto& first = states[(size_t) channel * 4];
+        auto& second = states[(size_t) channel * 4 + 1];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[2 * i] = process (design.firstPath, first, source[i]);
+            dest[2 * i + 1] = process (design.secondPath, second, source[i]);
+        }
+    }
+
+    void downsample (int channel, const float* source, float* dest, int numSamples) noexcept override
+    {
+        auto& first = states[(size_t) channel * 4 + 2];
+        auto& second = states[(size_t) channel * 4 + 3];
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = 0.5f * (process (design.firstPath, first, source[2 * i + 1])
+                              + process (design.secondPath, second, source[2 * i]));
+    }
+
+    //==============================================================================
+    double getLatency() const noexcept override
+    {
+        // Coming back down, each path goes through the other's filters too,
+        // so the whole thing is both chains of allpass filters in a row:
+        return design.latency;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int maxNumCoefficients = 8;
+
+    struct Path final
+    {
+        std::array<float, maxNumCoefficients> coefficients;
+        int numCoefficients = 0;
+    };
+
+    struct Design final
+    {
+        Design (int stageIndex)
+        {
+            const auto transition = getTransitionBand (stageIndex) / 2.0;
+
+            auto k = std::tan ((1.0 - transition * 2.0) * MathConstants<double>::pi / 4.0);
+            k *= k;
+
+            const auto kkRoot = std::pow (1.0 - k * k, 0.25);
+            const auto e = 0.5 * (1.0 - kkRoot) / (1.0 + kkRoot);
+            const auto e4 = std::pow (e, 4.0);
+            const auto q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+            const auto attenuation = std::pow (10.0, -stopbandAttenuation / 10.0);
+            const auto a = attenuation / (1.0 - attenuation);
+            auto order = (int) std::ceil (std::log (a * a / 16.0) / std::log (q));
+
+            if ((order % 2) == 0)
+                ++order;
+
+            order = jmax (3, order);
+
+            const auto numCoefficients = jmin (2 * maxNumCoefficients, (order - 1) / 2);
+
+            for (int i = 0; i < numCoefficients; ++i)
+            {
+                const auto coefficient = computeCoefficient (i + 1, k, q, order);
+                auto& path = (i % 2) == 0 ? firstPath : secondPath;
+
+                path.coefficients[(size_t) path.numCoefficients++] = (float) coefficient;
+                latency += (1.0 - coefficient) / (1.0 + coefficient);
+            }
+        }
+
+        Path firstPath, secondPath;
+        double latency = 0.0;
+
+        static double computeCoefficient (int c, double k, double q, int order) noexcept
+        {
+            constexpr auto pi = MathConstants<double>::pi;
+            auto numerator = 0.0, denominator = 0.0;
+
+            for (int i = 0; i < 20; ++i)
+                numerator += (i % 2 == 0 ? 1.0 : -1.0) * std::pow (q, (double) (i * (i + 1)))
+                           * std::sin ((double) (i * 2 + 1) * c * pi / order);
+
+            for (int i = 1; i < 20; ++i)
+                denominator += (i % 2 == 0 ? 1.0 : -1.0) * std::pow (q, (double) (i * i))
+                             * std::cos ((double) (i * 2) * c * pi / order);
+
+            const auto ww = numerator * std::pow (q, 0.25) / (denominator + 0.5);
+            const auto wwSquared = ww * ww;
+            const auto x = std::sqrt ((1.0 - wwSquared * k) * (1.0 - wwSquared / k)) / (1.0 + wwSquared);
+
+            return (1.0 - x) / (1.0 + x);
+        }
+    };
+
+    /** The last input and output of each allpass filter in a path.
+        Each channel has one of these per path, going up, and another per path, coming back down.
+    */
+    struct State final
+    {
+        std::array<float, maxNumCoefficients> previousInputs, previousOutputs;
+    };
+
+    const Design& design;
+    std::vector<State> states;
+
+    //==============================================================================
+    static const Design& getDesign (int stageIndex)
+    {
+        static const Design designs[maxNumStages] = { Design (0), Design (1), Design (2) };
+        return designs[stageIndex];
+    }
+
+    static float process (const Path& path, State& state, float sample) noexcept
+    {
+        for (int i = 0; i < path.numCoefficients; ++i)
+        {
+            const auto output = path.coefficients[(size_t) i] * (sample - state.previousOutputs[(size_t) i])
+                              + state.previousInputs[(size_t) i];
+
+            state.previousInputs[(size_t) i] = sample;
+            state.previousOutputs[(size_t) i] = output;
+            sample = output;
+        }
+
+        return sample;
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRStage)
+};
+
+//==============================================================================
+Oversampler::Oversampler (int f, FilterType type) :
+    factor (jlimit (1, 1 << maxNumStages, nextPowerOfTwo (f))),
+    filterType (type)
+{
+    jassert (f == factor); // Only 1, 2, 4 and 8 are supported!
+
+    for (int i = 0; (1 << i) < factor; ++i)
+    {
+        if (filterType == FilterType::linearPhase)
+            stages.emplace_back (std::make_unique<FIRStage> (i));
+        else
+            stages.emplace_back (std::make_unique<IIRStage> (i));
+    }
+
+    // Adding up the latency in samples at the highest rate, so that it's exact for the FIR stages:
+    double latency = 0.0;
+
+    for (int i = 0; i < (int) stages.size(); ++i)
+        latency += stages[(size_t) i]->getLatency() * (double) (factor >> i);
+
+    if (filterType == FilterType::linearPhase)
+    {
+        const auto wholeLatency = roundToInt (latency);
+        delayLength = (factor - (wholeLatency % factor)) % factor;
+        latencySamples = (wholeLatency + delayLength) / factor;
+    }
+    else
+    {
+        latencySamples = roundToInt (latency / (double) factor);
+    }
+}
+
+Oversampler::~Oversampler()
+{
+}
+
+//==============================================================================
+void Oversampler::prepare (int numChannels, int newMaxBlockSize)
+{
+    jassert (numChannels > 0 && newMaxBlockSize > 0);
+
+    maxNumChannels = jmax (1, numChannels);
+    maxBlockSize = jmax (1, newMaxBlockSize);
+
+    for (int i = 0; i < (int) stages.size(); ++i)
+        stages[(size_t) i]->prepare (maxNumChannels, maxBlockSize << i);
+
+    oversampled.setSize (maxNumChannels, maxBlockSize * factor);
+    intermediate.setSize (2, jmax (1, maxBlockSize * factor / 2));
+    delayLine.setSize (maxNumChannels, jmax (1, delayLength));
+
+    reset();
+}
+
+void Oversampler::reset() noexcept
+{
+    for (auto& stage : stages)
+        stage->reset();
+
+    oversampled.clear();
+    delayLine.clear();
+    delayPosition = 0;
+}
+
+//==============================================================================
+juce::AudioBuffer<float>& Oversampler::upsample (const juce::AudioBuffer<float>& source) noexcept
+{
+    jassert (maxBlockSize > 0); // Forgot to call prepare()?
+    jassert (source.getNumSamples() <= maxBlockSize);
+    jassert (source.getNumChannels() <= maxNumChannels);
+
+    const auto numChannels = jmin (source.getNumChannels(), maxNumChannels);
+    const auto numSamples = jmin (source.getNumSamples(), maxBlockSize);
+    const auto numStages = (int) stages.size();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* input = source.getReadPointer (channel);
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            // NB: Bouncing between the intermediate channels, ending up in the oversampled buffer.
+            auto* output = i == numStages - 1 ? oversampled.getWritePointer (channel)
+                                              : intermediate.getWritePointer (i % 2);
+
+            stages[(size_t) i]->upsample (channel, input, output, numSamples << i);
+            input = output;
+        }
+    }
+
+    oversampledView.setDataToReferTo (oversampled.getArrayOfWritePointers(), numChannels, numSamples * factor);
+    applyDelay (numSamples * factor);
+    return oversampledView;
+}
+
+void Oversampler::downsample (juce::AudioBuffer<float>& dest) noexcept
+{
+    const auto numChannels = jmin (dest.getNumChannels(), oversampledView.getNumChannels());
+    const auto numSamples = jmin (dest.getNumSamples(), oversampledView.getNumSamples() / factor);
+    const auto numStages = (int) stages.size();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* input = oversampledView.getReadPointer (channel);
+
+        for (int i = numStages; --i >= 0;)
+        {
+            auto* output = i == 0 ? dest.getWritePointer (channel)
+                                  : intermediate.getWritePointer (i % 2);
+
+            stages[(size_t) i]->downsample (channel, input, output, numSamples << i);
+            input = output;
+        }
+    }
+}
+
+void Oversampler::applyDelay (int numSamples) noexcept
+{
+    if (delayLength <= 0)
+        return;
+
+    int position = delayPosition;
+
+    for (int channel = 0; channel < oversampledView.getNumChannels(); ++channel)
+    {
+        auto* samples = oversampledView.getWritePointer (channel);
+        auto* delayed = delayLine.getWritePointer (channel);
+        position = delayPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            std::swap (samples[i], delayed[position]);
+
+            if (++position >= delayLength)
+                position = 0;
+        }
+    }
+
+    delayPosition = position;
+}
@@ -0,0 +1,124 @@
+/** Oversamples audio by 2, 4 or 8, so that non-linear processing doesn't alias.
+
+    Each doubling is a half-band filter, which only needs half of its taps
+    thanks to every other one being zero, and only runs at the lower of the rates.
+    Later stages get away with far fewer taps than the first, seeing as everything
+    above the original Nyquist gets filtered out at the end anyway.
+
+    The filter designs are worked out once, and shared by every instance,
+    so that having one of these on each of hundreds of tracks stays cheap.
+    Nothing gets allocated after prepare().
+
+    @code
+        oversampler.process (buffer, [&] (juce::AudioBuffer<float>& oversampledBuffer)
+        {
+            // Distort oversampledBuffer here...
+        });
+    @endcode
+*/
+class Oversampler final
+{
+public:
+    //==============================================================================
+    /** */
+    enum class FilterType
+    {
+        /** FIR half-bands, which keep the phase intact, at the cost of more latency.
+            The latency is padded out to a whole number of samples.
+        */
+        linearPhase,
+
+        /** IIR half-bands made of allpass filters, which cost far less and have little latency,
+            but shift the phase around near Nyquist. The latency is only approximate.
+        */
+        minimumPhase
+    };
+
+    //==============================================================================
+    /** Creates an oversampler.
+
+        @param factor       Either 1, 2, 4 or 8. 1 doesn't oversample at all.
+        @param filterType   The kind of filters to use for each doubling.
+    */
+    Oversampler (int factor, FilterType filterType = FilterType::minimumPhase);
+
+    /** Destructor. */
+    ~Oversampler();
+
+    //==============================================================================
+    /** Allocates everything needed to process up to maxBlockSize samples at a time.
+        Larger blocks passed to process() get split up.
+    */
+    void prepare (int numChannels, int maxBlockSize);
+
+    /** Clears the state of all of the filters. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** @returns the oversampling factor. */
+    int getFactor() const noexcept { return factor; }
+
+    /** @returns the type of filters in use. */
+    FilterType getFilterType() const noexcept { return filterType; }
+
+    /** @returns the latency of upsampling and downsampling again, at the original sample rate. */
+    int getLatencySamples() const noexcept { return latencySamples; }
+
+    //==============================================================================
+    /** Upsamples the buffer, passes the oversampled version to the function,
+        and downsamples the result back into the buffer.
+    */
+    template<typename ProcessFunction>
+    void process (juce::AudioBuffer<float>& buffer, ProcessFunction&& processOversampled)
+    {
+        if (factor <= 1)
+        {
+            processOversampled (buffer);
+            return;
+        }
+
+        const auto numChannels = jmin (buffer.getNumChannels(), maxNumChannels);
+        auto** channels = buffer.getArrayOfWritePointers();
+
+        for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        {
+            const auto numThisTime = jmin (maxBlockSize, buffer.getNumSamples() - start);
+            juce::AudioBuffer<float> block (channels, numChannels, start, numThisTime);
+
+            processOversampled (upsample (block));
+            downsample (block);
+        }
+    }
+
+    /** Upsamples the buffer into an internal one, which gets returned.
+        The buffer must not be longer than the block size given to prepare().
+    */
+    juce::AudioBuffer<float>& upsample (const juce::AudioBuffer<float>& source) noexcept;
+
+    /** Downsamples whatever is in the internal oversampled buffer back into the destination. */
+    void downsample (juce::AudioBuffer<float>& dest) noexcept;
+
+private:
+    //==============================================================================
+    class Stage;
+    class FIRStage;
+    class IIRStage;
+
+    const int factor;
+    const FilterType filterType;
+    std::vector<std::unique_ptr<Stage>> stages;
+    int maxNumChannels = 0, maxBlockSize = 0, latencySamples = 0;
+
+    juce::AudioBuffer<float> oversampled;       //< Holds the audio at the highest rate.
+    juce::AudioBuffer<float> intermediate;      //< Holds the audio between the stages.
+    juce::AudioBuffer<float> oversampledView;   //< The part of the oversampled buffer used by the current block.
+
+    juce::AudioBuffer<float> delayLine;         //< Pads the latency of linear phase filters out to a whole number of samples.
+    int delayLength = 0, delayPosition = 0;
+
+    //==============================================================================
+    void applyDelay (int numSamples) noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+};
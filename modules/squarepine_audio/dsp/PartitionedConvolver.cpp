@@ -0,0 +1,655 @@
+//==============================================================================
+namespace
+{
+    /** @returns how much of an impulse response gets convolved on the audio thread.
+
+        The tail's partitions only get handed to the background threads once they've been filled,
+        and need a whole partition's worth of time to get convolved, so the head has to cover two of them.
+    */
+    int getHeadLength (int headPartitionSize) noexcept
+    {
+        return 2 * headPartitionSize * PartitionedConvolver::tailPartitionRatio;
+    }
+
+    int getFFTOrder (int partitionSize)
+    {
+        return roundToInt (std::log2 ((double) partitionSize * 2.0));
+    }
+
+    /** Splits the interleaved bins the FFT produces into all of the real parts, then all of the imaginary parts,
+        which makes multiplying spectra a plain loop that vectorises.
+    */
+    void deinterleave (const float* data, float* spectrum, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            spectrum[i] = data[2 * i];
+            spectrum[numBins + i] = data[2 * i + 1];
+        }
+    }
+
+    void interleave (const float* spectrum, float* data, int numBins) noexcept
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            data[2 * i] = spectrum[i];
+            data[2 * i + 1] = spectrum[numBins + i];
+        }
+    }
+
+    /** Ramps from one output to the other, over a partition, leaving the result in the first one. */
+    void rampBetween (float* fromSamples, const float* toSamples, int numSamples, int position, int partitionSize) noexcept
+    {
+        const auto increment = 1.0f / (float) partitionSize;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto gain = (float) (position + i + 1) * increment;
+            fromSamples[i] += (toSamples[i] - fromSamples[i]) * gain;
+        }
+    }
+
+    /** Transforms each partition of the impulse response, zero-padded to twice its size. */
+    void transformPartitions (const juce::AudioBuffer<float>& impulseResponse, juce::AudioBuffer<float>& dest,
+                              int start, int partitionSize, int numPartitions)
+    {
+        const auto numChannels = jmax (1, impulseResponse.getNumChannels());
+        const auto numBins = partitionSize + 1;
+
+        dest.setSize (numChannels, jmax (1, numPartitions * numBins * 2));
+        dest.clear();
+
+        if (numPartitions <= 0)
+            return;
+
+        dsp::FFT fft (getFFTOrder (partitionSize));
+        HeapBlock<float> data ((size_t) partitionSize * 4);
+
+        for (int channel = 0; channel < impulseResponse.getNumChannels(); ++channel)
+        {
+            for (int i = 0; i < numPartitions; ++i)
+            {
+                const auto partitionStart = start + i * partitionSize;
+                const auto numSamples = jmin (partitionSize, impulseResponse.getNumSamples() - partitionStart);
+
+                FloatVectorOperations::clear (data.get(), partitionSize * 4);
+                FloatVectorOperations::copy (data.get(), impulseResponse.getReadPointer (channel, partitionStart), numSamples);
+
+                fft.performRealOnlyForwardTransform (data.get(), true);
+                deinterleave (data.get(), dest.getWritePointer (channel, i * numBins * 2), numBins);
+            }
+        }
+    }
+}
+
+//==============================================================================
+PartitionedConvolver::Kernel::Kernel (const juce::AudioBuffer<float>& impulseResponse, int partitionSize) :
+    length (impulseResponse.getNumSamples()),
+    headPartitionSize (partitionSize)
+{
+    jassert (isPowerOfTwo (partitionSize) && partitionSize >= 16);
+
+    const auto tailPartitionSize = headPartitionSize * tailPartitionRatio;
+    const auto headLength = getHeadLength (headPartitionSize);
+
+    numHeadPartitions = jmax (1, (jmin (length, headLength) + headPartitionSize - 1) / headPartitionSize);
+    numTailPartitions = (jmax (0, length - headLength) + tailPartitionSize - 1) / tailPartitionSize;
+
+    transformPartitions (impulseResponse, head, 0, headPartitionSize, numHeadPartitions);
+    transformPartitions (impulseResponse, tail, headLength, tailPartitionSize, numTailPartitions);
+}
+
+//==============================================================================
+/** The threads that convolve the tails, shared by every convolver. */
+class PartitionedConvolver::BackgroundThreads final
+{
+public:
+    BackgroundThreads()
+    {
+        const auto numThreads = jlimit (1, 4, SystemStats::getNumCpus() - 1);
+
+        for (int i = 0; i < numThreads; ++i)
+            workers.add (new Worker (*this))->startThread (8);
+    }
+
+    ~BackgroundThreads()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        workers.clear();
+    }
+
+    //==============================================================================
+    void add (PartitionedConvolver& convolver)
+    {
+        const ScopedWriteLock sl (lock);
+        convolvers.addIfNotAlreadyThere (&convolver);
+    }
+
+    /** NB: This waits for the convolver's tail to be done with, if one of the threads is busy with it. */
+    void remove (PartitionedConvolver& convolver)
+    {
+        const ScopedWriteLock sl (lock);
+        convolvers.removeFirstMatchingValue (&convolver);
+    }
+
+    void notify() noexcept
+    {
+        workAvailable.signal();
+    }
+
+private:
+    //==============================================================================
+    class Worker final : public Thread
+    {
+    public:
+        Worker (BackgroundThreads& o) :
+            Thread ("Convolution Tails"),
+            owner (o)
+        {
+        }
+
+        ~Worker() override
+        {
+            stopThread (1000);
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                owner.workAvailable.wait (10);
+
+                const ScopedReadLock sl (owner.lock);
+                auto hasWokenAnother = false;
+
+                for (auto* convolver : owner.convolvers)
+                {
+                    // Waking up another thread before getting busy, in case more tails are waiting:
+                    if (! hasWokenAnother && convolver->tailJob.load (std::memory_order_relaxed) == TailJob::pending)
+                    {
+                        owner.notify();
+                        hasWokenAnother = true;
+                    }
+
+                    convolver->processTailIfPending();
+                }
+            }
+        }
+
+    private:
+        BackgroundThreads& owner;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+    };
+
+    //==============================================================================
+    ReadWriteLock lock;
+    Array<PartitionedConvolver*> convolvers;
+    WaitableEvent workAvailable;
+    OwnedArray<Worker> workers;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundThreads)
+};
+
+//==============================================================================
+void PartitionedConvolver::Transition::set (const Weights& fromWeights, const Weights& toWeights) noexcept
+{
+    size = 0;
+
+    const auto findOrAdd = [this] (int kernelIndex)
+    {
+        for (int i = 0; i < size; ++i)
+            if (kernelIndices[(size_t) i] == kernelIndex)
+                return i;
+
+        kernelIndices[(size_t) size] = kernelIndex;
+        from[(size_t) size] = 0.0f;
+        to[(size_t) size] = 0.0f;
+        return size++;
+    };
+
+    for (int i = 0; i < fromWeights.size; ++i)
+        from[(size_t) findOrAdd (fromWeights.kernelIndices[(size_t) i])] += fromWeights.values[(size_t) i];
+
+    for (int i = 0; i < toWeights.size; ++i)
+        to[(size_t) findOrAdd (toWeights.kernelIndices[(size_t) i])] += toWeights.values[(size_t) i];
+
+    isRamping = false;
+
+    for (int i = 0; i < size; ++i)
+        if (from[(size_t) i] != to[(size_t) i])
+            isRamping = true;
+}
+
+void PartitionedConvolver::Transform::prepare (int newPartitionSize)
+{
+    partitionSize = newPartitionSize;
+    numBins = partitionSize + 1;
+
+    fft = std::make_unique<dsp::FFT> (getFFTOrder (partitionSize));
+    data.calloc ((size_t) partitionSize * 4);
+    spectrum.calloc ((size_t) numBins * 2);
+    fromSpectrum.calloc ((size_t) numBins * 2);
+    toSpectrum.calloc ((size_t) numBins * 2);
+}
+
+//==============================================================================
+PartitionedConvolver::PartitionedConvolver()
+{
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+    backgroundThreads->remove (*this);
+}
+
+//==============================================================================
+void PartitionedConvolver::prepare (int newNumChannels, const Array<const Kernel*>& newKernels)
+{
+    // Making sure none of the background threads are still busy with the old setup:
+    backgroundThreads->remove (*this);
+    tailJob.store (TailJob::idle);
+    numLateTailPartitions.store (0);
+
+    kernels = newKernels;
+    numChannels = jmax (1, newNumChannels);
+    headPartitionSize = kernels.isEmpty() ? 0 : kernels.getFirst()->getHeadPartitionSize();
+    tailPartitionSize = headPartitionSize * tailPartitionRatio;
+    numHeadPartitions = numTailPartitions = 0;
+    targetWeights = headWeights = tailWeights = {};
+
+    if (kernels.isEmpty())
+        return;
+
+    for (const auto* kernel : kernels)
+    {
+        jassert (kernel->getHeadPartitionSize() == headPartitionSize); // They all have to be partitioned the same way!
+
+        numHeadPartitions = jmax (numHeadPartitions, kernel->numHeadPartitions);
+        numTailPartitions = jmax (numTailPartitions, kernel->numTailPartitions);
+    }
+
+    headTransform.prepare (headPartitionSize);
+    headInputs.setSize (numChannels, headPartitionSize * 2);
+    headSpectra.setSize (numChannels, numHeadPartitions * headTransform.numBins * 2);
+    headFrom.setSize (numChannels, headTransform.numBins * 2);
+    headTo.setSize (numChannels, headTransform.numBins * 2);
+
+    if (numTailPartitions > 0)
+    {
+        tailTransform.prepare (tailPartitionSize);
+        tailInputs.setSize (numChannels, tailPartitionSize * 3);
+        tailOutputs.setSize (numChannels, tailPartitionSize * 2);
+        tailSpectra.setSize (numChannels, numTailPartitions * tailTransform.numBins * 2);
+    }
+
+    reset();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    // NB: Taking the convolver away from the background threads blocks until none of them are busy with it,
+    //     after which whatever tail was still to be worked out can be forgotten about.
+    backgroundThreads->remove (*this);
+    tailJob.store (TailJob::idle);
+
+    for (auto* buffer : { &headInputs, &headSpectra, &headFrom, &headTo, &tailInputs, &tailOutputs, &tailSpectra })
+        buffer->clear();
+
+    headPosition = headSpectrumIndex = 0;
+    tailPosition = tailSlot = tailSpectrumIndex = 0;
+    numDroppedTailPartitions = numTailPartitionsToSkip = 0;
+    hasStarted = false;
+
+    if (numTailPartitions > 0)
+        backgroundThreads->add (*this);
+}
+
+//==============================================================================
+void PartitionedConvolver::setWeights (const int* kernelIndices, const float* weights, int numWeights) noexcept
+{
+    jassert (isPositiveAndNotGreaterThan (numWeights, maxNumWeights));
+
+    targetWeights.size = 0;
+
+    for (int i = 0; i < jmin (numWeights, maxNumWeights); ++i)
+    {
+        if (isPositiveAndBelow (kernelIndices[i], kernels.size()))
+        {
+            targetWeights.kernelIndices[(size_t) targetWeights.size] = kernelIndices[i];
+            targetWeights.values[(size_t) targetWeights.size] = weights[i];
+            ++targetWeights.size;
+        }
+        else
+        {
+            jassertfalse; // There's no such kernel!
+        }
+    }
+
+    if (! hasStarted)
+        headWeights = tailWeights = targetWeights;
+}
+
+//==============================================================================
+void PartitionedConvolver::process (juce::AudioBuffer<float>& buffer) noexcept
+{
+    process (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), 0, buffer.getNumSamples());
+}
+
+void PartitionedConvolver::process (float* const* channels, int numGivenChannels, int startSample, int numSamples) noexcept
+{
+    jassert (numGivenChannels <= numChannels);
+
+    const auto numChannelsToProcess = jmin (numChannels, numGivenChannels);
+
+    if (numHeadPartitions <= 0)
+    {
+        for (int channel = 0; channel < numGivenChannels; ++channel)
+            FloatVectorOperations::clear (channels[channel] + startSample, numSamples);
+
+        return;
+    }
+
+    hasStarted = true;
+
+    for (int start = 0; start < numSamples;)
+    {
+        if (headPosition == 0)
+            startHeadPartition();
+
+        const auto numThisTime = jmin (numSamples - start, headPartitionSize - headPosition);
+
+        for (int channel = 0; channel < numChannelsToProcess; ++channel)
+        {
+            auto* samples = channels[channel] + startSample + start;
+
+            if (numTailPartitions > 0)
+                FloatVectorOperations::copy (tailInputs.getWritePointer (channel, tailPartitionSize * (1 + tailSlot) + tailPosition),
+                                             samples, numThisTime);
+
+            processHead (channel, samples, numThisTime);
+
+            if (numTailPartitions > 0)
+                FloatVectorOperations::add (samples, tailOutputs.getReadPointer (channel, tailPartitionSize * tailSlot + tailPosition),
+                                            numThisTime);
+        }
+
+        start += numThisTime;
+        headPosition += numThisTime;
+        tailPosition += numThisTime;
+
+        if (headPosition >= headPartitionSize)
+        {
+            headPosition = 0;
+
+            // Moving the partition that's just been filled to the front, for the next one to overlap with:
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* inputs = headInputs.getWritePointer (channel);
+                FloatVectorOperations::copy (inputs, inputs + headPartitionSize, headPartitionSize);
+                FloatVectorOperations::clear (inputs + headPartitionSize, headPartitionSize);
+            }
+        }
+
+        if (tailPosition >= tailPartitionSize)
+        {
+            tailPosition = 0;
+
+            if (numTailPartitions > 0)
+                finishTailPartition();
+        }
+    }
+}
+
+//==============================================================================
+void PartitionedConvolver::multiplyAdd (float* destination, const float* a, const float* b, int numBins) noexcept
+{
+    auto* destinationImaginary = destination + numBins;
+    const auto* aImaginary = a + numBins;
+    const auto* bImaginary = b + numBins;
+
+    for (int i = 0; i < numBins; ++i)
+    {
+        destination[i] += a[i] * b[i] - aImaginary[i] * bImaginary[i];
+        destinationImaginary[i] += a[i] * bImaginary[i] + aImaginary[i] * b[i];
+    }
+}
+
+
+void PartitionedConvolver::accumulate (const Transition& transition, bool isHead, int channel,
+                                       const float* inputSpectra, int newestIndex, int numInputSpectra,
+                                       int firstPartition, int endPartition,
+                                       float* scratch, float* from, float* to) const noexcept
+{
+    const auto numBins = isHead ? headTransform.numBins : tailTransform.numBins;
+    const auto spectrumSize = numBins * 2;
+
+    for (int k = 0; k < transition.size; ++k)
+    {
+        const auto fromWeight = transition.isRamping ? transition.from[(size_t) k] : 0.0f;
+        const auto toWeight = transition.to[(size_t) k];
+
+        if (fromWeight == 0.0f && toWeight == 0.0f)
+            continue;
+
+        const auto& kernel = *kernels.getUnchecked (transition.kernelIndices[(size_t) k]);
+        const auto& partitions = isHead ? kernel.head : kernel.tail;
+        const auto* kernelSpectra = partitions.getReadPointer (channel % partitions.getNumChannels());
+        const auto numPartitions = jmin (endPartition, isHead ? kernel.numHeadPartitions : kernel.numTailPartitions);
+
+        if (numPartitions <= firstPartition)
+            continue;
+
+        FloatVectorOperations::clear (scratch, spectrumSize);
+
+        for (int i = firstPartition; i < numPartitions; ++i)
+        {
+            const auto inputIndex = (newestIndex - i + numInputSpectra) % numInputSpectra;
+            multiplyAdd (scratch, inputSpectra + inputIndex * spectrumSize, kernelSpectra + i * spectrumSize, numBins);
+        }
+
+        if (toWeight != 0.0f)
+            FloatVectorOperations::addWithMultiply (to, scratch, toWeight, spectrumSize);
+
+        if (fromWeight != 0.0f)
+            FloatVectorOperations::addWithMultiply (from, scratch, fromWeight, spectrumSize);
+    }
+}
+
+//==============================================================================
+void PartitionedConvolver::startHeadPartition() noexcept
+{
+    headTransition.set (headWeights, targetWeights);
+    headWeights = targetWeights;
+    headSpectrumIndex = (headSpectrumIndex + 1) % numHeadPartitions;
+
+    // Everything but the partition about to be filled is already known, so gets convolved once up front:
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* from = headFrom.getWritePointer (channel);
+        auto* to = headTo.getWritePointer (channel);
+
+        FloatVectorOperations::clear (from, headFrom.getNumSamples());
+        FloatVectorOperations::clear (to, headTo.getNumSamples());
+
+        accumulate (headTransition, true, channel,
+                    headSpectra.getReadPointer (channel), headSpectrumIndex, numHeadPartitions,
+                    1, numHeadPartitions, headTransform.spectrum, from, to);
+    }
+}
+
+void PartitionedConvolver::processHead (int channel, float* samples, int numSamples) noexcept
+{
+    auto& transform = headTransform;
+    const auto size = transform.partitionSize;
+    const auto spectrumSize = transform.numBins * 2;
+
+    // The previous partition, then as much of the current one as there is so far:
+    auto* inputs = headInputs.getWritePointer (channel);
+    FloatVectorOperations::copy (inputs + size + headPosition, samples, numSamples);
+    FloatVectorOperations::copy (transform.data, inputs, size * 2);
+
+    transform.fft->performRealOnlyForwardTransform (transform.data, true);
+
+    auto* inputSpectrum = headSpectra.getWritePointer (channel, headSpectrumIndex * spectrumSize);
+    deinterleave (transform.data, inputSpectrum, transform.numBins);
+
+    FloatVectorOperations::copy (transform.fromSpectrum, headFrom.getReadPointer (channel), spectrumSize);
+    FloatVectorOperations::copy (transform.toSpectrum, headTo.getReadPointer (channel), spectrumSize);
+
+    accumulate (headTransition, true, channel,
+                headSpectra.getReadPointer (channel), headSpectrumIndex, numHeadPartitions,
+                0, 1, transform.spectrum, transform.fromSpectrum, transform.toSpectrum);
+
+    const auto* output = transform.data + size + headPosition;
+
+    if (headTransition.isRamping)
+    {
+        interleave (transform.fromSpectrum, transform.data, transform.numBins);
+        transform.fft->performRealOnlyInverseTransform (transform.data);
+        FloatVectorOperations::copy (samples, output, numSamples);
+
+        interleave (transform.toSpectrum, transform.data, transform.numBins);
+        transform.fft->performRealOnlyInverseTransform (transform.data);
+        rampBetween (samples, output, numSamples, headPosition, size);
+    }
+    else
+    {
+        interleave (transform.toSpectrum, transform.data, transform.numBins);
+        transform.fft->performRealOnlyInverseTransform (transform.data);
+        FloatVectorOperations::copy (samples, output, numSamples);
+    }
+}
+
+//==============================================================================
+void PartitionedConvolver::finishTailPartition() noexcept
+{
+    // The last partition's tail is about to be played, so must be done with by now:
+    if (tailJob.load (std::memory_order_acquire) != TailJob::idle)
+    {
+        if (! isNonRealtime)
+        {
+            // Whether none of the threads got to it yet or one is still busy with it, working it out here could take
+            // longer than the callback has left. So rather than do that or wait, the output that was just played gets
+            // played again, and the partition of input that was just filled gets written over,
+            // to be made up for with silence once the threads have caught up:
+            numDroppedTailPartitions = jmin (numDroppedTailPartitions + 1, numTailPartitions);
+            numLateTailPartitions.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Offline, there's all the time in the world, so it gets worked out here if none of the threads got to it:
+        if (! processTailIfPending())
+            while (tailJob.load (std::memory_order_acquire) != TailJob::idle)
+                tailJobFinished.wait (1);
+    }
+
+    tailTransition.set (tailWeights, targetWeights);
+    tailWeights = targetWeights;
+    numTailPartitionsToSkip = numDroppedTailPartitions;
+    numDroppedTailPartitions = 0;
+
+    // NB: The slot that's just been filled, and the output that's just been played, are the ones to work on next.
+    tailSlot = 1 - tailSlot;
+
+    tailJob.store (TailJob::pending, std::memory_order_release);
+    backgroundThreads->notify();
+}
+
+bool PartitionedConvolver::processTailIfPending() noexcept
+{
+    auto expected = TailJob::pending;
+
+    if (! tailJob.compare_exchange_strong (expected, TailJob::running, std::memory_order_acquire))
+        return false;
+
+    processTail();
+    tailJob.store (TailJob::idle, std::memory_order_release);
+    tailJobFinished.signal();
+    return true;
+}
+
+void PartitionedConvolver::processTail() noexcept
+{
+    auto& transform = tailTransform;
+    const auto size = transform.partitionSize;
+    const auto spectrumSize = transform.numBins * 2;
+    const auto slot = 1 - tailSlot;
+
+    // Keeping the partitions that got dropped in the history, as silence, so that the ones around them stay in step.
+    // NB: The first of them still overlaps with the last partition that made it, which has to be kept in.
+    for (int i = 0; i < numTailPartitionsToSkip; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* spectrum = tailSpectra.getWritePointer (channel, tailSpectrumIndex * spectrumSize);
+
+            if (i == 0)
+            {
+                FloatVectorOperations::copy (transform.data, tailInputs.getReadPointer (channel), size);
+                FloatVectorOperations::clear (transform.data + size, size);
+
+                transform.fft->performRealOnlyForwardTransform (transform.data, true);
+                deinterleave (transform.data, spectrum, transform.numBins);
+            }
+            else
+            {
+                FloatVectorOperations::clear (spectrum, spectrumSize);
+            }
+        }
+
+        tailSpectrumIndex = (tailSpectrumIndex + 1) % numTailPartitions;
+    }
+
+    if (numTailPartitionsToSkip > 0)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            FloatVectorOperations::clear (tailInputs.getWritePointer (channel), size);
+
+        numTailPartitionsToSkip = 0;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* previous = tailInputs.getWritePointer (channel);
+        const auto* current = tailInputs.getReadPointer (channel, size * (1 + slot));
+
+        FloatVectorOperations::copy (transform.data, previous, size);
+        FloatVectorOperations::copy (transform.data + size, current, size);
+        FloatVectorOperations::copy (previous, current, size);
+
+        transform.fft->performRealOnlyForwardTransform (transform.data, true);
+        deinterleave (transform.data, tailSpectra.getWritePointer (channel, tailSpectrumIndex * spectrumSize), transform.numBins);
+
+        FloatVectorOperations::clear (transform.fromSpectrum, spectrumSize);
+        FloatVectorOperations::clear (transform.toSpectrum, spectrumSize);
+
+        accumulate (tailTransition, false, channel,
+                    tailSpectra.getReadPointer (channel), tailSpectrumIndex, numTailPartitions,
+                    0, numTailPartitions, transform.spectrum, transform.fromSpectrum, transform.toSpectrum);
+
+        auto* output = tailOutputs.getWritePointer (channel, size * slot);
+
+        if (tailTransition.isRamping)
+        {
+            interleave (transform.fromSpectrum, transform.data, transform.numBins);
+            transform.fft->performRealOnlyInverseTransform (transform.data);
+            FloatVectorOperations::copy (output, transform.data + size, size);
+
+            interleave (transform.toSpectrum, transform.data, transform.numBins);
+            transform.fft->performRealOnlyInverseTransform (transform.data);
+            rampBetween (output, transform.data + size, size, 0, size);
+        }
+        else
+        {
+            interleave (transform.toSpectrum, transform.data, transform.numBins);
+            transform.fft->performRealOnlyInverseTransform (transform.data);
+            FloatVectorOperations::copy (output, transform.data + size, size);
+        }
+    }
+
+    tailSpectrumIndex = (tailSpectrumIndex + 1) % numTailPartitions;
+}
@@ -0,0 +1,220 @@
+/** Convolves audio with a mix of impulse responses, whose weights can change while playing.
+
+    The start of each impulse response gets convolved on the audio thread, in short partitions,
+    without adding any latency. Everything after that gets convolved in much longer partitions
+    on a handful of background threads, shared by every convolver, which have a whole partition's
+    worth of time to get each one done. That keeps impulse responses that are seconds long cheap,
+    even with lots of convolvers running at once.
+
+    The audio thread never waits on those threads, nor takes over their work: if none of them
+    has finished a partition when it's due, the tail plays on from the one before it, and the input
+    that was meant for it gets left out of the tail, which is counted in getNumLateTailPartitions().
+    When rendering offline, call setNonRealtime() to have it finish the partition itself or wait instead,
+    so that nothing gets left out.
+
+    The impulse responses get mixed together in the frequency domain, so mixing in more of them
+    mostly costs a few more multiplies. When the weights change, the output gets ramped from
+    the old mix to the new one over the next partition, so that moving between them doesn't click.
+
+    Nothing gets allocated while processing.
+
+    @see PositionedImpulseResponse, ConvolutionProcessor
+*/
+class PartitionedConvolver final
+{
+public:
+    //==============================================================================
+    /** An impulse response, cut up into partitions and transformed, ready to be convolved with.
+
+        Building one of these allocates, and does a whole bunch of FFTs, so avoid doing it on the audio thread.
+        The same kernel can be used by any number of convolvers at once.
+    */
+    class Kernel final
+    {
+    public:
+        /** Creates a kernel out of an impulse response.
+
+            @param impulseResponse      The impulse response, which should be at the same sample rate as the audio.
+                                        Each channel of the audio gets convolved with the matching channel,
+                                        wrapping around when there are fewer of them.
+            @param headPartitionSize    The size of the partitions convolved on the audio thread,
+                                        which must be a power of two. The ones on the background
+                                        threads are tailPartitionRatio times longer.
+        */
+        Kernel (const juce::AudioBuffer<float>& impulseResponse, int headPartitionSize);
+
+        //==============================================================================
+        /** @returns the length of the impulse response, in samples. */
+        int getLength() const noexcept                  { return length; }
+        /** @returns the number of channels in the impulse response. */
+        int getNumChannels() const noexcept             { return head.getNumChannels(); }
+        /** @returns the size of the partitions convolved on the audio thread. */
+        int getHeadPartitionSize() const noexcept       { return headPartitionSize; }
+
+    private:
+        //==============================================================================
+        friend class PartitionedConvolver;
+
+        int length = 0, headPartitionSize = 0;
+        int numHeadPartitions = 0, numTailPartitions = 0;
+
+        /** The spectrum of each partition, as all of the real parts followed by all of the imaginary parts. */
+        juce::AudioBuffer<float> head, tail;
+
+        //==============================================================================
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Kernel)
+    };
+
+    //==============================================================================
+    /** How much longer the partitions on the background threads are than the ones on the audio thread. */
+    static constexpr int tailPartitionRatio = 8;
+
+    /** The most kernels that can be mixed together at once. */
+    static constexpr int maxNumWeights = 4;
+
+    //==============================================================================
+    /** Constructor. */
+    PartitionedConvolver();
+
+    /** Destructor. */
+    ~PartitionedConvolver();
+
+    //==============================================================================
+    /** Allocates everything needed to convolve the given number of channels with any of the kernels.
+
+        The kernels must all have the same head partition size,
+        and must outlive this convolver, or the next call to prepare().
+    */
+    void prepare (int numChannels, const Array<const Kernel*>& kernels);
+
+    /** Clears any audio still ringing out.
+
+        NB: This waits for any background thread that's busy with this convolver, so avoid calling it from the audio thread.
+    */
+    void reset() noexcept;
+
+    /** Makes process() work out a late partition of the tail itself, or wait for the background thread
+        that's busy with it, which suits offline rendering. By default, it does neither.
+    */
+    void setNonRealtime (bool shouldWait) noexcept          { isNonRealtime = shouldWait; }
+
+    /** @returns how many partitions of the tail weren't ready in time, since the convolver was prepared. */
+    int getNumLateTailPartitions() const noexcept           { return numLateTailPartitions.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Sets how much of each kernel to mix in, which can be called from the audio thread.
+
+        The change gets ramped in over the next partition,
+        unless nothing has been processed since the last reset.
+
+        @param kernelIndices    The indexes of the kernels, in the array given to prepare().
+        @param weights          How much of each of those kernels to mix in.
+        @param numWeights       The number of kernels to mix in, up to maxNumWeights.
+    */
+    void setWeights (const int* kernelIndices, const float* weights, int numWeights) noexcept;
+
+    /** Replaces the audio in the buffer with its convolution. */
+    void process (juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** Replaces the audio in a part of some channels with its convolution,
+        which saves building an AudioBuffer to refer to them.
+
+        @param channels     The channels, of which there must be no more than the convolver was prepared for.
+        @param numChannels  The number of channels.
+        @param startSample  Where the part to process starts in each channel.
+        @param numSamples   The number of samples to process.
+    */
+    void process (float* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    class BackgroundThreads;
+
+    /** A set of kernels and how much of each to mix in. */
+    struct Weights final
+    {
+        std::array<int, maxNumWeights> kernelIndices;
+        std::array<float, maxNumWeights> values;
+        int size = 0;
+    };
+
+    /** Every kernel in either of two sets of weights, with how much of it each set mixes in. */
+    struct Transition final
+    {
+        void set (const Weights& from, const Weights& to) noexcept;
+
+        std::array<int, maxNumWeights * 2> kernelIndices;
+        std::array<float, maxNumWeights * 2> from, to;
+        int size = 0;
+        bool isRamping = false;
+    };
+
+    /** The FFT and scratch space for one of the partition sizes. */
+    struct Transform final
+    {
+        void prepare (int partitionSize);
+
+        std::unique_ptr<dsp::FFT> fft;
+        HeapBlock<float> data, spectrum, fromSpectrum, toSpectrum;
+        int partitionSize = 0, numBins = 0;
+    };
+
+    //==============================================================================
+    SharedResourcePointer<BackgroundThreads> backgroundThreads;
+
+    Array<const Kernel*> kernels;
+    int numChannels = 0, headPartitionSize = 0, tailPartitionSize = 0;
+    int numHeadPartitions = 0, numTailPartitions = 0;
+
+    Weights targetWeights;
+    bool hasStarted = false;    //< Until there's been some audio, new weights don't need ramping to.
+    bool isNonRealtime = false;
+
+    // The head, convolved on the audio thread:
+    Transform headTransform;
+    Transition headTransition;
+    Weights headWeights;
+    juce::AudioBuffer<float> headInputs;        //< The last partition of input, then the current one.
+    juce::AudioBuffer<float> headSpectra;       //< The spectrum of each of the last partitions of input.
+    juce::AudioBuffer<float> headFrom, headTo;  //< Everything but the current partition, convolved.
+    int headPosition = 0, headSpectrumIndex = 0;
+
+    // The tail, convolved on the background threads:
+    enum class TailJob { idle, pending, running };
+    std::atomic<TailJob> tailJob { TailJob::idle };
+    WaitableEvent tailJobFinished;
+    std::atomic<int> numLateTailPartitions { 0 };
+
+    Transform tailTransform;
+    Transition tailTransition;
+    Weights tailWeights;
+    juce::AudioBuffer<float> tailInputs;        //< The previous partition of input, then two more to take turns filling.
+    juce::AudioBuffer<float> tailOutputs;       //< Two partitions of output, one being played and one being worked out.
+    juce::AudioBuffer<float> tailSpectra;
+    int tailPosition = 0, tailSlot = 0, tailSpectrumIndex = 0;
+    int numDroppedTailPartitions = 0;   //< The partitions of input that were filled while running late, so never got convolved.
+    int numTailPartitionsToSkip = 0;    //< The dropped partitions, once handed over to the next job.
+
+    //==============================================================================
+    static void multiplyAdd (float* destination, const float* a, const float* b, int numBins) noexcept;
+
+    /** Convolves the input spectra with the partitions of every kernel in the transition,
+        from firstPartition up to endPartition, adding what each kernel comes to into the from and to spectra.
+
+        The input spectra go round in a circle, with the newest one at newestIndex,
+        and partition n of each kernel gets multiplied by the one from n partitions ago.
+    */
+    void accumulate (const Transition& transition, bool isHead, int channel,
+                     const float* inputSpectra, int newestIndex, int numInputSpectra,
+                     int firstPartition, int endPartition,
+                     float* scratch, float* from, float* to) const noexcept;
+
+    void startHeadPartition() noexcept;
+    void processHead (int channel, float* samples, int numSamples) noexcept;
+    void finishTailPartition() noexcept;
+    void processTail() noexcept;
+    bool processTailIfPending() noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PartitionedConvolver)
+};
@@ -0,0 +1,237 @@
+/** Single cycles of each waveform, with fewer and fewer harmonics, shared by every WavetableLFO. */
+class WavetableLFO::Wavetables final
+{
+public:
+    Wavetables()
+    {
+        // Every harmonic gets read out of one cycle of a sine, so building the tables stays cheap:
+        std::vector<double> sine ((size_t) tableSize), sum ((size_t) tableSize);
+
+        for (int i = 0; i < tableSize; ++i)
+            sine[(size_t) i] = std::sin (MathConstants<double>::twoPi * (double) i / (double) tableSize);
+
+        sineTable.resize ((size_t) tableSize + 1);
+        store (sine, sineTable.data());
+
+        for (const auto w : { Waveform::triangle, Waveform::ramp, Waveform::square })
+        {
+            auto& levels = tables[(size_t) w];
+            levels.resize ((size_t) (numLevels * (tableSize + 1)));
+
+            for (int level = 0; level < numLevels; ++level)
+            {
+                const auto numHarmonics = 1 << level;
+                std::fill (sum.begin(), sum.end(), 0.0);
+
+                for (int harmonic = 1; harmonic <= numHarmonics; ++harmonic)
+                {
+                    // The Lanczos sigma factors tame the ringing around the edges:
+                    const auto sigmaPosition = MathConstants<double>::pi * harmonic / (numHarmonics + 1);
+                    const auto sigma = harmonic > 1 ? std::sin (sigmaPosition) / sigmaPosition : 1.0;
+                    const auto amplitude = sigma * getHarmonicAmplitude (w, harmonic);
+
+                    if (amplitude != 0.0)
+                        for (int i = 0; i < tableSize; ++i)
+                            sum[(size_t) i] += amplitude * sine[(size_t) ((harmonic * i) % tableSize)];
+                }
+
+                store (sum, levels.data() + level * (tableSize + 1));
+            }
+        }
+    }
+
+    //==============================================================================
+    /** @returns the table with as many harmonics as fit below Nyquist at the given rate. */
+    const float* getTable (Waveform waveform, double phasePerSample) const noexcept
+    {
+        if (waveform == Waveform::sine)
+            return sineTable.data();
+
+        auto level = numLevels - 1;
+
+        if (phasePerSample > 0.0)
+            level = jlimit (0, numLevels - 1, (int) std::floor (std::log2 (0.5 / phasePerSample)));
+
+        return tables[(size_t) waveform].data() + level * (tableSize + 1);
+    }
+
+    //==============================================================================
+    static constexpr int tableSize = 2048;
+    static constexpr int numLevels = 10;    //< The top level has up to 512 harmonics.
+
+private:
+    //==============================================================================
+    std::vector<float> sineTable;
+    std::array<std::vector<float>, 4> tables;
+
+    //==============================================================================
+    /** @returns the amplitude of a harmonic in the Fourier series of a waveform that goes from -1 to 1. */
+    static double getHarmonicAmplitude (Waveform waveform, int harmonic) noexcept
+    {
+        constexpr auto pi = MathConstants<double>::pi;
+        const auto n = (double) harmonic;
+        const auto isOdd = (harmonic % 2) != 0;
+
+        switch (waveform)
+        {
+            case Waveform::triangle:    return isOdd ? ((harmonic % 4) == 1 ? 8.0 : -8.0) / (pi * pi * n * n) : 0.0;
+            case Waveform::ramp:        return -2.0 / (pi * n);
+            case Waveform::square:      return isOdd ? 4.0 / (pi * n) : 0.0;
+            case Waveform::sine:        return harmonic == 1 ? 1.0 : 0.0;
+            default:                    break;
+        }
+
+        jassertfalse;
+        return 0.0;
+    }
+
+    /** Scales down whatever little overshoot is left, so the output never goes past 1,
+        and adds a copy of the first sample to the end for the interpolation to reach into.
+    */
+    static void store (const std::vector<double>& source, float* dest) noexcept
+    {
+        double peak = 0.0;
+
+        for (const auto s : source)
+            peak = jmax (peak, std::abs (s));
+
+        const auto scale = peak > 1.0 ? 1.0 / peak : 1.0;
+
+        for (int i = 0; i < tableSize; ++i)
+            dest[i] = (float) (source[(size_t) i] * scale);
+
+        dest[tableSize] = dest[0];
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Wavetables)
+};
+
+//==============================================================================
+const WavetableLFO::Wavetables& WavetableLFO::getWavetables()
+{
+    static const Wavetables wavetables;
+    return wavetables;
+}
+
+//==============================================================================
+WavetableLFO::WavetableLFO (Waveform w) :
+    waveform (w)
+{
+    prepare (sampleRate, 512);
+}
+
+//==============================================================================
+void WavetableLFO::prepare (double newSampleRate, int newMaxBlockSize)
+{
+    jassert (newSampleRate > 0.0 && newMaxBlockSize > 0);
+
+    sampleRate = newSampleRate;
+    maxBlockSize = jmax (1, newMaxBlockSize);
+    modulation.calloc ((size_t) maxBlockSize);
+
+    // NB: Making sure the tables are built here, rather than on the audio thread.
+    ignoreUnused (getWavetables());
+
+    updatePhasePerSample();
+}
+
+void WavetableLFO::reset (double newPhase) noexcept
+{
+    phase = newPhase - std::floor (newPhase);
+}
+
+//==============================================================================
+void WavetableLFO::setFrequency (double newFrequency) noexcept
+{
+    jassert (newFrequency >= 0.0);
+
+    frequency = jmax (0.0, newFrequency);
+    updatePhasePerSample();
+}
+
+void WavetableLFO::setTempoSyncedRate (const Tempo& tempo, double numBeatsPerCycle) noexcept
+{
+    jassert (numBeatsPerCycle > 0.0);
+
+    setFrequency (tempo.get() / (60.0 * numBeatsPerCycle));
+}
+
+void WavetableLFO::syncToBeat (double beatPosition, double numBeatsPerCycle) noexcept
+{
+    jassert (numBeatsPerCycle > 0.0);
+
+    reset (beatPosition / numBeatsPerCycle);
+}
+
+void WavetableLFO::updatePhasePerSample() noexcept
+{
+    // Anything past Nyquist would only alias anyway:
+    phasePerSample = jlimit (0.0, 0.5, frequency / sampleRate);
+}
+
+//==============================================================================
+const float* WavetableLFO::generate (int numSamples) noexcept
+{
+    jassert (isPositiveAndNotGreaterThan (numSamples, maxBlockSize));
+    numSamples = jlimit (0, maxBlockSize, numSamples);
+
+    constexpr auto tableSize = Wavetables::tableSize;
+    const auto* table = getWavetables().getTable (waveform, phasePerSample);
+    auto* dest = modulation.get();
+    auto p = phase;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto position = p * (double) tableSize;
+        const auto index = (int) position;
+        const auto fraction = (float) (position - (double) index);
+
+        dest[i] = table[index] + fraction * (table[index + 1] - table[index]);
+
+        p += phasePerSample;
+
+        if (p >= 1.0)
+            p -= 1.0;
+    }
+
+    phase = p;
+
+    if (depth != 1.0f)
+        FloatVectorOperations::multiply (dest, depth, numSamples);
+
+    return dest;
+}
+
+void WavetableLFO::process (juce::AudioBuffer<float>& buffer) noexcept
+{
+    const auto numChannels = buffer.getNumChannels();
+    const auto numSamples = buffer.getNumSamples();
+    auto** channels = buffer.getArrayOfWritePointers();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        const auto numThisTime = jmin (maxBlockSize, numSamples - start);
+        const auto* values = generate (numThisTime);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            auto* dest = channels[i] + start;
+
+            switch (operation)
+            {
+                case Operation::add:        FloatVectorOperations::add (dest, values, numThisTime); break;
+                case Operation::subtract:   FloatVectorOperations::subtract (dest, values, numThisTime); break;
+                case Operation::multiply:   FloatVectorOperations::multiply (dest, values, numThisTime); break;
+                case Operation::replace:    FloatVectorOperations::copy (dest, values, numThisTime); break;
+
+                case Operation::divide:
+                    for (int s = 0; s < numThisTime; ++s)
+                        dest[s] /= values[s];
+                break;
+
+                default: jassertfalse; break;
+            }
+        }
+    }
+}
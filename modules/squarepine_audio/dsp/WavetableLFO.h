@@ -0,0 +1,117 @@
+class Tempo;
+
+//==============================================================================
+/** An LFO that works out a whole block of modulation values at once.
+
+    The waveforms come from band-limited wavetables, read with a phase accumulator
+    that carries on from one block to the next. The table is picked once per block,
+    according to the rate, so that fast rates don't alias.
+
+    Applying the modulation to a buffer is a single vectorised pass per channel,
+    so there are no virtual calls or per-sample maths in the way.
+
+    Unlike LFO, this doesn't allocate anything once prepare() has been called.
+*/
+class WavetableLFO final
+{
+public:
+    //==============================================================================
+    /** */
+    enum class Waveform
+    {
+        sine,       //< Starts at 0, going up.
+        triangle,   //< Starts at 0, going up.
+        ramp,       //< Goes from -1 up to 1.
+        square      //< Starts at 1, for the first half of the cycle.
+    };
+
+    /** How the modulation gets combined with the samples of a buffer. */
+    enum class Operation
+    {
+        add,
+        subtract,
+        multiply,
+        divide,
+        replace
+    };
+
+    //==============================================================================
+    /** Constructor. */
+    WavetableLFO (Waveform waveform = Waveform::sine);
+
+    //==============================================================================
+    /** Prepares to generate blocks of up to the given size.
+        Longer blocks are fine too, but get done in several passes.
+    */
+    void prepare (double sampleRate, int maxBlockSize);
+
+    /** Moves the phase back to the given point in the cycle, between 0 and 1. */
+    void reset (double newPhase = 0.0) noexcept;
+
+    //==============================================================================
+    /** */
+    void setWaveform (Waveform newWaveform) noexcept        { waveform = newWaveform; }
+    /** */
+    Waveform getWaveform() const noexcept                   { return waveform; }
+
+    /** */
+    void setOperation (Operation newOperation) noexcept     { operation = newOperation; }
+    /** */
+    Operation getOperation() const noexcept                 { return operation; }
+
+    /** Sets the rate in Hz. */
+    void setFrequency (double newFrequency) noexcept;
+    /** @returns the rate in Hz. */
+    double getFrequency() const noexcept                    { return frequency; }
+
+    /** Sets the rate to a cycle every so many beats at the given tempo.
+
+        For example, a quarter note at 120 BPM would be a cycle every beat, or 2 Hz.
+    */
+    void setTempoSyncedRate (const Tempo& tempo, double numBeatsPerCycle) noexcept;
+
+    /** Moves the phase to where it would be at the given position in beats,
+        when tempo-synced with the given number of beats per cycle.
+
+        Use this to line the LFO up with the host's transport.
+    */
+    void syncToBeat (double beatPosition, double numBeatsPerCycle) noexcept;
+
+    /** Sets how much the waveform gets scaled by. Defaults to 1. */
+    void setDepth (float newDepth) noexcept                 { depth = newDepth; }
+    /** */
+    float getDepth() const noexcept                         { return depth; }
+
+    /** @returns the current point in the cycle, between 0 and 1. */
+    double getPhase() const noexcept                        { return phase; }
+
+    //==============================================================================
+    /** Works out the next numSamples modulation values, and moves the phase along.
+
+        @returns the values, which stay valid until the next call.
+                 numSamples must not be more than the block size given to prepare().
+    */
+    const float* generate (int numSamples) noexcept;
+
+    /** Applies the next block of modulation to all of the channels of the buffer. */
+    void process (juce::AudioBuffer<float>& buffer) noexcept;
+
+private:
+    //==============================================================================
+    class Wavetables;
+
+    Waveform waveform = Waveform::sine;
+    Operation operation = Operation::replace;
+    double sampleRate = 44100.0, frequency = 1.0, phase = 0.0, phasePerSample = 0.0;
+    float depth = 1.0f;
+
+    HeapBlock<float> modulation;
+    int maxBlockSize = 0;
+
+    //==============================================================================
+    static const Wavetables& getWavetables();
+    void updatePhasePerSample() noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableLFO)
+};
@@ -1,106 +1,197 @@
 //==============================================================================
-#if 0 && ! DOXYGEN
-    //These are some bits of code that could be useful someday...
+BitCrusherProcessor::Quantiser BitCrusherProcessor::Quantiser::forBitDepth (int bitDepth) noexcept
+{
+    Quantiser quantiser;
 
-    /** Obtain the maximum value, pre-negative a number of bits to the */
-    inline float getMaxValueForNumBits (int numBits) noexcept
+    if (bitDepth < 32)
     {
-        BigInteger biggy;
-        biggy.setRange (0, numBits - 1, true);
-
-        return (float) biggy.toInteger() * 0.5f; //Halved to offset, making the middle-most number 0 dBFS
+        quantiser.scale = std::ldexp (1.0f, jmax (1, bitDepth) - 1);
+        quantiser.inverseScale = 1.0f / quantiser.scale;
+        quantiser.wet = 1.0f;
     }
 
-    /** Discrete sample bit-conversion algorithm */
-    inline float reduceSample (float sample, int bitDepth) noexcept
-    {
-        return (float) std::clamp (getMaxValueForNumBits (bitDepth) * sample, -maxValue, maxValue);
-    }
+    return quantiser;
+}
 
-    inline constexpr float compressSample (float sample, float scale) noexcept
+namespace
+{
+    /** Quantises a sample down to the steps of the given scale, rounding towards negative infinity,
+        and clipping at the largest step below 1.
+
+        NB: Truncating and stepping down below zero, instead of calling std::floor,
+            so the loops around this vectorise without needing SSE4.1.
+    */
+    inline float quantiseSample (float sample, float scale, float inverseScale) noexcept
     {
-        return sample * scale;
+        const auto scaled = jlimit (-scale, scale - 1.0f, sample * scale);
+        const auto truncated = (float) (int) scaled;
+        return (truncated > scaled ? truncated - 1.0f : truncated) * inverseScale;
     }
+}
+
+//==============================================================================
+BitCrusherProcessor::BitCrusherProcessor()
+{
+    addParameter (bitDepth);
+    addParameter (downsampling);
+}
+
+//==============================================================================
+void BitCrusherProcessor::setBitDepth (int newBitDepth)
+{
+    bitDepth->operator= (newBitDepth);
+}
 
-    // Ye olde...
-    m = (float) (1 << (localBitDepth - 1));
-    M = 1.0f / (float) m;
+int BitCrusherProcessor::getBitDepth() const noexcept
+{
+    return bitDepth->get();
+}
 
-    for (int i = numChannels; --i >= 0;)
-        for (int f = numSamples; --f >= 0;)
-            dest[i][f] = (float) ((float) src[i][f] * m * M);
-#endif
+void BitCrusherProcessor::setDownsampling (int newDownsampling)
+{
+    downsampling->operator= (newDownsampling);
+}
+
+int BitCrusherProcessor::getDownsampling() const noexcept
+{
+    return downsampling->get();
+}
 
 //==============================================================================
-inline double crushToNBit (double sample, int bitDepth)
+void BitCrusherProcessor::setOversampling (int factor, Oversampler::FilterType filterType)
 {
-    constexpr auto one = 1.0;
-    constexpr auto two = 2.0;
+    // NB: Preparing the new oversampler before swapping it in, so the audio thread never waits on the allocations.
+    auto newOversampler = std::make_unique<Oversampler> (factor, filterType);
+    newOversampler->prepare (jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels()), jmax (1, getBlockSize()));
 
-    const auto bd = bitDepth;
-    auto s = 0.0;
+    {
+        const ScopedLock sl (getCallbackLock());
+        std::swap (oversampler, newOversampler);
+    }
 
-	if (sample >= 1.0f)
-       s = std::pow (two, bd - 1) - one;
-	else if (sample <= -1.0f)
-       s = std::pow (-two, bd - 1);
-    else
-       s = std::floor (sample * -std::pow (-two, bd - one));
+    setLatencySamples (oversampler->getLatencySamples());
+}
 
-    // NB: Deliberately quantising with casts here!
-	return (double) (int) s;
+int BitCrusherProcessor::getOversamplingFactor() const noexcept
+{
+    return oversampler->getFactor();
 }
 
-inline double crushBit (double sample, int bitDepth)
+//==============================================================================
+void BitCrusherProcessor::prepareToPlay (double newSampleRate, int bufferSize)
 {
-/*
-    auto mixAmount = lerp (1.0, 32.0, static_cast<double> (bitDepth) / 32.0) / 32.0;
+    const ScopedLock sl (getCallbackLock());
 
-    mixAmount *= 0.08;
+    setRateAndBufferSizeDetails (newSampleRate, bufferSize);
 
-    mixAmount = 0.0;
+    const auto numChannels = jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels());
 
-    sample = (sample * (1.0 - mixAmount))
-           + (DistortionFunctions::hyperbolicTangentSoftClipping (sample) * mixAmount);
-*/
-    sample = crushToNBit (sample, bitDepth);
+    oversampler->prepare (numChannels, jmax (1, bufferSize));
+    setLatencySamples (oversampler->getLatencySamples());
 
-	sample = sample / -std::pow (-2.0, (double) bitDepth - 1.0);
+    heldSamples.calloc ((size_t) numChannels);
+    numHeldChannels = numChannels;
+    holdPosition = 0;
 
-    return sample;
+    lastQuantiser = Quantiser::forBitDepth (bitDepth->get());
 }
 
-//==============================================================================
-BitCrusherProcessor::BitCrusherProcessor()
+void BitCrusherProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
 {
-    addParameter (bitDepth);
+    const ScopedLock sl (getCallbackLock());
+
+    const auto factor = oversampler->getFactor();
+
+    // NB: Even silence has to go through the oversampler's filters, which are still holding
+    //     the tail of the audio before it, lest that get lost and the filters fall out of step.
+    if (buffer.hasBeenCleared() && factor <= 1)
+        return; // Nothing to do here.
+
+    const auto quantiser = Quantiser::forBitDepth (bitDepth->get());
+
+    // NB: Holding for as long at the higher rate, so that the effective rate stays the same.
+    const auto localDownsampling = downsampling->get();
+    const auto holdLength = localDownsampling > 1 ? localDownsampling * factor : 1;
+
+    // When oversampling, the audio still has to go through the filters, to keep the latency the same.
+    if (quantiser.wet == 0.0f && lastQuantiser.wet == 0.0f && holdLength <= 1 && factor <= 1)
+        return;
+
+    oversampler->process (buffer, [&] (juce::AudioBuffer<float>& b)
+    {
+        hold (b, holdLength);
+
+        const auto numSamples = b.getNumSamples();
+
+        for (int i = b.getNumChannels(); --i >= 0;)
+        {
+            auto* samples = b.getWritePointer (i);
+
+            if (quantiser != lastQuantiser)
+                crossfade (samples, numSamples, lastQuantiser, quantiser);
+            else if (quantiser.wet > 0.0f)
+                quantise (samples, numSamples, quantiser);
+        }
+
+        lastQuantiser = quantiser;
+    });
 }
 
 //==============================================================================
-void BitCrusherProcessor::setBitDepth (int newBitDepth)
+void BitCrusherProcessor::quantise (float* samples, int numSamples, const Quantiser& quantiser) noexcept
 {
-    bitDepth->operator= (newBitDepth);
+    const auto scale = quantiser.scale;
+    const auto inverseScale = quantiser.inverseScale;
+
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] = quantiseSample (samples[i], scale, inverseScale);
 }
 
-int BitCrusherProcessor::getBitDepth() const noexcept
+void BitCrusherProcessor::crossfade (float* samples, int numSamples, const Quantiser& from, const Quantiser& to) noexcept
 {
-    return bitDepth->get();
+    const auto step = 1.0f / (float) jmax (1, numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto sample = samples[i];
+        const auto a = sample + (quantiseSample (sample, from.scale, from.inverseScale) - sample) * from.wet;
+        const auto b = sample + (quantiseSample (sample, to.scale, to.inverseScale) - sample) * to.wet;
+
+        samples[i] = a + (b - a) * ((float) (i + 1) * step);
+    }
 }
 
-//==============================================================================
-void BitCrusherProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
+void BitCrusherProcessor::hold (juce::AudioBuffer<float>& buffer, int holdLength) noexcept
 {
-    int localBitDepth = 32;
+    if (holdLength <= 1)
+        return;
+
+    if (holdPosition >= holdLength)
+        holdPosition = 0;
 
+    const auto numChannels = jmin (buffer.getNumChannels(), numHeldChannels);
+    const auto numSamples = buffer.getNumSamples();
+    auto position = holdPosition;
+
+    for (int channel = 0; channel < numChannels; ++channel)
     {
-        const ScopedLock sl (getCallbackLock());
-        localBitDepth = bitDepth->get();
+        auto* samples = buffer.getWritePointer (channel);
+        auto& held = heldSamples[channel];
+        position = holdPosition;
+
+        // Filling in whole runs of the held sample at a time:
+        for (int i = 0; i < numSamples;)
+        {
+            if (position == 0)
+                held = samples[i];
+
+            const auto runLength = jmin (holdLength - position, numSamples - i);
+            FloatVectorOperations::fill (samples + i, held, runLength);
+
+            i += runLength;
+            position = (position + runLength) % holdLength;
+        }
     }
 
-    if (buffer.hasBeenCleared() || localBitDepth >= 32)
-        return; // Nothing to do here.
-
-    for (auto channel : AudioBufferView<float> (buffer))
-        for (auto& sample : channel)
-            sample = (float) crushBit ((double) sample, localBitDepth);
+    holdPosition = position;
 }
@@ -1,4 +1,10 @@
-/** Use this processor to dynamically crush the audio's bits. */
+/** Use this processor to dynamically crush the audio's bits,
+    and to drop its sample rate by holding onto samples for longer.
+
+    Everything that depends on the settings gets worked out once per block,
+    leaving a plain quantise and hold over every channel. Changing the bit depth
+    crossfades from the old one to the new one over the next block, so it doesn't click.
+*/
 class BitCrusherProcessor final : public InternalProcessor
 {
 public:
@@ -6,23 +12,71 @@ public:
     BitCrusherProcessor();
 
     //==============================================================================
-    /** */
+    /** Sets how many bits to quantise the audio to, between 1 and 32.
+        32, the default, leaves the audio alone.
+    */
     void setBitDepth (int newBitDepth);
 
     /** */
     int getBitDepth() const noexcept;
 
+    /** Sets how many samples in a row each sample gets held for, between 1 and 64,
+        which divides the sample rate by as much. 1, the default, leaves the audio alone.
+    */
+    void setDownsampling (int newDownsampling);
+
+    /** */
+    int getDownsampling() const noexcept;
+
+    //==============================================================================
+    /** Crushes the audio at a higher sample rate, so that the harmonics the quantisation adds don't alias.
+
+        This allocates, so call it from the message thread. The processor's latency gets updated to match.
+
+        @param factor       1, 2, 4 or 8. 1, the default, turns oversampling off.
+        @param filterType   The kind of filters used to get to the higher rate and back.
+    */
+    void setOversampling (int factor, Oversampler::FilterType filterType = Oversampler::FilterType::minimumPhase);
+
+    /** @returns the oversampling factor, which is 1 when oversampling is off. */
+    int getOversamplingFactor() const noexcept;
+
     //==============================================================================
     /** @internal */
     const String getName() const override { return TRANS ("BitCrusher"); }
     /** @internal */
     Identifier getIdentifier() const override { return "bitCrusher"; }
     /** @internal */
+    void prepareToPlay (double, int) override;
+    /** @internal */
     void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
 
 private:
     //==============================================================================
+    /** The settings for quantising to a bit depth, worked out once per block. */
+    struct Quantiser final
+    {
+        static Quantiser forBitDepth (int bitDepth) noexcept;
+
+        bool operator== (const Quantiser& other) const noexcept { return scale == other.scale && wet == other.wet; }
+        bool operator!= (const Quantiser& other) const noexcept { return ! operator== (other); }
+
+        float scale = 1.0f, inverseScale = 1.0f;
+        float wet = 0.0f;   //< 0 when the audio gets left alone, 1 when it gets quantised.
+    };
+
     AudioParameterInt* bitDepth = new AudioParameterInt ("bitDepth", "Bit-Depth", 1, 32, 32);
+    AudioParameterInt* downsampling = new AudioParameterInt ("downsampling", "Downsampling", 1, 64, 1);
+    std::unique_ptr<Oversampler> oversampler = std::make_unique<Oversampler> (1);
+
+    Quantiser lastQuantiser;    //< What the last block got quantised with, to crossfade from.
+    HeapBlock<float> heldSamples;
+    int numHeldChannels = 0, holdPosition = 0;
+
+    //==============================================================================
+    static void quantise (float* samples, int numSamples, const Quantiser&) noexcept;
+    static void crossfade (float* samples, int numSamples, const Quantiser& from, const Quantiser& to) noexcept;
+    void hold (juce::AudioBuffer<float>&, int holdLength) noexcept;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BitCrusherProcessor)
@@ -0,0 +1,197 @@
+//==============================================================================
+ConvolutionProcessor::ConvolutionProcessor()
+{
+    addParameter (sourceX);
+    addParameter (sourceY);
+    addParameter (mix);
+}
+
+ConvolutionProcessor::~ConvolutionProcessor()
+{
+}
+
+//==============================================================================
+void ConvolutionProcessor::Setup::prepare (int numChannels)
+{
+    Array<const PartitionedConvolver::Kernel*> kernelPointers;
+
+    for (const auto* kernel : kernels)
+        kernelPointers.add (kernel);
+
+    convolver.prepare (numChannels, kernelPointers);
+}
+
+//==============================================================================
+void ConvolutionProcessor::setImpulseResponses (const std::vector<PositionedImpulseResponse>& impulseResponses)
+{
+    auto newSetup = std::make_unique<Setup>();
+    int newLongestLength = 0;
+
+    for (const auto& impulseResponse : impulseResponses)
+    {
+        newSetup->kernels.add (new PartitionedConvolver::Kernel (impulseResponse.impulseResponse, headPartitionSize));
+        newSetup->positions.add (impulseResponse.position);
+        newLongestLength = jmax (newLongestLength, impulseResponse.impulseResponse.getNumSamples());
+    }
+
+    // NB: Preparing everything before swapping it in, so the audio thread never waits on the allocations.
+    newSetup->prepare (jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels()));
+
+    {
+        const ScopedLock sl (getCallbackLock());
+        std::swap (setup, newSetup);
+    }
+
+    longestLength = newLongestLength;
+}
+
+int ConvolutionProcessor::getNumImpulseResponses() const noexcept
+{
+    const ScopedLock sl (getCallbackLock());
+    return setup != nullptr ? setup->kernels.size() : 0;
+}
+
+//==============================================================================
+void ConvolutionProcessor::setSourcePosition (juce::Point<float> newPosition)
+{
+    sourceX->operator= (newPosition.x);
+    sourceY->operator= (newPosition.y);
+}
+
+juce::Point<float> ConvolutionProcessor::getSourcePosition() const noexcept
+{
+    return { sourceX->get(), sourceY->get() };
+}
+
+void ConvolutionProcessor::setMix (float newMix)
+{
+    mix->operator= (newMix);
+}
+
+float ConvolutionProcessor::getMix() const noexcept
+{
+    return mix->get();
+}
+
+//==============================================================================
+double ConvolutionProcessor::getTailLengthSeconds() const
+{
+    const auto sampleRate = getSampleRate();
+    return sampleRate > 0.0 ? (double) longestLength.load() / sampleRate : 0.0;
+}
+
+void ConvolutionProcessor::prepareToPlay (double newSampleRate, int bufferSize)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    setRateAndBufferSizeDetails (newSampleRate, bufferSize);
+
+    const auto numChannels = jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels());
+    dryBuffer.setSize (numChannels, jmax (1, bufferSize));
+
+    if (setup != nullptr)
+        setup->prepare (numChannels);
+}
+
+void ConvolutionProcessor::releaseResources()
+{
+    const ScopedLock sl (getCallbackLock());
+
+    if (setup != nullptr)
+        setup->convolver.reset();
+}
+
+void ConvolutionProcessor::updateWeights() noexcept
+{
+    constexpr auto maxNumWeights = PartitionedConvolver::maxNumWeights;
+
+    const auto& positions = setup->positions;
+    const auto source = getSourcePosition();
+
+    // Finding the nearest impulse responses, plus the next nearest one, in order:
+    std::array<int, maxNumWeights + 1> nearest;
+    std::array<float, maxNumWeights + 1> distances;
+    int numNearest = 0;
+
+    for (int i = 0; i < positions.size(); ++i)
+    {
+        const auto distance = positions.getReference (i).getDistanceFrom (source);
+        auto index = numNearest;
+
+        if (numNearest < (int) nearest.size())
+            ++numNearest;
+        else if (distance < distances.back())
+            --index;
+        else
+            continue;
+
+        for (; index > 0 && distances[(size_t) index - 1] > distance; --index)
+        {
+            nearest[(size_t) index] = nearest[(size_t) index - 1];
+            distances[(size_t) index] = distances[(size_t) index - 1];
+        }
+
+        nearest[(size_t) index] = i;
+        distances[(size_t) index] = distance;
+    }
+
+    // Weighting by inverse distance, less that of the nearest one being left out,
+    // so that impulse responses fade in and out as they become some of the nearest ones:
+    constexpr auto minimumDistance = 1.0e-6f;
+    const auto numWeights = jmin (numNearest, maxNumWeights);
+    const auto cutoff = numNearest > maxNumWeights ? 1.0f / jmax (minimumDistance, distances.back()) : 0.0f;
+
+    std::array<float, maxNumWeights> weights;
+    auto total = 0.0f;
+
+    for (int i = 0; i < numWeights; ++i)
+    {
+        weights[(size_t) i] = jmax (0.0f, 1.0f / jmax (minimumDistance, distances[(size_t) i]) - cutoff);
+        total += weights[(size_t) i];
+    }
+
+    for (int i = 0; i < numWeights; ++i)
+        weights[(size_t) i] = total > 0.0f ? weights[(size_t) i] / total : 1.0f / (float) numWeights;
+
+    setup->convolver.setWeights (nearest.data(), weights.data(), numWeights);
+}
+
+void ConvolutionProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    // NB: Not skipping buffers that have been cleared, so that the tails get to ring out.
+    if (setup == nullptr || setup->kernels.isEmpty())
+        return;
+
+    setup->convolver.setNonRealtime (isNonRealtime());
+    updateWeights();
+
+    const auto localMix = mix->get();
+
+    if (localMix >= 1.0f)
+    {
+        setup->convolver.process (buffer);
+        return;
+    }
+
+    const auto numChannels = jmin (buffer.getNumChannels(), dryBuffer.getNumChannels());
+    const auto numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += dryBuffer.getNumSamples())
+    {
+        const auto numThisTime = jmin (dryBuffer.getNumSamples(), numSamples - start);
+
+        for (int i = 0; i < numChannels; ++i)
+            dryBuffer.copyFrom (i, 0, buffer, i, start, numThisTime);
+
+        // NB: Handing over the channels as they are, since an AudioBuffer referring to more than 32 of them allocates.
+        setup->convolver.process (buffer.getArrayOfWritePointers(), numChannels, start, numThisTime);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            buffer.applyGain (i, start, numThisTime, localMix);
+            buffer.addFrom (i, start, dryBuffer, i, 0, numThisTime, 1.0f - localMix);
+        }
+    }
+}
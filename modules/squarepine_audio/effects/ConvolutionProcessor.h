@@ -0,0 +1,94 @@
+/** Convolves the audio with a set of impulse responses, each captured at a different position,
+    mixing between the ones nearest to wherever the source currently is.
+
+    Moving the source crossfades between the impulse responses, so it can be automated smoothly.
+    The start of each impulse response gets convolved without any latency, and the rest of it
+    on background threads, so impulse responses that last for several seconds are fine,
+    and so are lots of instances of this processor.
+
+    The audio thread never waits on those background threads, unless the processor is set to be non-realtime,
+    so be sure to do that when rendering offline, where they'd otherwise fall behind and leave parts of the tails out.
+
+    @see PositionedImpulseResponse, PartitionedConvolver
+*/
+class ConvolutionProcessor final : public InternalProcessor
+{
+public:
+    /** Constructor. */
+    ConvolutionProcessor();
+
+    /** Destructor. */
+    ~ConvolutionProcessor() override;
+
+    //==============================================================================
+    /** The size of the partitions convolved on the audio thread. */
+    static constexpr int headPartitionSize = 256;
+
+    /** Sets the impulse responses to convolve with, and where each of them was captured.
+
+        This allocates and does a lot of FFTs, so don't call it from the audio thread.
+        The impulse responses should be at the sample rate the processor is going to play at.
+    */
+    void setImpulseResponses (const std::vector<PositionedImpulseResponse>& impulseResponses);
+
+    /** @returns the number of impulse responses being mixed between. */
+    int getNumImpulseResponses() const noexcept;
+
+    //==============================================================================
+    /** Moves the source, with each coordinate between 0 and 1, as laid out in PositionedImpulseResponse.
+        The impulse responses nearest to it get mixed in.
+    */
+    void setSourcePosition (juce::Point<float> newPosition);
+
+    /** */
+    juce::Point<float> getSourcePosition() const noexcept;
+
+    /** Sets the amount of dry and wet signal in the output,
+        between 0 for full dry and 1 for full wet.
+    */
+    void setMix (float newMix);
+
+    /** @returns the current mix. */
+    float getMix() const noexcept;
+
+    //==============================================================================
+    /** @internal */
+    const String getName() const override { return TRANS ("Convolution"); }
+    /** @internal */
+    Identifier getIdentifier() const override { return "convolution"; }
+    /** @internal */
+    double getTailLengthSeconds() const override;
+    /** @internal */
+    void prepareToPlay (double sampleRate, int bufferSize) override;
+    /** @internal */
+    void releaseResources() override;
+    /** @internal */
+    void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
+
+private:
+    //==============================================================================
+    /** Everything built out of a set of impulse responses, swapped in as a whole. */
+    struct Setup final
+    {
+        void prepare (int numChannels);
+
+        OwnedArray<PartitionedConvolver::Kernel> kernels;
+        Array<juce::Point<float>> positions;
+        PartitionedConvolver convolver;
+    };
+
+    std::unique_ptr<Setup> setup;
+    std::atomic<int> longestLength { 0 };
+
+    AudioParameterFloat* sourceX = new AudioParameterFloat ("sourceX", "Source X", 0.0f, 1.0f, 0.5f);
+    AudioParameterFloat* sourceY = new AudioParameterFloat ("sourceY", "Source Y", 0.0f, 1.0f, 0.5f);
+    AudioParameterFloat* mix = new AudioParameterFloat ("mix", "Mix", 0.0f, 1.0f, 1.0f);
+
+    juce::AudioBuffer<float> dryBuffer;
+
+    //==============================================================================
+    void updateWeights() noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionProcessor)
+};
@@ -1,11 +1,51 @@
+DitherProcessor::DitherProcessor()
+{
+    addParameter (bitDepth);
+    addParameter (noiseShaping);
+}
+
+//==============================================================================
+void DitherProcessor::setBitDepth (int newBitDepth)                 { bitDepth->operator= (newBitDepth); }
+int DitherProcessor::getBitDepth() const noexcept                   { return bitDepth->get(); }
+
+void DitherProcessor::setNoiseShaping (BasicDither::NoiseShaping newNoiseShaping)
+{
+    noiseShaping->operator= (static_cast<int> (newNoiseShaping));
+}
+
+BasicDither::NoiseShaping DitherProcessor::getNoiseShaping() const noexcept
+{
+    return static_cast<BasicDither::NoiseShaping> (noiseShaping->getIndex());
+}
+
+void DitherProcessor::setSeed (uint32 newSeed)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    seed = newSeed;
+    seedDithers();
+}
+
+void DitherProcessor::seedDithers()
+{
+    // NB: Neighbouring seeds are fine here, because BasicDither scrambles them.
+    for (int i = 0; i < dithers.size(); ++i)
+        dithers.getUnchecked (i)->setSeed (seed + (uint32) i);
+}
+
+//==============================================================================
 void DitherProcessor::prepareToPlay (const double newSampleRate, const int estimatedSamplesPerBlock)
 {
+    const ScopedLock sl (getCallbackLock());
+
     setRateAndBufferSizeDetails (newSampleRate, estimatedSamplesPerBlock);
 
     dithers.clearQuick (true);
 
     for (auto i = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels()); --i >= 0;)
         dithers.add (new BasicDither());
+
+    seedDithers();
 }
 
 void DitherProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
@@ -13,9 +53,28 @@ void DitherProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer
     if (isBypassed())
         return;
 
+    const auto localBitDepth = bitDepth->get();
+
+    // NB: Past 24 bits, there's nothing to quantise to that a float doesn't already hold.
+    if (localBitDepth > 24)
+        return;
+
+    const ScopedLock sl (getCallbackLock());
+
     const auto numSamples = buffer.getNumSamples();
+    const auto localNoiseShaping = getNoiseShaping();
 
     for (int i = buffer.getNumChannels(); --i >= 0;)
+    {
         if (auto* d = dithers[i])
+        {
+            if (d->getBitDepth() != localBitDepth)
+                d->setBitDepth (localBitDepth);
+
+            if (d->getNoiseShaping() != localNoiseShaping)
+                d->setNoiseShaping (localNoiseShaping);
+
             d->process (buffer.getWritePointer (i), numSamples);
+        }
+    }
 }
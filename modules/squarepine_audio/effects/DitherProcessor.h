@@ -1,9 +1,35 @@
-/** Use this processor to apply dither to any incoming audio channels. */
+/** Use this processor to dither and quantise any incoming audio channels to a bit depth,
+    such as right before writing them out to a file at that bit depth.
+
+    By default, the bit depth is 32, which leaves the audio alone,
+    as it already fits a 32-bit floating point file as is.
+
+    Each channel gets its own, uncorrelated, noise stream, all of which come from one seed.
+    Setting the seed makes renders repeatable.
+
+    @see BasicDither
+*/
 class DitherProcessor final : public InternalProcessor
 {
 public:
     /** Constructor. */
-    DitherProcessor() = default;
+    DitherProcessor();
+
+    //==============================================================================
+    /** Sets the bit depth to quantise to, between 1 and 24, or anything above that to leave the audio alone.
+        The default is 32.
+    */
+    void setBitDepth (int newBitDepth);
+    /** */
+    int getBitDepth() const noexcept;
+
+    /** Sets the curve the noise gets shaped to. The default is flat. */
+    void setNoiseShaping (BasicDither::NoiseShaping newNoiseShaping);
+    /** */
+    BasicDither::NoiseShaping getNoiseShaping() const noexcept;
+
+    /** Sets the seed that every channel's noise stream comes from, and starts them over. */
+    void setSeed (uint32 newSeed);
 
     //==============================================================================
     /** @internal */
@@ -17,7 +43,16 @@ public:
 
 private:
     //==============================================================================
+    AudioParameterInt* bitDepth = new AudioParameterInt ("bitDepth", "Bit-Depth", 1, 32, 32);
+    AudioParameterChoice* noiseShaping = new AudioParameterChoice ("noiseShaping", "Noise Shaping",
+                                                                   { "None", "First Order", "Second Order",
+                                                                     "Wannamaker 3 Tap", "Lipshitz 5 Tap" }, 0);
+
     OwnedArray<BasicDither> dithers;
+    uint32 seed = (uint32) Random().nextInt();
+
+    //==============================================================================
+    void seedDithers();
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DitherProcessor)
@@ -0,0 +1,225 @@
+//==============================================================================
+namespace
+{
+    /** How steeply the gate turns things down under the threshold, which is close enough to a cliff. */
+    constexpr auto gateSlope = 100.0f;
+
+    /** Turns gains in decibels into linear ones, in place, within 3e-7 of Decibels::decibelsToGain.
+
+        NB: Splitting off the integer part into the exponent and using a polynomial for the rest,
+            instead of calling std::pow, so that the loop vectorises.
+    */
+    void decibelsToGain (float* values, int numValues) noexcept
+    {
+        // log2 (10) / 20, which turns decibels into octaves:
+        constexpr auto octavesPerDecibel = 0.166096404744368f;
+
+        constexpr auto c1 = 6.93147180559945e-01f, c2 = 2.40226506959101e-01f, c3 = 5.55041086648216e-02f,
+                       c4 = 9.61812910762848e-03f, c5 = 1.33335581464284e-03f, c6 = 1.54035303933816e-04f,
+                       c7 = 1.52527338040598e-05f;
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            const auto x = jlimit (-126.0f, 126.0f, values[i] * octavesPerDecibel);
+
+            // Rounding to the nearest integer, leaving the polynomial between -0.5 and 0.5:
+            const auto n = (int) (x + std::copysign (0.5f, x));
+            const auto f = x - (float) n;
+
+            const auto exponent = static_cast<uint32> (n + 127) << 23;
+            float scale;
+            std::memcpy (&scale, &exponent, sizeof (float));
+
+            values[i] = scale * (1.0f + f * (c1 + f * (c2 + f * (c3 + f * (c4 + f * (c5 + f * (c6 + f * c7)))))));
+        }
+    }
+}
+
+//==============================================================================
+DynamicsProcessor::DynamicsProcessor (Mode m, float defaultThresholdDb, float defaultRatio,
+                                      float defaultAttackMs, float defaultReleaseMs) :
+    mode (m)
+{
+    const auto createTimeRange = [] (float start, float end)
+    {
+        NormalisableRange<float> timeRange (start, end);
+        timeRange.setSkewForCentre (std::sqrt (start * end));
+        return timeRange;
+    };
+
+    addParameter (threshold = new AudioParameterFloat ("threshold", NEEDS_TRANS ("Threshold"), -80.0f, 0.0f, defaultThresholdDb));
+    addParameter (ratio = new AudioParameterFloat ("ratio", NEEDS_TRANS ("Ratio"), 1.0f, 20.0f, defaultRatio));
+    addParameter (knee = new AudioParameterFloat ("knee", NEEDS_TRANS ("Knee"), 0.0f, 24.0f, 6.0f));
+    addParameter (range = new AudioParameterFloat ("range", NEEDS_TRANS ("Range"), 0.0f, 100.0f, mode == Mode::compressor ? 100.0f : 60.0f));
+    addParameter (makeupGain = new AudioParameterFloat ("makeupGain", NEEDS_TRANS ("Makeup Gain"), -24.0f, 24.0f, 0.0f));
+    addParameter (attack = new AudioParameterFloat ("attack", NEEDS_TRANS ("Attack"), createTimeRange (0.01f, 200.0f), defaultAttackMs));
+    addParameter (release = new AudioParameterFloat ("release", NEEDS_TRANS ("Release"), createTimeRange (1.0f, 5000.0f), defaultReleaseMs));
+    addParameter (detection = new AudioParameterChoice ("detection", NEEDS_TRANS ("Detection"), { "Peak", "RMS" }, 0));
+    addParameter (linked = new AudioParameterBool ("linked", NEEDS_TRANS ("Linked"), true));
+
+    // NB: The sidechain starts out disabled, so that this behaves like any other effect until something turns it on.
+    if (addBus (true))
+        if (auto* sidechain = getBus (true, 1))
+            sidechain->enable (false);
+}
+
+//==============================================================================
+void DynamicsProcessor::setThreshold (float newThresholdDb)         { threshold->operator= (newThresholdDb); }
+float DynamicsProcessor::getThreshold() const noexcept              { return threshold->get(); }
+void DynamicsProcessor::setRatio (float newRatio)                   { ratio->operator= (newRatio); }
+float DynamicsProcessor::getRatio() const noexcept                  { return ratio->get(); }
+void DynamicsProcessor::setKnee (float newKneeDb)                   { knee->operator= (newKneeDb); }
+float DynamicsProcessor::getKnee() const noexcept                   { return knee->get(); }
+void DynamicsProcessor::setRange (float newRangeDb)                 { range->operator= (newRangeDb); }
+float DynamicsProcessor::getRange() const noexcept                  { return range->get(); }
+void DynamicsProcessor::setMakeupGain (float newMakeupGainDb)       { makeupGain->operator= (newMakeupGainDb); }
+float DynamicsProcessor::getMakeupGain() const noexcept             { return makeupGain->get(); }
+void DynamicsProcessor::setAttack (float newAttackMs)               { attack->operator= (newAttackMs); }
+float DynamicsProcessor::getAttack() const noexcept                 { return attack->get(); }
+void DynamicsProcessor::setRelease (float newReleaseMs)             { release->operator= (newReleaseMs); }
+float DynamicsProcessor::getRelease() const noexcept                { return release->get(); }
+void DynamicsProcessor::setLinked (bool shouldBeLinked)             { linked->operator= (shouldBeLinked); }
+bool DynamicsProcessor::isLinked() const noexcept                   { return linked->get(); }
+
+void DynamicsProcessor::setDetection (BlockEnvelopeFollower::Detection newDetection)
+{
+    detection->operator= (static_cast<int> (newDetection));
+}
+
+BlockEnvelopeFollower::Detection DynamicsProcessor::getDetection() const noexcept
+{
+    return static_cast<BlockEnvelopeFollower::Detection> (detection->getIndex());
+}
+
+bool DynamicsProcessor::isUsingSidechain() const
+{
+    if (auto* sidechain = getBus (true, 1))
+        return sidechain->isEnabled() && sidechain->getNumberOfChannels() > 0;
+
+    return false;
+}
+
+//==============================================================================
+bool DynamicsProcessor::canAddBus (bool isInput) const
+{
+    return isInput && getBusCount (true) < 2;
+}
+
+void DynamicsProcessor::prepareToPlay (double newSampleRate, int bufferSize)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    setRateAndBufferSizeDetails (newSampleRate, bufferSize);
+
+    const auto numChannels = jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    follower.prepare (newSampleRate, numChannels);
+    gains.setSize (numChannels, jmax (1, bufferSize));
+}
+
+void DynamicsProcessor::releaseResources()
+{
+    const ScopedLock sl (getCallbackLock());
+    follower.reset();
+}
+
+//==============================================================================
+DynamicsProcessor::GainComputer DynamicsProcessor::createGainComputer() const noexcept
+{
+    GainComputer computer;
+    computer.threshold = threshold->get();
+    computer.knee = knee->get();
+    computer.halfKnee = computer.knee * 0.5f;
+    computer.kneeScale = computer.knee > 0.0f ? 0.5f / computer.knee : 0.0f;
+    computer.range = range->get();
+    computer.makeup = makeupGain->get();
+
+    switch (mode)
+    {
+        case Mode::compressor:
+            computer.direction = 1.0f;
+            computer.slope = 1.0f - 1.0f / ratio->get();
+        break;
+
+        case Mode::expander:
+            computer.direction = -1.0f;
+            computer.slope = ratio->get() - 1.0f;
+        break;
+
+        case Mode::gate:
+            computer.direction = -1.0f;
+            computer.slope = gateSlope;
+        break;
+    }
+
+    return computer;
+}
+
+void DynamicsProcessor::GainComputer::process (float* values, int numValues) const noexcept
+{
+    // How far past the threshold each level is, on the side that gets turned down,
+    // with the corner rounded off over the knee, which is where the branches would go:
+    for (int i = 0; i < numValues; ++i)
+    {
+        const auto overshoot = (values[i] - threshold) * direction;
+        const auto inKnee = jlimit (0.0f, knee, overshoot + halfKnee);
+        const auto amount = inKnee * inKnee * kneeScale + jmax (0.0f, overshoot - halfKnee);
+
+        values[i] = jmax (-range, -slope * amount) + makeup;
+    }
+
+    decibelsToGain (values, numValues);
+}
+
+void DynamicsProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    // NB: Not skipping buffers that have been cleared, so that the envelopes keep on releasing through them.
+    const auto numChannels = jmin (buffer.getNumChannels(), getMainBusNumOutputChannels(), gains.getNumChannels());
+    const auto numSamples = buffer.getNumSamples();
+
+    if (numChannels <= 0 || numSamples <= 0)
+        return;
+
+    follower.setAttackMs (attack->get());
+    follower.setReleaseMs (release->get());
+    follower.setDetection (getDetection());
+    follower.setLinked (linked->get());
+
+    const auto computer = createGainComputer();
+
+    // Following the sidechain, if it's enabled and there's anything in it:
+    const auto* const* detectorChannels = buffer.getArrayOfReadPointers();
+    auto numDetectorChannels = numChannels;
+
+    if (isUsingSidechain())
+    {
+        const auto firstChannel = getChannelIndexInProcessBlockBuffer (true, 1, 0);
+        const auto numSidechainChannels = jmin (getBus (true, 1)->getNumberOfChannels(),
+                                                buffer.getNumChannels() - firstChannel,
+                                                gains.getNumChannels());
+
+        if (numSidechainChannels > 0)
+        {
+            detectorChannels += firstChannel;
+            numDetectorChannels = numSidechainChannels;
+        }
+    }
+
+    const auto numGains = follower.getNumEnvelopes (numDetectorChannels);
+    auto* const* gainChannels = gains.getArrayOfWritePointers();
+
+    for (int start = 0; start < numSamples; start += gains.getNumSamples())
+    {
+        const auto numThisTime = jmin (gains.getNumSamples(), numSamples - start);
+
+        follower.process (detectorChannels, numDetectorChannels, start, gainChannels, numThisTime);
+
+        for (int i = 0; i < numGains; ++i)
+            computer.process (gainChannels[i], numThisTime);
+
+        for (int i = 0; i < numChannels; ++i)
+            FloatVectorOperations::multiply (buffer.getWritePointer (i, start), gainChannels[i % numGains], numThisTime);
+    }
+}
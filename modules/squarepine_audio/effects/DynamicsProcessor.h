@@ -0,0 +1,184 @@
+/** The base for the compressor, expander and gate, which only differ in which way their curves bend.
+
+    The levels get followed with a BlockEnvelopeFollower, on all of the main channels,
+    or on the sidechain input when that bus is enabled. The gain is worked out from them
+    in decibels, then turned into a linear gain and applied, each in its own pass over the block.
+
+    @see CompressorProcessor, ExpanderProcessor, GateProcessor
+*/
+class DynamicsProcessor : public InternalProcessor
+{
+public:
+    /** The different shapes of gain curve. */
+    enum class Mode
+    {
+        compressor, //< Turns down anything over the threshold, by the ratio.
+        expander,   //< Turns down anything under the threshold, by the ratio.
+        gate        //< Turns anything under the threshold all the way down, by the range.
+    };
+
+    //==============================================================================
+    /** Sets the level the curve bends at, in decibels, between -80 and 0. */
+    void setThreshold (float newThresholdDb);
+    /** */
+    float getThreshold() const noexcept;
+
+    /** Sets how much the curve bends, between 1 and 20.
+
+        A compressor turns the level over the threshold down to 1 / ratio of what it was,
+        an expander turns the level under the threshold down to ratio times what it was,
+        and a gate ignores this.
+    */
+    void setRatio (float newRatio);
+    /** */
+    float getRatio() const noexcept;
+
+    /** Sets the width of the soft knee around the threshold, in decibels, between 0 and 24. */
+    void setKnee (float newKneeDb);
+    /** */
+    float getKnee() const noexcept;
+
+    /** Sets the most the gain can get turned down by, in decibels, between 0 and 100. */
+    void setRange (float newRangeDb);
+    /** */
+    float getRange() const noexcept;
+
+    /** Sets the gain applied after everything else, in decibels, between -24 and 24. */
+    void setMakeupGain (float newMakeupGainDb);
+    /** */
+    float getMakeupGain() const noexcept;
+
+    //==============================================================================
+    /** Sets how quickly the levels get followed as they rise, in milliseconds. */
+    void setAttack (float newAttackMs);
+    /** */
+    float getAttack() const noexcept;
+
+    /** Sets how quickly the levels get followed as they fall, in milliseconds. */
+    void setRelease (float newReleaseMs);
+    /** */
+    float getRelease() const noexcept;
+
+    /** Sets how the levels get measured. */
+    void setDetection (BlockEnvelopeFollower::Detection newDetection);
+    /** */
+    BlockEnvelopeFollower::Detection getDetection() const noexcept;
+
+    /** Sets whether every channel gets the same gain, worked out from all of them together,
+        or each one gets its own. Channels are linked by default, which keeps the stereo image steady.
+    */
+    void setLinked (bool shouldBeLinked);
+    /** */
+    bool isLinked() const noexcept;
+
+    //==============================================================================
+    /** @returns true if the levels are being followed on the sidechain input. */
+    bool isUsingSidechain() const;
+
+    //==============================================================================
+    /** @internal */
+    bool canAddBus (bool isInput) const override;
+    /** @internal */
+    void prepareToPlay (double, int) override;
+    /** @internal */
+    void releaseResources() override;
+    /** @internal */
+    void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
+
+protected:
+    //==============================================================================
+    /** Creates a processor with the given curve, and a disabled sidechain input bus. */
+    DynamicsProcessor (Mode mode, float defaultThresholdDb, float defaultRatio,
+                       float defaultAttackMs, float defaultReleaseMs);
+
+private:
+    //==============================================================================
+    /** The settings for turning levels into gains, worked out once per block. */
+    struct GainComputer final
+    {
+        /** Turns levels in decibels into linear gains, in place. */
+        void process (float* values, int numValues) const noexcept;
+
+        float threshold = 0.0f, direction = 1.0f, slope = 0.0f;
+        float halfKnee = 0.0f, kneeScale = 0.0f, knee = 0.0f;
+        float range = 0.0f, makeup = 0.0f;
+    };
+
+    const Mode mode;
+
+    AudioParameterFloat* threshold = nullptr;
+    AudioParameterFloat* ratio = nullptr;
+    AudioParameterFloat* knee = nullptr;
+    AudioParameterFloat* range = nullptr;
+    AudioParameterFloat* makeupGain = nullptr;
+    AudioParameterFloat* attack = nullptr;
+    AudioParameterFloat* release = nullptr;
+    AudioParameterChoice* detection = nullptr;
+    AudioParameterBool* linked = nullptr;
+
+    BlockEnvelopeFollower follower;
+    juce::AudioBuffer<float> gains;     //< The envelopes, then the gains worked out from them.
+
+    //==============================================================================
+    GainComputer createGainComputer() const noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicsProcessor)
+};
+
+//==============================================================================
+/** Turns down anything louder than the threshold. */
+class CompressorProcessor final : public DynamicsProcessor
+{
+public:
+    /** Constructor. */
+    CompressorProcessor() : DynamicsProcessor (Mode::compressor, -20.0f, 4.0f, 10.0f, 100.0f) {}
+
+    //==============================================================================
+    /** @internal */
+    const String getName() const override { return TRANS ("Compressor"); }
+    /** @internal */
+    Identifier getIdentifier() const override { return "compressor"; }
+
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorProcessor)
+};
+
+//==============================================================================
+/** Turns down anything quieter than the threshold, making the quiet parts quieter still. */
+class ExpanderProcessor final : public DynamicsProcessor
+{
+public:
+    /** Constructor. */
+    ExpanderProcessor() : DynamicsProcessor (Mode::expander, -40.0f, 2.0f, 1.0f, 100.0f) {}
+
+    //==============================================================================
+    /** @internal */
+    const String getName() const override { return TRANS ("Expander"); }
+    /** @internal */
+    Identifier getIdentifier() const override { return "expander"; }
+
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ExpanderProcessor)
+};
+
+//==============================================================================
+/** Silences anything quieter than the threshold, down by as much as the range. */
+class GateProcessor final : public DynamicsProcessor
+{
+public:
+    /** Constructor. */
+    GateProcessor() : DynamicsProcessor (Mode::gate, -50.0f, 1.0f, 0.1f, 50.0f) {}
+
+    //==============================================================================
+    /** @internal */
+    const String getName() const override { return TRANS ("Gate"); }
+    /** @internal */
+    Identifier getIdentifier() const override { return "gate"; }
+
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GateProcessor)
+};
@@ -1,5 +1,7 @@
 void HissingProcessor::prepareToPlay (const double newSampleRate, const int estimatedSamplesPerBlock)
 {
+    const ScopedLock sl (getCallbackLock());
+
     setRateAndBufferSizeDetails (newSampleRate, estimatedSamplesPerBlock);
 
     constexpr auto secondsBetweenHisses = 3;
@@ -11,6 +13,39 @@ void HissingProcessor::prepareToPlay (const double newSampleRate, const int esti
     blockCounter = random.nextInt (blocksBetweenHisses);
     blocksPerHiss = jmax (2, roundToInt (newSampleRate * 2.5 / estimatedSamplesPerBlock));
     level = 0.001;
+
+    // Giving every channel its own seed, which keeps their hiss uncorrelated:
+    generators.clearQuick (true);
+
+    for (auto i = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels()); --i >= 0;)
+        generators.add (new NoiseGenerator (NoiseGenerator::Type::gaussian))->setSeed ((uint32) random.nextInt());
+
+    maxChunkSize = jmax (1, estimatedSamplesPerBlock);
+    noise.malloc ((size_t) maxChunkSize);
+    ramp.malloc ((size_t) maxChunkSize);
+}
+
+double HissingProcessor::getTailLengthSeconds() const
+{
+    // The hiss comes and goes whether there's any input or not, so it never dies away:
+    return std::numeric_limits<double>::infinity();
+}
+
+void HissingProcessor::fillRamp (int numSamples) noexcept
+{
+    constexpr auto hissLevel = 0.65;
+    constexpr auto swell = 1.000025;
+
+    // How loud the generator's noise gets added, which is the spread of the sum of four uniform numbers:
+    constexpr auto noiseLevel = 0.2;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        ramp[i] = (float) (level * noiseLevel);
+
+        if (level < hissLevel)
+            level *= swell;
+    }
 }
 
 void HissingProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
@@ -18,7 +53,7 @@ void HissingProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffe
     if (isBypassed())
         return;
 
-    constexpr auto hissLevel = 0.65;
+    const ScopedLock sl (getCallbackLock());
 
     if (++blockCounter >= blocksBetweenHisses)
     {
@@ -28,24 +63,22 @@ void HissingProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffe
         blocksBetweenHisses = jmax (10, maxBlocksBetweenHisses - random.nextInt (maxBlocksBetweenHisses / 4));
     }
 
-    if (blockCounter < blocksPerHiss)
-    {
-        for (int j = 0; j < buffer.getNumChannels(); ++j)
-        {
-            auto* d = buffer.getWritePointer (j, 0);
+    const auto numChannels = jmin (buffer.getNumChannels(), generators.size());
+    const auto numSamples = buffer.getNumSamples();
 
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
-            {
-                auto noise = 0.0;
+    if (blockCounter >= blocksPerHiss || numChannels <= 0)
+        return;
 
-                for (int k = 4; --k >= 0;)
-                    noise += random.nextDouble();
+    for (int start = 0; start < numSamples; start += maxChunkSize)
+    {
+        const auto numThisTime = jmin (maxChunkSize, numSamples - start);
 
-                *d++ += (float) (level * noise * 0.2);
+        fillRamp (numThisTime);
 
-                if (level < hissLevel)
-                    level *= 1.000025;
-            }
+        for (int i = 0; i < numChannels; ++i)
+        {
+            generators.getUnchecked (i)->process (noise, numThisTime);
+            FloatVectorOperations::addWithMultiply (buffer.getWritePointer (i, start), noise, ramp, numThisTime);
         }
     }
 }
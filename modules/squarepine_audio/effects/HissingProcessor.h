@@ -1,4 +1,8 @@
-/** Use this processor to add periodic hissing over the provided audio. */
+/** Use this processor to add periodic hissing over the provided audio.
+
+    Each channel gets its own NoiseGenerator, making close to Gaussian noise a block at a time,
+    which gets swelled in by a ramp that's worked out once per block and shared by every channel.
+*/
 class HissingProcessor final : public InternalProcessor
 {
 public:
@@ -14,6 +18,8 @@ public:
     void prepareToPlay (double, int) override;
     /** @internal */
     void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
+    /** @internal */
+    double getTailLengthSeconds() const override;
 
 private:
     //==============================================================================
@@ -22,6 +28,13 @@ private:
     double level = 0.0;
     juce::Random random;
 
+    OwnedArray<NoiseGenerator> generators;
+    HeapBlock<float> noise, ramp;
+    int maxChunkSize = 0;
+
+    //==============================================================================
+    void fillRamp (int numSamples) noexcept;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HissingProcessor)
 };
@@ -24,6 +24,22 @@ void JUCEReverbProcessor::releaseResources()
     reverb.reset();
 }
 
+double JUCEReverbProcessor::getTailLengthSeconds() const
+{
+    // Once frozen, whatever's in the reverb goes round forever:
+    if (freezeMode->get())
+        return std::numeric_limits<double>::infinity();
+
+    // The reverb's longest comb filter is 1617 samples long at 44.1 kHz, plus the 23 samples of stereo spread,
+    // and every trip round it scales what's left by the feedback that the room size sets.
+    // This is how long that takes to die away by 90 dB:
+    constexpr auto longestCombSeconds = (1617.0 + 23.0) / 44100.0;
+    constexpr auto decayDecibels = -90.0;
+
+    const auto feedback = (double) roomSize->get() * 0.28 + 0.7;
+    return (decayDecibels / 20.0) / std::log10 (feedback) * longestCombSeconds;
+}
+
 void JUCEReverbProcessor::updateReverbParameters()
 {
     Reverb::Parameters localParams;
@@ -46,8 +62,8 @@ void JUCEReverbProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBu
     const auto numChannels = buffer.getNumChannels();
     const auto numSamples = buffer.getNumSamples();
 
+    // NB: A cleared buffer still gets processed, since the reverb has to ring out into it.
     if (isBypassed()
-        || buffer.hasBeenCleared()
         || numChannels <= 0
         || numSamples <= 0)
         return;
@@ -16,6 +16,8 @@ public:
     void releaseResources() override;
     /** @internal */
     void processBlock (juce::AudioBuffer<float>&, MidiBuffer&) override;
+    /** @internal */
+    double getTailLengthSeconds() const override;
 
 private:
     //==============================================================================
@@ -1,6 +1,8 @@
 LevelsProcessor::LevelsProcessor() :
     InternalProcessor (false)
 {
+    // Otherwise the audio thread might end up waiting on a lock to measure the levels:
+    jassert (channelLevels.front().peak.is_lock_free() && channelLevels.front().energy.is_lock_free());
 }
 
 //==============================================================================
@@ -14,15 +16,83 @@ LevelsProcessor::Mode LevelsProcessor::getMode() const noexcept
     return mode.load (std::memory_order_relaxed);
 }
 
+//==============================================================================
+void LevelsProcessor::enableBroadcasting (int maximumNumChannels, int numSamples)
+{
+    // NB: Preparing the ring again could pull it out from underneath a reader, which nothing can stop.
+    if (isBroadcasting.load (std::memory_order_acquire))
+    {
+        jassert (maximumNumChannels == broadcastRing.getNumChannels() && numSamples == broadcastRing.getCapacity());
+        return;
+    }
+
+    broadcastRing.prepare (maximumNumChannels, numSamples);
+    isBroadcasting.store (true, std::memory_order_release);
+}
+
+BroadcastAudioRing<float>* LevelsProcessor::getBroadcastRing() noexcept
+{
+    return isBroadcasting.load (std::memory_order_acquire) ? &broadcastRing : nullptr;
+}
+
 //==============================================================================
 void LevelsProcessor::getChannelLevels (Array<float>& destData)
 {
-    getChannelLevels (destData, floatChannelDetails);
+    refreshLastLevels();
+
+    destData.clearQuick();
+    destData.addArray (lastLevels);
 }
 
 void LevelsProcessor::getChannelLevels (Array<double>& destData)
 {
-    getChannelLevels (destData, doubleChannelDetails);
+    refreshLastLevels();
+
+    destData.clearQuick();
+
+    for (const auto level : lastLevels)
+        destData.add ((double) level);
+}
+
+void LevelsProcessor::refreshLastLevels()
+{
+    const auto blocks = numBlocks.load (std::memory_order_acquire);
+
+    if (blocks == numBlocksLastRead)
+        return;
+
+    numBlocksLastRead = blocks;
+
+    const auto currentMode = mode.load (std::memory_order_relaxed);
+    const auto numLevels = numChannels.load (std::memory_order_relaxed);
+
+    lastLevels.resize (numLevels);
+
+    for (int i = 0; i < numLevels; ++i)
+    {
+        auto& level = channelLevels[(size_t) i];
+
+        // NB: Taking both, so that whatever built up before the mode last changed doesn't linger.
+        const auto peak = level.peak.exchange (Measurement(), std::memory_order_relaxed);
+        const auto energy = level.energy.exchange (Measurement(), std::memory_order_relaxed);
+        const auto& measured = currentMode == Mode::rms ? energy : peak;
+
+        // A block that came along after the count was read may already have been taken in by the last read,
+        // in which case there's nothing new in this channel, and the last level still stands:
+        if (measured.numSamples == 0)
+            continue;
+
+        switch (currentMode)
+        {
+            case Mode::peak:    lastLevels.set (i, peak.value); break;
+            case Mode::rms:     lastLevels.set (i, std::sqrt (energy.value / (float) energy.numSamples)); break;
+            case Mode::midSide: lastLevels.set (i, square (peak.value)); break;
+
+            default:
+                jassertfalse;
+            break;
+        }
+    }
 }
 
 //==============================================================================
@@ -32,19 +102,20 @@ void LevelsProcessor::prepareToPlay (double newSampleRate, int bufferSize)
 
     setRateAndBufferSizeDetails (newSampleRate, bufferSize);
 
-    const auto numChannels = jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels());
-
-    floatChannelDetails.prepare (numChannels);
-    doubleChannelDetails.prepare (numChannels);
+    for (auto& level : channelLevels)
+    {
+        level.peak.store (Measurement(), std::memory_order_relaxed);
+        level.energy.store (Measurement(), std::memory_order_relaxed);
+    }
 }
 
 //==============================================================================
 void LevelsProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
 {
-    process (buffer, floatChannelDetails);
+    process (buffer);
 }
 
 void LevelsProcessor::processBlock (juce::AudioBuffer<double>& buffer, MidiBuffer&)
 {
-    process (buffer, doubleChannelDetails);
+    process (buffer);
 }
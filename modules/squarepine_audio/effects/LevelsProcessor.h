@@ -1,6 +1,10 @@
 /** Use an instance of this within an audio callback of some kind,
     and call getChannelLevels (on the main thread) to get the
-    last known audio levels.
+    loudest audio levels since the last time they were asked for.
+
+    Neither side ever waits on the other: the audio thread folds each block
+    into a set of per-channel atomics, which the reader swaps out for fresh ones,
+    so a peak that comes and goes in between two reads still gets seen.
 */
 class LevelsProcessor final : public InternalProcessor
 {
@@ -9,9 +13,15 @@ public:
     LevelsProcessor();
 
     //==============================================================================
-    /** */
+    /** Provides the level of each channel since the last call, in whichever mode is set.
+
+        If no audio came through in the meantime, this gives back the same levels as last time,
+        rather than making a meter that gets read more often than blocks come along flicker.
+
+        @warning Only call this from one thread at a time, like the message thread.
+    */
     void getChannelLevels (Array<float>& destData);
-    /** */
+    /** @see getChannelLevels */
     void getChannelLevels (Array<double>& destData);
 
     //==============================================================================
@@ -29,6 +39,30 @@ public:
     /** @returns the current mode for audio levels analysis. */
     Mode getMode() const noexcept;
 
+    //==============================================================================
+    /** Starts publishing the audio that goes through this processor into a BroadcastAudioRing,
+        which any number of meters, scopes, recorders and whatnot can then read from at their own pace.
+
+        The audio thread copies each block into the ring once, however many readers there are.
+
+        The ring only gets prepared by the first call: readers can't get hold of it before that,
+        and it's never prepared again from underneath them afterwards, so any later calls are ignored.
+
+        @param maximumNumChannels   The number of channels to publish.
+        @param numSamples           The number of samples that the ring holds on to,
+                                    which is how far behind a reader can fall before missing out.
+
+        @see getBroadcastRing
+    */
+    void enableBroadcasting (int maximumNumChannels, int numSamples);
+
+    /** @returns the ring that the audio gets published into,
+        or nullptr if broadcasting hasn't been enabled yet.
+
+        @see enableBroadcasting, Meter::setAudioSource
+    */
+    BroadcastAudioRing<float>* getBroadcastRing() noexcept;
+
     //==============================================================================
     /** @internal */
     const String getName() const override { return TRANS ("Levels Meter"); }
@@ -49,69 +83,98 @@ public:
 
 private:
     //==============================================================================
-    template<typename FloatType>
-    struct ChannelDetails final
-    {
-        void prepare (int numChannels)
-        {
-            channels.resize (numChannels);
-            channels.clearQuick();
+    /** The most channels whose levels get kept track of. */
+    static constexpr int maxNumChannels = 64;
 
-            tempBuffer.resize (numChannels);
-            tempBuffer.clearQuick();
-        }
+    /** Something measured over a number of samples, along with how many went into it,
+        small enough to be swapped as a whole without a lock.
+
+        Having the count in there too is what tells the reader apart a channel that was silent
+        from one that a block was only halfway through being added to when it looked.
+    */
+    struct Measurement final
+    {
+        float value = 0.0f;                 //< The peak, or the sum of the squares.
+        uint32 numSamples = 0;
+    };
 
-        Array<FloatType> channels, tempBuffer;
+    /** What the audio thread has measured in a channel since the reader last took it. */
+    struct ChannelLevel final
+    {
+        std::atomic<Measurement> peak { Measurement() };
+        std::atomic<Measurement> energy { Measurement() };
     };
 
     std::atomic<Mode> mode { Mode::peak };
-    ChannelDetails<float> floatChannelDetails;
-    ChannelDetails<double> doubleChannelDetails;
+    std::array<ChannelLevel, maxNumChannels> channelLevels;
+    std::atomic<int> numChannels { 0 };
+    std::atomic<uint32> numBlocks { 0 };
+    BroadcastAudioRing<float> broadcastRing;
+    std::atomic<bool> isBroadcasting { false };
+
+    // NB: These are only ever touched by the reader.
+    Array<float> lastLevels;
+    uint32 numBlocksLastRead = 0;
 
     //==============================================================================
-    template<typename FloatType>
-    void getChannelLevels (Array<FloatType>& destData, ChannelDetails<FloatType>& details)
+    void refreshLastLevels();
+
+    /** NB: These only go around again if the reader took the measurement in the meantime, which is rare. */
+    static void accumulatePeak (std::atomic<Measurement>& peak, float newPeak, int numSamples) noexcept
+    {
+        auto current = peak.load (std::memory_order_relaxed);
+        Measurement next;
+
+        do
+        {
+            next.value = jmax (current.value, newPeak);
+            next.numSamples = current.numSamples + (uint32) numSamples;
+        }
+        while (! peak.compare_exchange_weak (current, next, std::memory_order_relaxed));
+    }
+
+    static void accumulateEnergy (std::atomic<Measurement>& energy, float sumOfSquares, int numSamples) noexcept
     {
-        destData.clearQuick();
+        auto current = energy.load (std::memory_order_relaxed);
+        Measurement next;
 
-        const ScopedLock lock (getCallbackLock());
-        destData.addArray (details.channels);
+        do
+        {
+            next.value = current.value + sumOfSquares;
+            next.numSamples = current.numSamples + (uint32) numSamples;
+        }
+        while (! energy.compare_exchange_weak (current, next, std::memory_order_relaxed));
     }
 
     template<typename FloatType>
-    void process (juce::AudioBuffer<FloatType>& buffer, ChannelDetails<FloatType>& details)
+    void process (juce::AudioBuffer<FloatType>& buffer)
     {
-        const auto numChannels = jmin (buffer.getNumChannels(), getTotalNumInputChannels(), getTotalNumOutputChannels());
+        const auto numChans = jmin (buffer.getNumChannels(), getTotalNumInputChannels(), getTotalNumOutputChannels());
+        const auto numSamples = buffer.getNumSamples();
+
+        if (isBroadcasting.load (std::memory_order_acquire))
+            broadcastRing.write (buffer, numChans, numSamples);
+
+        if (numSamples <= 0)
+            return;
 
-        details.tempBuffer.clearQuick();
+        const auto numLevels = jmin (numChans, maxNumChannels);
+        const auto isRMS = mode.load (std::memory_order_relaxed) == Mode::rms;
 
-        switch (mode.load (std::memory_order_relaxed))
+        for (int i = 0; i < numLevels; ++i)
         {
-            case Mode::peak:
-                for (int i = 0; i < numChannels; ++i)
-                    details.tempBuffer.add (buffer.getMagnitude (i, 0, buffer.getNumSamples()));
-            break;
-
-            case Mode::rms:
-                for (int i = 0; i < numChannels; ++i)
-                    details.tempBuffer.add (buffer.getRMSLevel (i, 0, buffer.getNumSamples()));
-            break;
-
-            case Mode::midSide:
-                for (int i = 0; i < numChannels; ++i)
-                {
-                    const auto v = buffer.getMagnitude (i, 0, buffer.getNumSamples());
-                    details.tempBuffer.add (square (v));
-                }
-            break;
-
-            default:
-                jassertfalse;
-            break;
-        };
-
-        const ScopedLock lock (getCallbackLock());
-        details.channels.swapWith (details.tempBuffer);
+            auto& level = channelLevels[(size_t) i];
+
+            if (isRMS)
+                accumulateEnergy (level.energy, (float) (square (buffer.getRMSLevel (i, 0, numSamples)) * numSamples), numSamples);
+            else
+                accumulatePeak (level.peak, (float) buffer.getMagnitude (i, 0, numSamples), numSamples);
+        }
+
+        numChannels.store (numLevels, std::memory_order_relaxed);
+
+        // NB: Releasing the levels to the reader, which only swaps them out once it sees the count go up.
+        numBlocks.fetch_add (1, std::memory_order_release);
     }
 
     //==============================================================================
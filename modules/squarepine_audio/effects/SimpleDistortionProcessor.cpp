@@ -21,20 +21,51 @@ private:
 
 //==============================================================================
 SimpleDistortionProcessor::SimpleDistortionProcessor() :
-    amountParam (new AmountParameter())
+    amountParam (new AmountParameter()),
+    oversampler (std::make_unique<Oversampler> (1))
 {
     addParameter (amountParam);
 }
 
 //==============================================================================
-void SimpleDistortionProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
+void SimpleDistortionProcessor::setOversampling (int factor, Oversampler::FilterType filterType)
 {
-    auto localAmount = 1.0f;
+    // NB: Preparing the new oversampler before swapping it in, so the audio thread never waits on the allocations.
+    auto newOversampler = std::make_unique<Oversampler> (factor, filterType);
+    newOversampler->prepare (jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels()), jmax (1, getBlockSize()));
 
     {
         const ScopedLock sl (getCallbackLock());
-        localAmount = amountParam->get();
+        std::swap (oversampler, newOversampler);
     }
 
-    DistortionFunctions::performSimple (buffer, localAmount);
+    setLatencySamples (oversampler->getLatencySamples());
+}
+
+int SimpleDistortionProcessor::getOversamplingFactor() const noexcept
+{
+    return oversampler->getFactor();
+}
+
+//==============================================================================
+void SimpleDistortionProcessor::prepareToPlay (double newSampleRate, int bufferSize)
+{
+    const ScopedLock sl (getCallbackLock());
+
+    setRateAndBufferSizeDetails (newSampleRate, bufferSize);
+
+    oversampler->prepare (jmax (2, getTotalNumInputChannels(), getTotalNumOutputChannels()), jmax (1, bufferSize));
+    setLatencySamples (oversampler->getLatencySamples());
+}
+
+void SimpleDistortionProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)
+{
+    const ScopedLock sl (getCallbackLock());
+    const auto localAmount = amountParam->get();
+
+    oversampler->process (buffer, [localAmount] (juce::AudioBuffer<float>& b)
+    {
+        for (int i = b.getNumChannels(); --i >= 0;)
+            DistortionFunctions::performSimple (b.getWritePointer (i), b.getNumSamples(), localAmount);
+    });
 }
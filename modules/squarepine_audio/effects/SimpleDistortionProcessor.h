@@ -5,18 +5,34 @@ public:
     /** Constructor. */
     SimpleDistortionProcessor();
 
+    //==============================================================================
+    /** Runs the distortion at a higher sample rate, so that the harmonics it adds don't alias.
+
+        This allocates, so call it from the message thread. The processor's latency gets updated to match.
+
+        @param factor       1, 2, 4 or 8. 1, the default, turns oversampling off.
+        @param filterType   The kind of filters used to get to the higher rate and back.
+    */
+    void setOversampling (int factor, Oversampler::FilterType filterType = Oversampler::FilterType::minimumPhase);
+
+    /** @returns the oversampling factor, which is 1 when oversampling is off. */
+    int getOversamplingFactor() const noexcept;
+
     //==============================================================================
     /** @internal */
     const String getName() const override { return TRANS ("Simple Distortion"); }
     /** @internal */
     Identifier getIdentifier() const override { return "simpleDistortion"; }
     /** @internal */
+    void prepareToPlay (double, int) override;
+    /** @internal */
     void processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
 
 private:
     //==============================================================================
     class AmountParameter;
     AmountParameter* amountParam;
+    std::unique_ptr<Oversampler> oversampler;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleDistortionProcessor)
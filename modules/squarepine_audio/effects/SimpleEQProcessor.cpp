@@ -1,120 +1,3 @@
-//==============================================================================
-class SimpleEQProcessor::InternalFilter final : public AudioProcessorParameter::Listener
-{
-public:
-    InternalFilter (FilterType filterType,
-                    AudioParameterFloat* g,
-                    AudioParameterFloat* c,
-                    AudioParameterFloat* r) :
-        type (filterType),
-        gain (g),
-        cutoff (c),
-        resonance (r)
-    {
-        updateParams();
-
-        gain->addListener (this);
-        cutoff->addListener (this);
-        resonance->addListener (this);
-    }
-
-    //==============================================================================
-    void prepare (double newSampleRate, int bufferSize, int numChannels)
-    {
-        sampleRate = newSampleRate;
-
-        const dsp::ProcessSpec spec
-        {
-            sampleRate,
-            (uint32) jmax (0, bufferSize),
-            (uint32) jmax (0, numChannels)
-        };
-
-        floatProcessor.prepare (spec);
-        doubleProcessor.prepare (spec);
-
-        updateParams();
-    }
-
-    void reset()
-    {
-        floatProcessor.reset();
-        doubleProcessor.reset();
-    }
-
-    void process (juce::AudioBuffer<float>& buffer, bool wholeProcIsBypassed)
-    {
-        process (floatProcessor, buffer, wholeProcIsBypassed);
-    }
-
-    void process (juce::AudioBuffer<double>& buffer, bool wholeProcIsBypassed)
-    {
-        process (doubleProcessor, buffer, wholeProcIsBypassed);
-    }
-
-    void updateParams()
-    {
-        updateParamsFor (floatProcessor);
-        updateParamsFor (doubleProcessor);
-    }
-
-    void parameterValueChanged (int, float) override    { updateParams(); }
-    void parameterGestureChanged (int, bool) override   { }
-
-    //==============================================================================
-    const FilterType type = FilterType::bandpass;
-    double sampleRate = 44100.0;
-    ProcessorDuplicator<float> floatProcessor;
-    ProcessorDuplicator<double> doubleProcessor;
-
-    // NB: These are owned by the parent EQ processor.
-    AudioParameterFloat* gain = nullptr;
-    AudioParameterFloat* cutoff = nullptr;
-    AudioParameterFloat* resonance = nullptr;
-
-private:
-    //==============================================================================
-    template<typename SampleType>
-    void updateParamsFor (ProcessorDuplicator<SampleType>& processor)
-    {
-        const auto g = (SampleType) gain->get();
-        const auto c = (SampleType) cutoff->get();
-        const auto r = (SampleType) resonance->get();
-
-        using Coeffs = Coefficients<SampleType>;
-        typename Coeffs::Ptr coeffs;
-
-        switch (type)
-        {
-            case FilterType::lowpass:   coeffs = Coeffs::makeLowShelf (sampleRate, c, r, g); break;
-            case FilterType::highpass:  coeffs = Coeffs::makeHighShelf (sampleRate, c, r, g); break;
-            case FilterType::bandpass:  coeffs = Coeffs::makePeakFilter (sampleRate, c, r, g); break;
-
-            default:
-                jassertfalse;
-            break;
-        };
-
-        processor.state = *coeffs;
-    }
-
-    template<typename SampleType>
-    void process (ProcessorDuplicator<SampleType>& processor,
-                  juce::AudioBuffer<SampleType>& buffer,
-                  bool wholeProcIsBypassed)
-    {
-        dsp::AudioBlock<SampleType> block (buffer);
-        Context<SampleType> context (block);
-        context.isBypassed = wholeProcIsBypassed;
-
-        processor.process (context);
-    }
-
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InternalFilter)
-};
-
-//==============================================================================
 SimpleEQProcessor::SimpleEQProcessor() :
     InternalProcessor (false)
 {
@@ -134,28 +17,73 @@ void SimpleEQProcessor::prepareToPlay (const double newSampleRate, const int buf
 
     const ScopedLock sl (getCallbackLock());
 
-    for (auto* f : filters)
-        f->prepare (newSampleRate, bufferSize, numChans);
+    floatCascade.prepare (newSampleRate, bands.size(), numChans);
+    doubleCascade.prepare (newSampleRate, bands.size(), numChans);
+
+    // NB: Starting out on the bands' settings, rather than gliding over to them from the last sample rate's.
+    updateBands (true);
+    floatCascade.reset();
+    doubleCascade.reset();
 }
 
-void SimpleEQProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)    { process (buffer); }
-void SimpleEQProcessor::processBlock (juce::AudioBuffer<double>& buffer, MidiBuffer&)   { process (buffer); }
+void SimpleEQProcessor::processBlock (juce::AudioBuffer<float>& buffer, MidiBuffer&)    { process (buffer, floatCascade); }
+void SimpleEQProcessor::processBlock (juce::AudioBuffer<double>& buffer, MidiBuffer&)   { process (buffer, doubleCascade); }
 
 template<typename SampleType>
-void SimpleEQProcessor::process (juce::AudioBuffer<SampleType>& buffer)
+void SimpleEQProcessor::process (juce::AudioBuffer<SampleType>& buffer, BiquadCascade<SampleType>& cascade)
 {
     const auto numChannels = buffer.getNumChannels();
     const auto numSamples = buffer.getNumSamples();
 
-    const bool isWholeProcBypassed = isBypassed()
-                                  || buffer.hasBeenCleared()
-                                  || numChannels <= 0
-                                  || numSamples <= 0;
+    if (isBypassed()
+        || buffer.hasBeenCleared()
+        || numChannels <= 0
+        || numSamples <= 0)
+        return;
 
     const ScopedLock sl (getCallbackLock());
 
-    for (auto* f : filters)
-        f->process (buffer, isWholeProcBypassed);
+    updateBands (false);
+    cascade.process (buffer.getArrayOfWritePointers(), numChannels, numSamples);
+}
+
+void SimpleEQProcessor::updateBands (bool force)
+{
+    // NB: The parameters get polled here, on the audio thread, instead of being listened to,
+    //     which could happen on any thread, in the middle of a block.
+    const auto sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+
+    for (int i = 0; i < bands.size(); ++i)
+    {
+        auto& band = bands.getReference (i);
+
+        const auto g = band.gain->get();
+        const auto c = band.cutoff->get();
+        const auto r = band.resonance->get();
+
+        if (! force && g == band.lastGain && c == band.lastCutoff && r == band.lastResonance)
+            continue;
+
+        band.lastGain = g;
+        band.lastCutoff = c;
+        band.lastResonance = r;
+
+        BiquadCoefficients coefficients;
+
+        switch (band.type)
+        {
+            case BandType::lowShelf:    coefficients = BiquadCoefficients::makeLowShelf (sampleRate, c, r, g); break;
+            case BandType::peak:        coefficients = BiquadCoefficients::makePeakFilter (sampleRate, c, r, g); break;
+            case BandType::highShelf:   coefficients = BiquadCoefficients::makeHighShelf (sampleRate, c, r, g); break;
+
+            default:
+                jassertfalse;
+            break;
+        }
+
+        floatCascade.setCoefficients (i, coefficients);
+        doubleCascade.setCoefficients (i, coefficients);
+    }
 }
 
 //==============================================================================
@@ -164,20 +92,20 @@ AudioProcessorValueTreeState::ParameterLayout SimpleEQProcessor::createParameter
     struct Config final
     {
         String name;
-        FilterType type = FilterType::bandpass;
+        BandType type = BandType::peak;
         int note = 0;
     };
 
     const Config configs[] =
     {
-        { NEEDS_TRANS ("LowShelf"), FilterType::highpass, 24 },
-        { NEEDS_TRANS ("BandPass1"), FilterType::bandpass, 48 },
-        { NEEDS_TRANS ("BandPass2"), FilterType::bandpass, 60 },
-        { NEEDS_TRANS ("BandPass3"), FilterType::bandpass, 72 },
-        { NEEDS_TRANS ("HighShelf"), FilterType::lowpass, 108 }
+        { NEEDS_TRANS ("LowShelf"), BandType::lowShelf, 24 },
+        { NEEDS_TRANS ("BandPass1"), BandType::peak, 48 },
+        { NEEDS_TRANS ("BandPass2"), BandType::peak, 60 },
+        { NEEDS_TRANS ("BandPass3"), BandType::peak, 72 },
+        { NEEDS_TRANS ("HighShelf"), BandType::highShelf, 108 }
     };
 
-    filters.ensureStorageAllocated (numElementsInArray (configs));
+    bands.ensureStorageAllocated (numElementsInArray (configs));
 
     auto layout = createDefaultParameterLayout();
 
@@ -195,14 +123,19 @@ AudioProcessorValueTreeState::ParameterLayout SimpleEQProcessor::createParameter
                                                                 TRANS ("Q (XYZ)").replace ("XYZ", TRANS (c.name)),
                                                                 0.00001f, 10.0f, 1.0f / MathConstants<float>::sqrt2);
 
-        filters.add (new InternalFilter (c.type, gain.get(), cutoff.get(), resonance.get()));
+        Band band;
+        band.type = c.type;
+        band.gain = gain.get();
+        band.cutoff = cutoff.get();
+        band.resonance = resonance.get();
+        bands.add (band);
 
         layout.add (std::move (gain));
         layout.add (std::move (cutoff));
         layout.add (std::move (resonance));
     }
 
-    filters.minimiseStorageOverheads();
+    bands.minimiseStorageOverheads();
 
     return layout;
 }
@@ -24,28 +24,36 @@ public:
 
 private:
     //==============================================================================
-    using FilterType = dsp::StateVariableTPTFilterType;
+    enum class BandType
+    {
+        lowShelf,
+        peak,
+        highShelf
+    };
 
-    template<typename SampleType>
-    using Context = dsp::ProcessContextReplacing<SampleType>;
-
-    template<typename SampleType>
-    using Filter = dsp::IIR::Filter<SampleType>;
+    struct Band final
+    {
+        BandType type = BandType::peak;
 
-    template<typename SampleType>
-    using Coefficients = dsp::IIR::Coefficients<SampleType>;
+        // NB: These are owned by the parent EQ processor.
+        AudioParameterFloat* gain = nullptr;
+        AudioParameterFloat* cutoff = nullptr;
+        AudioParameterFloat* resonance = nullptr;
 
-    template<typename SampleType>
-    using ProcessorDuplicator = dsp::ProcessorDuplicator<Filter<SampleType>, Coefficients<SampleType>>;
+        float lastGain = 0.0f, lastCutoff = 0.0f, lastResonance = 0.0f;
+    };
 
-    class InternalFilter;
-    OwnedArray<InternalFilter> filters;
+    Array<Band> bands;
+    BiquadCascade<float> floatCascade;
+    BiquadCascade<double> doubleCascade;
 
     //==============================================================================
     AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    void updateBands (bool force);
+
     template<typename SampleType>
-    void process (juce::AudioBuffer<SampleType>& buffer);
+    void process (juce::AudioBuffer<SampleType>& buffer, BiquadCascade<SampleType>& cascade);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQProcessor)
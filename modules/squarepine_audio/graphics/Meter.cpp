@@ -97,6 +97,50 @@ bool Meter::refreshLevels()
     return areLevelsDifferent;
 }
 
+void Meter::setAudioSource (BroadcastAudioRing<float>* source)
+{
+    audioSource = source;
+
+    if (audioSource != nullptr)
+    {
+        audioSourceReader = audioSource->createReader();
+        audioSourceBuffer.setSize (audioSource->getNumChannels(), 4096, false, false, true);
+    }
+}
+
+void Meter::getChannelLevels (Array<float>& destData)
+{
+    if (audioSource == nullptr)
+    {
+        destData.clearQuick();
+        return;
+    }
+
+    const auto numChannels = audioSourceBuffer.getNumChannels();
+    auto numSamplesRead = 0;
+
+    // Taking the peaks of everything since the last refresh, a buffer-load at a time,
+    // though without chasing after a writer that never stops:
+    while (numSamplesRead < audioSource->getCapacity())
+    {
+        const auto numSamples = audioSource->read (audioSourceReader, audioSourceBuffer);
+
+        if (numSamples <= 0)
+            break;
+
+        if (numSamplesRead == 0)
+        {
+            destData.clearQuick();
+            destData.insertMultiple (0, 0.0f, numChannels);
+        }
+
+        for (int i = 0; i < numChannels; ++i)
+            destData.set (i, jmax (destData[i], audioSourceBuffer.getMagnitude (i, 0, numSamples)));
+
+        numSamplesRead += numSamples;
+    }
+}
+
 void Meter::initVolumeGradient (int width, int height, bool isVertical)
 {
     if (width <= 0 || height <= 0)
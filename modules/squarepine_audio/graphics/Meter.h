@@ -196,8 +196,23 @@ public:
     void resetClippingLevel() { clippingLevel = ClippingLevel::none; }
 
     //==============================================================================
-    /** */
-    virtual void getChannelLevels (Array<float>& destData) = 0;
+    /** Makes the meter measure the peaks of the audio in a ring,
+        with a reader of its own, for as long as no subclass provides its own levels.
+
+        @param source The ring to read from, or nullptr to stop reading from it.
+                     This must outlive the meter, or be reset before being deleted,
+                     and must not be prepared again while the meter reads from it.
+
+        @see LevelsProcessor::enableBroadcasting
+    */
+    void setAudioSource (BroadcastAudioRing<float>* source);
+
+    /** Provides the latest levels of each channel.
+
+        By default, this measures the peaks of the audio in the ring given to setAudioSource(),
+        since the last time the levels were asked for, or gives back none without a ring.
+    */
+    virtual void getChannelLevels (Array<float>& destData);
 
 protected:
     //==============================================================================
@@ -207,6 +222,9 @@ protected:
     Array<float> levels;
     ClippingLevel clippingLevel = ClippingLevel::none;
     Colour colourLowIntensity, colourMediumIntensity, colourHighIntensity;
+    BroadcastAudioRing<float>* audioSource = nullptr;
+    BroadcastAudioRing<float>::Reader audioSourceReader;
+    juce::AudioBuffer<float> audioSourceBuffer;
 
     /** The expiration time of the maximum meter level, after which it decays. */
     enum { maxLevelExpiryMs = 3000 };
@@ -1,4 +1,70 @@
-ProgramAudioProcessorEditor::ProgramAudioProcessorEditor (AudioProcessor& p) :
+//==============================================================================
+class ProgramAudioProcessorEditor::EffectStatisticsOverlay final : public Component,
+                                                                  private Timer
+{
+public:
+    EffectStatisticsOverlay (EffectProcessorChain& c) :
+        chain (c)
+    {
+        setInterceptsMouseClicks (false, false);
+        startTimerHz (4);
+    }
+
+    void paint (Graphics& g) override
+    {
+        if (lines.isEmpty())
+            return;
+
+        constexpr int lineHeight = 16;
+
+        auto area = getLocalBounds().reduced (4);
+        area = area.removeFromBottom (jmin (area.getHeight(), lines.size() * lineHeight));
+
+        g.setColour (Colours::black.withAlpha (0.7f));
+        g.fillRect (area.expanded (2));
+
+        g.setColour (Colours::white);
+        g.setFont (Font (Font::getDefaultMonospacedFontName(), 12.0f, Font::plain));
+
+        for (const auto& line : lines)
+            g.drawFittedText (line, area.removeFromTop (lineHeight), Justification::centredLeft, 1);
+    }
+
+private:
+    EffectProcessorChain& chain;
+    StringArray lines;
+
+    void timerCallback() override
+    {
+        StringArray newLines;
+
+        for (int i = 0; i < chain.getNumEffects(); ++i)
+        {
+            if (auto effect = chain.getEffectProcessor (i))
+            {
+                const auto summary = effect->statistics.getSummary();
+
+                newLines.add (effect->name
+                              + ": mean " + String (summary.meanMs, 3)
+                              + " ms, p99 " + String (summary.p99Ms, 3)
+                              + " ms, max " + String (summary.maxMs, 3)
+                              + " ms, denormals " + String (summary.numDenormalFlushes)
+                              + ", latency " + String (summary.latencySamples));
+            }
+        }
+
+        if (newLines != lines)
+        {
+            lines.swapWith (newLines);
+            repaint();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectStatisticsOverlay)
+};
+
+//==============================================================================
+ProgramAudioProcessorEditor::ProgramAudioProcessorEditor (AudioProcessor& p, bool showEffectStatistics) :
     AudioProcessorEditor (p)
 {
     setOpaque (true);
@@ -23,7 +89,21 @@ ProgramAudioProcessorEditor::ProgramAudioProcessorEditor (AudioProcessor& p) :
     panel.addProperties (programs);
 
     addAndMakeVisible (panel);
-    setSize (400, std::clamp (totalHeight, 25, 400));
+
+    if (showEffectStatistics)
+    {
+        if (auto* chain = dynamic_cast<EffectProcessorChain*> (&p))
+        {
+            statisticsOverlay = std::make_unique<EffectStatisticsOverlay> (*chain);
+            addAndMakeVisible (statisticsOverlay.get());
+        }
+    }
+
+    setSize (400, std::clamp (totalHeight, statisticsOverlay != nullptr ? 200 : 25, 400));
+}
+
+ProgramAudioProcessorEditor::~ProgramAudioProcessorEditor()
+{
 }
 
 void ProgramAudioProcessorEditor::paint (Graphics& g)
@@ -34,4 +114,7 @@ void ProgramAudioProcessorEditor::paint (Graphics& g)
 void ProgramAudioProcessorEditor::resized()
 {
     panel.setBounds (getLocalBounds());
+
+    if (statisticsOverlay != nullptr)
+        statisticsOverlay->setBounds (getLocalBounds());
 }
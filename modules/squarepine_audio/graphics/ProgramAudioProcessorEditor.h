@@ -2,8 +2,16 @@
 class ProgramAudioProcessorEditor final : public AudioProcessorEditor
 {
 public:
-    /** */
-    ProgramAudioProcessorEditor (AudioProcessor& p);
+    /** Constructor.
+
+        @param processor            The processor to edit.
+        @param showEffectStatistics If the processor is an EffectProcessorChain, setting this
+                                    to true will overlay how each of its effects has been performing.
+    */
+    ProgramAudioProcessorEditor (AudioProcessor& processor, bool showEffectStatistics = false);
+
+    /** Destructor. */
+    ~ProgramAudioProcessorEditor() override;
 
     //==============================================================================
     /** @internal */
@@ -42,7 +50,10 @@ private:
     };
 
     //==============================================================================
+    class EffectStatisticsOverlay;
+
     PropertyPanel panel;
+    std::unique_ptr<EffectStatisticsOverlay> statisticsOverlay;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProgramAudioProcessorEditor)
@@ -1,3 +1,340 @@
+//==============================================================================
+namespace
+{
+    /** The zeroth order modified Bessel function of the first kind, which the Kaiser window is made of. */
+    double besselI0 (double x) noexcept
+    {
+        const auto halfX = x * 0.5;
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+        {
+            term *= square (halfX / (double) k);
+            sum += term;
+        }
+
+        return sum;
+    }
+}
+
+//==============================================================================
+PolyphaseFilterBank::PolyphaseFilterBank (Quality q) :
+    quality (q)
+{
+    switch (quality)
+    {
+        case Quality::low:      halfLength = 8;  numPhases = 128; rolloff = 0.85; kaiserBeta = 6.0;  break;
+        case Quality::medium:   halfLength = 16; numPhases = 256; rolloff = 0.91; kaiserBeta = 8.0;  break;
+        case Quality::high:     halfLength = 32; numPhases = 512; rolloff = 0.95; kaiserBeta = 10.0; break;
+        default: jassertfalse; break;
+    }
+
+    numTaps = halfLength * 2;
+
+    const auto numCoefficients = (size_t) ((numPhases + 1) * numTaps);
+    coefficients.calloc (numCoefficients);
+    window.calloc (numCoefficients);
+
+    const auto windowScale = 1.0 / besselI0 (kaiserBeta);
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto windowPos = ((double) (halfLength - 1 - tap) + (double) phase / (double) numPhases) / (double) halfLength;
+
+            if (std::abs (windowPos) < 1.0)
+                window[phase * numTaps + tap] = (float) (besselI0 (kaiserBeta * std::sqrt (1.0 - square (windowPos))) * windowScale);
+        }
+    }
+
+    createCoefficients (rolloff);
+}
+
+double PolyphaseFilterBank::getCutoffForRatio (double ratio) const noexcept
+{
+    // When downsampling, the cutoff must come down to the destination's Nyquist frequency:
+    return rolloff / jmax (1.0, ratio);
+}
+
+void PolyphaseFilterBank::setCutoff (double newCutoff)
+{
+    if (! approximatelyEqual (newCutoff, cutoff))
+        createCoefficients (newCutoff);
+}
+
+void PolyphaseFilterBank::createCoefficients (double newCutoff)
+{
+    cutoff = newCutoff;
+
+    // Each row holds the filter for a position between two source samples, and the extra row is the next sample's:
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto* row = coefficients.get() + phase * numTaps;
+        const auto* rowWindow = window.get() + phase * numTaps;
+        const auto fraction = (double) phase / (double) numPhases;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto x = (double) (halfLength - 1 - tap) + fraction;
+            const auto sincPos = MathConstants<double>::pi * cutoff * x;
+            const auto sinc = approximatelyEqual (sincPos, 0.0) ? 1.0 : std::sin (sincPos) / sincPos;
+            const auto coefficient = cutoff * sinc * (double) rowWindow[tap];
+
+            row[tap] = (float) coefficient;
+            sum += coefficient;
+        }
+
+        // Making each phase pass DC at unity gain, so that interpolating between phases can't ripple:
+        if (sum > 0.0)
+            FloatVectorOperations::multiply (row, (float) (1.0 / sum), numTaps);
+    }
+}
+
+void PolyphaseFilterBank::createKernel (double fraction, float* kernel) const noexcept
+{
+    jassert (fraction >= 0.0 && fraction < 1.0);
+
+    const auto phase = fraction * (double) numPhases;
+    const auto phaseIndex = jlimit (0, numPhases - 1, (int) phase);
+    const auto phaseFraction = (float) (phase - (double) phaseIndex);
+    const auto* row = coefficients.get() + phaseIndex * numTaps;
+
+    FloatVectorOperations::copyWithMultiply (kernel, row, 1.0f - phaseFraction, numTaps);
+    FloatVectorOperations::addWithMultiply (kernel, row + numTaps, phaseFraction, numTaps);
+}
+
+float PolyphaseFilterBank::apply (const float* samples, const float* kernel, int numTaps) noexcept
+{
+    jassert ((numTaps % 4) == 0);
+
+    // Four separate sums, so the compiler can keep them in a single vector register:
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+
+    for (int i = 0; i < numTaps; i += 4)
+    {
+        sum0 += samples[i] * kernel[i];
+        sum1 += samples[i + 1] * kernel[i + 1];
+        sum2 += samples[i + 2] * kernel[i + 2];
+        sum3 += samples[i + 3] * kernel[i + 3];
+    }
+
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+//==============================================================================
+/** The filter banks for each step of the ratio, shared by every resampler,
+    which only get made the first time a resampler of their quality comes along.
+*/
+class PolyphaseResampler::CutoffBanks final
+{
+public:
+    CutoffBanks() = default;
+
+    static constexpr int numStepsPerOctave = 8;
+
+    const OwnedArray<PolyphaseFilterBank>& get (Quality quality)
+    {
+        const ScopedLock sl (lock);
+
+        auto& banks = banksForQuality[(size_t) quality];
+
+        if (banks.isEmpty())
+        {
+            const auto numSteps = roundToInt (std::log2 (maxRatioForCutoff) * numStepsPerOctave);
+
+            for (int step = 0; step <= numSteps; ++step)
+            {
+                auto* bank = banks.add (new PolyphaseFilterBank (quality));
+                bank->setCutoff (bank->getCutoffForRatio (std::exp2 ((double) step / numStepsPerOctave)));
+            }
+        }
+
+        return banks;
+    }
+
+private:
+    CriticalSection lock;
+    std::array<OwnedArray<PolyphaseFilterBank>, 3> banksForQuality;    //< One for each Quality.
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CutoffBanks)
+};
+
+//==============================================================================
+PolyphaseResampler::PolyphaseResampler (Quality quality) :
+    filterBanks (cutoffBanks->get (quality))
+{
+    filterBank = getFilterBankForRatio (getRatio());
+    kernel.calloc ((size_t) filterBank->getNumTaps());
+    currentRatio.setCurrentAndTargetValue (getRatio());
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+//==============================================================================
+void PolyphaseResampler::prepare (int numChannels, double, int)
+{
+    history.setSize (jmax (1, numChannels), filterBank->getNumTaps() * 2, false, false, true);
+    reset();
+}
+
+void PolyphaseResampler::reset() noexcept
+{
+    history.clear();
+    historyIndex = 0;
+    subSamplePos = 1.0;
+    numSamplesConsumed = 0;
+    currentRatio.setCurrentAndTargetValue (currentRatio.getTargetValue());
+}
+
+void PolyphaseResampler::setTargetRatio (double newRatio, int numDestSamplesToSlide)
+{
+    // NB: Otherwise the slide would hang around until some later setRatio(), which is meant to jump.
+    if (newRatio == getRatio() || newRatio <= 0.0)
+        return;
+
+    numSamplesToSlide.store (jmax (0, numDestSamplesToSlide), std::memory_order_relaxed);
+    setRatio (newRatio);
+}
+
+void PolyphaseResampler::updateRatio()
+{
+    // NB: The ratio and the filter bank only ever change from process(), so they can't change underneath it.
+    ratioChanged.store (true, std::memory_order_release);
+}
+
+void PolyphaseResampler::applyRatioChange (LinearSmoothedValue<double>& ratioToChange, int numSamplesToSlideOver) const noexcept
+{
+    const auto target = getRatio();
+
+    if (numSamplesToSlideOver > 0)
+    {
+        // NB: Resetting the number of steps also jumps to the old target, so the slide starts from where it's at.
+        const auto current = ratioToChange.getCurrentValue();
+        ratioToChange.reset (numSamplesToSlideOver);
+        ratioToChange.setCurrentAndTargetValue (current);
+        ratioToChange.setTargetValue (target);
+    }
+    else
+    {
+        ratioToChange.setCurrentAndTargetValue (target);
+    }
+}
+
+const PolyphaseFilterBank* PolyphaseResampler::getFilterBankForRatio (double ratio) const noexcept
+{
+    // Rounding up to the next step, whose cutoff is lower, with a little leeway for ratios right on a step:
+    const auto step = (int) std::ceil (std::log2 (jmax (1.0, ratio)) * CutoffBanks::numStepsPerOctave - 1.0e-6);
+    return filterBanks.getUnchecked (jlimit (0, filterBanks.size() - 1, step));
+}
+
+int PolyphaseResampler::getNumSamplesNeeded (int numDestSamples) const
+{
+    // Going through the same steps as process() does, on copies:
+    auto slidingRatio = currentRatio;
+
+    if (ratioChanged.load (std::memory_order_acquire))
+        applyRatioChange (slidingRatio, numSamplesToSlide.load (std::memory_order_relaxed));
+
+    auto position = subSamplePos;
+    int numNeeded = 0;
+
+    for (int i = 0; i < numDestSamples; ++i)
+    {
+        while (position >= 1.0)
+        {
+            ++numNeeded;
+            position -= 1.0;
+        }
+
+        position += slidingRatio.getNextValue();
+    }
+
+    return numNeeded;
+}
+
+//==============================================================================
+void PolyphaseResampler::process (juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& dest)
+{
+    process (source.getArrayOfReadPointers(), source.getNumChannels(), source.getNumSamples(),
+             dest.getArrayOfWritePointers(), dest.getNumChannels(), dest.getNumSamples());
+}
+
+void PolyphaseResampler::process (const float* const* src, int numSourceChannels, int numSourceSamples,
+                                  float* const* dst, int numDestChannels, int numDestSamples) noexcept
+{
+    if (ratioChanged.exchange (false, std::memory_order_acquire))
+        applyRatioChange (currentRatio, numSamplesToSlide.exchange (0, std::memory_order_relaxed));
+
+    {
+        // While sliding, the cutoff only ever needs to come down, which happens once at the start of a slide:
+        const auto isSliding = currentRatio.isSmoothing();
+        const auto* bank = getFilterBankForRatio (isSliding ? jmax (currentRatio.getCurrentValue(), currentRatio.getTargetValue())
+                                                            : currentRatio.getTargetValue());
+
+        if (! isSliding || bank->getCutoff() < filterBank->getCutoff())
+            filterBank = bank;
+    }
+
+    const auto numTaps = filterBank->getNumTaps();
+    const auto numChannels = jmin (numSourceChannels, numDestChannels, history.getNumChannels());
+
+    for (int i = numChannels; i < numDestChannels; ++i)
+        FloatVectorOperations::clear (dst[i], numDestSamples);
+
+    numSamplesConsumed = 0;
+
+    if (numChannels <= 0)
+        return;
+
+    auto** hist = history.getArrayOfWritePointers();
+
+    for (int s = 0; s < numDestSamples; ++s)
+    {
+        while (subSamplePos >= 1.0)
+        {
+            // The source must hold enough samples to fill the destination at the current ratio!
+            jassert (numSamplesConsumed < numSourceSamples);
+            const auto hasSample = numSamplesConsumed < numSourceSamples;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                const auto sample = hasSample ? src[i][numSamplesConsumed] : 0.0f;
+                hist[i][historyIndex] = sample;
+                hist[i][historyIndex + numTaps] = sample;
+            }
+
+            if (++historyIndex >= numTaps)
+                historyIndex = 0;
+
+            if (hasSample)
+                ++numSamplesConsumed;
+
+            subSamplePos -= 1.0;
+        }
+
+        if (approximatelyEqual (subSamplePos, 0.0) && approximatelyEqual (currentRatio.getCurrentValue(), 1.0) && ! currentRatio.isSmoothing())
+        {
+            // Landing right on a source sample, which only needs delaying by the same latency as when filtering:
+            for (int i = 0; i < numChannels; ++i)
+                dst[i][s] = hist[i][historyIndex + filterBank->getHalfLength() - 1];
+        }
+        else
+        {
+            // Working out the filter for this position once, for all of the channels:
+            filterBank->createKernel (subSamplePos, kernel.get());
+
+            for (int i = 0; i < numChannels; ++i)
+                dst[i][s] = PolyphaseFilterBank::apply (hist[i] + historyIndex, kernel.get(), numTaps);
+        }
+
+        subSamplePos += currentRatio.getNextValue();
+    }
+}
+
 //==============================================================================
 #if SQUAREPINE_USE_R8BRAIN
 
@@ -34,12 +34,45 @@ public:
     /** If the ratio has changed, you might need to override this to update your subclass. */
     virtual void updateRatio() {}
 
+    /** @returns the number of source samples that the next call to process() needs to fill
+        a destination of the given length.
+
+        Unless a subclass knows better, this is only an estimate based on the current ratio.
+    */
+    virtual int getNumSamplesNeeded (int numDestSamples) const
+    {
+        return (int) std::ceil ((double) numDestSamples * getRatio());
+    }
+
     /** @returns the current resampling ratio */
     sp_nodiscard double getRatio() const noexcept { return ratio.load (std::memory_order_relaxed); }
 
     /** @returns the inverse resampling ratio */
     sp_nodiscard double getInverseRatio() const noexcept { return 1.0 / getRatio(); }
 
+protected:
+    /** Copies as much of the source as fits into the destination, without allocating,
+        and clears whatever is left of the destination.
+    */
+    static void copyOrClear (const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& dest) noexcept
+    {
+        const auto numChannels = jmin (source.getNumChannels(), dest.getNumChannels());
+        const auto numSamples = jmin (source.getNumSamples(), dest.getNumSamples());
+
+        for (int i = 0; i < dest.getNumChannels(); ++i)
+        {
+            if (i < numChannels && ! source.hasBeenCleared())
+            {
+                dest.copyFrom (i, 0, source, i, 0, numSamples);
+                dest.clear (i, numSamples, dest.getNumSamples() - numSamples);
+            }
+            else
+            {
+                dest.clear (i, 0, dest.getNumSamples());
+            }
+        }
+    }
+
 private:
     std::atomic<double> ratio { 1.0 };
 
@@ -83,7 +116,7 @@ public:
 
         if (approximatelyEqual (r, 1.0) || source.hasBeenCleared())
         {
-            dest = source;
+            copyOrClear (source, dest);
         }
         else
         {
@@ -117,10 +150,208 @@ using LinearResampler = TemplatedResampler<LinearInterpolator>;
 /** */
 using ZeroOrderHoldResampler = TemplatedResampler<ZeroOrderHoldInterpolator>;
 
+//==============================================================================
+/** A bank of Kaiser-windowed sinc filters, precomputed at a fixed number of phases
+    in between two source samples.
+
+    The filter for any position in between two phases gets interpolated from them,
+    which makes this the building block for resampling at arbitrary ratios.
+
+    @see PolyphaseResampler, ResamplingAudioFormatReader
+*/
+class PolyphaseFilterBank final
+{
+public:
+    /** The trade-offs between quality and speed that are available. */
+    enum class Quality
+    {
+        low,        //< 16 taps: fine for previewing.
+        medium,     //< 32 taps.
+        high        //< 64 taps: for rendering.
+    };
+
+    /** Creates a filter bank with its cutoff just below the Nyquist frequency. */
+    explicit PolyphaseFilterBank (Quality quality = Quality::high);
+
+    //==============================================================================
+    /** @returns the quality that this filter bank was created with. */
+    Quality getQuality() const noexcept { return quality; }
+
+    /** @returns the number of source samples that each filter spans. */
+    int getNumTaps() const noexcept { return numTaps; }
+
+    /** @returns the number of taps on either side of the position being filtered at. */
+    int getHalfLength() const noexcept { return halfLength; }
+
+    //==============================================================================
+    /** @returns the cutoff that's needed for resampling at the given ratio,
+        relative to the source's Nyquist frequency.
+    */
+    double getCutoffForRatio (double ratio) const noexcept;
+
+    /** @returns the cutoff of the filters, relative to the source's Nyquist frequency. */
+    double getCutoff() const noexcept { return cutoff; }
+
+    /** Recalculates the filters for a new cutoff, without allocating. */
+    void setCutoff (double newCutoff);
+
+    //==============================================================================
+    /** Works out the filter for a position, past source sample getHalfLength() - 1 by
+        the given fraction, which must be in the range [0, 1).
+
+        @param fraction The position in between the two source samples.
+        @param kernel   Where to put the getNumTaps() coefficients of the filter.
+    */
+    void createKernel (double fraction, float* kernel) const noexcept;
+
+    /** Applies a filter to a run of getNumTaps() source samples.
+        @returns the filtered sample.
+    */
+    static float apply (const float* samples, const float* kernel, int numTaps) noexcept;
+
+private:
+    //==============================================================================
+    const Quality quality;
+    int halfLength = 0, numTaps = 0, numPhases = 0;
+    double rolloff = 0.0, kaiserBeta = 0.0, cutoff = 0.0;
+
+    HeapBlock<float> coefficients;  //< numPhases + 1 rows of numTaps coefficients.
+    HeapBlock<float> window;        //< The Kaiser window for each of the coefficients, which doesn't depend on the cutoff.
+
+    //==============================================================================
+    void createCoefficients (double newCutoff);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseFilterBank)
+};
+
+//==============================================================================
+/** A multichannel windowed-sinc resampler, built around a PolyphaseFilterBank.
+
+    Rather than running a separate interpolator over each channel one after the other,
+    as the TemplatedResamplers do, this works out the filter for each output sample
+    once and then applies it to every channel. That's what keeps it cheap for stems
+    with lots of channels.
+
+    When downsampling, the cutoff of the filter follows the ratio to keep aliasing out.
+    Rather than working the filters out again for every new ratio, it picks from
+    a set of them made up front, in steps of an eighth of an octave up to a ratio of
+    maxRatioForCutoff, always taking the step with the next lowest cutoff.
+    Every resampler of the same quality shares the one set.
+
+    Just like JUCE's interpolators, each call to process() fills the whole of the
+    destination, and consumes however many source samples that took,
+    which is available from getNumSamplesConsumed() afterwards.
+    getNumSamplesNeeded() tells exactly how many that will be beforehand,
+    so that callers can pull just enough audio from disk.
+    The output is late by getLatencySamples(), whatever the ratio.
+
+    For varispeed, setTargetRatio() slides the ratio from one destination sample
+    to the next rather than jumping at the start of a block. Nothing gets allocated
+    after prepare(), whichever way the ratio changes.
+*/
+class PolyphaseResampler final : public Resampler
+{
+public:
+    /** */
+    using Quality = PolyphaseFilterBank::Quality;
+
+    /** Constructor. */
+    PolyphaseResampler (Quality quality = Quality::high);
+
+    /** Destructor. */
+    ~PolyphaseResampler() override;
+
+    //==============================================================================
+    /** The highest ratio that the cutoff follows the ratio to.
+        Past this, the cutoff stays where it is at this ratio, so some aliasing creeps in.
+    */
+    static constexpr double maxRatioForCutoff = 4.0;
+
+    /** @returns the quality that this resampler was created with. */
+    Quality getQuality() const noexcept { return filterBank->getQuality(); }
+
+    /** @returns the number of source samples that the last call to process() consumed. */
+    int getNumSamplesConsumed() const noexcept { return numSamplesConsumed; }
+
+    /** @returns the delay that the filter introduces, in source samples. */
+    int getLatencySamples() const noexcept { return filterBank->getHalfLength(); }
+
+    /** Forgets about any of the audio that was processed so far. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Slides over to a new ratio, over the given number of destination samples.
+
+        The slide starts with the next call to process(), and carries on over as many
+        calls as it takes. setRatio() on the other hand jumps straight to the new ratio.
+
+        When sliding into a higher ratio than 1, the filter's cutoff is set for the
+        highest ratio of the slide from the start, so nothing aliases on the way there.
+
+        Setting the same ratio as getRatio() does nothing, and leaves any slide
+        that hasn't started yet alone.
+    */
+    void setTargetRatio (double newRatio, int numDestSamplesToSlide);
+
+    /** @returns the ratio that process() is at, which trails getRatio() while sliding.
+        This must only be called from the thread that calls process().
+    */
+    double getCurrentRatio() const noexcept { return currentRatio.getCurrentValue(); }
+
+    /** @returns the exact number of source samples that the next call to process()
+        will consume to fill a destination of the given length.
+
+        This must only be called from the thread that calls process().
+    */
+    int getNumSamplesNeeded (int numDestSamples) const override;
+
+    /** Does the same as process(), but on channels that aren't in AudioBuffers,
+        which saves building AudioBuffers to refer to parts of other ones.
+    */
+    void process (const float* const* source, int numSourceChannels, int numSourceSamples,
+                  float* const* dest, int numDestChannels, int numDestSamples) noexcept;
+
+    //==============================================================================
+    /** @internal */
+    void prepare (int numChannels, double sampleRate, int numSamples) override;
+    /** @internal */
+    void process (juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& dest) override;
+    /** @internal */
+    void updateRatio() override;
+
+private:
+    //==============================================================================
+    class CutoffBanks;
+
+    SharedResourcePointer<CutoffBanks> cutoffBanks;
+    const OwnedArray<PolyphaseFilterBank>& filterBanks;    //< One per step of the ratio, for this resampler's quality.
+    const PolyphaseFilterBank* filterBank = nullptr;        //< Whichever of the filterBanks process() is filtering with.
+    HeapBlock<float> kernel;
+
+    std::atomic<bool> ratioChanged { false };
+    std::atomic<int> numSamplesToSlide { 0 };
+    LinearSmoothedValue<double> currentRatio { 1.0 };
+
+    juce::AudioBuffer<float> history;   //< The last numTaps source samples of each channel, written twice over so that they can always be read in one go.
+    int historyIndex = 0;
+    double subSamplePos = 1.0;
+    int numSamplesConsumed = 0;
+
+    //==============================================================================
+    void applyRatioChange (LinearSmoothedValue<double>& ratioToChange, int numSamplesToSlideOver) const noexcept;
+    const PolyphaseFilterBank* getFilterBankForRatio (double ratio) const noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler)
+};
+
 //==============================================================================
 #if SQUAREPINE_USE_R8BRAIN
 
-/** */
+/** @warning Every change of ratio rebuilds r8brain's resamplers, which allocates.
+             For varispeed, use a PolyphaseResampler's setTargetRatio() instead.
+*/
 class R8brainResampler final : public Resampler
 {
 public:
@@ -1,26 +1,33 @@
 ResamplingAudioFormatReader::ResamplingAudioFormatReader (std::shared_ptr<AudioFormatReader> formatReader,
-                                                          std::shared_ptr<TimeSliceThread> tst) :
+                                                          PolyphaseFilterBank::Quality quality) :
     AudioFormatReader (formatReader->input, formatReader->getFormatName() + "-SRC"),
     reader (formatReader),
-    timeSliceThread (tst)
+    filterBank (quality)
 {
     jassert (reader != nullptr);
 
     sampleRate = originalSampleRate = reader->sampleRate;
     jassert (sampleRate != 0.0);
 
-    bitsPerSample = reader->bitsPerSample;
+    // NB: Everything gets resampled as floats, and written out as such.
+    bitsPerSample = 32;
+    usesFloatingPointData = true;
+
     lengthInSamples = reader->lengthInSamples;
     numChannels = reader->numChannels;
-    usesFloatingPointData = reader->usesFloatingPointData;
     metadataValues = reader->metadataValues;
     input = nullptr;
+
+    kernel.calloc ((size_t) filterBank.getNumTaps());
+
+    if (originalSampleRate > 0.0)
+        prepare (originalSampleRate, 0);
 }
 
 ResamplingAudioFormatReader::ResamplingAudioFormatReader (std::shared_ptr<AudioFormatReader> formatReader,
                                                           int expectedReadBlockSize, double outputSampleRate,
-                                                          std::shared_ptr<TimeSliceThread> tst) :
-    ResamplingAudioFormatReader (formatReader, tst)
+                                                          PolyphaseFilterBank::Quality quality) :
+    ResamplingAudioFormatReader (formatReader, quality)
 {
     prepare (outputSampleRate, expectedReadBlockSize);
 }
@@ -28,7 +35,6 @@ ResamplingAudioFormatReader::ResamplingAudioFormatReader (std::shared_ptr<AudioF
 ResamplingAudioFormatReader::~ResamplingAudioFormatReader()
 {
     input = nullptr; // Prevent the base-class from deleting the input...
-    source = nullptr; // Clear before the time-slice thread...
 }
 
 //==============================================================================
@@ -40,37 +46,64 @@ void ResamplingAudioFormatReader::prepare (double currentOutputSampleRate, int e
         return;
     }
 
+    sampleRate = currentOutputSampleRate;
     sourceRatio = currentOutputSampleRate / originalSampleRate;
+    sourceSamplesPerOutputSample = originalSampleRate / currentOutputSampleRate;
+    lengthInSamples = std::llround (static_cast<double> (reader->lengthInSamples) * sourceRatio);
 
-    // We're in a resampling situation, and the block size has changed, probably due to time-stretching
-    const bool blockSizeChanged = sampleRate == currentOutputSampleRate
-                               && currentOutputSampleRate != originalSampleRate
-                               && expectedReadBlockSize != sourceBlockSize;
+    filterBank.setCutoff (filterBank.getCutoffForRatio (sourceSamplesPerOutputSample));
 
-    // We're currently using a sample rate that's different than the current sample rate used by the interface
-    if (sampleRate != currentOutputSampleRate || blockSizeChanged)
-    {
-        sampleRate = currentOutputSampleRate;
-        lengthInSamples = std::llround (static_cast<double> (reader->lengthInSamples) * sourceRatio);
+    // The cache must hold all of the source samples around the output samples of the largest read:
+    constexpr int minSamplesPerRead = 512;
+    maxSamplesPerRead = jmax (minSamplesPerRead, expectedReadBlockSize);
 
-        if (sampleRate != originalSampleRate || expectedReadBlockSize != sourceBlockSize)
-        {
-            if (source == nullptr)
-                source.reset (new AudioTransportSource());
+    const auto cacheSize = (int) std::ceil ((double) maxSamplesPerRead * sourceSamplesPerOutputSample)
+                         + filterBank.getNumTaps() + 2;
+
+    cache.setSize (jmax (1, (int) numChannels), cacheSize, false, false, true);
+    cacheStart = 0;
+    numCached = 0;
+}
 
-            sourceBlockSize = expectedReadBlockSize;
-            source->prepareToPlay (sourceBlockSize, currentOutputSampleRate);
+//==============================================================================
+double ResamplingAudioFormatReader::getSourcePosition (int64 outputPosition) const noexcept
+{
+    // NB: Working this out from scratch for every sample is what makes reads sample-exact, wherever they start.
+    return (double) outputPosition * sourceSamplesPerOutputSample;
+}
 
-            if (rSource == nullptr)
-                rSource.reset (new AudioFormatReaderSource (reader.get(), false));
+void ResamplingAudioFormatReader::fillCache (int64 firstSample, int numSamples)
+{
+    jassert (numSamples <= cache.getNumSamples());
 
-            const auto readAheadSize = timeSliceThread == nullptr ? 0 : 2048;
+    const auto cacheEnd = cacheStart + numCached;
 
-            source->setSource (rSource.get(), readAheadSize, timeSliceThread.get(), reader->sampleRate);
+    if (firstSample >= cacheStart && firstSample + numSamples <= cacheEnd)
+        return;
 
-            outputBuffer.setSize ((int) numChannels, sourceBlockSize, false, true, true);
+    if (firstSample >= cacheStart && firstSample < cacheEnd)
+    {
+        // Reading along, so whatever overlaps with the last read is kept:
+        const auto numToKeep = (int) (cacheEnd - firstSample);
+        const auto offset = (int) (firstSample - cacheStart);
+
+        for (int i = 0; i < cache.getNumChannels(); ++i)
+        {
+            auto* channel = cache.getWritePointer (i);
+            std::memmove (channel, channel + offset, sizeof (float) * (size_t) numToKeep);
         }
+
+        numCached = numToKeep;
     }
+    else
+    {
+        numCached = 0;
+    }
+
+    // Filling up the whole of the cache, which reads ahead of what's needed right now:
+    cacheStart = firstSample;
+    reader->read (&cache, numCached, cache.getNumSamples() - numCached, cacheStart + numCached, true, true);
+    numCached = cache.getNumSamples();
 }
 
 //==============================================================================
@@ -81,88 +114,72 @@ bool ResamplingAudioFormatReader::readSamples (int** destSamples, int numDestCha
     if (reader == nullptr)
         return false;
 
-    // Pass through if no SRC required
-    if (sourceRatio == 1.0)
-        return reader->readSamples (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
-
-    if (source != nullptr)
-    {
-        if (outputBuffer.getNumSamples() != numSamples)
-            outputBuffer.setSize (numDestChannels, numSamples);
-
-        if (! source->isPlaying())
-            source->start();
-
-        /** To avoid playback issues when moving from block to block, "source" manages its position
-            The interface to this function specifies a playback position, so we check to see whether that new position
-            is different to the "source" position (within a tolerance) if it is then we move the source's position to the requested position
-        */
-        const auto newPosition = std::llround ((double) startSampleInFile * (1.0 / sourceRatio));
-        const auto diff = std::abs (rSource->getNextReadPosition() - newPosition);
+    const auto isPassThrough = sourceRatio == 1.0;
 
-        constexpr auto positionDiff = 5;
-        if (diff > positionDiff)
-            rSource->setNextReadPosition (newPosition);
+    // Pass through if no SRC required, and nothing needs converting either
+    if (isPassThrough && reader->usesFloatingPointData)
+        return reader->readSamples (destSamples, numDestChannels, startOffsetInDestBuffer, startSampleInFile, numSamples);
 
-        AudioSourceChannelInfo info (&outputBuffer, 0, numSamples);
-        source->getNextAudioBlock (info);
-    }
+    const auto numTaps = filterBank.getNumTaps();
+    const auto halfLength = filterBank.getHalfLength();
+    const auto numCacheChannels = cache.getNumChannels();
 
-    writeOutputBuffers (destSamples, numDestChannels, startOffsetInDestBuffer, numSamples);
+    while (numSamples > 0)
+    {
+        const auto numThisTime = jmin (numSamples, maxSamplesPerRead);
 
-    return true;
-}
+        // The source samples that the filters of this run of output samples span:
+        const auto firstSample = isPassThrough ? startSampleInFile
+                                               : (int64) std::floor (getSourcePosition (startSampleInFile)) - halfLength + 1;
+        const auto endSample = isPassThrough ? startSampleInFile + numThisTime
+                                             : (int64) std::floor (getSourcePosition (startSampleInFile + numThisTime - 1)) + halfLength + 1;
 
-//==============================================================================
-void ResamplingAudioFormatReader::writeOutputBuffers (int** destSamples, int numDestChannels, int startOffsetInDestBuffer, int numSamples)
-{
-    const auto localNumChannels = (int) numChannels;
-    const bool localUsesFloatingPointData = usesFloatingPointData;
+        fillCache (firstSample, (int) (endSample - firstSample));
 
-    // Copy SRC-ed samples to output
-    if (localUsesFloatingPointData)
-    {
-        const auto offset = (size_t) startOffsetInDestBuffer;
+        const auto** cached = cache.getArrayOfReadPointers();
 
-        for (int i = numDestChannels; --i >= 0;)
+        if (isPassThrough)
         {
-            if (auto* targetChannel = destSamples[i])
-            {
-                const float* sourceChannel = nullptr;
-
-                if (i < localNumChannels)
-                    sourceChannel = outputBuffer.getReadPointer (i, 0);
+            const auto offset = (int) (firstSample - cacheStart);
 
-                if (sourceChannel != nullptr)
-                    FloatVectorOperations::copy (reinterpret_cast<float*> (targetChannel) + offset, sourceChannel, numSamples);
-                else
-                    FloatVectorOperations::clear (reinterpret_cast<float*> (targetChannel) + offset, numSamples);
+            for (int i = numDestChannels; --i >= 0;)
+            {
+                if (auto* targetChannel = reinterpret_cast<float*> (destSamples[i]))
+                {
+                    if (i < numCacheChannels)
+                        FloatVectorOperations::copy (targetChannel + startOffsetInDestBuffer, cached[i] + offset, numThisTime);
+                    else
+                        FloatVectorOperations::clear (targetChannel + startOffsetInDestBuffer, numThisTime);
+                }
             }
         }
-    }
-    else
-    {
-        // Convert from float to int32:
-        using DestinationType = AudioData::Pointer<AudioData::Int32, AudioData::LittleEndian, AudioData::NonInterleaved, AudioData::NonConst>;
-        using SourceType = AudioData::Pointer<AudioData::Float32, AudioData::LittleEndian, AudioData::NonInterleaved, AudioData::Const>;
-
-        for (int i = numDestChannels; --i >= 0;)
+        else
         {
-            if (auto* targetChannel = destSamples[i])
+            for (int s = 0; s < numThisTime; ++s)
             {
-                DestinationType dest (targetChannel);
-                dest += startOffsetInDestBuffer;
-
-                const float* sourceChannel = nullptr;
-
-                if (i < localNumChannels)
-                    sourceChannel = outputBuffer.getReadPointer (i, 0);
-
-                if (sourceChannel != nullptr)
-                    dest.convertSamples (SourceType (sourceChannel), numSamples);
-                else
-                    dest.clearSamples (numSamples);
+                const auto position = getSourcePosition (startSampleInFile + s);
+                const auto sourceSample = std::floor (position);
+                const auto offset = (int) ((int64) sourceSample - halfLength + 1 - cacheStart);
+
+                // Working out the filter for this position once, for all of the channels:
+                filterBank.createKernel (position - sourceSample, kernel.get());
+
+                for (int i = numDestChannels; --i >= 0;)
+                {
+                    if (auto* targetChannel = reinterpret_cast<float*> (destSamples[i]))
+                    {
+                        targetChannel[startOffsetInDestBuffer + s] = i < numCacheChannels
+                                                                   ? PolyphaseFilterBank::apply (cached[i] + offset, kernel.get(), numTaps)
+                                                                   : 0.0f;
+                    }
+                }
             }
         }
+
+        startSampleInFile += numThisTime;
+        startOffsetInDestBuffer += numThisTime;
+        numSamples -= numThisTime;
     }
+
+    return true;
 }
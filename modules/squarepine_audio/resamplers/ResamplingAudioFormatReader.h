@@ -1,4 +1,12 @@
-/** */
+/** Wraps another reader, resampling its audio on the fly to a different sample rate.
+
+    Every sample gets worked out directly from the wrapped reader's samples around it
+    with a PolyphaseFilterBank, so reading from anywhere in the file gives exactly
+    the same result, no matter what was read before. A small cache of the source
+    samples around the last read keeps reading along or scrubbing around cheap.
+
+    The output is always floating point, and gets written straight into the destination.
+*/
 class ResamplingAudioFormatReader final : public AudioFormatReader
 {
 public:
@@ -7,21 +15,23 @@ public:
         Remember to call prepare when the desired output sample rate is known.
     */
     ResamplingAudioFormatReader (std::shared_ptr<AudioFormatReader> formatReader,
-                                 std::shared_ptr<TimeSliceThread> timeSliceThread = {});
+                                 PolyphaseFilterBank::Quality quality = PolyphaseFilterBank::Quality::high);
 
     /** */
     ResamplingAudioFormatReader (std::shared_ptr<AudioFormatReader> formatReader,
                                  int expectedReadBlockSize, double outputSampleRate,
-                                 std::shared_ptr<TimeSliceThread> timeSliceThread = {});
+                                 PolyphaseFilterBank::Quality quality = PolyphaseFilterBank::Quality::high);
 
     /** */
     ~ResamplingAudioFormatReader() override;
 
     //==============================================================================
-    /** */
+    /** Sets the sample rate to resample to, and allocates a cache that fits
+        reads of the expected size in one go. Larger reads get split up.
+    */
     void prepare (double outputRate, int expectedReadBlockSize);
 
-    /** */
+    /** @returns the output sample rate over the original one. */
     double getConversionRatio() const noexcept { return sourceRatio; }
 
     //==============================================================================
@@ -34,19 +44,21 @@ public:
 
 private:
     //==============================================================================
-    juce::AudioBuffer<float> outputBuffer;
-
     std::shared_ptr<AudioFormatReader> reader;
-    std::shared_ptr<TimeSliceThread> timeSliceThread;
+    PolyphaseFilterBank filterBank;
+    HeapBlock<float> kernel;
 
-    std::unique_ptr<AudioFormatReaderSource> rSource;
-    std::unique_ptr<AudioTransportSource> source;
+    juce::AudioBuffer<float> cache;         //< Source samples, starting at cacheStart.
+    int64 cacheStart = 0;
+    int numCached = 0;
 
-    double sourceRatio = 0.0;
-    int sourceBlockSize = 0;
+    double sourceRatio = 1.0;               //< The output sample rate over the original one.
+    double sourceSamplesPerOutputSample = 1.0;
+    int maxSamplesPerRead = 0;
 
     //==============================================================================
-    void writeOutputBuffers (int** destSamples, int numDestChannels, int startOffsetInDestBuffer, int numSamples);
+    double getSourcePosition (int64 outputPosition) const noexcept;
+    void fillCache (int64 firstSample, int numSamples);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplingAudioFormatReader)
@@ -0,0 +1,381 @@
+WsolaStretcher::WsolaStretcher (int channels, double sr, int ol, double stretch, double pitch) :
+    Stretcher (sr, ol, stretch, pitch),
+    numChannels (jmax (1, channels))
+{
+    SQUAREPINE_CRASH_TRACER;
+
+    reset (sampleRate, outputLength);
+}
+
+WsolaStretcher::~WsolaStretcher()
+{
+}
+
+//==============================================================================
+int WsolaStretcher::getInputLength() const
+{
+    return inputLength;
+}
+
+int WsolaStretcher::getInputLength (int newOutputLength)
+{
+    // The buffers were only allocated for outputs up to the size given to reset()!
+    jassert (isPositiveAndNotGreaterThan (newOutputLength, maxOutputLength));
+
+    outputLength = jlimit (0, maxOutputLength, newOutputLength);
+    updateInputLength();
+    return inputLength;
+}
+
+int WsolaStretcher::getMaxInputLength() const
+{
+    return maxInputLength;
+}
+
+//==============================================================================
+void WsolaStretcher::reset (double newSampleRate, int newOutputLength)
+{
+    SQUAREPINE_CRASH_TRACER;
+
+    jassert (newSampleRate > 0.0 && newOutputLength > 0);
+
+    sampleRate = newSampleRate;
+    outputLength = maxOutputLength = jmax (1, newOutputLength);
+
+    // Frames of around 20 ms, each of which may move by up to half a frame to line up with the last one:
+    frameLength = jlimit (256, 8192, nextPowerOfTwo (roundToInt (sampleRate * 0.02)));
+    synthesisHop = frameLength / 2;
+    searchRadius = frameLength / 2;
+    fftSize = nextPowerOfTwo (frameLength + 2 * searchRadius);
+    fft = std::make_unique<dsp::FFT> (roundToInt (std::log2 ((double) fftSize)));
+
+    // A periodic Hann window, which adds up to exactly 1 when overlapped by half:
+    window.calloc ((size_t) frameLength);
+
+    for (int i = 0; i < frameLength; ++i)
+        window[i] = 0.5f - 0.5f * std::cos (MathConstants<float>::twoPi * (float) i / (float) frameLength);
+
+    searchData.calloc ((size_t) fftSize * 2);
+    templateData.calloc ((size_t) fftSize * 2);
+    searchEnergy.calloc ((size_t) (frameLength + 2 * searchRadius + 1));
+
+    // Making room for the most that a single block can need, at the extremes of the stretch and pitch:
+    constexpr double minStretch = 0.1, maxPitch = 10.0, minTotalStretch = 0.1 * 0.1;
+    const auto maxAnalysisHop = (int) std::ceil ((double) synthesisHop / minTotalStretch);
+
+    maxInputLength = (int) std::ceil ((double) outputLength / minStretch) + 2 * maxAnalysisHop + frameLength + 2 * searchRadius;
+    input.setSize (numChannels, maxInputLength + 2 * (frameLength + searchRadius), false, false, true);
+    overlapAdd.setSize (numChannels, (int) std::ceil ((double) outputLength * maxPitch) + 2 * frameLength + 64, false, false, true);
+    input.clear();
+    overlapAdd.clear();
+
+    pitchShifter.prepare (numChannels, sampleRate, outputLength);
+    pitchShifter.setRatio (pitchFactor);
+
+    // The input starts off with silence, for the first frames to reach back into:
+    inputStart = -(int64) (synthesisHop + searchRadius);
+    numInput = synthesisHop + searchRadius;
+
+    // The first frame starts half a frame early, and its first half gets skipped, so the output doesn't fade in:
+    nextAnalysisPosition = -(double) synthesisHop;
+    lastFramePosition = 0;
+    hasLastFrame = false;
+    numCompleted = 0;
+    numToSkip = synthesisHop;
+
+    numOutputSamplesExpected = 0.0;
+    numOutputSamplesProduced = 0;
+
+    updateInputLength();
+}
+
+void WsolaStretcher::update (bool)
+{
+    // NB: Any stretch and pitch can be done exactly, so neither gets quantised.
+    pitchShifter.setRatio (pitchFactor);
+    updateInputLength();
+}
+
+//==============================================================================
+void WsolaStretcher::process (juce::AudioBuffer<float>& buffer)
+{
+    jassert (buffer.getNumSamples() >= jmax (inputLength, outputLength));
+
+    discardUnneededInput();
+    appendInput (&buffer, jmin (inputLength, buffer.getNumSamples()));
+    numOutputSamplesExpected += (double) inputLength * stretchFactor;
+
+    render (buffer, jmin (outputLength, buffer.getNumSamples()));
+    updateInputLength();
+}
+
+int WsolaStretcher::getRemainingSamples (juce::AudioBuffer<float>& buffer)
+{
+    // Whatever is left of the output for the input so far, flushed out with silence:
+    const auto numRemaining = (int) jlimit ((int64) 0, (int64) jmin (buffer.getNumSamples(), maxOutputLength),
+                                            (int64) std::llround (numOutputSamplesExpected) - numOutputSamplesProduced);
+
+    if (numRemaining <= 0)
+        return 0;
+
+    const auto inputEnd = getInputEndNeeded (getNumStretchedSamplesNeeded (numRemaining));
+
+    discardUnneededInput();
+    appendInput (nullptr, (int) jlimit ((int64) 0, (int64) maxInputLength, inputEnd - (inputStart + numInput)));
+
+    render (buffer, numRemaining);
+    updateInputLength();
+    return numRemaining;
+}
+
+//==============================================================================
+double WsolaStretcher::getAnalysisHop() const noexcept
+{
+    return (double) synthesisHop / (stretchFactor * pitchFactor);
+}
+
+int WsolaStretcher::getNumStretchedSamplesNeeded (int numOutputSamples) const
+{
+    if (approximatelyEqual (pitchFactor, 1.0))
+        return numOutputSamples;
+
+    return pitchShifter.getNumSamplesNeeded (numOutputSamples);
+}
+
+int64 WsolaStretcher::getInputEndNeeded (int numStretchedSamples) const noexcept
+{
+    // Going through the frames that are yet to be synthesised, assuming the worst about where each lands:
+    auto completed = numCompleted - numToSkip;
+    auto position = nextAnalysisPosition;
+    auto lastPosition = lastFramePosition;
+    auto hasLast = hasLastFrame;
+    const auto analysisHop = getAnalysisHop();
+    int64 inputEnd = 0;
+
+    while (completed < numStretchedSamples)
+    {
+        const auto nominal = (int64) std::llround (position);
+
+        if (hasLast)
+        {
+            inputEnd = jmax (inputEnd, nominal + searchRadius + frameLength, lastPosition + synthesisHop + frameLength);
+            lastPosition = nominal + searchRadius;
+        }
+        else
+        {
+            inputEnd = jmax (inputEnd, nominal + frameLength);
+            lastPosition = nominal;
+        }
+
+        hasLast = true;
+        completed += synthesisHop;
+        position += analysisHop;
+    }
+
+    return inputEnd;
+}
+
+void WsolaStretcher::updateInputLength()
+{
+    const auto inputEnd = getInputEndNeeded (getNumStretchedSamplesNeeded (outputLength));
+    inputLength = (int) jlimit ((int64) 0, (int64) maxInputLength, inputEnd - (inputStart + numInput));
+}
+
+//==============================================================================
+void WsolaStretcher::appendInput (const juce::AudioBuffer<float>* source, int numSamples) noexcept
+{
+    // The input must've been limited to getMaxInputLength()!
+    jassert (numInput + numSamples <= input.getNumSamples());
+    numSamples = jmin (numSamples, input.getNumSamples() - numInput);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        if (source != nullptr && i < source->getNumChannels())
+            input.copyFrom (i, numInput, *source, i, 0, numSamples);
+        else
+            input.clear (i, numInput, numSamples);
+    }
+
+    numInput += numSamples;
+}
+
+void WsolaStretcher::discardUnneededInput() noexcept
+{
+    // Keeping whatever the next frames may still look at, including the search region before them:
+    auto firstNeeded = (int64) std::llround (nextAnalysisPosition) - searchRadius;
+
+    if (hasLastFrame)
+        firstNeeded = jmin (firstNeeded, lastFramePosition + synthesisHop);
+
+    const auto numToDiscard = (int) jlimit ((int64) 0, (int64) numInput, firstNeeded - inputStart);
+
+    if (numToDiscard <= 0)
+        return;
+
+    numInput -= numToDiscard;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto* channel = input.getWritePointer (i);
+        std::memmove (channel, channel + numToDiscard, sizeof (float) * (size_t) numInput);
+    }
+
+    inputStart += numToDiscard;
+}
+
+int64 WsolaStretcher::findBestFramePosition (int64 searchStart, int64 templateStart) noexcept
+{
+    const auto searchLength = frameLength + 2 * searchRadius;
+    const auto searchOffset = (int) (searchStart - inputStart);
+    const auto templateOffset = (int) (templateStart - inputStart);
+
+    FloatVectorOperations::clear (searchData.get(), fftSize * 2);
+    FloatVectorOperations::clear (templateData.get(), fftSize * 2);
+
+    // Mixing the channels down, so that they all get lined up the same way and the FFTs are only done once:
+    for (int i = 0; i < numChannels; ++i)
+    {
+        FloatVectorOperations::add (searchData.get(), input.getReadPointer (i, searchOffset), searchLength);
+        FloatVectorOperations::add (templateData.get(), input.getReadPointer (i, templateOffset), frameLength);
+    }
+
+    searchEnergy[0] = 0.0;
+
+    for (int i = 0; i < searchLength; ++i)
+        searchEnergy[i + 1] = searchEnergy[i] + square ((double) searchData[i]);
+
+    fft->performRealOnlyForwardTransform (searchData.get(), true);
+    fft->performRealOnlyForwardTransform (templateData.get(), true);
+
+    // Cross-correlating, by multiplying the search region's spectrum by the conjugate of the template's:
+    auto* searchSpectrum = reinterpret_cast<std::complex<float>*> (searchData.get());
+    const auto* templateSpectrum = reinterpret_cast<const std::complex<float>*> (templateData.get());
+
+    for (int i = 0; i <= fftSize / 2; ++i)
+        searchSpectrum[i] *= std::conj (templateSpectrum[i]);
+
+    fft->performRealOnlyInverseTransform (searchData.get());
+
+    // Normalising by the energy of each candidate, so that loud candidates don't win just for being loud:
+    const auto getScore = [&] (int lag)
+    {
+        const auto energy = searchEnergy[lag + frameLength] - searchEnergy[lag];
+        return (double) searchData[lag] / std::sqrt (energy + 1.0e-9);
+    };
+
+    auto bestLag = searchRadius;
+    auto bestScore = getScore (bestLag);
+
+    for (int lag = 0; lag <= 2 * searchRadius; ++lag)
+    {
+        const auto score = getScore (lag);
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    return searchStart + bestLag;
+}
+
+bool WsolaStretcher::synthesiseFrame() noexcept
+{
+    const auto nominal = (int64) std::llround (nextAnalysisPosition);
+    const auto inputEnd = inputStart + numInput;
+    auto framePosition = nominal;
+
+    if (hasLastFrame)
+    {
+        // Looking for where the input best continues from the end of the last frame:
+        const auto searchStart = nominal - searchRadius;
+        const auto templateStart = lastFramePosition + synthesisHop;
+
+        if (searchStart < inputStart || templateStart < inputStart
+            || searchStart + 2 * searchRadius + frameLength > inputEnd
+            || templateStart + frameLength > inputEnd)
+        {
+            jassertfalse; // Not enough input was provided!
+            return false;
+        }
+
+        framePosition = findBestFramePosition (searchStart, templateStart);
+    }
+    else if (framePosition < inputStart || framePosition + frameLength > inputEnd)
+    {
+        jassertfalse; // Not enough input was provided!
+        return false;
+    }
+
+    if (numCompleted + frameLength > overlapAdd.getNumSamples())
+    {
+        jassertfalse;
+        return false;
+    }
+
+    const auto inputOffset = (int) (framePosition - inputStart);
+
+    for (int i = 0; i < numChannels; ++i)
+        FloatVectorOperations::addWithMultiply (overlapAdd.getWritePointer (i, numCompleted),
+                                                input.getReadPointer (i, inputOffset),
+                                                window.get(), frameLength);
+
+    numCompleted += synthesisHop;
+    lastFramePosition = framePosition;
+    hasLastFrame = true;
+    nextAnalysisPosition += getAnalysisHop();
+    return true;
+}
+
+void WsolaStretcher::consumeStretched (int numSamples) noexcept
+{
+    jassert (isPositiveAndNotGreaterThan (numSamples, numCompleted));
+
+    // NB: The overlapping half of the last frame, past the completed samples, must come along too.
+    const auto numToKeep = numCompleted - numSamples + (frameLength - synthesisHop);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto* channel = overlapAdd.getWritePointer (i);
+        std::memmove (channel, channel + numSamples, sizeof (float) * (size_t) numToKeep);
+        FloatVectorOperations::clear (channel + numToKeep, numSamples);
+    }
+
+    numCompleted -= numSamples;
+}
+
+void WsolaStretcher::render (juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    const auto numStretched = getNumStretchedSamplesNeeded (numSamples);
+
+    while (numCompleted - numToSkip < numStretched)
+        if (! synthesiseFrame())
+            break;
+
+    if (numToSkip > 0 && numCompleted >= numToSkip)
+    {
+        consumeStretched (numToSkip);
+        numToSkip = 0;
+    }
+
+    const auto numDestChannels = jmin (numChannels, buffer.getNumChannels());
+
+    if (approximatelyEqual (pitchFactor, 1.0))
+    {
+        for (int i = 0; i < numDestChannels; ++i)
+            buffer.copyFrom (i, 0, overlapAdd, i, 0, numSamples);
+    }
+    else
+    {
+        // NB: Handing over the channels as they are, since AudioBuffers referring to more than 32 of them allocate.
+        pitchShifter.process (overlapAdd.getArrayOfReadPointers(), numChannels, numStretched,
+                              buffer.getArrayOfWritePointers(), numDestChannels, numSamples);
+    }
+
+    for (int i = numDestChannels; i < buffer.getNumChannels(); ++i)
+        buffer.clear (i, 0, numSamples);
+
+    consumeStretched (jmin (numStretched, numCompleted));
+    numOutputSamplesProduced += numSamples;
+}
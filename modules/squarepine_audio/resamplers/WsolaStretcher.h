@@ -0,0 +1,92 @@
+/** A time-stretcher and pitch-shifter that needs no third party SDK.
+
+    The time-stretching is done with WSOLA (waveform similarity overlap-add):
+    the input is cut into windowed frames that get overlap-added at a fixed hop,
+    while the hop between the frames taken from the input follows the stretch.
+    Each frame is nudged to wherever the input best lines up with the end of the previous
+    frame, which keeps the waveform continuous and avoids the phasiness of a plain overlap-add.
+
+    Finding where the input lines up best is done once, with an FFT cross-correlation
+    of all of the channels mixed together, so that the channels stay in phase with
+    each other and more channels only cost another overlap-add each.
+
+    Pitch-shifting is done by stretching by the pitch as well, and resampling
+    the result back down to length with a PolyphaseResampler. That adds the
+    resampler's latency to the output whenever the pitch isn't 1.
+
+    Nothing gets allocated after reset(), whatever the stretch and pitch.
+*/
+class WsolaStretcher final : public Stretcher
+{
+public:
+    /** Constructor. */
+    WsolaStretcher (int numChannels, double sampleRate, int outputLength,
+                    double stretch = 1.0, double pitch = 1.0);
+
+    /** Destructor. */
+    ~WsolaStretcher() override;
+
+    //==============================================================================
+    /** @returns the number of channels that this was created for. */
+    int getNumChannels() const noexcept { return numChannels; }
+
+    /** @returns the length of the frames that get overlap-added, which depends on the sample rate. */
+    int getFrameLength() const noexcept { return frameLength; }
+
+    //==============================================================================
+    /** @internal */
+    int getInputLength() const override;
+    /** @internal */
+    int getInputLength (int newOutputLength) override;
+    /** @internal */
+    int getMaxInputLength() const override;
+    /** @internal */
+    void reset (double sampleRate, int outBufferSize) override;
+    /** @internal */
+    void process (juce::AudioBuffer<float>& buffer) override;
+    /** @internal */
+    int getRemainingSamples (juce::AudioBuffer<float>& buffer) override;
+
+private:
+    //==============================================================================
+    const int numChannels;
+    int frameLength = 0, synthesisHop = 0, searchRadius = 0, fftSize = 0;
+    int maxInputLength = 0, maxOutputLength = 0, inputLength = 0;
+
+    std::unique_ptr<dsp::FFT> fft;
+    HeapBlock<float> window, searchData, templateData;
+    HeapBlock<double> searchEnergy;     //< The running sum of the squares of the mixed down search region.
+
+    juce::AudioBuffer<float> input;     //< The input, starting at inputStart.
+    int64 inputStart = 0;
+    int numInput = 0;
+
+    juce::AudioBuffer<float> overlapAdd;    //< The stretched output, of which the first numCompleted samples are finished.
+    int numCompleted = 0, numToSkip = 0;
+
+    double nextAnalysisPosition = 0.0;
+    int64 lastFramePosition = 0;
+    bool hasLastFrame = false;
+
+    PolyphaseResampler pitchShifter { PolyphaseResampler::Quality::medium };
+    double numOutputSamplesExpected = 0.0;
+    int64 numOutputSamplesProduced = 0;
+
+    //==============================================================================
+    double getAnalysisHop() const noexcept;
+    int getNumStretchedSamplesNeeded (int numOutputSamples) const;
+    int64 getInputEndNeeded (int numStretchedSamples) const noexcept;
+    void updateInputLength();
+
+    void appendInput (const juce::AudioBuffer<float>* source, int numSamples) noexcept;
+    void discardUnneededInput() noexcept;
+    int64 findBestFramePosition (int64 searchStart, int64 templateStart) noexcept;
+    bool synthesiseFrame() noexcept;
+    void consumeStretched (int numSamples) noexcept;
+    void render (juce::AudioBuffer<float>& buffer, int numSamples);
+
+    void update (bool exactStretch) override;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WsolaStretcher)
+};
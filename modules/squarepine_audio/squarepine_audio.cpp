@@ -38,15 +38,24 @@ namespace sp
     #include "core/EffectProcessorFactory.cpp"
     #include "core/InternalAudioPluginFormat.cpp"
     #include "core/InternalProcessor.cpp"
+    #include "core/OfflineChainRenderer.cpp"
     #include "devices/DummyAudioIODevice.cpp"
     #include "devices/DummyAudioIODeviceCallback.cpp"
     #include "devices/DummyAudioIODeviceType.cpp"
     #include "devices/MediaDevicePoller.cpp"
+    #include "dsp/BasicDither.cpp"
+    #include "dsp/BiquadCascade.cpp"
     #include "dsp/LFO.cpp"
+    #include "dsp/WavetableLFO.cpp"
+    #include "dsp/NoiseGenerator.cpp"
+    #include "dsp/Oversampler.cpp"
+    #include "dsp/PartitionedConvolver.cpp"
     #include "effects/ADSRProcessor.cpp"
     #include "effects/BitCrusherProcessor.cpp"
     #include "effects/ChorusProcessor.cpp"
+    #include "effects/ConvolutionProcessor.cpp"
     #include "effects/DitherProcessor.cpp"
+    #include "effects/DynamicsProcessor.cpp"
     #include "effects/HissingProcessor.cpp"
     #include "effects/JUCEReverbProcessor.cpp"
     #include "effects/LevelsProcessor.cpp"
@@ -69,6 +78,7 @@ namespace sp
     #include "resamplers/ResamplingAudioFormatReader.cpp"
     #include "resamplers/ResamplingProcessor.cpp"
     #include "resamplers/Stretcher.cpp"
+    #include "resamplers/WsolaStretcher.cpp"
     #include "time/DecimalTime.cpp"
     #include "time/MBTTime.cpp"
     #include "time/SMPTETime.cpp"
@@ -77,4 +87,21 @@ namespace sp
     #include "time/TimeSignature.cpp"
     #include "wrappers/AudioSourceProcessor.cpp"
     #include "wrappers/AudioTransportProcessor.cpp"
+
+    #include "unittests/AudioBufferFIFOUnitTests.cpp"
+    #include "unittests/BitCrusherUnitTests.cpp"
+    #include "unittests/BroadcastAudioRingUnitTests.cpp"
+    #include "unittests/ConvolutionUnitTests.cpp"
+    #include "unittests/DistortionFunctionsUnitTests.cpp"
+    #include "unittests/DitherUnitTests.cpp"
+    #include "unittests/DynamicsUnitTests.cpp"
+    #include "unittests/EffectProcessorChainUnitTests.cpp"
+    #include "unittests/LevelsProcessorUnitTests.cpp"
+    #include "unittests/LFOUnitTests.cpp"
+    #include "unittests/NoiseGeneratorUnitTests.cpp"
+    #include "unittests/OversamplerUnitTests.cpp"
+    #include "unittests/ResamplerUnitTests.cpp"
+    #include "unittests/SimpleEQUnitTests.cpp"
+    #include "unittests/StretcherUnitTests.cpp"
+    #include "unittests/SquarePineAudioUnitTestGatherer.cpp"
 }
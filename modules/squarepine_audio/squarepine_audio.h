@@ -57,6 +57,17 @@
     #define SQUAREPINE_USE_REX_AUDIO_FORMAT 0
 #endif
 
+/** Config: SQUAREPINE_COMPILE_BENCHMARKS
+
+    Enable this along with SQUAREPINE_COMPILE_UNIT_TESTS to also run the benchmarks,
+    which only log how long things take rather than checking anything.
+
+    By default, this is off.
+*/
+#ifndef SQUAREPINE_COMPILE_BENCHMARKS
+    #define SQUAREPINE_COMPILE_BENCHMARKS 0
+#endif
+
 //==============================================================================
 // Incomplete support right now...
 #undef SQUAREPINE_USE_R8BRAIN
@@ -102,6 +113,8 @@ namespace sp
     //==============================================================================
     #include "core/AudioBufferView.h"
     #include "core/AudioBufferFIFO.h"
+    #include "core/BroadcastAudioRing.h"
+    #include "core/AudioDelayLine.h"
     #include "core/AudioUtilities.h"
     #include "core/ChildProcessPluginScanner.h"
     #include "core/InternalAudioPluginFormat.h"
@@ -109,6 +122,7 @@ namespace sp
     #include "core/EffectProcessor.h"
     #include "core/EffectProcessorFactory.h"
     #include "core/EffectProcessorChain.h"
+    #include "core/OfflineChainRenderer.h"
     #include "core/MetadataUtilities.h"
     #include "core/MIDIChannel.h"
     #include "codecs/REXAudioFormat.h"
@@ -117,14 +131,21 @@ namespace sp
     #include "devices/DummyAudioIODeviceType.h"
     #include "devices/MediaDevicePoller.h"
     #include "dsp/BasicDither.h"
+    #include "dsp/BiquadCascade.h"
     #include "dsp/DistortionFunctions.h"
     #include "dsp/EnvelopeFollower.h"
     #include "dsp/LFO.h"
+    #include "dsp/WavetableLFO.h"
+    #include "dsp/NoiseGenerator.h"
+    #include "dsp/Oversampler.h"
     #include "dsp/PositionedImpulseResponse.h"
+    #include "dsp/PartitionedConvolver.h"
     #include "effects/ADSRProcessor.h"
     #include "effects/BitCrusherProcessor.h"
     #include "effects/ChorusProcessor.h"
+    #include "effects/ConvolutionProcessor.h"
     #include "effects/DitherProcessor.h"
+    #include "effects/DynamicsProcessor.h"
     #include "effects/HissingProcessor.h"
     #include "effects/JUCEReverbProcessor.h"
     #include "effects/LevelsProcessor.h"
@@ -147,6 +168,7 @@ namespace sp
     #include "resamplers/ResamplingAudioFormatReader.h"
     #include "resamplers/ResamplingProcessor.h"
     #include "resamplers/Stretcher.h"
+    #include "resamplers/WsolaStretcher.h"
     #include "time/TimeHelpers.h"
     #include "time/TimeFormat.h"
     #include "time/DecimalTime.h"
@@ -157,6 +179,7 @@ namespace sp
     #include "time/TimeKeeper.h"
     #include "wrappers/AudioSourceProcessor.h"
     #include "wrappers/AudioTransportProcessor.h"
+    #include "unittests/SquarePineAudioUnitTestGatherer.h"
 }
 
 //==============================================================================
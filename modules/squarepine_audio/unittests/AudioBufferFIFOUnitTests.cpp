@@ -0,0 +1,304 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class AudioBufferFIFOUnitTests final : public UnitTest
+{
+public:
+    AudioBufferFIFOUnitTests() :
+        UnitTest ("AudioBufferFIFO", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testSpans();
+        testCopying();
+        testConcurrentTransfer();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    static constexpr int numChannels = 2;
+
+    // Every sample holds its own position, so anything that went missing or out of order shows up:
+    static float getExpectedSample (int64 position, int channel) noexcept
+    {
+        return (float) (position % 65536) * (channel == 0 ? 1.0f : -1.0f);
+    }
+
+    static void fillSpan (const AudioBufferFIFO<float>::Span& span, int64 position)
+    {
+        for (auto* block : { &span.block1, &span.block2 })
+        {
+            for (int c = 0; c < block->getNumChannels(); ++c)
+                for (int s = 0; s < block->getNumSamples(); ++s)
+                    block->getChannel (c)[s] = getExpectedSample (position + s, c);
+
+            position += block->getNumSamples();
+        }
+    }
+
+    static bool checkSpan (const AudioBufferFIFO<float>::Span& span, int64 position)
+    {
+        for (auto* block : { &span.block1, &span.block2 })
+        {
+            for (int c = 0; c < block->getNumChannels(); ++c)
+                for (int s = 0; s < block->getNumSamples(); ++s)
+                    if (block->getChannel (c)[s] != getExpectedSample (position + s, c))
+                        return false;
+
+            position += block->getNumSamples();
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    void testSpans()
+    {
+        beginTest ("Acquiring and committing spans");
+
+        AudioBufferFIFO<float> fifo (numChannels, 100);
+        expectEquals (fifo.getTotalSize(), 100);
+        expectEquals (fifo.getFreeSpace(), 100);
+
+        // The whole of the buffer must be usable:
+        auto span = fifo.acquireWrite (150);
+        expectEquals (span.getNumSamples(), 100);
+        expectEquals (span.block2.getNumSamples(), 0);
+        fillSpan (span, 0);
+        fifo.commitWrite (span.getNumSamples());
+
+        expectEquals (fifo.getNumReady(), 100);
+        expectEquals (fifo.acquireWrite (1).getNumSamples(), 0);
+
+        span = fifo.acquireRead (70);
+        expectEquals (span.getNumSamples(), 70);
+        expect (checkSpan (span, 0));
+        fifo.commitRead (span.getNumSamples());
+
+        span = fifo.acquireWrite (60);
+        expectEquals (span.getNumSamples(), 60);
+        fillSpan (span, 100);
+        fifo.commitWrite (span.getNumSamples());
+
+        // Reading past the end must wrap around into a second block:
+        span = fifo.acquireRead (100);
+        expectEquals (span.block1.getNumSamples(), 30);
+        expectEquals (span.block2.getNumSamples(), 60);
+        expect (checkSpan (span, 70));
+
+        // Only part of a span may be committed:
+        fifo.commitRead (10);
+        expectEquals (fifo.getNumReady(), 80);
+
+        fifo.clear();
+        expectEquals (fifo.getNumReady(), 0);
+        expectEquals (fifo.getFreeSpace(), 100);
+    }
+
+    void testCopying()
+    {
+        beginTest ("Copying in and out");
+
+        AudioBufferFIFO<float> fifo (numChannels, 64);
+        juce::AudioBuffer<float> source (numChannels, 48), destination (numChannels, 48);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int s = 0; s < source.getNumSamples(); ++s)
+                source.setSample (c, s, getExpectedSample (s, c));
+
+        for (int round = 0; round < 10; ++round)
+        {
+            fifo.push (source);
+            destination.clear();
+            fifo.readTo (destination);
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int s = 0; s < source.getNumSamples(); ++s)
+                    expectEquals (destination.getSample (c, s), source.getSample (c, s));
+        }
+
+        // Reading while adding, at half the gain:
+        fifo.push (source);
+        destination.makeCopyOf (source);
+        fifo.readToAdding (destination, -1, 0.5f);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int s = 0; s < source.getNumSamples(); ++s)
+                expectEquals (destination.getSample (c, s), source.getSample (c, s) * 1.5f);
+
+        expectEquals (fifo.getNumReady(), 0);
+
+        // Pushing more than there's room for must keep what fits:
+        fifo.push (source);
+        fifo.push (source);
+        expectEquals (fifo.getNumReady(), 64);
+
+        fifo.pop (64);
+        fifo.pushSilence (16);
+        expectEquals (fifo.getNumReady(), 16);
+    }
+
+    //==============================================================================
+    /** Streams positions through the FIFO from one thread to another, checking every sample on the way out.
+
+        @returns the number of blocks that came out wrong.
+    */
+    static int64 transfer (AudioBufferFIFO<float>& fifo, int64 numSamples, int blockSize,
+                           uint32 producerAffinity = 0, uint32 consumerAffinity = 0)
+    {
+        std::thread producer ([&]()
+        {
+            if (producerAffinity != 0)
+                Thread::setCurrentThreadAffinityMask (producerAffinity);
+
+            for (int64 position = 0; position < numSamples;)
+            {
+                const auto span = fifo.acquireWrite ((int) jmin ((int64) blockSize, numSamples - position));
+
+                if (span.getNumSamples() == 0)
+                {
+                    Thread::yield();
+                    continue;
+                }
+
+                fillSpan (span, position);
+                fifo.commitWrite (span.getNumSamples());
+                position += span.getNumSamples();
+            }
+        });
+
+        if (consumerAffinity != 0)
+            Thread::setCurrentThreadAffinityMask (consumerAffinity);
+
+        int64 numErrors = 0;
+
+        for (int64 position = 0; position < numSamples;)
+        {
+            const auto span = fifo.acquireRead (blockSize);
+
+            if (span.getNumSamples() == 0)
+            {
+                Thread::yield();
+                continue;
+            }
+
+            if (! checkSpan (span, position))
+                ++numErrors;
+
+            fifo.commitRead (span.getNumSamples());
+            position += span.getNumSamples();
+        }
+
+        producer.join();
+
+        if (consumerAffinity != 0)
+            Thread::setCurrentThreadAffinityMask (~(uint32) 0);
+
+        return numErrors;
+    }
+
+    void testConcurrentTransfer()
+    {
+        beginTest ("Concurrent transfer");
+
+        for (auto blockSize : { 1, 37, 256, 1000 })
+        {
+            AudioBufferFIFO<float> fifo (numChannels, 999);
+            expectEquals (transfer (fifo, 1000000, blockSize), (int64) 0);
+            expectEquals (fifo.getNumReady(), 0);
+        }
+    }
+
+    //==============================================================================
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        const auto numCpus = jmin (32, SystemStats::getNumCpus());
+
+        if (numCpus < 2)
+        {
+            logMessage ("Skipping the performance measurements, for lack of CPU cores.");
+            return;
+        }
+
+        // Neighbouring cores, and the cores furthest apart, which are likely on other dies or sockets:
+        Array<std::pair<int, int>> corePairs { { 0, 1 }, { 0, numCpus / 2 }, { 0, numCpus - 1 } };
+
+        for (const auto& pair : corePairs)
+        {
+            const auto producerAffinity = (uint32) 1 << pair.first;
+            const auto consumerAffinity = (uint32) 1 << pair.second;
+            const auto corePairName = "cores " + String (pair.first) + " and " + String (pair.second);
+
+            // Throughput, streaming blocks through as fast as they go:
+            {
+                constexpr int64 numSamples = 1 << 25;
+                AudioBufferFIFO<float> fifo (numChannels, 8192);
+
+                const auto startTicks = Time::getHighResolutionTicks();
+                expectEquals (transfer (fifo, numSamples, 512, producerAffinity, consumerAffinity), (int64) 0);
+                const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+                logMessage ("Throughput between " + corePairName + ": "
+                            + String ((double) numSamples / seconds / 1.0e6, 1) + " million stereo samples per second");
+            }
+
+            // Latency, bouncing a block back and forth through a pair of FIFOs:
+            {
+                constexpr int numRoundTrips = 20000;
+                constexpr int blockSize = 64;
+                AudioBufferFIFO<float> there (numChannels, blockSize * 4), back (numChannels, blockSize * 4);
+                juce::AudioBuffer<float> block (numChannels, blockSize);
+                block.clear();
+
+                std::thread echo ([&]()
+                {
+                    Thread::setCurrentThreadAffinityMask (consumerAffinity);
+                    juce::AudioBuffer<float> echoBlock (numChannels, blockSize);
+
+                    for (int i = 0; i < numRoundTrips; ++i)
+                    {
+                        while (there.getNumReady() < blockSize)
+                            continue;
+
+                        there.readTo (echoBlock);
+                        back.push (echoBlock);
+                    }
+                });
+
+                Thread::setCurrentThreadAffinityMask (producerAffinity);
+                const auto startTicks = Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numRoundTrips; ++i)
+                {
+                    there.push (block);
+
+                    while (back.getNumReady() < blockSize)
+                        continue;
+
+                    back.readTo (block);
+                }
+
+                const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+                echo.join();
+                Thread::setCurrentThreadAffinityMask (~(uint32) 0);
+
+                logMessage ("Latency between " + corePairName + ": "
+                            + String (seconds / (numRoundTrips * 2) * 1.0e9, 0) + " ns per hop");
+            }
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioBufferFIFOUnitTests)
+};
+
+#endif
@@ -0,0 +1,277 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class BitCrusherUnitTests final : public UnitTest
+{
+public:
+    BitCrusherUnitTests() :
+        UnitTest ("BitCrusher", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testQuantisation();
+        testDownsampling();
+        testTransitions();
+        testClearedBlocks();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blockSize = 512;
+
+    static juce::AudioBuffer<float> createNoise (int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        Random random (1234);
+
+        // NB: Going past full scale, so the clipping gets checked too.
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (c, i, random.nextFloat() * 2.5f - 1.25f);
+
+        return buffer;
+    }
+
+    /** What quantising a sample to a bit depth should come out as. */
+    static float getExpectedSample (float sample, int bitDepth)
+    {
+        const auto scale = std::pow (2.0, (double) bitDepth - 1.0);
+        return (float) (jlimit (-scale, scale - 1.0, std::floor ((double) sample * scale)) / scale);
+    }
+
+    /** How the processor used to crush each sample, with the powers worked out every time, for comparison. */
+    static float crushTheOldWay (float sample, int bitDepth)
+    {
+        const auto scale = -std::pow (-2.0, (double) bitDepth - 1.0);
+        return (float) (std::floor (jlimit (-1.0, 1.0, (double) sample) * scale) / scale);
+    }
+
+    static void process (BitCrusherProcessor& bitCrusher, juce::AudioBuffer<float>& buffer)
+    {
+        MidiBuffer midiMessages;
+        bitCrusher.processBlock (buffer, midiMessages);
+    }
+
+    //==============================================================================
+    void testQuantisation()
+    {
+        beginTest ("Quantisation");
+
+        for (const auto bitDepth : { 1, 2, 3, 4, 7, 8, 12, 16, 23, 24 })
+        {
+            BitCrusherProcessor bitCrusher;
+            bitCrusher.setBitDepth (bitDepth);
+            bitCrusher.prepareToPlay (sampleRate, blockSize);
+
+            const auto input = createNoise (2, blockSize);
+            auto output = input;
+            process (bitCrusher, output);
+
+            int numDifferences = 0;
+
+            for (int c = 0; c < input.getNumChannels(); ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    if (output.getSample (c, i) != getExpectedSample (input.getSample (c, i), bitDepth))
+                        ++numDifferences;
+
+            expectEquals (numDifferences, 0, String (bitDepth) + " bits");
+        }
+
+        BitCrusherProcessor bitCrusher;
+        bitCrusher.prepareToPlay (sampleRate, blockSize);
+
+        const auto input = createNoise (2, blockSize);
+        auto output = input;
+        process (bitCrusher, output);
+
+        int numDifferences = 0;
+
+        for (int c = 0; c < input.getNumChannels(); ++c)
+            for (int i = 0; i < blockSize; ++i)
+                if (output.getSample (c, i) != input.getSample (c, i))
+                    ++numDifferences;
+
+        expectEquals (numDifferences, 0, "32 bits should leave the audio alone");
+    }
+
+    void testDownsampling()
+    {
+        beginTest ("Downsampling");
+
+        constexpr int holdLength = 5;
+
+        BitCrusherProcessor bitCrusher;
+        bitCrusher.setDownsampling (holdLength);
+        bitCrusher.prepareToPlay (sampleRate, blockSize);
+
+        const auto input = createNoise (2, blockSize * 3);
+        auto output = input;
+        int numDifferences = 0;
+
+        // Odd block sizes, so that the holds straddle the blocks:
+        for (int start = 0, size = 37; start < output.getNumSamples(); start += size, size += 61)
+        {
+            const auto numThisTime = jmin (size, output.getNumSamples() - start);
+            juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), output.getNumChannels(), start, numThisTime);
+            process (bitCrusher, block);
+        }
+
+        for (int c = 0; c < input.getNumChannels(); ++c)
+            for (int i = 0; i < input.getNumSamples(); ++i)
+                if (output.getSample (c, i) != input.getSample (c, i - (i % holdLength)))
+                    ++numDifferences;
+
+        expectEquals (numDifferences, 0);
+    }
+
+    void testTransitions()
+    {
+        beginTest ("Transitions");
+
+        constexpr int bitDepth = 3;
+
+        BitCrusherProcessor bitCrusher;
+        bitCrusher.prepareToPlay (sampleRate, blockSize);
+
+        const auto input = createNoise (1, blockSize);
+        auto output = input;
+
+        // Going from being left alone to being crushed should crossfade over the block:
+        bitCrusher.setBitDepth (bitDepth);
+        process (bitCrusher, output);
+
+        float largestError = 0.0f;
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            const auto dry = input.getSample (0, i);
+            const auto wet = getExpectedSample (dry, bitDepth);
+            const auto position = (float) (i + 1) / (float) blockSize;
+
+            largestError = jmax (largestError, std::abs (output.getSample (0, i) - (dry + (wet - dry) * position)));
+        }
+
+        expectLessThan (largestError, 1.0e-6f);
+
+        // Once the transition is over, it should be back to plain quantising:
+        output = input;
+        process (bitCrusher, output);
+
+        int numDifferences = 0;
+
+        for (int i = 0; i < blockSize; ++i)
+            if (output.getSample (0, i) != getExpectedSample (input.getSample (0, i), bitDepth))
+                ++numDifferences;
+
+        expectEquals (numDifferences, 0);
+    }
+
+    void testClearedBlocks()
+    {
+        beginTest ("Cleared blocks while oversampling");
+
+        // A block that was cleared must carry on through the filters like any other silent one,
+        // so that the tail of the audio before it still comes out, and the audio after it isn't shifted:
+        BitCrusherProcessor cleared, silent;
+
+        for (auto* bitCrusher : { &cleared, &silent })
+        {
+            bitCrusher->setBitDepth (8);
+            bitCrusher->setOversampling (4);
+            bitCrusher->prepareToPlay (sampleRate, blockSize);
+        }
+
+        const auto noise = createNoise (2, blockSize);
+        int numDifferences = 0;
+        float largestTail = 0.0f;
+
+        for (int block = 0; block < 3; ++block)
+        {
+            auto clearedOutput = noise;
+            auto silentOutput = noise;
+
+            if (block == 1)
+            {
+                clearedOutput.clear();
+
+                for (int c = 0; c < silentOutput.getNumChannels(); ++c)
+                    FloatVectorOperations::clear (silentOutput.getWritePointer (c), blockSize);
+
+                expect (clearedOutput.hasBeenCleared() && ! silentOutput.hasBeenCleared());
+            }
+
+            process (cleared, clearedOutput);
+            process (silent, silentOutput);
+
+            for (int c = 0; c < noise.getNumChannels(); ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    if (clearedOutput.getSample (c, i) != silentOutput.getSample (c, i))
+                        ++numDifferences;
+
+            if (block == 1)
+                largestTail = clearedOutput.getMagnitude (0, blockSize);
+        }
+
+        expectEquals (numDifferences, 0);
+        expectGreaterThan (largestTail, 0.0f, "The tail of the audio before the cleared block should come out");
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr int numChannels = 2;
+        constexpr int numSamplesToProcess = 4 * 1024 * 1024;
+
+        for (const auto size : { 32, 128, 512, 2048 })
+        {
+            auto buffer = createNoise (numChannels, size);
+            const auto numIterations = numSamplesToProcess / size;
+
+            const auto getNanosecondsPerSample = [&] (const std::function<void()>& processBlock)
+            {
+                const auto startTicks = Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numIterations; ++i)
+                    processBlock();
+
+                const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+                return 1.0e9 * seconds / ((double) numIterations * size * numChannels);
+            };
+
+            BitCrusherProcessor bitCrusher;
+            bitCrusher.setBitDepth (8);
+            bitCrusher.prepareToPlay (sampleRate, size);
+
+            const auto perSample = getNanosecondsPerSample ([&]
+            {
+                const auto bitDepth = bitCrusher.getBitDepth();
+
+                for (auto channel : AudioBufferView<float> (buffer))
+                    for (auto& sample : channel)
+                        sample = crushTheOldWay (sample, bitDepth);
+            });
+
+            const auto quantised = getNanosecondsPerSample ([&] { process (bitCrusher, buffer); });
+
+            bitCrusher.setDownsampling (4);
+            const auto held = getNanosecondsPerSample ([&] { process (bitCrusher, buffer); });
+
+            logMessage ("Blocks of " + String (size) + ": " + String (perSample, 2) + " ns per sample with std::pow, "
+                        + String (quantised, 2) + " ns quantising, " + String (held, 2) + " ns quantising and holding");
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BitCrusherUnitTests)
+};
+
+#endif
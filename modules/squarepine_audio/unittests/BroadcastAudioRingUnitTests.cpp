@@ -0,0 +1,290 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class BroadcastAudioRingUnitTests final : public UnitTest
+{
+public:
+    BroadcastAudioRingUnitTests() :
+        UnitTest ("BroadcastAudioRing", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testReaders();
+        testOverruns();
+        testMeteringLevels();
+        testConcurrentReaders();
+    }
+
+private:
+    //==============================================================================
+    static constexpr int numChannels = 2;
+
+    // Every sample holds its own position, so anything that went missing, out of order or torn shows up:
+    static float getExpectedSample (int64 position, int channel) noexcept
+    {
+        return (float) (position % 65536) * (channel == 0 ? 1.0f : -1.0f);
+    }
+
+    static void fillBlock (juce::AudioBuffer<float>& block, int64 position)
+    {
+        for (int c = 0; c < block.getNumChannels(); ++c)
+            for (int s = 0; s < block.getNumSamples(); ++s)
+                block.setSample (c, s, getExpectedSample (position + s, c));
+    }
+
+    static bool checkBlock (const juce::AudioBuffer<float>& block, int numSamples, int64 position)
+    {
+        for (int c = 0; c < block.getNumChannels(); ++c)
+            for (int s = 0; s < numSamples; ++s)
+                if (block.getSample (c, s) != getExpectedSample (position + s, c))
+                    return false;
+
+        return true;
+    }
+
+    //==============================================================================
+    void testReaders()
+    {
+        beginTest ("Independent readers");
+
+        BroadcastAudioRing<float> ring;
+        ring.prepare (numChannels, 1000);
+
+        auto fastReader = ring.createReader();
+        auto slowReader = ring.createReader();
+
+        juce::AudioBuffer<float> block (numChannels, 300), destination (numChannels, 300);
+        int64 position = 0;
+
+        for (int i = 0; i < 10; ++i)
+        {
+            fillBlock (block, position);
+            ring.write (block);
+
+            expectEquals (ring.read (fastReader, destination), 300);
+            expect (checkBlock (destination, 300, position));
+
+            // The slow reader only reads every other block, in smaller chunks:
+            if (isOdd (i))
+            {
+                for (int64 slowPosition = position - 300; slowPosition < position + 300; slowPosition += 150)
+                {
+                    expectEquals (ring.read (slowReader, destination.getArrayOfWritePointers(), numChannels, 150), 150);
+                    expect (checkBlock (destination, 150, slowPosition));
+                }
+            }
+
+            position += 300;
+        }
+
+        expectEquals (ring.getNumReady (fastReader), (int64) 0);
+        expectEquals (ring.getNumReady (slowReader), (int64) 0);
+        expectEquals (fastReader.numOverruns + slowReader.numOverruns, (int64) 0);
+
+        // Double precision audio gets converted on the way in:
+        juce::AudioBuffer<double> doubleBlock (numChannels, 100);
+        doubleBlock.clear();
+        doubleBlock.setSample (1, 99, 0.25);
+        ring.write (doubleBlock);
+
+        expectEquals (ring.read (fastReader, destination), 100);
+        expectEquals (destination.getSample (1, 99), 0.25f);
+    }
+
+    void testOverruns()
+    {
+        beginTest ("Overruns");
+
+        BroadcastAudioRing<float> ring;
+        ring.prepare (numChannels, 1000);
+
+        auto reader = ring.createReader();
+        juce::AudioBuffer<float> block (numChannels, 400), destination (numChannels, 2000);
+
+        for (int64 position = 0; position < 2400; position += 400)
+        {
+            fillBlock (block, position);
+            ring.write (block);
+        }
+
+        // Only the last 1000 samples are left, and the reader must carry on from the oldest of them:
+        expectEquals (ring.read (reader, destination), 1000);
+        expect (checkBlock (destination, 1000, 1400));
+        expectEquals (reader.numOverruns, (int64) 1);
+        expectEquals (reader.numSamplesMissed, (int64) 1400);
+
+        // A block that's longer than the ring leaves only its end:
+        juce::AudioBuffer<float> longBlock (numChannels, 2500);
+        fillBlock (longBlock, 2400);
+        ring.write (longBlock);
+
+        expectEquals (ring.read (reader, destination), 1000);
+        expect (checkBlock (destination, 1000, 3900));
+        expectEquals (reader.numOverruns, (int64) 2);
+    }
+
+    void testMeteringLevels()
+    {
+        beginTest ("Metering from a LevelsProcessor");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        LevelsProcessor levelsProcessor;
+
+        // There's no ring for a meter to read from until broadcasting is enabled:
+        expect (levelsProcessor.getBroadcastRing() == nullptr);
+
+        levelsProcessor.enableBroadcasting (numChannels, (int) sampleRate);
+        levelsProcessor.prepareToPlay (sampleRate, blockSize);
+
+        auto* ring = levelsProcessor.getBroadcastRing();
+        expect (ring != nullptr && ring->getNumChannels() == numChannels);
+
+        // Any number of meters can be fed by the same processor:
+        Meter firstMeter, secondMeter;
+        firstMeter.setAudioSource (ring);
+        secondMeter.setAudioSource (ring);
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            buffer.clear();
+            buffer.setSample (0, 10, i == 2 ? 0.5f : 0.25f);
+            buffer.setSample (1, 10, -0.125f);
+            levelsProcessor.processBlock (buffer, midiBuffer);
+        }
+
+        // Enabling it again mustn't prepare the ring again underneath the meters, which would lose what they haven't read yet:
+        levelsProcessor.enableBroadcasting (numChannels, (int) sampleRate);
+        expect (levelsProcessor.getBroadcastRing() == ring);
+        expectEquals (ring->getNumSamplesWritten(), (int64) blockSize * 4);
+
+        for (auto* meter : { &firstMeter, &secondMeter })
+        {
+            expect (meter->refreshLevels());
+
+            // The meters smooth their levels towards the peaks:
+            expectWithinAbsoluteError (meter->getChannelLevel (0), lerp (0.0f, 0.5f, 0.9f), 1.0e-6f);
+            expectWithinAbsoluteError (meter->getChannelLevel (1), lerp (0.0f, 0.125f, 0.9f), 1.0e-6f);
+
+            // Nothing new came in:
+            expect (! meter->refreshLevels());
+        }
+
+        firstMeter.setAudioSource (nullptr);
+        secondMeter.setAudioSource (nullptr);
+    }
+
+    //==============================================================================
+    void testConcurrentReaders()
+    {
+        beginTest ("1 writer and 8 readers at 192 kHz");
+
+        constexpr int numReaders = 8;
+        constexpr double sampleRate = 192000.0;
+        constexpr int blockSize = 256;
+        constexpr int64 numSamples = (int64) sampleRate * 60;
+
+        BroadcastAudioRing<float> ring;
+        ring.prepare (numChannels, (int) sampleRate / 4);
+
+        std::atomic<bool> finishedWriting { false };
+        std::array<int64, numReaders> numErrors {}, numSamplesRead {}, numOverruns {};
+        std::vector<std::thread> readers;
+
+        for (int r = 0; r < numReaders; ++r)
+        {
+            readers.emplace_back ([&, r]()
+            {
+                auto reader = ring.createReader();
+                juce::AudioBuffer<float> destination (numChannels, 1024 + r * 512);
+
+                for (;;)
+                {
+                    // NB: Checking before reading, so that nothing written beforehand gets left behind.
+                    const auto wasFinished = finishedWriting.load();
+                    const auto numRead = ring.read (reader, destination);
+
+                    if (numRead > 0 && ! checkBlock (destination, numRead, reader.position - numRead))
+                        ++numErrors[(size_t) r];
+
+                    numSamplesRead[(size_t) r] += numRead;
+
+                    if (numRead == 0)
+                    {
+                        if (wasFinished)
+                            break;
+
+                        Thread::yield();
+                    }
+                }
+
+                numOverruns[(size_t) r] = reader.numOverruns;
+            });
+        }
+
+        juce::AudioBuffer<float> block (numChannels, blockSize);
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        int64 worstWriteTicks = 0, totalWriteTicks = 0;
+        const auto startTicks = Time::getHighResolutionTicks();
+       #endif
+
+        for (int64 position = 0; position < numSamples; position += blockSize)
+        {
+            fillBlock (block, position);
+
+           #if SQUAREPINE_COMPILE_BENCHMARKS
+            const auto writeStartTicks = Time::getHighResolutionTicks();
+            ring.write (block);
+            const auto writeTicks = Time::getHighResolutionTicks() - writeStartTicks;
+
+            worstWriteTicks = jmax (worstWriteTicks, writeTicks);
+            totalWriteTicks += writeTicks;
+           #else
+            ring.write (block);
+           #endif
+        }
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        const auto writingSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+       #endif
+
+        finishedWriting = true;
+
+        for (auto& reader : readers)
+            reader.join();
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        const auto numBlocks = numSamples / blockSize;
+        const auto blockMs = blockSize / sampleRate * 1000.0;
+
+        logMessage ("Wrote " + String (numSamples / sampleRate, 0) + " s of audio "
+                    + String (numSamples / sampleRate / writingSeconds, 1) + "x faster than realtime; "
+                    + "each block took " + String (Time::highResolutionTicksToSeconds (totalWriteTicks / numBlocks) * 1.0e6, 2)
+                    + " us on average and " + String (Time::highResolutionTicksToSeconds (worstWriteTicks) * 1.0e6, 2)
+                    + " us at worst, out of a " + String (blockMs * 1000.0, 0) + " us budget");
+       #endif
+
+        for (int r = 0; r < numReaders; ++r)
+        {
+            expectEquals (numErrors[(size_t) r], (int64) 0);
+            expect (numSamplesRead[(size_t) r] > 0);
+
+           #if SQUAREPINE_COMPILE_BENCHMARKS
+            logMessage ("Reader " + String (r + 1) + " read " + String (numSamplesRead[(size_t) r])
+                        + " samples, with " + String (numOverruns[(size_t) r]) + " overruns");
+           #endif
+        }
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BroadcastAudioRingUnitTests)
+};
+
+#endif
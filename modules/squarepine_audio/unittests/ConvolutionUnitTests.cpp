@@ -0,0 +1,415 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class ConvolutionUnitTests final : public UnitTest
+{
+public:
+    ConvolutionUnitTests() :
+        UnitTest ("Convolution", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testAccuracy();
+        testWeights();
+        testTransitions();
+        testRunningLate();
+        testProcessor();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    using Kernel = PartitionedConvolver::Kernel;
+
+    static constexpr int partitionSize = 64;
+    static constexpr int tailPartitionSize = partitionSize * PartitionedConvolver::tailPartitionRatio;
+
+    /** Where the tail starts, which is where most of the bookkeeping happens. */
+    static constexpr int headLength = tailPartitionSize * 2;
+
+    static juce::AudioBuffer<float> createNoise (int numChannels, int numSamples, int seed)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        Random random (seed);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+
+        return buffer;
+    }
+
+    /** Convolves the slow way, adding the result into the output, for comparison. */
+    static void convolve (const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& impulseResponse,
+                          float gain, juce::AudioBuffer<float>& output)
+    {
+        for (int c = 0; c < input.getNumChannels(); ++c)
+        {
+            const auto* x = input.getReadPointer (c);
+            const auto* h = impulseResponse.getReadPointer (c % impulseResponse.getNumChannels());
+
+            for (int i = 0; i < input.getNumSamples(); ++i)
+            {
+                double sum = 0.0;
+
+                for (int j = 0; j < jmin (i + 1, impulseResponse.getNumSamples()); ++j)
+                    sum += (double) h[j] * (double) x[i - j];
+
+                output.setSample (c, i, output.getSample (c, i) + gain * (float) sum);
+            }
+        }
+    }
+
+    /** Feeds the audio through the convolver in blocks of random sizes, up to the given one.
+
+        NB: The tests run much faster than real time, so the convolvers they check get set to wait
+            on the background threads, as they would when rendering offline, or else they'd leave tails out.
+    */
+    static void process (PartitionedConvolver& convolver, juce::AudioBuffer<float>& buffer, Random& random, int maxBlockSize)
+    {
+        for (int start = 0; start < buffer.getNumSamples();)
+        {
+            const auto numThisTime = jmin (buffer.getNumSamples() - start, 1 + random.nextInt (maxBlockSize));
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numThisTime);
+            convolver.process (block);
+            start += numThisTime;
+        }
+    }
+
+    /** @returns the largest difference, relative to the loudest expected sample. */
+    static float getLargestError (const juce::AudioBuffer<float>& actual, const juce::AudioBuffer<float>& expected,
+                                  int startSample = 0, int numSamples = -1)
+    {
+        const auto endSample = numSamples < 0 ? expected.getNumSamples() : startSample + numSamples;
+        float largestError = 0.0f, largestSample = 1.0e-6f;
+
+        for (int c = 0; c < expected.getNumChannels(); ++c)
+        {
+            for (int i = startSample; i < endSample; ++i)
+            {
+                largestError = jmax (largestError, std::abs (actual.getSample (c, i) - expected.getSample (c, i)));
+                largestSample = jmax (largestSample, std::abs (expected.getSample (c, i)));
+            }
+        }
+
+        return largestError / largestSample;
+    }
+
+    //==============================================================================
+    void testAccuracy()
+    {
+        beginTest ("Accuracy");
+
+        Random random (1234);
+        const auto input = createNoise (2, headLength + tailPartitionSize * 6, 1);
+
+        // Lengths on either side of where the partitions, and the tail, start:
+        for (const auto length : { 1, 37, partitionSize, partitionSize + 1, headLength, headLength + 1,
+                                   headLength + tailPartitionSize * 3 + 100 })
+        {
+            for (const auto numChannels : { 1, 2 })
+            {
+                const auto impulseResponse = createNoise (numChannels, length, length);
+                Kernel kernel (impulseResponse, partitionSize);
+
+                PartitionedConvolver convolver;
+                convolver.setNonRealtime (true);
+                convolver.prepare (2, { &kernel });
+
+                const int index = 0;
+                const float weight = 1.0f;
+                convolver.setWeights (&index, &weight, 1);
+
+                auto actual = input;
+                process (convolver, actual, random, 300);
+
+                juce::AudioBuffer<float> expected (2, input.getNumSamples());
+                expected.clear();
+                convolve (input, impulseResponse, 1.0f, expected);
+
+                expectLessThan (getLargestError (actual, expected), 1.0e-5f,
+                                String (length) + " samples, " + String (numChannels) + " channel(s)");
+            }
+        }
+    }
+
+    void testWeights()
+    {
+        beginTest ("Weights");
+
+        Random random (1234);
+        const auto input = createNoise (2, headLength + tailPartitionSize * 5, 1);
+
+        // Kernels of different lengths, some of which have no tail at all:
+        std::vector<juce::AudioBuffer<float>> impulseResponses;
+
+        for (const auto length : { headLength + tailPartitionSize * 2 + 5, 300, headLength + 700 })
+            impulseResponses.push_back (createNoise (2, length, length));
+
+        OwnedArray<Kernel> kernels;
+        Array<const Kernel*> kernelPointers;
+
+        for (const auto& impulseResponse : impulseResponses)
+            kernelPointers.add (kernels.add (new Kernel (impulseResponse, partitionSize)));
+
+        PartitionedConvolver convolver;
+        convolver.setNonRealtime (true);
+        convolver.prepare (2, kernelPointers);
+
+        const int indices[] = { 2, 0, 1 };
+        const float weights[] = { 0.25f, -0.5f, 0.75f };
+        convolver.setWeights (indices, weights, 3);
+
+        auto actual = input;
+        process (convolver, actual, random, 200);
+
+        juce::AudioBuffer<float> expected (2, input.getNumSamples());
+        expected.clear();
+
+        for (int i = 0; i < 3; ++i)
+            convolve (input, impulseResponses[(size_t) indices[i]], weights[i], expected);
+
+        expectLessThan (getLargestError (actual, expected), 1.0e-5f);
+    }
+
+    void testTransitions()
+    {
+        beginTest ("Transitions");
+
+        const auto input = createNoise (1, headLength + tailPartitionSize * 12, 1);
+        const auto first = createNoise (1, headLength + tailPartitionSize * 3, 2);
+        const auto second = createNoise (1, headLength + tailPartitionSize * 2 + 99, 3);
+
+        Kernel firstKernel (first, partitionSize), secondKernel (second, partitionSize);
+
+        PartitionedConvolver convolver;
+        convolver.setNonRealtime (true);
+        convolver.prepare (1, { &firstKernel, &secondKernel });
+
+        const float weight = 1.0f;
+        int index = 0;
+        convolver.setWeights (&index, &weight, 1);
+
+        // Switching over part of the way through a block, and a partition:
+        constexpr int blockSize = 100;
+        constexpr int switchSample = blockSize * 30;
+        auto actual = input;
+
+        for (int start = 0; start < actual.getNumSamples(); start += blockSize)
+        {
+            if (start == switchSample)
+            {
+                index = 1;
+                convolver.setWeights (&index, &weight, 1);
+            }
+
+            juce::AudioBuffer<float> block (actual.getArrayOfWritePointers(), 1, start, jmin (blockSize, actual.getNumSamples() - start));
+            convolver.process (block);
+        }
+
+        juce::AudioBuffer<float> before (1, input.getNumSamples()), after (1, input.getNumSamples());
+        before.clear();
+        after.clear();
+        convolve (input, first, 1.0f, before);
+        convolve (input, second, 1.0f, after);
+
+        expectLessThan (getLargestError (actual, before, 0, switchSample), 1.0e-5f, "Before switching");
+
+        // The tail only switches over once the partition it's being worked out for has started playing:
+        const auto settledSample = (switchSample / tailPartitionSize + 3) * tailPartitionSize;
+        expectLessThan (getLargestError (actual, after, settledSample, input.getNumSamples() - settledSample), 1.0e-5f,
+                        "After switching");
+    }
+
+    void testRunningLate()
+    {
+        beginTest ("Running late");
+
+        const auto impulseResponse = createNoise (1, headLength + tailPartitionSize * 3 + 100, 4);
+        Kernel kernel (impulseResponse, partitionSize);
+
+        PartitionedConvolver convolver;
+        convolver.prepare (1, { &kernel });
+
+        const int index = 0;
+        const float weight = 1.0f;
+        convolver.setWeights (&index, &weight, 1);
+
+        // Going as fast as possible, which the background threads can't keep up with,
+        // but which the audio thread must get through without waiting on them:
+        auto rushed = createNoise (1, tailPartitionSize * 64, 5);
+        Random random (1234);
+        process (convolver, rushed, random, partitionSize);
+
+        bool allFinite = true;
+
+        for (int i = 0; i < rushed.getNumSamples(); ++i)
+            allFinite = allFinite && std::isfinite (rushed.getSample (0, i));
+
+        expect (allFinite);
+
+        // Once given the time, it should be right back in step, after the impulse response's worth of silence
+        // that it takes for whatever was left out to ring out:
+        const auto numSilentPartitions = (impulseResponse.getNumSamples() + tailPartitionSize - 1) / tailPartitionSize + 2;
+        const auto input = createNoise (1, headLength + tailPartitionSize * 4, 6);
+
+        juce::AudioBuffer<float> actual (1, tailPartitionSize * numSilentPartitions + input.getNumSamples());
+        actual.clear();
+        actual.copyFrom (0, tailPartitionSize * numSilentPartitions, input, 0, 0, input.getNumSamples());
+
+        const auto numLateBefore = convolver.getNumLateTailPartitions();
+
+        for (int start = 0; start < actual.getNumSamples(); start += tailPartitionSize)
+        {
+            Thread::sleep (10);
+
+            juce::AudioBuffer<float> block (actual.getArrayOfWritePointers(), 1, start, tailPartitionSize);
+            convolver.process (block);
+        }
+
+        juce::AudioBuffer<float> expected (1, input.getNumSamples());
+        expected.clear();
+        convolve (input, impulseResponse, 1.0f, expected);
+
+        juce::AudioBuffer<float> settled (actual.getArrayOfWritePointers(), 1,
+                                          tailPartitionSize * numSilentPartitions, input.getNumSamples());
+
+        expectLessThan (getLargestError (settled, expected), 1.0e-5f);
+        expectEquals (convolver.getNumLateTailPartitions(), numLateBefore, "Nothing should be late with time to spare");
+    }
+
+    void testProcessor()
+    {
+        beginTest ("Processor");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 480;
+        constexpr int length = 6000;
+
+        // One impulse response in each corner:
+        std::vector<PositionedImpulseResponse> impulseResponses;
+        std::vector<juce::AudioBuffer<float>> buffers;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            buffers.push_back (createNoise (2, length, i + 10));
+            impulseResponses.emplace_back (buffers.back(), (float) (i % 2), (float) (i / 2));
+        }
+
+        const auto input = createNoise (2, blockSize * 30, 1);
+
+        const auto run = [&] (juce::Point<float> position, float mix)
+        {
+            ConvolutionProcessor processor;
+            processor.setNonRealtime (true);
+            processor.setImpulseResponses (impulseResponses);
+            processor.setSourcePosition (position);
+            processor.setMix (mix);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            auto output = input;
+            MidiBuffer midiMessages;
+
+            for (int start = 0; start < output.getNumSamples(); start += blockSize)
+            {
+                juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), 2, start, blockSize);
+                processor.processBlock (block, midiMessages);
+            }
+
+            expectEquals (processor.getNumImpulseResponses(), 4);
+            expectWithinAbsoluteError (processor.getTailLengthSeconds(), length / sampleRate, 1.0e-9);
+            return output;
+        };
+
+        // Right on one of them, only that one should be heard:
+        {
+            juce::AudioBuffer<float> expected (2, input.getNumSamples());
+            expected.clear();
+            convolve (input, buffers[1], 1.0f, expected);
+
+            expectLessThan (getLargestError (run ({ 1.0f, 0.0f }, 1.0f), expected), 1.0e-5f, "In a corner");
+        }
+
+        // Right in the middle, all of them equally:
+        {
+            juce::AudioBuffer<float> expected (2, input.getNumSamples());
+            expected.clear();
+
+            for (const auto& buffer : buffers)
+                convolve (input, buffer, 0.25f, expected);
+
+            expectLessThan (getLargestError (run ({ 0.5f, 0.5f }, 1.0f), expected), 1.0e-5f, "In the middle");
+        }
+
+        // Completely dry:
+        expectLessThan (getLargestError (run ({ 0.5f, 0.5f }, 0.0f), input), 1.0e-6f, "Dry");
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+        constexpr int numChannels = 2;
+        constexpr int numBlocks = (int) (sampleRate * 5.0) / blockSize;
+        constexpr int headPartitionSize = ConvolutionProcessor::headPartitionSize;
+
+        // A grid of 3 second long impulse responses, shared by every convolver:
+        OwnedArray<Kernel> kernels;
+        Array<const Kernel*> kernelPointers;
+
+        for (int i = 0; i < 4; ++i)
+            kernelPointers.add (kernels.add (new Kernel (createNoise (numChannels, (int) sampleRate * 3, i), headPartitionSize)));
+
+        auto buffer = createNoise (numChannels, blockSize, 1);
+
+        for (const auto numConvolvers : { 1, 8, 24 })
+        {
+            OwnedArray<PartitionedConvolver> convolvers;
+
+            // NB: Waiting on the background threads, which run behind when going this much faster than real time,
+            //     so that the audio thread gets charged for whatever it would have had to do itself.
+            for (int i = 0; i < numConvolvers; ++i)
+            {
+                auto* convolver = convolvers.add (new PartitionedConvolver());
+                convolver->setNonRealtime (true);
+                convolver->prepare (numChannels, kernelPointers);
+            }
+
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                // Moving between the kernels the whole time, so that the crossfading gets counted too:
+                const int indices[] = { 0, 1, 2, 3 };
+                const auto position = (float) block / (float) numBlocks;
+                const float weights[] = { 1.0f - position, position, 0.5f * position, 0.25f };
+
+                for (auto* convolver : convolvers)
+                {
+                    convolver->setWeights (indices, weights, 4);
+                    convolver->process (buffer);
+                }
+            }
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            const auto percentage = 100.0 * seconds * sampleRate / ((double) numBlocks * blockSize);
+
+            logMessage (String (numConvolvers) + " stereo convolver(s), mixing four 3 second impulse responses: "
+                        + String (percentage, 2) + "% of real time on the audio thread, "
+                        + String (percentage / numConvolvers, 2) + "% each");
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionUnitTests)
+};
+
+#endif
@@ -0,0 +1,216 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class DistortionFunctionsUnitTests final : public UnitTest
+{
+public:
+    DistortionFunctionsUnitTests() :
+        UnitTest ("DistortionFunctions", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testAccuracy();
+        testLookupTables();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    using Curve = DistortionFunctions::Curve;
+
+    static constexpr int numSamples = 100000;
+    static constexpr float maxInput = 10.0f;
+
+    struct Contender final
+    {
+        String name;
+        std::function<float (float)> reference;
+        std::function<void (float*, int)> scalar, batch;
+        float maxError = 0.0f;  //< As documented alongside the batch function.
+    };
+
+    /** NB: The scalar loop gets built from the reference's own type, so that it can be inlined. */
+    template<typename ReferenceType>
+    static Contender createContender (const String& name, ReferenceType reference,
+                                      std::function<void (float*, int)> batch, float maxError)
+    {
+        const auto scalar = [reference] (float* samples, int num)
+        {
+            for (int i = 0; i < num; ++i)
+                samples[i] = reference (samples[i]);
+        };
+
+        return { name, reference, scalar, std::move (batch), maxError };
+    }
+
+    static std::vector<Contender> getContenders()
+    {
+        using DF = DistortionFunctions;
+        constexpr auto amount = 0.5f, threshold = 0.4f;
+        const Range<float> thresholds (1.0f / 3.0f, 2.0f / 3.0f);
+
+        return
+        {
+            createContender ("Simple",
+                             [=] (float x) { return (float) DF::simple ((double) x, (double) amount); },
+                             [=] (float* s, int n) { DF::performSimple (s, n, amount); }, 1.0e-6f),
+            createContender ("Hyperbolic tangent",
+                             [] (float x) { return (float) DF::hyperbolicTangentSoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performHyperbolicTangentSoftClipping (s, n); }, 4.0e-7f),
+            createContender ("Sinusoidal",
+                             [] (float x) { return (float) DF::sinusoidalSoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performSinusoidalSoftClipping (s, n); }, 3.0e-7f),
+            createContender ("Exponential 2",
+                             [] (float x) { return (float) DF::exponential2SoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performExponential2SoftClipping (s, n); }, 3.0e-7f),
+            createContender ("Two stage quadratic",
+                             [] (float x) { return (float) DF::twoStageQuadraticSoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performTwoStageQuadraticSoftClipping (s, n); }, 1.0e-6f),
+            createContender ("Cubic",
+                             [] (float x) { return (float) DF::cubicSoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performCubicSoftClipping (s, n); }, 1.0e-6f),
+            createContender ("Reciprocal",
+                             [] (float x) { return (float) DF::reciprocalSoftClipping ((double) x); },
+                             [] (float* s, int n) { DF::performReciprocalSoftClipping (s, n); }, 1.0e-6f),
+            createContender ("Fold back",
+                             [=] (float x) { return (float) DF::foldBack ((double) x, (double) threshold); },
+                             [=] (float* s, int n) { DF::performFoldBack (s, n, threshold); }, 1.0e-6f),
+            createContender ("Hard clipping",
+                             [] (float x) { return DF::hardClipping (x); },
+                             [] (float* s, int n) { DF::performHardClipping (s, n); }, 0.0f),
+            createContender ("Soft clipping",
+                             [=] (float x) { return (float) DF::softClipping ((double) x, (double) thresholds.getStart(), (double) thresholds.getEnd()); },
+                             [=] (float* s, int n) { DF::performSoftClipping (s, n, thresholds); }, 1.0e-6f),
+            createContender ("Exponential",
+                             [] (float x) { return (float) DF::softClippingExp ((double) x); },
+                             [] (float* s, int n) { DF::performSoftClippingExp (s, n); }, 3.0e-7f),
+            createContender ("Half wave rectification",
+                             [] (float x) { return DF::halfWaveRectification (x); },
+                             [] (float* s, int n) { DF::performHalfWaveRectification (s, n); }, 0.0f),
+            createContender ("Full wave rectification",
+                             [] (float x) { return DF::fullWaveRectification (x); },
+                             [] (float* s, int n) { DF::performFullWaveRectification (s, n); }, 0.0f)
+        };
+    }
+
+    /** A sweep across the whole of the input range, so that every branch gets hit. */
+    static std::vector<float> createSweep()
+    {
+        std::vector<float> samples ((size_t) numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[(size_t) i] = jmap ((float) i, 0.0f, (float) (numSamples - 1), -maxInput, maxInput);
+
+        return samples;
+    }
+
+    static float getLargestError (const std::vector<float>& input, const std::vector<float>& output,
+                                  const std::function<float (float)>& reference)
+    {
+        float largest = 0.0f;
+
+        for (size_t i = 0; i < input.size(); ++i)
+            largest = jmax (largest, std::abs (output[i] - reference (input[i])));
+
+        return largest;
+    }
+
+    //==============================================================================
+    void testAccuracy()
+    {
+        beginTest ("Accuracy of the batch functions");
+
+        const auto input = createSweep();
+
+        for (const auto& contender : getContenders())
+        {
+            auto output = input;
+            contender.batch (output.data(), numSamples);
+
+            const auto error = getLargestError (input, output, contender.reference);
+            logMessage (contender.name + ": max error " + String (error));
+
+            // NB: A little leeway, for the reference being rounded to a float too.
+            expect (error <= contender.maxError + 1.0e-7f, contender.name + ": " + String (error));
+        }
+    }
+
+    void testLookupTables()
+    {
+        beginTest ("Accuracy of the lookup tables");
+
+        const auto input = createSweep();
+
+        const std::pair<Curve, std::function<float (float)>> curves[] =
+        {
+            { Curve::hyperbolicTangent, [] (float x) { return (float) DistortionFunctions::hyperbolicTangentSoftClipping ((double) x); } },
+            { Curve::sinusoidal,        [] (float x) { return (float) DistortionFunctions::sinusoidalSoftClipping ((double) x); } },
+            { Curve::exponential2,      [] (float x) { return (float) DistortionFunctions::exponential2SoftClipping ((double) x); } },
+            { Curve::exponential,       [] (float x) { return (float) DistortionFunctions::softClippingExp ((double) x); } }
+        };
+
+        for (const auto& curve : curves)
+        {
+            const DistortionFunctions::LookupTable table (curve.first);
+
+            auto output = input;
+            table.process (output.data(), numSamples);
+
+            expectLessThan (getLargestError (input, output, curve.second), 2.0e-5f);
+        }
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr int blockSize = 512;
+        constexpr int numBlocks = 2000;
+
+        auto input = createSweep();
+        input.resize ((size_t) blockSize);
+
+        const auto getNanosecondsPerSample = [&] (const std::function<void (float*, int)>& process)
+        {
+            auto block = input;
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                std::copy (input.begin(), input.end(), block.begin());
+                process (block.data(), blockSize);
+            }
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            return 1.0e9 * seconds / ((double) numBlocks * blockSize);
+        };
+
+        for (const auto& contender : getContenders())
+        {
+            const auto scalar = getNanosecondsPerSample (contender.scalar);
+            const auto batch = getNanosecondsPerSample (contender.batch);
+
+            logMessage (contender.name + ": " + String (scalar, 2) + " ns per sample, or "
+                        + String (batch, 2) + " ns per sample in batches");
+        }
+
+        for (const auto curve : { Curve::hyperbolicTangent, Curve::sinusoidal, Curve::exponential2, Curve::exponential })
+        {
+            const DistortionFunctions::LookupTable table (curve);
+            const auto lookup = getNanosecondsPerSample ([&] (float* s, int n) { table.process (s, n); });
+
+            logMessage ("Lookup table " + String ((int) curve) + ": " + String (lookup, 2) + " ns per sample");
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionFunctionsUnitTests)
+};
+
+#endif
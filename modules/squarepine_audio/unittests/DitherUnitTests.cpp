@@ -0,0 +1,390 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class DitherUnitTests final : public UnitTest
+{
+public:
+    DitherUnitTests() :
+        UnitTest ("Dither", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testNoise();
+        testQuantisation();
+        testNoiseShaping();
+        testProcessor();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    using NoiseShaping = BasicDither::NoiseShaping;
+
+    static constexpr int numSamples = 1 << 18;
+
+    static Array<NoiseShaping> getAllNoiseShapings()
+    {
+        return { NoiseShaping::none, NoiseShaping::firstOrder, NoiseShaping::secondOrder,
+                 NoiseShaping::wannamaker3, NoiseShaping::lipshitz5 };
+    }
+
+    static String getShapingName (NoiseShaping noiseShaping)
+    {
+        switch (noiseShaping)
+        {
+            case NoiseShaping::none:            return "No noise shaping";
+            case NoiseShaping::firstOrder:      return "First order";
+            case NoiseShaping::secondOrder:     return "Second order";
+            case NoiseShaping::wannamaker3:     return "Wannamaker 3 tap";
+            case NoiseShaping::lipshitz5:       return "Lipshitz 5 tap";
+        }
+
+        return {};
+    }
+
+    static std::vector<float> createSine (float amplitude, double frequency = 441.0, double sampleRate = 44100.0)
+    {
+        std::vector<float> samples ((size_t) numSamples);
+
+        for (size_t i = 0; i < samples.size(); ++i)
+            samples[i] = amplitude * (float) std::sin (MathConstants<double>::twoPi * frequency * (double) i / sampleRate);
+
+        return samples;
+    }
+
+    //==============================================================================
+    void testNoise()
+    {
+        beginTest ("Noise");
+
+        std::vector<float> noise ((size_t) numSamples), other ((size_t) numSamples);
+        BasicDither::generateTriangularNoise (1234, 0, noise.data(), numSamples);
+        BasicDither::generateTriangularNoise (1235, 0, other.data(), numSamples);
+
+        double sum = 0.0, sumOfSquares = 0.0, sumOfProducts = 0.0;
+        int numInMiddle = 0;
+
+        for (size_t i = 0; i < noise.size(); ++i)
+        {
+            expect (noise[i] > -1.0f && noise[i] < 1.0f);
+
+            sum += noise[i];
+            sumOfSquares += square ((double) noise[i]);
+            sumOfProducts += (double) noise[i] * (double) other[i];
+
+            if (std::abs (noise[i]) < 0.5f)
+                ++numInMiddle;
+        }
+
+        // A triangle between -1 and 1 has a variance of 1/6, and three quarters of it sits between -0.5 and 0.5:
+        expectWithinAbsoluteError (sum / numSamples, 0.0, 0.005);
+        expectWithinAbsoluteError (sumOfSquares / numSamples, 1.0 / 6.0, 0.002);
+        expectWithinAbsoluteError ((double) numInMiddle / numSamples, 0.75, 0.005);
+
+        // Different keys should give uncorrelated streams:
+        expectWithinAbsoluteError (sumOfProducts / sumOfSquares, 0.0, 0.01);
+
+        // Picking up part of the way along should carry on with the same stream:
+        std::vector<float> later (100);
+        BasicDither::generateTriangularNoise (1234, 12345, later.data(), (int) later.size());
+        expect (std::equal (later.begin(), later.end(), noise.begin() + 12345));
+    }
+
+    void testQuantisation()
+    {
+        beginTest ("Quantisation");
+
+        for (const auto bitDepth : { 8, 16, 24 })
+        {
+            const auto step = std::ldexp (1.0f, 1 - bitDepth);
+            auto input = createSine (0.99f);
+            input[0] = 1.0f; // Which should get clipped to the largest step below it.
+
+            BasicDither dither;
+            dither.setSeed (1234);
+            dither.setBitDepth (bitDepth);
+
+            auto output = input;
+            dither.process (output.data(), numSamples);
+
+            bool allOnSteps = true;
+            float largestError = 0.0f;
+
+            for (size_t i = 0; i < output.size(); ++i)
+            {
+                const auto steps = output[i] / step;
+                allOnSteps = allOnSteps && steps == std::floor (steps) && output[i] <= 1.0f - step && output[i] >= -1.0f;
+                largestError = jmax (largestError, std::abs (output[i] - input[i]));
+            }
+
+            expect (allOnSteps, String (bitDepth) + " bits");
+            expectLessThan (largestError, step * 1.5f, String (bitDepth) + " bits");
+        }
+
+        // A sample on a step should get moved a whole step either way a quarter of the time, however loud it is,
+        // which it wouldn't be if the noise lost its finer values to rounding:
+        for (const auto bitDepth : { 16, 24 })
+        {
+            for (const auto level : { 0.0f, 0.75f })
+            {
+                const auto step = std::ldexp (1.0f, 1 - bitDepth);
+
+                BasicDither dither;
+                dither.setSeed (1234);
+                dither.setBitDepth (bitDepth);
+
+                std::vector<float> samples ((size_t) numSamples, level);
+                dither.process (samples.data(), numSamples);
+
+                int numMoved = 0;
+
+                for (const auto sample : samples)
+                    if (std::abs (sample - level) >= step)
+                        ++numMoved;
+
+                expectWithinAbsoluteError ((double) numMoved / numSamples, 0.25, 0.01,
+                                           String (bitDepth) + " bits, at " + String (level));
+            }
+        }
+
+        // The point of dithering: a level in between the steps should survive, on average.
+        {
+            constexpr auto bitDepth = 16;
+            const auto level = std::ldexp (0.3f, 1 - bitDepth);
+
+            BasicDither dither;
+            dither.setSeed (1234);
+            dither.setBitDepth (bitDepth);
+
+            std::vector<float> samples ((size_t) numSamples, level);
+            dither.process (samples.data(), numSamples);
+
+            double sum = 0.0;
+
+            for (const auto sample : samples)
+                sum += sample;
+
+            expectWithinAbsoluteError (sum / numSamples / level, 1.0, 0.02);
+        }
+    }
+
+    void testNoiseShaping()
+    {
+        beginTest ("Noise shaping");
+
+        constexpr auto bitDepth = 16;
+        const auto input = createSine (0.5f);
+
+        // How much of the error is below about 700 Hz, which is where the curves should take it away from:
+        const auto getLowFrequencyError = [&] (NoiseShaping noiseShaping, int blockSize)
+        {
+            BasicDither dither;
+            dither.setSeed (1234);
+            dither.setBitDepth (bitDepth);
+            dither.setNoiseShaping (noiseShaping);
+
+            auto output = input;
+
+            for (int start = 0; start < numSamples; start += blockSize)
+                dither.process (output.data() + start, jmin (blockSize, numSamples - start));
+
+            std::vector<double> error ((size_t) numSamples);
+
+            for (size_t i = 0; i < error.size(); ++i)
+                error[i] = (double) output[i] - (double) input[i];
+
+            // Three running averages in a row, whose sidelobes are low enough to keep the boosted highs out:
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                constexpr int windowSize = 64;
+                double sum = 0.0;
+                auto previous = error;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    sum += previous[(size_t) i];
+
+                    if (i >= windowSize)
+                        sum -= previous[(size_t) (i - windowSize)];
+
+                    error[(size_t) i] = sum / windowSize;
+                }
+            }
+
+            double lowFrequencyEnergy = 0.0;
+
+            for (const auto e : error)
+                lowFrequencyEnergy += e * e;
+
+            return Decibels::gainToDecibels (std::sqrt (lowFrequencyEnergy / numSamples), -1000.0);
+        };
+
+        const auto flat = getLowFrequencyError (NoiseShaping::none, 512);
+
+        for (const auto noiseShaping : getAllNoiseShapings())
+        {
+            if (noiseShaping == NoiseShaping::none)
+                continue;
+
+            const auto shaped = getLowFrequencyError (noiseShaping, 512);
+            expectLessThan (shaped, flat - 10.0, getShapingName (noiseShaping));
+
+            // The errors carry on from one block to the next:
+            expectEquals (getLowFrequencyError (noiseShaping, 100), shaped, getShapingName (noiseShaping) + " in small blocks");
+        }
+
+        // Clipping shouldn't make the error feedback run away:
+        for (const auto noiseShaping : getAllNoiseShapings())
+        {
+            BasicDither dither;
+            dither.setBitDepth (bitDepth);
+            dither.setNoiseShaping (noiseShaping);
+
+            auto samples = createSine (4.0f);
+            dither.process (samples.data(), numSamples);
+
+            const auto clipped = createSine (4.0f);
+            float largestError = 0.0f;
+
+            for (size_t i = 0; i < samples.size(); ++i)
+                largestError = jmax (largestError, std::abs (samples[i] - jlimit (-1.0f, 1.0f, clipped[i])));
+
+            expectLessThan (largestError, 0.01f, getShapingName (noiseShaping) + " while clipping");
+        }
+    }
+
+    void testProcessor()
+    {
+        beginTest ("Processor");
+
+        constexpr int blockSize = 512;
+
+        // By default, the audio is left alone:
+        {
+            DitherProcessor processor;
+            processor.prepareToPlay (44100.0, blockSize);
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            MidiBuffer midiMessages;
+
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (c, i, 0.25f * (float) std::sin (i * 0.01));
+
+            juce::AudioBuffer<float> original;
+            original.makeCopyOf (buffer);
+            processor.processBlock (buffer, midiMessages);
+
+            bool isUnchanged = true;
+
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    isUnchanged = isUnchanged && buffer.getSample (c, i) == original.getSample (c, i);
+
+            expect (isUnchanged, "The default bit depth should pass the audio through");
+        }
+
+        const auto run = [] (uint32 seed)
+        {
+            DitherProcessor processor;
+            processor.setBitDepth (16);
+            processor.setNoiseShaping (NoiseShaping::secondOrder);
+            processor.setSeed (seed);
+
+            // NB: Preparing picks up the seed, rather than starting the channels over with random ones.
+            processor.prepareToPlay (44100.0, blockSize);
+
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            MidiBuffer midiMessages;
+
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (c, i, 0.25f * (float) std::sin (i * 0.01));
+
+            processor.processBlock (buffer, midiMessages);
+            return buffer;
+        };
+
+        const auto first = run (1234), again = run (1234), other = run (4321);
+
+        const auto isSame = [] (const juce::AudioBuffer<float>& a, int channelA, const juce::AudioBuffer<float>& b, int channelB)
+        {
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                if (a.getSample (channelA, i) != b.getSample (channelB, i))
+                    return false;
+
+            return true;
+        };
+
+        expect (isSame (first, 0, again, 0) && isSame (first, 1, again, 1), "The same seed should repeat");
+        expect (! isSame (first, 0, other, 0), "Different seeds should differ");
+        expect (! isSame (first, 0, first, 1), "The channels should be dithered differently");
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+        constexpr int numChannels = 2;
+        constexpr int numBlocks = (int) (sampleRate * 60.0) / blockSize;
+
+        const auto source = createSine (0.5f, 441.0, sampleRate);
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+        const auto getMegasamplesPerSecond = [&] (const std::function<void (float*, int)>& process)
+        {
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    auto* samples = buffer.getWritePointer (c);
+                    FloatVectorOperations::copy (samples, source.data(), blockSize);
+                    process (samples, blockSize);
+                }
+            }
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            return (double) numBlocks * blockSize * numChannels / seconds / 1.0e6;
+        };
+
+        // What drawing TPDF noise from juce::Random one sample at a time costs, for comparison:
+        {
+            Random random (1234);
+
+            const auto megasamples = getMegasamplesPerSecond ([&] (float* samples, int num)
+            {
+                for (int i = 0; i < num; ++i)
+                    samples[i] = std::floor (samples[i] * 32768.0f + random.nextFloat() - random.nextFloat() + 0.5f) / 32768.0f;
+            });
+
+            logMessage ("juce::Random, one sample at a time: " + String (megasamples, 1) + " million samples per second");
+        }
+
+        for (const auto noiseShaping : getAllNoiseShapings())
+        {
+            BasicDither dither;
+            dither.setBitDepth (16);
+            dither.setNoiseShaping (noiseShaping);
+
+            const auto megasamples = getMegasamplesPerSecond ([&] (float* samples, int num) { dither.process (samples, num); });
+
+            logMessage (getShapingName (noiseShaping) + ": " + String (megasamples, 1) + " million samples per second, "
+                        + String (megasamples * 1.0e6 / sampleRate, 0) + " times real time per channel");
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DitherUnitTests)
+};
+
+#endif
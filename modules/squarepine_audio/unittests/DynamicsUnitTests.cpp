@@ -0,0 +1,330 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class DynamicsUnitTests final : public UnitTest
+{
+public:
+    DynamicsUnitTests() :
+        UnitTest ("Dynamics", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testFollower();
+        testCurves();
+        testLinking();
+        testSidechain();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    using Detection = BlockEnvelopeFollower::Detection;
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 480;
+
+    /** Noise that swells and fades, so that the envelopes have something to follow. */
+    static juce::AudioBuffer<float> createSwellingNoise (int numChannels, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        Random random (1234);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto swell = 0.55 + 0.45 * std::sin (MathConstants<double>::twoPi * (c + 1) * i / sampleRate);
+                buffer.setSample (c, i, (float) swell * (random.nextFloat() * 2.0f - 1.0f));
+            }
+        }
+
+        return buffer;
+    }
+
+    /** Fills each channel with a constant level, in decibels. */
+    static juce::AudioBuffer<float> createLevels (std::initializer_list<float> levelsDb, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer ((int) levelsDb.size(), numSamples);
+        int channel = 0;
+
+        for (const auto level : levelsDb)
+            FloatVectorOperations::fill (buffer.getWritePointer (channel++), Decibels::decibelsToGain (level, -1000.0f), numSamples);
+
+        return buffer;
+    }
+
+    static void process (DynamicsProcessor& processor, juce::AudioBuffer<float>& buffer)
+    {
+        MidiBuffer midiMessages;
+
+        for (int start = 0; start < buffer.getNumSamples(); start += blockSize)
+        {
+            juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                            start, jmin (blockSize, buffer.getNumSamples() - start));
+            processor.processBlock (block, midiMessages);
+        }
+    }
+
+    /** @returns how much the gain of the last sample of a channel was changed by, in decibels. */
+    static double getFinalGainDb (const juce::AudioBuffer<float>& before, const juce::AudioBuffer<float>& after, int channel)
+    {
+        const auto last = before.getNumSamples() - 1;
+        return Decibels::gainToDecibels ((double) after.getSample (channel, last) / (double) before.getSample (channel, last), -1000.0);
+    }
+
+    /** The textbook curves, with a quadratic knee, worked out the slow way. */
+    static double getExpectedGainDb (DynamicsProcessor::Mode mode, double level, double threshold,
+                                     double ratio, double knee, double range)
+    {
+        const auto isCompressor = mode == DynamicsProcessor::Mode::compressor;
+        const auto overshoot = isCompressor ? level - threshold : threshold - level;
+        const auto slope = isCompressor ? 1.0 - 1.0 / ratio
+                                        : (mode == DynamicsProcessor::Mode::expander ? ratio - 1.0 : 100.0);
+
+        double amount = 0.0;
+
+        if (2.0 * std::abs (overshoot) <= knee && knee > 0.0)
+            amount = square (overshoot + knee / 2.0) / (2.0 * knee);
+        else if (overshoot > 0.0)
+            amount = overshoot;
+
+        return jmax (-range, -slope * amount);
+    }
+
+    //==============================================================================
+    void testFollower()
+    {
+        beginTest ("Follower");
+
+        constexpr int numChannels = 3;
+        constexpr int numSamples = 48000;
+        const auto input = createSwellingNoise (numChannels, numSamples);
+
+        for (const auto detection : { Detection::peak, Detection::rms })
+        {
+            BlockEnvelopeFollower follower;
+            follower.prepare (sampleRate, numChannels);
+            follower.setAttackMs (5.0f);
+            follower.setReleaseMs (50.0f);
+            follower.setDetection (detection);
+
+            juce::AudioBuffer<float> envelopes (numChannels, numSamples);
+            Random random (1234);
+
+            // Odd block sizes, so that the envelopes carry on across them:
+            for (int start = 0; start < numSamples;)
+            {
+                const auto numThisTime = jmin (numSamples - start, 1 + random.nextInt (700));
+                juce::AudioBuffer<float> block (envelopes.getArrayOfWritePointers(), numChannels, start, numThisTime);
+                follower.process (input.getArrayOfReadPointers(), numChannels, start, block.getArrayOfWritePointers(), numThisTime);
+                start += numThisTime;
+            }
+
+            double largestError = 0.0;
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                EnvelopeFollower<double> expected (sampleRate);
+                expected.setAttackMs (5.0);
+                expected.setReleaseMs (50.0);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto sample = (double) input.getSample (c, i);
+                    const auto level = detection == Detection::rms ? 10.0 * std::log10 (expected.processDecibels (sample * sample))
+                                                                   : 20.0 * std::log10 (expected.process (sample));
+
+                    largestError = jmax (largestError, std::abs (level - (double) envelopes.getSample (c, i)));
+                }
+            }
+
+            expectLessThan (largestError, 1.0e-3, detection == Detection::rms ? "RMS" : "Peak");
+        }
+    }
+
+    void testCurves()
+    {
+        beginTest ("Curves");
+
+        constexpr double threshold = -30.0, ratio = 4.0, range = 40.0;
+
+        const auto createProcessor = [] (DynamicsProcessor::Mode mode) -> std::unique_ptr<DynamicsProcessor>
+        {
+            switch (mode)
+            {
+                case DynamicsProcessor::Mode::compressor:   return std::make_unique<CompressorProcessor>();
+                case DynamicsProcessor::Mode::expander:     return std::make_unique<ExpanderProcessor>();
+                case DynamicsProcessor::Mode::gate:         return std::make_unique<GateProcessor>();
+            }
+
+            return {};
+        };
+
+        for (const auto mode : { DynamicsProcessor::Mode::compressor, DynamicsProcessor::Mode::expander, DynamicsProcessor::Mode::gate })
+        {
+            const auto name = createProcessor (mode)->getName();
+
+            for (const auto knee : { 0.0f, 12.0f })
+            {
+                double largestError = 0.0;
+
+                // Levels on either side of, and within, the knee:
+                for (const auto level : { -60.0f, -40.0f, -35.0f, -31.0f, -30.0f, -27.0f, -20.0f, -6.0f, 0.0f })
+                {
+                    auto processor = createProcessor (mode);
+                    processor->setThreshold ((float) threshold);
+                    processor->setRatio ((float) ratio);
+                    processor->setKnee (knee);
+                    processor->setRange ((float) range);
+                    processor->setMakeupGain (3.0f);
+                    processor->setAttack (0.1f);
+                    processor->setRelease (1.0f);
+                    processor->prepareToPlay (sampleRate, blockSize);
+
+                    const auto input = createLevels ({ level, level }, blockSize * 4);
+                    auto output = input;
+                    process (*processor, output);
+
+                    const auto expected = getExpectedGainDb (mode, level, threshold, ratio, knee, range) + 3.0;
+                    largestError = jmax (largestError, std::abs (getFinalGainDb (input, output, 0) - expected));
+                }
+
+                expectLessThan (largestError, 1.0e-3, name + " with a knee of " + String (knee));
+            }
+        }
+    }
+
+    void testLinking()
+    {
+        beginTest ("Linking");
+
+        constexpr float loud = -6.0f, quiet = -40.0f;
+
+        for (const auto linked : { true, false })
+        {
+            CompressorProcessor compressor;
+            compressor.setThreshold (-20.0f);
+            compressor.setRatio (4.0f);
+            compressor.setKnee (0.0f);
+            compressor.setLinked (linked);
+            compressor.prepareToPlay (sampleRate, blockSize);
+
+            const auto input = createLevels ({ loud, quiet }, blockSize * 4);
+            auto output = input;
+            process (compressor, output);
+
+            const auto expectedLoud = getExpectedGainDb (DynamicsProcessor::Mode::compressor, loud, -20.0, 4.0, 0.0, 100.0);
+
+            expectWithinAbsoluteError (getFinalGainDb (input, output, 0), expectedLoud, 1.0e-3);
+            expectWithinAbsoluteError (getFinalGainDb (input, output, 1), linked ? expectedLoud : 0.0, 1.0e-3,
+                                       linked ? "Linked" : "Unlinked");
+        }
+    }
+
+    void testSidechain()
+    {
+        beginTest ("Sidechain");
+
+        CompressorProcessor compressor;
+        compressor.setThreshold (-20.0f);
+        compressor.setRatio (4.0f);
+        compressor.setKnee (0.0f);
+
+        expect (! compressor.isUsingSidechain());
+
+        auto* sidechain = compressor.getBus (true, 1);
+        expect (sidechain != nullptr);
+
+        if (sidechain == nullptr)
+            return;
+
+        sidechain->enable();
+        expect (compressor.isUsingSidechain());
+        compressor.prepareToPlay (sampleRate, blockSize);
+
+        // Quiet main channels, which only get turned down because of the loud sidechain:
+        const auto input = createLevels ({ -40.0f, -40.0f, -6.0f, -6.0f }, blockSize * 4);
+        auto output = input;
+        process (compressor, output);
+
+        const auto expected = getExpectedGainDb (DynamicsProcessor::Mode::compressor, -6.0, -20.0, 4.0, 0.0, 100.0);
+
+        expectWithinAbsoluteError (getFinalGainDb (input, output, 0), expected, 1.0e-3);
+        expectWithinAbsoluteError (getFinalGainDb (input, output, 1), expected, 1.0e-3);
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr int numChannels = 64;
+        constexpr int size = 512;
+        constexpr int numBlocks = (int) sampleRate * 10 / size;
+
+        auto buffer = createSwellingNoise (numChannels, size);
+
+        const auto getPercentageOfRealTime = [&] (const std::function<void()>& processBlock)
+        {
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numBlocks; ++i)
+                processBlock();
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            return 100.0 * seconds * sampleRate / ((double) numBlocks * size);
+        };
+
+        // What following and compressing each sample one at a time costs, for comparison:
+        {
+            OwnedArray<EnvelopeFollower<float>> followers;
+
+            for (int c = 0; c < numChannels; ++c)
+                followers.add (new EnvelopeFollower<float> ((float) sampleRate));
+
+            const auto percentage = getPercentageOfRealTime ([&]
+            {
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    auto* samples = buffer.getWritePointer (c);
+
+                    for (int i = 0; i < size; ++i)
+                    {
+                        const auto level = Decibels::gainToDecibels (followers.getUnchecked (c)->process (samples[i]));
+                        samples[i] *= Decibels::decibelsToGain (jmin (0.0f, (level + 20.0f) * -0.75f));
+                    }
+                }
+            });
+
+            logMessage (String (numChannels) + " channels, one sample at a time: " + String (percentage, 2) + "% of real time");
+        }
+
+        for (const auto detection : { Detection::peak, Detection::rms })
+        {
+            for (const auto linked : { true, false })
+            {
+                CompressorProcessor compressor;
+                compressor.setPlayConfigDetails (numChannels, numChannels, sampleRate, size);
+                compressor.setDetection (detection);
+                compressor.setLinked (linked);
+                compressor.prepareToPlay (sampleRate, size);
+
+                MidiBuffer midiMessages;
+                const auto percentage = getPercentageOfRealTime ([&] { compressor.processBlock (buffer, midiMessages); });
+
+                logMessage (String (numChannels) + " channels, " + (detection == Detection::rms ? "RMS" : "peak")
+                            + (linked ? ", linked: " : ", unlinked: ") + String (percentage, 2) + "% of real time");
+            }
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicsUnitTests)
+};
+
+#endif
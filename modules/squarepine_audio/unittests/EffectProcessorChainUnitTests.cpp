@@ -0,0 +1,990 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+/** A factory that only knows about the internal effects, for testing purposes.
+
+    The internal format leaves out the reverb, so the factory creates that one itself.
+*/
+class InternalEffectProcessorFactory final : public EffectProcessorFactory
+{
+public:
+    InternalEffectProcessorFactory() :
+        EffectProcessorFactory (knownPlugins)
+    {
+        auto format = std::make_unique<InternalAudioPluginFormat> (graph);
+        format->addPluginDescriptions (knownPlugins);
+        formatManager.addFormat (format.release());
+
+        knownPlugins.addType (JUCEReverbProcessor().getPluginDescription());
+    }
+
+    ~InternalEffectProcessorFactory() override
+    {
+        stopCreatingPlugins();
+    }
+
+    const AudioPluginFormatManager& getAudioPluginFormatManager() const override { return formatManager; }
+
+    std::unique_ptr<AudioPluginInstance> createPluginOnAnyThread (const PluginDescription& description) const override
+    {
+        if (description.fileOrIdentifier == JUCEReverbProcessor().getIdentifier().toString())
+            return std::make_unique<JUCEReverbProcessor>();
+
+        return EffectProcessorFactory::createPluginOnAnyThread (description);
+    }
+
+private:
+    AudioProcessorGraph graph;
+    KnownPluginList knownPlugins;
+    AudioPluginFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InternalEffectProcessorFactory)
+};
+
+//==============================================================================
+/** Drives a processor from an audio device, keeping track of how long each callback took. */
+class TimedProcessorCallback final : public AudioIODeviceCallback
+{
+public:
+    TimedProcessorCallback (AudioProcessor& p) :
+        processor (p)
+    {
+    }
+
+    void audioDeviceIOCallback (const float**, int, float** outputChannelData,
+                                int numOutputChannels, int numSamples) override
+    {
+        juce::AudioBuffer<float> buffer (outputChannelData, numOutputChannels, numSamples);
+
+        for (int i = 0; i < numOutputChannels; ++i)
+        {
+            auto* data = buffer.getWritePointer (i);
+
+            for (int s = 0; s < numSamples; ++s)
+                data[s] = random.nextFloat() * 2.0f - 1.0f;
+        }
+
+        const auto startTicks = Time::getHighResolutionTicks();
+        processor.processBlock (buffer, midiBuffer);
+        const auto elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+
+        totalTicks += elapsedTicks;
+        ++numCallbacks;
+
+        if (elapsedTicks > worstTicks.load())
+            worstTicks = elapsedTicks;
+    }
+
+    void audioDeviceAboutToStart (AudioIODevice* device) override
+    {
+        processor.prepareToPlay (device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples());
+    }
+
+    void audioDeviceStopped() override
+    {
+        processor.releaseResources();
+    }
+
+    double getWorstCallbackMs() const   { return Time::highResolutionTicksToSeconds (worstTicks.load()) * 1000.0; }
+    int getNumCallbacks() const         { return numCallbacks.load(); }
+
+    double getMeanCallbackMs() const
+    {
+        const auto num = numCallbacks.load();
+        return num > 0 ? Time::highResolutionTicksToSeconds (totalTicks.load() / num) * 1000.0 : 0.0;
+    }
+
+private:
+    AudioProcessor& processor;
+    MidiBuffer midiBuffer;
+    Random random;
+    std::atomic<int64> worstTicks { 0 }, totalTicks { 0 };
+    std::atomic<int> numCallbacks { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimedProcessorCallback)
+};
+
+//==============================================================================
+class EffectProcessorChainUnitTests final : public UnitTest
+{
+public:
+    EffectProcessorChainUnitTests() :
+        UnitTest ("EffectProcessorChain", UnitTestCategories::audioProcessors)
+    {
+    }
+
+    void runTest() override
+    {
+        testEditingWhileProcessing();
+        testProcessingModesMatch();
+        testOversizedBlocks();
+        testParallelBranches();
+        testEffectStatistics();
+        testLatencyCompensation();
+        testBatchCreation();
+        testBinaryState();
+        testEffectSleeping();
+        testTailsOutlastSleeping();
+        testOfflineRendering();
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testProcessingModePerformance();
+        testSessionRestorePerformance();
+       #endif
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+
+    static EffectProcessorChain::Ptr createGainChain (int numEffects, int numChannels, int blockSize)
+    {
+        auto chain = std::make_shared<EffectProcessorChain> (std::make_shared<InternalEffectProcessorFactory>());
+
+        // Every other effect is partially wet so as to exercise the dry/wet mixing:
+        for (int i = 0; i < numEffects; ++i)
+        {
+            if (auto effect = chain->appendNewEffect ("gain"))
+            {
+                if (auto* gainProcessor = dynamic_cast<GainProcessor*> (effect->plugin.get()))
+                    gainProcessor->setGain (0.5f);
+
+                if (isOdd (i))
+                    chain->setMixLevel (i, 0.25f);
+            }
+        }
+
+        chain->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        chain->prepareToPlay (sampleRate, blockSize);
+        return chain;
+    }
+
+    static void fillWithNoise (juce::AudioBuffer<float>& buffer, Random& random)
+    {
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+        {
+            auto* data = buffer.getWritePointer (i);
+
+            for (int s = 0; s < buffer.getNumSamples(); ++s)
+                data[s] = random.nextFloat() * 2.0f - 1.0f;
+        }
+    }
+
+    void testProcessingModesMatch()
+    {
+        beginTest ("Copying and in-place processing modes match");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 512;
+
+        auto copyingChain = createGainChain (4, numChannels, blockSize);
+        auto inPlaceChain = createGainChain (4, numChannels, blockSize);
+        copyingChain->setProcessingMode (EffectProcessorChain::ProcessingMode::copying);
+        inPlaceChain->setProcessingMode (EffectProcessorChain::ProcessingMode::inPlace);
+
+        juce::AudioBuffer<float> copyingBuffer (numChannels, blockSize), inPlaceBuffer (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+        Random random (4321);
+
+        for (int block = 0; block < 8; ++block)
+        {
+            fillWithNoise (copyingBuffer, random);
+            inPlaceBuffer.makeCopyOf (copyingBuffer);
+
+            copyingChain->processBlock (copyingBuffer, midiBuffer);
+            inPlaceChain->processBlock (inPlaceBuffer, midiBuffer);
+
+            for (int i = 0; i < numChannels; ++i)
+                for (int s = 0; s < blockSize; ++s)
+                    expectWithinAbsoluteError (inPlaceBuffer.getSample (i, s), copyingBuffer.getSample (i, s), 1.0e-5f);
+        }
+    }
+
+    void testOversizedBlocks()
+    {
+        beginTest ("Blocks larger than promised");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 128;
+        constexpr auto oversizedBlockSize = blockSize * 3 + 17;
+
+        // Two half-gain branches in parallel, so the branches' buffers get split up too:
+        auto chain = createGainChain (3, numChannels, blockSize);
+        chain->setMixLevel (1, 1.0f);
+        expect (chain->setParallelBranch (0, 0, 0));
+        expect (chain->setParallelBranch (1, 0, 1));
+        chain->prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (numChannels, oversizedBlockSize), expected (numChannels, oversizedBlockSize);
+        Random random (2468);
+        fillWithNoise (buffer, random);
+        expected.makeCopyOf (buffer);
+        expected.applyGain (0.5f);
+
+        // The MIDI must come back out at the same positions it went in at:
+        MidiBuffer midiBuffer;
+        midiBuffer.addEvent (MidiMessage::noteOn (1, 60, 0.5f), 3);
+        midiBuffer.addEvent (MidiMessage::noteOff (1, 60), blockSize * 2 + 5);
+
+        chain->processBlock (buffer, midiBuffer);
+
+        for (int i = 0; i < numChannels; ++i)
+            for (int s = 0; s < oversizedBlockSize; ++s)
+                expectWithinAbsoluteError (buffer.getSample (i, s), expected.getSample (i, s), 1.0e-5f);
+
+        expectEquals (midiBuffer.getNumEvents(), 2);
+        expectEquals (midiBuffer.getFirstEventTime(), 3);
+        expectEquals (midiBuffer.getLastEventTime(), blockSize * 2 + 5);
+    }
+
+    void testParallelBranches()
+    {
+        beginTest ("Parallel branches");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 512;
+
+        // Two half-gain branches summed together, followed by another half-gain effect in series:
+        auto chain = createGainChain (3, numChannels, blockSize);
+        chain->setMixLevel (1, 1.0f);
+        expect (chain->setParallelBranch (0, 0, 0));
+        expect (chain->setParallelBranch (1, 0, 1));
+        chain->prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize), expected (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+        Random random (5678);
+
+        for (int block = 0; block < 8; ++block)
+        {
+            fillWithNoise (buffer, random);
+            expected.makeCopyOf (buffer);
+            expected.applyGain (0.5f);
+
+            chain->processBlock (buffer, midiBuffer);
+
+            for (int i = 0; i < numChannels; ++i)
+                for (int s = 0; s < blockSize; ++s)
+                    expectWithinAbsoluteError (buffer.getSample (i, s), expected.getSample (i, s), 1.0e-5f);
+        }
+
+        const auto timings = chain->getBranchTimings();
+        expectEquals ((int) timings.size(), 2);
+
+        for (const auto& timing : timings)
+            logMessage ("Group " + String (timing.parallelGroup) + ", branch " + String (timing.branchIndex)
+                        + ": last " + String (timing.lastMs, 4) + " ms, peak " + String (timing.peakMs, 4) + " ms");
+
+        // The branches must survive a round-trip through the chain's state:
+        if (MessageManager::existsAndIsCurrentThread())
+        {
+            MemoryBlock state;
+            chain->getStateInformation (state);
+
+            auto restoredChain = createGainChain (0, numChannels, blockSize);
+            restoredChain->setStateInformation (state.getData(), (int) state.getSize());
+
+            expectEquals (restoredChain->getNumEffects(), 3);
+            expect (restoredChain->getParallelGroup (0) == 0);
+            expect (restoredChain->getBranchIndex (1) == 1);
+            expect (restoredChain->getParallelGroup (2) == -1);
+        }
+    }
+
+    void testEffectStatistics()
+    {
+        beginTest ("Effect statistics");
+
+        {
+            EffectProcessorStatistics statistics;
+
+            for (int i = 1; i <= 300; ++i)
+                statistics.addBlock ((double) i, isOdd (i), 64);
+
+            const auto summary = statistics.getSummary();
+            expectEquals (summary.numBlocks, EffectProcessorStatistics::windowSize);
+            expectEquals (summary.minMs, 45.0);
+            expectEquals (summary.maxMs, 300.0);
+            expect (summary.p50Ms <= summary.p95Ms && summary.p95Ms <= summary.p99Ms && summary.p99Ms <= summary.maxMs);
+            expectEquals (summary.numDenormalFlushes, (int64) 150);
+            expectEquals (summary.latencySamples, 64);
+
+            statistics.reset();
+            expectEquals (statistics.getSummary().numBlocks, 0);
+            expectEquals (statistics.getSummary().numDenormalFlushes, (int64) 0);
+        }
+
+        {
+            constexpr auto numChannels = 2;
+            constexpr auto blockSize = 512;
+            constexpr auto numBlocks = 32;
+
+            auto chain = createGainChain (2, numChannels, blockSize);
+
+            juce::AudioBuffer<float> buffer (numChannels, blockSize);
+            MidiBuffer midiBuffer;
+            Random random (2468);
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                fillWithNoise (buffer, random);
+                chain->processBlock (buffer, midiBuffer);
+            }
+
+            for (int i = 0; i < chain->getNumEffects(); ++i)
+            {
+                const auto summary = chain->getEffectProcessor (i)->statistics.getSummary();
+                expectEquals (summary.numBlocks, numBlocks);
+                expect (summary.minMs <= summary.meanMs && summary.meanMs <= summary.maxMs);
+
+                logMessage ("Effect " + String (i) + ": mean " + String (summary.meanMs, 4)
+                            + " ms, p99 " + String (summary.p99Ms, 4) + " ms, max " + String (summary.maxMs, 4) + " ms");
+            }
+        }
+    }
+
+    void testLatencyCompensation()
+    {
+        beginTest ("Latency compensation");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 512;
+        constexpr auto latency = 64;
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+
+        const auto processImpulse = [&] (EffectProcessorChain& chain)
+        {
+            buffer.clear();
+
+            for (int i = 0; i < numChannels; ++i)
+                buffer.setSample (i, 0, 1.0f);
+
+            chain.processBlock (buffer, midiBuffer);
+        };
+
+        // NB: The gain effects only claim to be late, so anything the chain delays shows up as is.
+        {
+            // Mixing half wet: the dry impulse must come out as late as the effect claims to be.
+            auto chain = createGainChain (1, numChannels, blockSize);
+            chain->getEffectProcessor (0)->plugin->setLatencySamples (latency);
+            chain->setMixLevel (0, 0.5f);
+            chain->prepareToPlay (sampleRate, blockSize);
+
+            expectEquals (chain->getLatencySamples(), latency);
+
+            processImpulse (*chain);
+            expectWithinAbsoluteError (buffer.getSample (0, 0), 0.25f, 1.0e-5f);
+            expectWithinAbsoluteError (buffer.getSample (0, latency), 0.5f, 1.0e-5f);
+            expectWithinAbsoluteError (buffer.getSample (1, latency), 0.5f, 1.0e-5f);
+
+            // A bypassed effect gets replaced by a delay of the same length:
+            chain->setBypass (0, true);
+            processImpulse (*chain);
+            expectWithinAbsoluteError (buffer.getSample (0, 0), 0.0f, 1.0e-5f);
+            expectWithinAbsoluteError (buffer.getSample (0, latency), 1.0f, 1.0e-5f);
+            expectEquals (chain->getLatencySamples(), latency);
+        }
+
+        {
+            // Latencies in series add up, but only the longest branch of a parallel group counts:
+            auto chain = createGainChain (4, numChannels, blockSize);
+            chain->getEffectProcessor (0)->plugin->setLatencySamples (latency);
+            chain->getEffectProcessor (1)->plugin->setLatencySamples (latency / 2);
+            chain->getEffectProcessor (2)->plugin->setLatencySamples (latency);
+            chain->getEffectProcessor (3)->plugin->setLatencySamples (latency * 2);
+
+            for (int i = 0; i < chain->getNumEffects(); ++i)
+                chain->setMixLevel (i, 1.0f);
+
+            expect (chain->setParallelBranch (1, 0, 0));
+            expect (chain->setParallelBranch (2, 0, 1));
+            chain->prepareToPlay (sampleRate, blockSize);
+
+            expectEquals (chain->getLatencySamples(), latency + latency + latency * 2);
+
+            // The shorter branch gets lined up with the longer one, which shows up as an echo here:
+            processImpulse (*chain);
+
+            for (int s = 0; s < blockSize; ++s)
+                expectWithinAbsoluteError (buffer.getSample (0, s), (s == 0 || s == latency / 2) ? 0.125f : 0.0f, 1.0e-5f);
+
+            // The chain has to cope with an effect becoming later than it has room for, without allocating:
+            chain->getEffectProcessor (3)->plugin->setLatencySamples (blockSize * 8);
+            processImpulse (*chain);
+
+            chain->prepareToPlay (sampleRate, blockSize);
+            expectEquals (chain->getLatencySamples(), latency + latency + blockSize * 8);
+        }
+    }
+
+    void testBatchCreation()
+    {
+        beginTest ("Batch creation and warm pool");
+
+        auto factory = std::make_shared<InternalEffectProcessorFactory>();
+        const auto gainDescription = factory->createPluginDescription ("gain");
+
+        Array<PluginDescription> descriptions;
+        for (int i = 0; i < 16; ++i)
+            descriptions.add (gainDescription);
+
+        const auto instances = factory->createPlugins (descriptions, sampleRate, 512);
+        expectEquals ((int) instances.size(), descriptions.size());
+
+        for (const auto& instance : instances)
+            expect (instance != nullptr);
+
+        constexpr auto warmPoolSize = 4;
+
+        const auto waitForWarmPool = [&]
+        {
+            for (int i = 0; i < 500 && factory->getNumWarmInstances (gainDescription) < warmPoolSize; ++i)
+                Thread::sleep (10);
+
+            return factory->getNumWarmInstances (gainDescription);
+        };
+
+        factory->setWarmPoolSize (gainDescription, warmPoolSize);
+        expectEquals (waitForWarmPool(), warmPoolSize);
+
+        // Taking an instance must top the pool back up:
+        expect (factory->createPlugin (gainDescription) != nullptr);
+        expectEquals (waitForWarmPool(), warmPoolSize);
+
+        factory->clearWarmPool();
+        expectEquals (factory->getNumWarmInstances (gainDescription), 0);
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testSessionRestorePerformance()
+    {
+        beginTest ("Session restore performance");
+
+        constexpr auto numChains = 40;
+        constexpr auto numEffectsPerChain = 8;
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 512;
+
+        MemoryBlock state;
+        createGainChain (numEffectsPerChain, numChannels, blockSize)->getStateInformation (state);
+
+        auto factory = std::make_shared<InternalEffectProcessorFactory>();
+        const auto gainDescription = factory->createPluginDescription ("gain");
+
+        const auto createSession = [&]
+        {
+            std::vector<EffectProcessorChain::Ptr> chains;
+
+            for (int i = 0; i < numChains; ++i)
+            {
+                chains.push_back (std::make_shared<EffectProcessorChain> (factory));
+                chains.back()->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+                chains.back()->prepareToPlay (sampleRate, blockSize);
+            }
+
+            return chains;
+        };
+
+        const auto logTiming = [&] (const String& name, double elapsedMs)
+        {
+            logMessage (name + ": " + String (numChains) + " chains of " + String (numEffectsPerChain)
+                        + " effects in " + String (elapsedMs, 2) + " ms");
+        };
+
+        const auto restoreSession = [&] (const String& name)
+        {
+            auto chains = createSession();
+            const auto startMs = Time::getMillisecondCounterHiRes();
+
+            for (auto& chain : chains)
+                chain->setStateInformation (state.getData(), (int) state.getSize());
+
+            logTiming (name, Time::getMillisecondCounterHiRes() - startMs);
+
+            for (auto& chain : chains)
+                expectEquals (chain->getNumEffects(), numEffectsPerChain);
+        };
+
+        // For comparison, inserting and preparing every effect one at a time:
+        {
+            auto chains = createSession();
+            const auto startMs = Time::getMillisecondCounterHiRes();
+
+            for (auto& chain : chains)
+                for (int i = 0; i < numEffectsPerChain; ++i)
+                    chain->appendNewEffect ("gain");
+
+            logTiming ("Serial insertion", Time::getMillisecondCounterHiRes() - startMs);
+        }
+
+        restoreSession ("Batched restore");
+
+        factory->setWarmPoolSize (gainDescription, numEffectsPerChain * 4);
+
+        for (int i = 0; i < 500 && factory->getNumWarmInstances (gainDescription) < numEffectsPerChain * 4; ++i)
+            Thread::sleep (10);
+
+        restoreSession ("Batched restore with a warm pool");
+        factory->clearWarmPool();
+    }
+   #endif
+
+    static float getGain (EffectProcessorChain& chain, int index)
+    {
+        if (auto effect = chain.getEffectProcessor (index))
+            if (auto* gainProcessor = dynamic_cast<GainProcessor*> (effect->plugin.get()))
+                return gainProcessor->getGain();
+
+        return -1.0f;
+    }
+
+    void testBinaryState()
+    {
+        beginTest ("Binary state");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 512;
+
+        auto chain = createGainChain (16, numChannels, blockSize);
+
+        MemoryBlock firstState, secondState;
+        chain->getStateInformation (firstState);
+        chain->getStateInformation (secondState);
+        expect (firstState == secondState);
+        expect (firstState.getSize() > 8 && std::memcmp (firstState.getData(), "SPCH", 4) == 0);
+
+        // Changing a parameter must get the plugin's state written again:
+        if (auto* gainProcessor = dynamic_cast<GainProcessor*> (chain->getEffectProcessor (3)->plugin.get()))
+            gainProcessor->setGain (0.25f);
+
+        MemoryBlock changedState;
+        chain->getStateInformation (changedState);
+        expect (changedState != secondState);
+
+        {
+            auto restoredChain = createGainChain (0, numChannels, blockSize);
+            restoredChain->setStateInformation (changedState.getData(), (int) changedState.getSize());
+
+            expectEquals (restoredChain->getNumEffects(), 16);
+            expectWithinAbsoluteError (getGain (*restoredChain, 3), 0.25f, 1.0e-5f);
+            expectWithinAbsoluteError (getGain (*restoredChain, 4), 0.5f, 1.0e-5f);
+            expect (restoredChain->getMixLevel (1) == 0.25f);
+        }
+
+        // The XML format of older versions must still be readable:
+        {
+            InternalEffectProcessorFactory factory;
+            const auto gainDescription = factory.createPluginDescription ("gain");
+
+            auto gainPlugin = factory.createPlugin (gainDescription);
+            dynamic_cast<GainProcessor&> (*gainPlugin).setGain (0.75f);
+
+            MemoryBlock pluginState;
+            gainPlugin->getStateInformation (pluginState);
+
+            XmlElement chainElement ("EffectProcessorChain");
+            chainElement.setAttribute ("rootBypassed", 0);
+
+            auto* effectElement = chainElement.createNewChildElement ("effectRoot");
+            effectElement->setAttribute ("effectName", "Legacy");
+            effectElement->setAttribute ("effectBypassed", 1);
+            effectElement->setAttribute ("effectMixLevel", 0.5);
+            effectElement->addChildElement (gainDescription.createXml().release());
+            effectElement->createNewChildElement ("effectState")->addTextElement (Base64::toBase64 (pluginState.getData(), pluginState.getSize()));
+
+            MemoryBlock legacyState;
+            AudioProcessor::copyXmlToBinary (chainElement, legacyState);
+
+            auto restoredChain = createGainChain (0, numChannels, blockSize);
+            restoredChain->setStateInformation (legacyState.getData(), (int) legacyState.getSize());
+
+            expectEquals (restoredChain->getNumEffects(), 1);
+            expect (restoredChain->getEffectName (0) == String ("Legacy"));
+            expect (restoredChain->isBypassed (0) == true);
+            expect (restoredChain->getMixLevel (0) == 0.5f);
+            expectWithinAbsoluteError (getGain (*restoredChain, 0), 0.75f, 1.0e-5f);
+        }
+    }
+
+    void testEffectSleeping()
+    {
+        beginTest ("Effect sleeping");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 256;
+        constexpr auto latency = blockSize * 2;
+
+        auto sleepingChain = createGainChain (8, numChannels, blockSize);
+        auto wakefulChain = createGainChain (8, numChannels, blockSize);
+        wakefulChain->setSleepingEnabled (false);
+
+        for (auto* chain : { sleepingChain.get(), wakefulChain.get() })
+        {
+            chain->getEffectProcessor (2)->plugin->setLatencySamples (latency);
+            chain->prepareToPlay (sampleRate, blockSize);
+        }
+
+        juce::AudioBuffer<float> sleepingBuffer (numChannels, blockSize), wakefulBuffer (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+        Random random (0x5eed);
+
+        const auto processBlock = [&] (bool silent)
+        {
+            if (silent)
+                sleepingBuffer.clear();
+            else
+                fillWithNoise (sleepingBuffer, random);
+
+            wakefulBuffer.makeCopyOf (sleepingBuffer, true);
+            sleepingChain->processBlock (sleepingBuffer, midiBuffer);
+            wakefulChain->processBlock (wakefulBuffer, midiBuffer);
+
+            auto maxError = 0.0f;
+
+            for (int i = 0; i < numChannels; ++i)
+                for (int s = 0; s < blockSize; ++s)
+                    maxError = jmax (maxError, std::abs (sleepingBuffer.getSample (i, s) - wakefulBuffer.getSample (i, s)));
+
+            return maxError;
+        };
+
+        const auto getNumBlocksSkipped = [&] (EffectProcessorChain& chain, int index)
+        {
+            return chain.getEffectStatistics (index)->numBlocksSkipped;
+        };
+
+        // The number of silent blocks that an effect must process before it can sleep:
+        const auto getNumBlocksToSleep = [&] (int latencySamples)
+        {
+            return (int64) std::ceil ((EffectProcessorChain::sleepHoldSeconds * sampleRate + latencySamples) / blockSize);
+        };
+
+        const auto numSilentBlocks = 100;
+
+        for (int i = 0; i < 8; ++i)
+            expectEquals (processBlock (false), 0.0f);
+
+        auto maxError = 0.0f;
+
+        for (int i = 0; i < numSilentBlocks; ++i)
+            maxError = jmax (maxError, processBlock (true));
+
+        expectEquals (maxError, 0.0f);
+        expectEquals (getNumBlocksSkipped (*sleepingChain, 0), numSilentBlocks - getNumBlocksToSleep (0));
+        expectEquals (getNumBlocksSkipped (*sleepingChain, 2), numSilentBlocks - getNumBlocksToSleep (latency));
+        expectEquals (getNumBlocksSkipped (*wakefulChain, 0), (int64) 0);
+
+        // The effects must wake up right away, and sound exactly as if they had never slept:
+        const auto numSkipped = getNumBlocksSkipped (*sleepingChain, 0);
+        expectEquals (processBlock (false), 0.0f);
+        expectEquals (getNumBlocksSkipped (*sleepingChain, 0), numSkipped);
+
+        // A signal just above the threshold must not be enough to wake a sleeping effect:
+        for (int i = 0; i < numSilentBlocks; ++i)
+            processBlock (true);
+
+        const auto quietLevel = Decibels::decibelsToGain (sleepingChain->getSilenceThreshold() + 3.0f);
+        sleepingBuffer.clear();
+        sleepingBuffer.setSample (0, 0, quietLevel);
+        sleepingChain->processBlock (sleepingBuffer, midiBuffer);
+        expectEquals (sleepingBuffer.getSample (0, 0), 0.0f);
+    }
+
+    void testTailsOutlastSleeping()
+    {
+        beginTest ("Tails outlast sleeping");
+
+        constexpr auto numChannels = 2;
+        constexpr auto blockSize = 256;
+
+        auto sleepingChain = createGainChain (0, numChannels, blockSize);
+        auto wakefulChain = createGainChain (0, numChannels, blockSize);
+        wakefulChain->setSleepingEnabled (false);
+
+        for (auto* chain : { sleepingChain.get(), wakefulChain.get() })
+        {
+            expect (chain->appendNewEffect ("simpleReverb") != nullptr);
+            chain->prepareToPlay (sampleRate, blockSize);
+        }
+
+        const auto tailSeconds = sleepingChain->getTailLengthSeconds();
+        expect (tailSeconds > 1.0 && std::isfinite (tailSeconds));
+
+        juce::AudioBuffer<float> sleepingBuffer (numChannels, blockSize), wakefulBuffer (numChannels, blockSize);
+        MidiBuffer midiBuffer;
+        Random random (0x7a11);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            fillWithNoise (sleepingBuffer, random);
+            wakefulBuffer.makeCopyOf (sleepingBuffer, true);
+            sleepingChain->processBlock (sleepingBuffer, midiBuffer);
+            wakefulChain->processBlock (wakefulBuffer, midiBuffer);
+        }
+
+        // Well past the time an effect without a tail would have been put to sleep, the reverb must still be ringing out,
+        // exactly as it would have without sleeping:
+        const auto numTailBlocks = roundToInt (sampleRate / blockSize);
+        auto maxError = 0.0f, lastLevel = 0.0f;
+
+        for (int i = 0; i < numTailBlocks; ++i)
+        {
+            sleepingBuffer.clear();
+            wakefulBuffer.clear();
+            sleepingChain->processBlock (sleepingBuffer, midiBuffer);
+            wakefulChain->processBlock (wakefulBuffer, midiBuffer);
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int s = 0; s < blockSize; ++s)
+                    maxError = jmax (maxError, std::abs (sleepingBuffer.getSample (c, s) - wakefulBuffer.getSample (c, s)));
+
+            lastLevel = wakefulBuffer.getMagnitude (0, blockSize);
+        }
+
+        expect (lastLevel > Decibels::decibelsToGain (sleepingChain->getSilenceThreshold()));
+        expectEquals (maxError, 0.0f);
+        expectEquals (sleepingChain->getEffectStatistics (0)->numBlocksSkipped, (int64) 0);
+
+        // A generator's output has nothing to do with its input, so it must never be put to sleep:
+        expect (std::isinf (HissingProcessor().getTailLengthSeconds()));
+    }
+
+    void testOfflineRendering()
+    {
+        beginTest ("Offline rendering");
+
+        constexpr auto numChannels = 2;
+        constexpr auto numJobs = 8;
+        const auto numSourceSamples = (int) sampleRate * 10;
+
+        // Every other effect of the gain chain is a quarter wet, so each pair of effects scales by 0.5 * 0.875:
+        constexpr auto numEffects = 4;
+        constexpr auto expectedGain = 0.5f * 0.875f * 0.5f * 0.875f;
+
+        MemoryBlock chainState;
+        createGainChain (numEffects, numChannels, 512)->getStateInformation (chainState);
+
+        juce::AudioBuffer<float> source (numChannels, numSourceSamples);
+        Random random (1357);
+        fillWithNoise (source, random);
+
+        MemoryBlock sourceData;
+        WavAudioFormat wavFormat;
+
+        {
+            std::unique_ptr<AudioFormatWriter> writer (wavFormat.createWriterFor (new MemoryOutputStream (sourceData, false),
+                                                                                  sampleRate, (unsigned int) numChannels, 32, {}, 0));
+            expect (writer != nullptr && writer->writeFromAudioSampleBuffer (source, 0, numSourceSamples));
+        }
+
+        std::vector<MemoryBlock> renderedData ((size_t) numJobs);
+        std::vector<OfflineChainRenderer::Job> jobs ((size_t) numJobs);
+
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            auto& job = jobs[i];
+            job.reader.reset (wavFormat.createReaderFor (new MemoryInputStream (sourceData, false), true));
+            job.writer.reset (wavFormat.createWriterFor (new MemoryOutputStream (renderedData[i], false),
+                                                         sampleRate, (unsigned int) numChannels, 32, {}, 0));
+            job.chainState = chainState;
+        }
+
+        OfflineChainRenderer renderer (std::make_shared<InternalEffectProcessorFactory>());
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        const auto startMs = Time::getMillisecondCounterHiRes();
+       #endif
+
+        const auto results = renderer.render (jobs);
+
+        expectEquals ((int) results.size(), numJobs);
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            expect (result.result.wasOk(), result.result.getErrorMessage());
+            expectEquals (result.numSamplesWritten, (int64) numSourceSamples);
+
+            std::unique_ptr<AudioFormatReader> reader (wavFormat.createReaderFor (new MemoryInputStream (renderedData[i], false), true));
+            expect (reader != nullptr && reader->lengthInSamples == numSourceSamples);
+
+            if (reader == nullptr)
+                continue;
+
+            juce::AudioBuffer<float> rendered (numChannels, numSourceSamples);
+            reader->read (&rendered, 0, numSourceSamples, 0, true, true);
+
+            auto maxError = 0.0f;
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int s = 0; s < numSourceSamples; ++s)
+                    maxError = jmax (maxError, std::abs (rendered.getSample (c, s) - source.getSample (c, s) * expectedGain));
+
+            expectLessThan (maxError, 1.0e-5f);
+            expect (result.realtimeFactor > 0.0);
+
+           #if SQUAREPINE_COMPILE_BENCHMARKS
+            logMessage ("Job " + String ((int) i) + ": " + String (result.realtimeFactor, 1) + "x realtime");
+           #endif
+        }
+
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        const auto elapsedMs = Time::getMillisecondCounterHiRes() - startMs;
+        const auto totalSeconds = (double) numSourceSamples * numJobs / sampleRate;
+        logMessage (String (numJobs) + " jobs on " + String (renderer.getNumWorkers()) + " workers: "
+                    + String (totalSeconds / (elapsedMs / 1000.0), 1) + "x realtime overall");
+       #endif
+
+        // A job that can't be rendered must say so, rather than bring the rest down:
+        {
+            OfflineChainRenderer::Job job;
+            job.chainState = chainState;
+            expect (renderer.render (job).result.failed());
+        }
+
+        // However many jobs are waiting, only the chains of the jobs being rendered may be around.
+        // NB: Every chain holds onto the factory, so the factory's use count says how many chains there are.
+        {
+            constexpr auto numWorkers = 2;
+            constexpr auto numWaitingJobs = numWorkers * 8;
+
+            auto factory = std::make_shared<InternalEffectProcessorFactory>();
+            OfflineChainRenderer limitedRenderer (factory, numWorkers);
+            const auto numUsesWithoutChains = factory.use_count();
+
+            std::vector<MemoryBlock> waitingData ((size_t) numWaitingJobs);
+            std::vector<OfflineChainRenderer::Job> waitingJobs ((size_t) numWaitingJobs);
+
+            for (size_t i = 0; i < waitingJobs.size(); ++i)
+            {
+                auto& job = waitingJobs[i];
+                job.reader.reset (wavFormat.createReaderFor (new MemoryInputStream (sourceData, false), true));
+                job.writer.reset (wavFormat.createWriterFor (new MemoryOutputStream (waitingData[i], false),
+                                                             sampleRate, (unsigned int) numChannels, 32, {}, 0));
+                job.chainState = chainState;
+            }
+
+            std::atomic<bool> isRendering { true };
+            std::atomic<long> mostUses { numUsesWithoutChains };
+
+            std::thread counter ([&]
+            {
+                while (isRendering.load())
+                {
+                    mostUses = jmax (mostUses.load(), factory.use_count());
+                    std::this_thread::yield();
+                }
+            });
+
+            const auto waitingResults = limitedRenderer.render (waitingJobs);
+            isRendering = false;
+            counter.join();
+
+            for (const auto& result : waitingResults)
+                expect (result.result.wasOk(), result.result.getErrorMessage());
+
+            expectLessOrEqual (mostUses.load() - numUsesWithoutChains, (long) numWorkers);
+            expectEquals (factory.use_count(), numUsesWithoutChains);
+        }
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testProcessingModePerformance()
+    {
+        beginTest ("Processing mode performance");
+
+        constexpr auto blockSize = 512;
+        constexpr auto numBlocks = 500;
+
+        for (auto numEffects : { 1, 4, 12 })
+        {
+            for (auto numChannels : { 2, 8, 16 })
+            {
+                auto chain = createGainChain (numEffects, numChannels, blockSize);
+
+                juce::AudioBuffer<float> buffer (numChannels, blockSize);
+                MidiBuffer midiBuffer;
+                Random random (1);
+
+                // NB: The copying mode only ever processes the first 2 channels.
+                String result;
+                result << numEffects << " effects, " << numChannels << " channels:";
+
+                for (auto mode : { EffectProcessorChain::ProcessingMode::copying,
+                                   EffectProcessorChain::ProcessingMode::inPlace })
+                {
+                    chain->setProcessingMode (mode);
+                    int64 totalTicks = 0;
+
+                    for (int block = 0; block < numBlocks; ++block)
+                    {
+                        fillWithNoise (buffer, random);
+
+                        const auto startTicks = Time::getHighResolutionTicks();
+                        chain->processBlock (buffer, midiBuffer);
+                        totalTicks += Time::getHighResolutionTicks() - startTicks;
+                    }
+
+                    const auto microsecondsPerBlock = Time::highResolutionTicksToSeconds (totalTicks) * 1.0e6 / numBlocks;
+
+                    result << (mode == EffectProcessorChain::ProcessingMode::copying ? " copying " : ", in-place ")
+                           << String (microsecondsPerBlock, 2) << " us/block";
+                }
+
+                logMessage (result);
+            }
+        }
+    }
+   #endif
+
+    void testEditingWhileProcessing()
+    {
+        beginTest ("Editing while processing");
+
+        constexpr auto blockSize = 1024;
+        constexpr int maxNumEffects = 16;
+        const StringArray identifiers { "gain", "polarityInverter", "stereoWidth", "stereoPanner" };
+
+        EffectProcessorChain chain (std::make_shared<InternalEffectProcessorFactory>());
+        TimedProcessorCallback callback (chain);
+
+        DummyAudioIODevice device (false, 2, sampleRate, blockSize);
+        device.open (2, sampleRate, blockSize);
+        device.start (&callback);
+
+        Random random (1234);
+        int numEdits = 0;
+        const auto endTime = Time::getMillisecondCounterHiRes() + 2000.0;
+
+        while (Time::getMillisecondCounterHiRes() < endTime)
+        {
+            const auto numEffects = chain.getNumEffects();
+            const auto identifier = identifiers[random.nextInt (identifiers.size())];
+
+            switch (numEffects < maxNumEffects ? random.nextInt (4) : 3)
+            {
+                case 0:     chain.appendNewEffect (identifier); break;
+                case 1:     chain.insertNewEffect (identifier, random.nextInt (numEffects + 1)); break;
+                case 2:     chain.moveEffect (random.nextInt (jmax (1, numEffects)), random.nextInt (jmax (1, numEffects))); break;
+                default:    chain.removeEffect (random.nextInt (jmax (1, numEffects))); break;
+            };
+
+            ++numEdits;
+        }
+
+        device.stop();
+        device.close();
+
+        expect (callback.getNumCallbacks() > 0);
+        expect (chain.getNumEffects() <= maxNumEffects);
+
+        logMessage ("Edits: " + String (numEdits)
+                    + ", callbacks: " + String (callback.getNumCallbacks())
+                    + ", mean callback: " + String (callback.getMeanCallbackMs(), 4) + " ms"
+                    + ", worst callback: " + String (callback.getWorstCallbackMs(), 4) + " ms"
+                    + " (budget: " + String (1000.0 * blockSize / sampleRate, 4) + " ms)");
+    }
+};
+
+#endif //SQUAREPINE_COMPILE_UNIT_TESTS
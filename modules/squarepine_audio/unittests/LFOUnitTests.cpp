@@ -0,0 +1,252 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class LFOUnitTests final : public UnitTest
+{
+public:
+    LFOUnitTests() :
+        UnitTest ("LFO", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testWaveforms();
+        testContinuity();
+        testBandLimiting();
+        testTempoSync();
+        testOperations();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    using Waveform = WavetableLFO::Waveform;
+    using Operation = WavetableLFO::Operation;
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+
+    /** @returns a whole cycle of the LFO at 1 Hz. */
+    static std::vector<float> generateCycle (Waveform waveform)
+    {
+        WavetableLFO lfo (waveform);
+        lfo.prepare (sampleRate, (int) sampleRate);
+        lfo.setFrequency (1.0);
+
+        const auto* values = lfo.generate ((int) sampleRate);
+        return { values, values + (int) sampleRate };
+    }
+
+    //==============================================================================
+    void testWaveforms()
+    {
+        beginTest ("Waveforms");
+
+        const auto sine = generateCycle (Waveform::sine);
+        float largestError = 0.0f;
+
+        for (size_t i = 0; i < sine.size(); ++i)
+            largestError = jmax (largestError, std::abs (sine[i] - (float) std::sin (MathConstants<double>::twoPi * (double) i / sampleRate)));
+
+        expectLessThan (largestError, 1.0e-4f);
+
+        // Away from the edges, the band-limited waveforms should be where the ideal ones are:
+        const auto triangle = generateCycle (Waveform::triangle);
+        const auto ramp = generateCycle (Waveform::ramp);
+        const auto square = generateCycle (Waveform::square);
+        const auto quarter = (size_t) sampleRate / 4;
+
+        expectWithinAbsoluteError (triangle[quarter / 2], 0.5f, 0.01f);
+        expectWithinAbsoluteError (triangle[quarter * 3], -1.0f, 0.01f);
+        expectWithinAbsoluteError (ramp[quarter], -0.5f, 0.01f);
+        expectWithinAbsoluteError (ramp[quarter * 3], 0.5f, 0.01f);
+        expectWithinAbsoluteError (square[quarter], 1.0f, 0.03f);
+        expectWithinAbsoluteError (square[quarter * 3], -1.0f, 0.03f);
+
+        for (const auto& values : { sine, triangle, ramp, square })
+            for (const auto v : values)
+                expect (std::abs (v) <= 1.0f);
+    }
+
+    void testContinuity()
+    {
+        beginTest ("Phase carries on from one block to the next");
+
+        WavetableLFO whole (Waveform::triangle), parts (Waveform::triangle);
+        whole.prepare (sampleRate, 4096);
+        parts.prepare (sampleRate, 4096);
+        whole.setFrequency (3.3);
+        parts.setFrequency (3.3);
+
+        const auto* expected = whole.generate (4000);
+        Random random (1234);
+        int numDifferences = 0;
+
+        for (int start = 0; start < 4000;)
+        {
+            const auto numThisTime = jmin (4000 - start, 1 + random.nextInt (700));
+            const auto* values = parts.generate (numThisTime);
+
+            for (int i = 0; i < numThisTime; ++i)
+                if (values[i] != expected[start + i])
+                    ++numDifferences;
+
+            start += numThisTime;
+        }
+
+        expectEquals (numDifferences, 0);
+        expectWithinAbsoluteError (parts.getPhase(), whole.getPhase(), 1.0e-9);
+    }
+
+    void testBandLimiting()
+    {
+        beginTest ("Band-limiting");
+
+        // So close to Nyquist, only the fundamental fits, so everything turns into a sine:
+        constexpr double frequency = sampleRate / 3.5;
+
+        WavetableLFO sine (Waveform::sine);
+        sine.prepare (sampleRate, blockSize);
+        sine.setFrequency (frequency);
+        const auto* expected = sine.generate (blockSize);
+
+        for (const auto waveform : { Waveform::triangle, Waveform::ramp, Waveform::square })
+        {
+            WavetableLFO lfo (waveform);
+            lfo.prepare (sampleRate, blockSize);
+            lfo.setFrequency (frequency);
+
+            const auto* values = lfo.generate (blockSize);
+
+            // Fitting the sine's gain, which is whatever the fundamental's amplitude is for the waveform:
+            double product = 0.0, energy = 0.0;
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                product += (double) values[i] * expected[i];
+                energy += (double) expected[i] * expected[i];
+            }
+
+            const auto gain = (float) (product / energy);
+            float largestError = 0.0f;
+
+            for (int i = 0; i < blockSize; ++i)
+                largestError = jmax (largestError, std::abs (values[i] - gain * expected[i]));
+
+            expectLessThan (largestError, 1.0e-4f);
+        }
+    }
+
+    void testTempoSync()
+    {
+        beginTest ("Tempo sync");
+
+        WavetableLFO lfo;
+        lfo.prepare (sampleRate, blockSize);
+
+        lfo.setTempoSyncedRate (Tempo (120.0), 1.0);
+        expectWithinAbsoluteError (lfo.getFrequency(), 2.0, 1.0e-9);
+
+        lfo.setTempoSyncedRate (Tempo (90.0), 4.0);
+        expectWithinAbsoluteError (lfo.getFrequency(), 0.375, 1.0e-9);
+
+        lfo.syncToBeat (9.0, 4.0);
+        expectWithinAbsoluteError (lfo.getPhase(), 0.25, 1.0e-9);
+    }
+
+    void testOperations()
+    {
+        beginTest ("Operations");
+
+        WavetableLFO reference;
+        reference.prepare (sampleRate, blockSize);
+        reference.setFrequency (5.0);
+        reference.setDepth (0.5f);
+        const auto* values = reference.generate (blockSize);
+
+        const std::pair<Operation, std::function<float (float, float)>> operations[] =
+        {
+            { Operation::add,       [] (float s, float v) { return s + v; } },
+            { Operation::subtract,  [] (float s, float v) { return s - v; } },
+            { Operation::multiply,  [] (float s, float v) { return s * v; } },
+            { Operation::divide,    [] (float s, float v) { return s / v; } },
+            { Operation::replace,   [] (float, float v)   { return v; } }
+        };
+
+        for (const auto& operation : operations)
+        {
+            WavetableLFO lfo;
+            lfo.prepare (sampleRate, blockSize);
+            lfo.setFrequency (5.0);
+            lfo.setDepth (0.5f);
+            lfo.setOperation (operation.first);
+
+            juce::AudioBuffer<float> buffer (3, blockSize);
+
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                FloatVectorOperations::fill (buffer.getWritePointer (c), 2.0f, blockSize);
+
+            lfo.process (buffer);
+
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                for (int i = 1; i < blockSize; ++i) // NB: Skipping the first sample, which is 0 and would blow up a division.
+                    expectWithinAbsoluteError (buffer.getSample (c, i), operation.second (2.0f, values[i]), 1.0e-5f);
+        }
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr int numChannels = 2;
+        constexpr int numBlocks = 10000;
+        constexpr double frequency = 5.0;
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        buffer.clear();
+
+        const auto logCost = [&] (const String& name, const std::function<void()>& processBlock)
+        {
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numBlocks; ++i)
+                processBlock();
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            const auto nanoseconds = 1.0e9 * seconds / ((double) numBlocks * blockSize * numChannels);
+
+            logMessage (name + ": " + String (nanoseconds, 2) + " ns per sample");
+        };
+
+        const LFO::Configuration configuration (sampleRate, frequency, 0.0);
+
+        SineLFO sineLFO;
+        sineLFO.setOperation (new LFO::MultiplyOperation());
+        logCost ("LFO (sine)", [&] { sineLFO.process (buffer, configuration); });
+
+        SquareLFO squareLFO;
+        squareLFO.setOperation (new LFO::MultiplyOperation());
+        logCost ("LFO (square)", [&] { squareLFO.process (buffer, configuration); });
+
+        for (const auto waveform : { Waveform::sine, Waveform::square })
+        {
+            WavetableLFO lfo (waveform);
+            lfo.prepare (sampleRate, blockSize);
+            lfo.setFrequency (frequency);
+            lfo.setOperation (Operation::multiply);
+
+            logCost (waveform == Waveform::sine ? "WavetableLFO (sine)" : "WavetableLFO (square)",
+                     [&] { lfo.process (buffer); });
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LFOUnitTests)
+};
+
+#endif
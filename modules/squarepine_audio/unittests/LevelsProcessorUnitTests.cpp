@@ -0,0 +1,288 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class LevelsProcessorUnitTests final : public UnitTest
+{
+public:
+    LevelsProcessorUnitTests() :
+        UnitTest ("LevelsProcessor", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testPeaks();
+        testModes();
+        testConcurrentReading();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testCallbackTimes();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    static constexpr int numChannels = 2;
+
+    template<typename FloatType>
+    static void processPeaks (LevelsProcessor& processor, juce::AudioBuffer<FloatType>& buffer, FloatType left, FloatType right)
+    {
+        MidiBuffer midiBuffer;
+
+        buffer.clear();
+        buffer.setSample (0, buffer.getNumSamples() / 2, left);
+        buffer.setSample (1, buffer.getNumSamples() / 3, -right);
+        processor.processBlock (buffer, midiBuffer);
+    }
+
+    //==============================================================================
+    void testPeaks()
+    {
+        beginTest ("Peaks since the last read");
+
+        LevelsProcessor processor;
+        processor.prepareToPlay (48000.0, 256);
+
+        juce::AudioBuffer<float> buffer (numChannels, 256);
+        Array<float> levels;
+
+        // Nothing has come through yet:
+        processor.getChannelLevels (levels);
+        expect (levels.isEmpty());
+
+        // A short peak shouldn't get lost behind the quieter blocks that come after it:
+        processPeaks (processor, buffer, 0.2f, 0.1f);
+        processPeaks (processor, buffer, 0.8f, 0.05f);
+        processPeaks (processor, buffer, 0.3f, 0.4f);
+
+        processor.getChannelLevels (levels);
+        expectEquals (levels.size(), numChannels);
+        expectEquals (levels[0], 0.8f);
+        expectEquals (levels[1], 0.4f);
+
+        // Reading again before any more audio comes through gives the same levels:
+        processor.getChannelLevels (levels);
+        expectEquals (levels[0], 0.8f);
+        expectEquals (levels[1], 0.4f);
+
+        // But the next read only covers what came through after the last one:
+        processPeaks (processor, buffer, 0.1f, 0.25f);
+
+        processor.getChannelLevels (levels);
+        expectEquals (levels[0], 0.1f);
+        expectEquals (levels[1], 0.25f);
+
+        // The same goes for double precision audio, whichever precision the levels are read in:
+        juce::AudioBuffer<double> doubleBuffer (numChannels, 256);
+        Array<double> doubleLevels;
+
+        processPeaks (processor, doubleBuffer, 0.5, 0.125);
+        processPeaks (processor, doubleBuffer, 0.25, 0.0625);
+
+        processor.getChannelLevels (doubleLevels);
+        expectEquals (doubleLevels.size(), numChannels);
+        expectEquals (doubleLevels[0], 0.5);
+        expectEquals (doubleLevels[1], 0.125);
+    }
+
+    void testModes()
+    {
+        beginTest ("Modes");
+
+        LevelsProcessor processor;
+        processor.prepareToPlay (48000.0, 256);
+
+        juce::AudioBuffer<float> buffer (numChannels, 256);
+        MidiBuffer midiBuffer;
+        Array<float> levels;
+
+        // The RMS level takes in all of the samples since the last read, instead of just the last block's:
+        processor.setMode (LevelsProcessor::Mode::rms);
+
+        for (const auto level : { 0.5f, 0.0f })
+        {
+            for (int c = 0; c < numChannels; ++c)
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    buffer.setSample (c, i, (i % 2) == 0 ? level : -level);
+
+            processor.processBlock (buffer, midiBuffer);
+        }
+
+        processor.getChannelLevels (levels);
+        expectWithinAbsoluteError (levels[0], std::sqrt (0.125f), 1.0e-6f);
+        expectWithinAbsoluteError (levels[1], std::sqrt (0.125f), 1.0e-6f);
+
+        processor.setMode (LevelsProcessor::Mode::midSide);
+        processPeaks (processor, buffer, 0.5f, 0.25f);
+
+        processor.getChannelLevels (levels);
+        expectEquals (levels[0], 0.25f);
+        expectEquals (levels[1], 0.0625f);
+    }
+
+    void testConcurrentReading()
+    {
+        beginTest ("Reading while the audio thread writes");
+
+        constexpr int blockSize = 32;
+        constexpr int numBlocks = 200000;
+        constexpr int spikeInterval = 1000;
+
+        LevelsProcessor processor;
+        processor.prepareToPlay (48000.0, blockSize);
+
+        // Quiet blocks with a loud spike every so often, where each spike is louder than the last,
+        // such that any read that takes in a spike gives back the latest one it took in:
+        std::vector<float> blockPeaks ((size_t) numBlocks);
+        Random random (1234);
+
+        for (int i = 0; i < numBlocks; ++i)
+            blockPeaks[(size_t) i] = (i % spikeInterval) == spikeInterval - 1
+                                        ? 0.6f + 0.0001f * (float) (i / spikeInterval)
+                                        : 0.1f + 0.4f * random.nextFloat();
+
+        std::atomic<bool> finishedWriting { false };
+
+        std::thread writer ([&]
+        {
+            juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                processPeaks (processor, buffer, blockPeaks[(size_t) i], blockPeaks[(size_t) i] * 0.5f);
+
+                // Pausing every so often, as though waiting on the next callback,
+                // which makes sure the reader gets a look in even on a single core:
+                if ((i % 500) == 250)
+                    Thread::sleep (1);
+            }
+
+            finishedWriting = true;
+        });
+
+        std::vector<float> reads;
+        Array<float> levels;
+
+        for (;;)
+        {
+            // NB: Checking before reading, so that nothing written beforehand gets left behind.
+            const auto wasFinished = finishedWriting.load();
+
+            processor.getChannelLevels (levels);
+
+            if (! levels.isEmpty() && (reads.empty() || reads.back() != levels[0]))
+                reads.push_back (levels[0]);
+
+            if (wasFinished)
+                break;
+        }
+
+        writer.join();
+
+        const auto sortedPeaks = [&]
+        {
+            auto peaks = blockPeaks;
+            std::sort (peaks.begin(), peaks.end());
+            return peaks;
+        }();
+
+        int numMadeUp = 0, numOutOfOrderSpikes = 0;
+        auto lastSpike = 0.0f;
+
+        for (const auto read : reads)
+        {
+            // Every read should be one block's peak, and never a mix of some:
+            if (! std::binary_search (sortedPeaks.begin(), sortedPeaks.end(), read))
+                ++numMadeUp;
+
+            // A spike that was already read shouldn't turn up again later:
+            if (read >= 0.6f)
+            {
+                if (read <= lastSpike)
+                    ++numOutOfOrderSpikes;
+
+                lastSpike = read;
+            }
+        }
+
+        expectEquals (numMadeUp, 0);
+        expectEquals (numOutOfOrderSpikes, 0);
+        expectEquals (lastSpike, sortedPeaks.back(), "The loudest spike should have been read");
+
+        logMessage (String ((int64) reads.size()) + " reads of " + String (numBlocks) + " blocks");
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testCallbackTimes()
+    {
+        beginTest ("Callback times");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = 200000;
+
+        const auto measure = [&] (LevelsProcessor::Mode mode, bool withReader)
+        {
+            LevelsProcessor processor;
+            processor.setMode (mode);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            juce::AudioBuffer<float> buffer (numChannels, blockSize);
+            MidiBuffer midiBuffer;
+            Random random (1234);
+
+            for (int c = 0; c < numChannels; ++c)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+
+            std::atomic<bool> finished { false };
+            std::thread reader;
+
+            // A reader that never lets up, which is far worse than any UI would be:
+            if (withReader)
+            {
+                reader = std::thread ([&]
+                {
+                    Array<float> levels;
+
+                    while (! finished.load())
+                        processor.getChannelLevels (levels);
+                });
+            }
+
+            double total = 0.0, worst = 0.0;
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                const auto startTicks = Time::getHighResolutionTicks();
+                processor.processBlock (buffer, midiBuffer);
+                const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+                total += seconds;
+                worst = jmax (worst, seconds);
+            }
+
+            finished = true;
+
+            if (reader.joinable())
+                reader.join();
+
+            logMessage (String (mode == LevelsProcessor::Mode::rms ? "RMS" : "Peak")
+                        + (withReader ? ", with a reader: " : ", on its own: ")
+                        + String (total / numBlocks * 1.0e9, 0) + " ns on average, "
+                        + String (worst * 1.0e6, 1) + " us at worst, out of "
+                        + String (blockSize / sampleRate * 1.0e6, 0) + " us per block");
+        };
+
+        for (const auto mode : { LevelsProcessor::Mode::peak, LevelsProcessor::Mode::rms })
+        {
+            measure (mode, false);
+            measure (mode, true);
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelsProcessorUnitTests)
+};
+
+#endif
@@ -0,0 +1,248 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class NoiseGeneratorUnitTests final : public UnitTest
+{
+public:
+    NoiseGeneratorUnitTests() :
+        UnitTest ("NoiseGenerator", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testLevels();
+        testDistributions();
+        testSpectra();
+        testStreams();
+        testHissing();
+    }
+
+private:
+    //==============================================================================
+    using Type = NoiseGenerator::Type;
+
+    static constexpr int numSamples = 1 << 18;
+
+    static String getTypeName (Type type)
+    {
+        switch (type)
+        {
+            case Type::white:       return "White";
+            case Type::pink:        return "Pink";
+            case Type::brown:       return "Brown";
+            case Type::gaussian:    return "Gaussian";
+        }
+
+        return {};
+    }
+
+    static std::vector<float> generate (Type type, uint32 seed = 1234, int blockSize = 512)
+    {
+        NoiseGenerator generator (type);
+        generator.setSeed (seed);
+
+        std::vector<float> samples ((size_t) numSamples);
+
+        for (int start = 0; start < numSamples; start += blockSize)
+            generator.process (samples.data() + start, jmin (blockSize, numSamples - start));
+
+        return samples;
+    }
+
+    /** @returns the central moments of the samples, from the mean up to the fourth. */
+    static std::array<double, 4> getMoments (const std::vector<float>& samples)
+    {
+        double mean = 0.0;
+
+        for (const auto sample : samples)
+            mean += sample;
+
+        mean /= (double) samples.size();
+
+        std::array<double, 4> moments { mean, 0.0, 0.0, 0.0 };
+
+        for (const auto sample : samples)
+        {
+            const auto difference = (double) sample - mean;
+            moments[1] += square (difference);
+            moments[2] += square (difference) * difference;
+            moments[3] += square (square (difference));
+        }
+
+        for (size_t i = 1; i < moments.size(); ++i)
+            moments[i] /= (double) samples.size();
+
+        return moments;
+    }
+
+    //==============================================================================
+    void testLevels()
+    {
+        beginTest ("Levels");
+
+        const auto expectedRMS = 1.0 / std::sqrt (3.0);
+
+        for (const auto type : { Type::white, Type::pink, Type::brown, Type::gaussian })
+        {
+            const auto moments = getMoments (generate (type));
+
+            // The coloured noise wanders about more, so its mean takes longer to settle:
+            expectWithinAbsoluteError (moments[0], 0.0, type == Type::white || type == Type::gaussian ? 0.01 : 0.05, getTypeName (type));
+            expectWithinAbsoluteError (std::sqrt (moments[1]) / expectedRMS, 1.0, 0.05, getTypeName (type));
+        }
+    }
+
+    void testDistributions()
+    {
+        beginTest ("Distributions");
+
+        {
+            const auto white = generate (Type::white);
+            expect (std::all_of (white.begin(), white.end(), [] (float s) { return s >= -1.0f && s < 1.0f; }));
+
+            // Uniform noise has an excess kurtosis of -1.2:
+            const auto moments = getMoments (white);
+            expectWithinAbsoluteError (moments[3] / square (moments[1]) - 3.0, -1.2, 0.02, "White");
+        }
+
+        {
+            const auto gaussian = generate (Type::gaussian);
+            expect (std::all_of (gaussian.begin(), gaussian.end(), [] (float s) { return s >= -2.0f && s < 2.0f; }));
+
+            // The sum of four uniform numbers is symmetric, with an excess kurtosis of -6 / 20:
+            const auto moments = getMoments (gaussian);
+            expectWithinAbsoluteError (moments[2] / std::pow (moments[1], 1.5), 0.0, 0.02, "Gaussian skew");
+            expectWithinAbsoluteError (moments[3] / square (moments[1]) - 3.0, -0.3, 0.03, "Gaussian kurtosis");
+        }
+    }
+
+    void testSpectra()
+    {
+        beginTest ("Spectra");
+
+        constexpr int order = 12;
+        constexpr int size = 1 << order;
+        constexpr double sampleRate = 48000.0;
+
+        dsp::FFT fft (order);
+        std::vector<float> window ((size_t) size);
+
+        for (size_t i = 0; i < window.size(); ++i)
+            window[i] = 0.5f - 0.5f * (float) std::cos (MathConstants<double>::twoPi * (double) i / size);
+
+        // The energy in an octave above the given frequency, averaged over the noise, in decibels:
+        const auto getOctaveLevels = [&] (const std::vector<float>& samples, double low, double high)
+        {
+            std::vector<double> power ((size_t) size / 2 + 1);
+            std::vector<float> data ((size_t) size * 2);
+
+            for (int start = 0; start + size <= (int) samples.size(); start += size / 2)
+            {
+                std::fill (data.begin(), data.end(), 0.0f);
+
+                for (int i = 0; i < size; ++i)
+                    data[(size_t) i] = samples[(size_t) (start + i)] * window[(size_t) i];
+
+                fft.performRealOnlyForwardTransform (data.data(), true);
+
+                for (size_t bin = 0; bin < power.size(); ++bin)
+                    power[bin] += square ((double) data[bin * 2]) + square ((double) data[bin * 2 + 1]);
+            }
+
+            const auto getOctaveLevel = [&] (double frequency)
+            {
+                double sum = 0.0;
+
+                for (auto bin = (size_t) (frequency * size / sampleRate); bin < (size_t) (frequency * 2.0 * size / sampleRate); ++bin)
+                    sum += power[bin];
+
+                return 10.0 * std::log10 (sum);
+            };
+
+            return getOctaveLevel (low) - getOctaveLevel (high);
+        };
+
+        // From the octave above 200 Hz to the one above 3.2 kHz, which is four octaves higher,
+        // white noise gains 3 dB per octave, pink holds steady, and brown loses 3 dB per octave:
+        expectWithinAbsoluteError (getOctaveLevels (generate (Type::white), 200.0, 3200.0), -12.0, 1.0, "White");
+        expectWithinAbsoluteError (getOctaveLevels (generate (Type::gaussian), 200.0, 3200.0), -12.0, 1.0, "Gaussian");
+        expectWithinAbsoluteError (getOctaveLevels (generate (Type::pink), 200.0, 3200.0), 0.0, 1.0, "Pink");
+        expectWithinAbsoluteError (getOctaveLevels (generate (Type::brown), 200.0, 3200.0), 12.0, 1.0, "Brown");
+    }
+
+    void testStreams()
+    {
+        beginTest ("Streams");
+
+        for (const auto type : { Type::white, Type::pink, Type::brown, Type::gaussian })
+        {
+            const auto first = generate (type, 1234, 512);
+
+            // The same seed gives the same noise, no matter how it's cut up into blocks:
+            expect (first == generate (type, 1234, 100), getTypeName (type) + " in different blocks");
+
+            // Neighbouring seeds give uncorrelated noise:
+            const auto second = generate (type, 1235, 512);
+            double sumOfProducts = 0.0, firstEnergy = 0.0, secondEnergy = 0.0;
+
+            for (size_t i = 0; i < first.size(); ++i)
+            {
+                sumOfProducts += (double) first[i] * (double) second[i];
+                firstEnergy += square ((double) first[i]);
+                secondEnergy += square ((double) second[i]);
+            }
+
+            // The coloured noise has fewer independent samples in it, so it has to be let off more:
+            const auto tolerance = type == Type::brown ? 0.1 : (type == Type::pink ? 0.05 : 0.01);
+            expectWithinAbsoluteError (sumOfProducts / std::sqrt (firstEnergy * secondEnergy), 0.0, tolerance,
+                                       getTypeName (type) + " with another seed");
+        }
+    }
+
+    void testHissing()
+    {
+        beginTest ("Hissing");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 480;
+        constexpr int numBlocks = (int) sampleRate * 30 / blockSize;
+
+        HissingProcessor processor;
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        MidiBuffer midiMessages;
+
+        int numHissingBlocks = 0;
+        float loudest = 0.0f;
+        bool channelsDiffer = false;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            buffer.clear();
+            processor.processBlock (buffer, midiMessages);
+
+            const auto magnitude = buffer.getMagnitude (0, blockSize);
+
+            if (magnitude > 0.0f)
+            {
+                ++numHissingBlocks;
+                loudest = jmax (loudest, magnitude);
+                channelsDiffer = channelsDiffer || buffer.getSample (0, 0) != buffer.getSample (1, 0);
+            }
+        }
+
+        // Hisses come around at least every 12 seconds or so:
+        expectGreaterThan (numHissingBlocks, 0);
+        expect (channelsDiffer, "The channels should hiss differently");
+
+        // The swell tops out at 0.65, and the noise peaks at 2 times 0.2 of that:
+        expectLessThan (loudest, 0.65f * 1.000025f * 0.2f * 2.0f);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoiseGeneratorUnitTests)
+};
+
+#endif
@@ -0,0 +1,228 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class OversamplerUnitTests final : public UnitTest
+{
+public:
+    OversamplerUnitTests() :
+        UnitTest ("Oversampler", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testPassband();
+        testAliasRejection();
+        testLatency();
+        testBlockSizes();
+    }
+
+private:
+    //==============================================================================
+    using FilterType = Oversampler::FilterType;
+
+    static constexpr int blockSize = 256;
+    static constexpr int numBlocks = 64;
+
+    /** Enough blocks for the filters to settle down before measuring anything. */
+    static constexpr int numSettlingBlocks = 16;
+
+    static std::vector<std::pair<int, FilterType>> getConfigurations()
+    {
+        std::vector<std::pair<int, FilterType>> configurations;
+
+        for (const auto type : { FilterType::linearPhase, FilterType::minimumPhase })
+            for (const auto factor : { 2, 4, 8 })
+                configurations.emplace_back (factor, type);
+
+        return configurations;
+    }
+
+    static String getName (int factor, FilterType type)
+    {
+        return String (factor) + "x " + (type == FilterType::linearPhase ? "linear phase" : "minimum phase");
+    }
+
+    /** @returns the RMS level of what comes out of the given number of blocks, after the settling ones.
+        The function gets called for every block at the original rate, then again at the higher rate.
+    */
+    template<typename GenerateFunction, typename ProcessFunction>
+    static double measure (Oversampler& oversampler, GenerateFunction&& generate, ProcessFunction&& process)
+    {
+        juce::AudioBuffer<float> buffer (1, blockSize);
+        double sum = 0.0;
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            generate (buffer);
+            oversampler.process (buffer, process);
+
+            if (i >= numSettlingBlocks)
+                for (int s = 0; s < blockSize; ++s)
+                    sum += square ((double) buffer.getSample (0, s));
+        }
+
+        return std::sqrt (sum / (double) ((numBlocks - numSettlingBlocks) * blockSize));
+    }
+
+    /** Fills buffers with one continuous sine, at a frequency relative to whatever rate the buffer is at. */
+    struct SineGenerator final
+    {
+        double frequency = 0.0, phase = 0.0;
+
+        void operator() (juce::AudioBuffer<float>& buffer) noexcept
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                buffer.setSample (0, i, (float) std::sin (phase));
+                phase += MathConstants<double>::twoPi * frequency;
+            }
+        }
+    };
+
+    //==============================================================================
+    void testPassband()
+    {
+        beginTest ("Passband");
+
+        for (const auto& configuration : getConfigurations())
+        {
+            for (const auto frequency : { 0.05, 0.2, 0.4, 0.45 })
+            {
+                Oversampler oversampler (configuration.first, configuration.second);
+                oversampler.prepare (1, blockSize);
+
+                SineGenerator sine { frequency };
+                const auto level = measure (oversampler, sine, [] (juce::AudioBuffer<float>&) {});
+
+                expectWithinAbsoluteError (level * MathConstants<double>::sqrt2, 1.0, 0.01,
+                                           getName (configuration.first, configuration.second) + " at " + String (frequency));
+            }
+        }
+    }
+
+    void testAliasRejection()
+    {
+        beginTest ("Alias rejection");
+
+        for (const auto& configuration : getConfigurations())
+        {
+            const auto factor = configuration.first;
+            auto worst = 0.0;
+
+            // Tones made at the higher rate, past the original Nyquist, which would fold back down into the passband:
+            for (auto frequency = 0.55; frequency < 0.5 * factor; frequency += 0.0173 * factor)
+            {
+                Oversampler oversampler (factor, configuration.second);
+                oversampler.prepare (1, blockSize);
+
+                SineGenerator sine { frequency / factor };
+                const auto level = measure (oversampler,
+                                            [] (juce::AudioBuffer<float>& b) { b.clear(); },
+                                            [&] (juce::AudioBuffer<float>& b) { sine (b); });
+
+                worst = jmax (worst, level * MathConstants<double>::sqrt2);
+            }
+
+            const auto decibels = Decibels::gainToDecibels (worst, -200.0);
+            logMessage (getName (factor, configuration.second) + ": worst alias at " + String (decibels, 1) + " dB");
+            expectLessThan (decibels, -80.0);
+        }
+    }
+
+    void testLatency()
+    {
+        beginTest ("Latency");
+
+        for (const auto& configuration : getConfigurations())
+        {
+            Oversampler oversampler (configuration.first, configuration.second);
+            oversampler.prepare (1, blockSize);
+
+            // The phase of a low sine, over a whole number of cycles, tells exactly how far behind it's running:
+            constexpr double frequency = 1.0 / 512.0;
+            SineGenerator sine { frequency };
+            juce::AudioBuffer<float> buffer (1, blockSize);
+            double real = 0.0, imaginary = 0.0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                const auto startPhase = sine.phase;
+                sine (buffer);
+                oversampler.process (buffer, [] (juce::AudioBuffer<float>&) {});
+
+                if (i >= numSettlingBlocks)
+                {
+                    for (int s = 0; s < blockSize; ++s)
+                    {
+                        const auto phase = startPhase + MathConstants<double>::twoPi * frequency * s;
+                        real += buffer.getSample (0, s) * std::sin (phase);
+                        imaginary += buffer.getSample (0, s) * std::cos (phase);
+                    }
+                }
+            }
+
+            const auto delay = -std::atan2 (imaginary, real) / (MathConstants<double>::twoPi * frequency);
+            const auto name = getName (configuration.first, configuration.second);
+            logMessage (name + ": " + String (oversampler.getLatencySamples()) + " samples of latency, measured at " + String (delay, 3));
+
+            // NB: The IIR filters' latency isn't a whole number of samples, so that gets rounded.
+            expectWithinAbsoluteError (delay, (double) oversampler.getLatencySamples(),
+                                       configuration.second == FilterType::linearPhase ? 1.0e-3 : 0.5, name);
+        }
+    }
+
+    void testBlockSizes()
+    {
+        beginTest ("Block sizes");
+
+        for (const auto& configuration : getConfigurations())
+        {
+            constexpr int numSamples = 4096;
+
+            const auto distort = [] (juce::AudioBuffer<float>& b)
+            {
+                for (int c = 0; c < b.getNumChannels(); ++c)
+                    DistortionFunctions::performHyperbolicTangentSoftClipping (b.getWritePointer (c), b.getNumSamples());
+            };
+
+            juce::AudioBuffer<float> expected (2, numSamples);
+            Random random (1234);
+
+            for (int c = 0; c < expected.getNumChannels(); ++c)
+                for (int i = 0; i < numSamples; ++i)
+                    expected.setSample (c, i, random.nextFloat() * 4.0f - 2.0f);
+
+            auto actual = expected;
+
+            Oversampler whole (configuration.first, configuration.second);
+            whole.prepare (2, numSamples);
+            whole.process (expected, distort);
+
+            // Odd sizes, some of which go past the prepared size, which should get split up:
+            Oversampler parts (configuration.first, configuration.second);
+            parts.prepare (2, 300);
+
+            for (int start = 0; start < numSamples;)
+            {
+                const auto numThisTime = jmin (numSamples - start, 1 + random.nextInt (700));
+                juce::AudioBuffer<float> block (actual.getArrayOfWritePointers(), 2, start, numThisTime);
+                parts.process (block, distort);
+                start += numThisTime;
+            }
+
+            float largestError = 0.0f;
+
+            for (int c = 0; c < expected.getNumChannels(); ++c)
+                for (int i = 0; i < numSamples; ++i)
+                    largestError = jmax (largestError, std::abs (actual.getSample (c, i) - expected.getSample (c, i)));
+
+            expectLessThan (largestError, 1.0e-5f, getName (configuration.first, configuration.second));
+        }
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OversamplerUnitTests)
+};
+
+#endif
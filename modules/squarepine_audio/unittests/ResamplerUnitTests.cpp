@@ -0,0 +1,415 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class ResamplerUnitTests final : public UnitTest
+{
+public:
+    ResamplerUnitTests() :
+        UnitTest ("Resampler", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testPassThrough();
+        testQuality();
+        testAliasing();
+        testSliding();
+        testFormatReader();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    static constexpr double sourceRate = 44100.0;
+    static constexpr double destRate = 48000.0;
+    static constexpr float amplitude = 0.5f;
+
+    struct Contender final
+    {
+        String name;
+        std::function<std::unique_ptr<Resampler>()> create;
+    };
+
+    static std::vector<Contender> getContenders()
+    {
+        using Quality = PolyphaseResampler::Quality;
+
+        return
+        {
+            { "Linear",                 [] { return std::make_unique<LinearResampler>(); } },
+            { "Lagrange",               [] { return std::make_unique<LagrangeResampler>(); } },
+            { "Windowed sinc",          [] { return std::make_unique<WindowedSincResampler>(); } },
+            { "Polyphase (low)",        [] { return std::make_unique<PolyphaseResampler> (Quality::low); } },
+            { "Polyphase (medium)",     [] { return std::make_unique<PolyphaseResampler> (Quality::medium); } },
+            { "Polyphase (high)",       [] { return std::make_unique<PolyphaseResampler> (Quality::high); } }
+        };
+    }
+
+    struct Measurement final
+    {
+        double gainDecibels = 0.0, thdnDecibels = 0.0;
+    };
+
+    /** Resamples a second of a sine, and fits a sine of the same frequency to the result.
+        Whatever the fit doesn't explain is noise and distortion.
+    */
+    static Measurement measureSine (Resampler& resampler, double frequency)
+    {
+        const auto ratio = sourceRate / destRate;
+        const auto numDestSamples = (int) destRate;
+        const auto numSourceSamples = (int) std::ceil (numDestSamples * ratio) + 8;
+
+        juce::AudioBuffer<float> source (1, numSourceSamples), dest (1, numDestSamples);
+
+        for (int i = 0; i < numSourceSamples; ++i)
+            source.setSample (0, i, amplitude * (float) std::sin (MathConstants<double>::twoPi * frequency * i / sourceRate));
+
+        resampler.prepare (1, sourceRate, numSourceSamples);
+        resampler.setRatio (sourceRate, destRate);
+        resampler.process (source, dest);
+
+        // Skipping the start, where the filters are still filling up:
+        constexpr int startSample = 2000;
+        const auto omega = MathConstants<double>::twoPi * frequency / destRate;
+        double sinSin = 0.0, cosCos = 0.0, sinCos = 0.0, ySin = 0.0, yCos = 0.0;
+
+        for (int i = startSample; i < numDestSamples; ++i)
+        {
+            const auto s = std::sin (omega * i), c = std::cos (omega * i);
+            const auto y = (double) dest.getSample (0, i);
+
+            sinSin += s * s;
+            cosCos += c * c;
+            sinCos += s * c;
+            ySin += y * s;
+            yCos += y * c;
+        }
+
+        const auto determinant = sinSin * cosCos - sinCos * sinCos;
+        const auto a = (ySin * cosCos - yCos * sinCos) / determinant;
+        const auto b = (yCos * sinSin - ySin * sinCos) / determinant;
+
+        double signalPower = 0.0, errorPower = 0.0;
+
+        for (int i = startSample; i < numDestSamples; ++i)
+        {
+            const auto fit = a * std::sin (omega * i) + b * std::cos (omega * i);
+            signalPower += fit * fit;
+            errorPower += square ((double) dest.getSample (0, i) - fit);
+        }
+
+        Measurement measurement;
+        measurement.gainDecibels = Decibels::gainToDecibels (std::sqrt (a * a + b * b) / amplitude, -200.0);
+        measurement.thdnDecibels = 10.0 * std::log10 (jmax (1.0e-30, errorPower / signalPower));
+        return measurement;
+    }
+
+    //==============================================================================
+    void testPassThrough()
+    {
+        beginTest ("Passing audio through at a ratio of 1");
+
+        PolyphaseResampler resampler;
+        resampler.prepare (2, sourceRate, 256);
+
+        juce::AudioBuffer<float> source (2, 256), dest (2, 256);
+        Random random (1234);
+
+        for (int c = 0; c < source.getNumChannels(); ++c)
+            for (int s = 0; s < source.getNumSamples(); ++s)
+                source.setSample (c, s, random.nextFloat() * 2.0f - 1.0f);
+
+        resampler.process (source, dest);
+        expectEquals (resampler.getNumSamplesConsumed(), 256);
+
+        // The audio must come out untouched, only late by the latency that filtering would have:
+        const auto latency = resampler.getLatencySamples();
+
+        for (int c = 0; c < source.getNumChannels(); ++c)
+        {
+            for (int s = 0; s < dest.getNumSamples(); ++s)
+            {
+                const auto expected = s >= latency ? source.getSample (c, s - latency) : 0.0f;
+                expectEquals (dest.getSample (c, s), expected);
+            }
+        }
+
+        // The other resamplers must not need to reallocate the destination either:
+        LagrangeResampler lagrange;
+        lagrange.prepare (2, sourceRate, 256);
+
+        const auto* destChannel = dest.getReadPointer (0);
+        lagrange.process (source, dest);
+        expect (dest.getReadPointer (0) == destChannel);
+        expectEquals (dest.getSample (1, 100), source.getSample (1, 100));
+    }
+
+    void testQuality()
+    {
+        beginTest ("THD+N and passband ripple, from 44.1 kHz to 48 kHz");
+
+        const Array<double> passbandFrequencies { 100.0, 1000.0, 5000.0, 10000.0, 15000.0, 18000.0 };
+
+        for (const auto& contender : getContenders())
+        {
+            auto resampler = contender.create();
+            const auto thdn = measureSine (*resampler, 1000.0).thdnDecibels;
+
+            auto minGain = std::numeric_limits<double>::max();
+            auto maxGain = std::numeric_limits<double>::lowest();
+
+            for (const auto frequency : passbandFrequencies)
+            {
+                resampler = contender.create();
+                const auto gain = measureSine (*resampler, frequency).gainDecibels;
+                minGain = jmin (minGain, gain);
+                maxGain = jmax (maxGain, gain);
+            }
+
+            logMessage (contender.name + ": THD+N at 1 kHz is " + String (thdn, 1)
+                        + " dB, passband ripple up to 18 kHz is " + String (maxGain - minGain, 4) + " dB");
+
+            if (auto* polyphase = dynamic_cast<PolyphaseResampler*> (resampler.get()))
+            {
+                if (polyphase->getQuality() == PolyphaseResampler::Quality::high)
+                {
+                    expectLessThan (thdn, -100.0);
+                    expectLessThan (maxGain - minGain, 0.01);
+                }
+                else if (polyphase->getQuality() == PolyphaseResampler::Quality::medium)
+                {
+                    expectLessThan (thdn, -85.0);
+                    expectLessThan (maxGain - minGain, 0.5);
+                }
+            }
+        }
+    }
+
+    void testAliasing()
+    {
+        beginTest ("Aliasing, from 96 kHz to 48 kHz");
+
+        PolyphaseResampler resampler;
+        resampler.prepare (1, 96000.0, 48000);
+        resampler.setRatio (2.0);
+
+        // A 30 kHz sine has no place at 48 kHz, and mustn't fold back down to 18 kHz:
+        juce::AudioBuffer<float> source (1, 48016), dest (1, 24000);
+
+        for (int i = 0; i < source.getNumSamples(); ++i)
+            source.setSample (0, i, amplitude * (float) std::sin (MathConstants<double>::twoPi * 30000.0 * i / 96000.0));
+
+        resampler.process (source, dest);
+
+        const auto level = dest.getRMSLevel (0, 1000, dest.getNumSamples() - 1000) / (amplitude * MathConstants<float>::sqrt2 * 0.5f);
+        expectLessThan (Decibels::gainToDecibels (level), -100.0f);
+    }
+
+    void testSliding()
+    {
+        beginTest ("Sliding between ratios");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr double frequency = 500.0;
+
+        PolyphaseResampler resampler;
+        resampler.prepare (1, sampleRate, 1024);
+        resampler.setTargetRatio (1.5, 20000);
+
+        juce::AudioBuffer<float> source (1, 1024), dest (1, 1024);
+        int64 sourcePosition = 0;
+        int numMismatches = 0;
+        float previous = 0.0f, secondPrevious = 0.0f, largestChange = 0.0f;
+
+        for (int block = 0; block < 200; ++block)
+        {
+            // Pulling exactly as much source as asked for, in blocks of all sorts of sizes:
+            const auto numDestSamples = 64 + (block * 37) % 500;
+            const auto numSourceSamples = resampler.getNumSamplesNeeded (numDestSamples);
+
+            source.setSize (1, numSourceSamples, false, false, true);
+            dest.setSize (1, numDestSamples, false, false, true);
+
+            for (int i = 0; i < numSourceSamples; ++i)
+                source.setSample (0, i, amplitude * (float) std::sin (MathConstants<double>::twoPi * frequency * (double) (sourcePosition + i) / sampleRate));
+
+            resampler.process (source, dest);
+
+            if (resampler.getNumSamplesConsumed() != numSourceSamples)
+                ++numMismatches;
+
+            sourcePosition += numSourceSamples;
+
+            // A sine has no sudden changes in its slope, so any jump in the ratio would show up here:
+            for (int i = 0; i < numDestSamples; ++i)
+            {
+                const auto sample = dest.getSample (0, i);
+
+                if (block > 0)
+                    largestChange = jmax (largestChange, std::abs (sample - 2.0f * previous + secondPrevious));
+
+                secondPrevious = previous;
+                previous = sample;
+            }
+
+            if (block == 100)
+                resampler.setTargetRatio (0.75, 5000);
+        }
+
+        expectEquals (numMismatches, 0);
+        expectEquals (resampler.getCurrentRatio(), 0.75);
+
+        // The change of slope of the fastest sine that came out, with some room for the filter's ripple:
+        const auto fastestOmega = MathConstants<double>::twoPi * frequency * 1.5 / sampleRate;
+        expectLessThan ((double) largestChange, square (fastestOmega) * amplitude * 1.05);
+
+        // Sliding to the ratio it's already at does nothing, so a jump after that still jumps:
+        resampler.setTargetRatio (0.75, 5000);
+        resampler.setRatio (2.0);
+
+        source.setSize (1, resampler.getNumSamplesNeeded (64), false, false, true);
+        dest.setSize (1, 64, false, false, true);
+        resampler.process (source, dest);
+
+        expectEquals (resampler.getCurrentRatio(), 2.0);
+    }
+
+    //==============================================================================
+    /** A reader of sines at a different frequency on each channel, which can be read from anywhere. */
+    class SineReader final : public AudioFormatReader
+    {
+    public:
+        SineReader() :
+            AudioFormatReader (nullptr, "Sine")
+        {
+            sampleRate = sourceRate;
+            bitsPerSample = 32;
+            lengthInSamples = (int64) sourceRate * 10;
+            numChannels = 2;
+            usesFloatingPointData = true;
+        }
+
+        static double getFrequency (int channel) noexcept { return channel == 0 ? 1000.0 : 3000.0; }
+
+        bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                          int64 startSampleInFile, int numSamples) override
+        {
+            for (int i = 0; i < numDestChannels; ++i)
+            {
+                if (auto* dest = reinterpret_cast<float*> (destSamples[i]))
+                {
+                    for (int s = 0; s < numSamples; ++s)
+                    {
+                        const auto position = startSampleInFile + s;
+                        dest[startOffsetInDestBuffer + s] = isPositiveAndBelow (position, lengthInSamples)
+                            ? amplitude * (float) std::sin (MathConstants<double>::twoPi * getFrequency (i) * (double) position / sourceRate)
+                            : 0.0f;
+                    }
+                }
+            }
+
+            return true;
+        }
+    };
+
+    void testFormatReader()
+    {
+        beginTest ("Reading from anywhere with a ResamplingAudioFormatReader");
+
+        constexpr int numChannels = 2;
+        constexpr int numSamples = 20000;
+        constexpr int64 startSample = 5000;
+
+        ResamplingAudioFormatReader reader (std::make_shared<SineReader>(), 1024, destRate);
+        expectEquals (reader.lengthInSamples, (int64) destRate * 10);
+
+        juce::AudioBuffer<float> inOneGo (numChannels, numSamples), inPieces (numChannels, numSamples);
+        reader.read (&inOneGo, 0, numSamples, startSample, true, true);
+
+        // Reading the same samples in pieces of all sorts of sizes, in any order, must give exactly the same result:
+        Array<Range<int>> pieces;
+        Random random (1234);
+
+        for (int position = 0; position < numSamples;)
+        {
+            const auto length = jmin (numSamples - position, 1 + random.nextInt (3000));
+            pieces.add ({ position, position + length });
+            position += length;
+        }
+
+        for (int i = pieces.size(); --i > 0;)
+            pieces.swap (i, random.nextInt (i + 1));
+
+        for (const auto& piece : pieces)
+            reader.read (&inPieces, piece.getStart(), piece.getLength(), startSample + piece.getStart(), true, true);
+
+        int numMismatches = 0;
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int s = 0; s < numSamples; ++s)
+                if (inOneGo.getSample (c, s) != inPieces.getSample (c, s))
+                    ++numMismatches;
+
+        expectEquals (numMismatches, 0);
+
+        // And the samples must be those of the same sines at the new rate, with no delay:
+        for (int c = 0; c < numChannels; ++c)
+        {
+            double signalPower = 0.0, errorPower = 0.0;
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                const auto expected = amplitude * std::sin (MathConstants<double>::twoPi * SineReader::getFrequency (c) * (double) (startSample + s) / destRate);
+                signalPower += square (expected);
+                errorPower += square ((double) inOneGo.getSample (c, s) - expected);
+            }
+
+            expectLessThan (10.0 * std::log10 (errorPower / signalPower), -100.0);
+        }
+    }
+
+    //==============================================================================
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance with 32 channels");
+
+        constexpr int numChannels = 32;
+        constexpr int blockSize = 512;
+        constexpr int numBlocks = 1000;
+
+        const auto ratio = sourceRate / destRate;
+        juce::AudioBuffer<float> source (numChannels, (int) std::ceil (blockSize * ratio) + 1), dest (numChannels, blockSize);
+        Random random (1234);
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int s = 0; s < source.getNumSamples(); ++s)
+                source.setSample (c, s, random.nextFloat() * 2.0f - 1.0f);
+
+        for (const auto& contender : getContenders())
+        {
+            auto resampler = contender.create();
+            resampler->prepare (numChannels, sourceRate, blockSize);
+            resampler->setRatio (sourceRate, destRate);
+
+            const auto startTicks = Time::getHighResolutionTicks();
+
+            for (int i = 0; i < numBlocks; ++i)
+                resampler->process (source, dest);
+
+            const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+            const auto audioSeconds = (double) (numBlocks * blockSize) / destRate;
+
+            logMessage (contender.name + ": " + String (audioSeconds / seconds, 1) + "x faster than realtime");
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplerUnitTests)
+};
+
+#endif
@@ -0,0 +1,408 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class SimpleEQUnitTests final : public UnitTest
+{
+public:
+    SimpleEQUnitTests() :
+        UnitTest ("SimpleEQ", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testCoefficients();
+        testCascade();
+        testGliding();
+        testStability();
+        testProcessor();
+    }
+
+private:
+    //==============================================================================
+    static constexpr double sampleRate = 48000.0;
+
+    /** The processor's five bands, with a bit of everything going on. */
+    static std::vector<BiquadCoefficients> createBands()
+    {
+        return
+        {
+            BiquadCoefficients::makeLowShelf (sampleRate, 80.0, 0.7, 2.0),
+            BiquadCoefficients::makePeakFilter (sampleRate, 250.0, 1.5, 0.5),
+            BiquadCoefficients::makePeakFilter (sampleRate, 1000.0, 4.0, 3.0),
+            BiquadCoefficients::makePeakFilter (sampleRate, 4000.0, 0.5, 0.25),
+            BiquadCoefficients::makeHighShelf (sampleRate, 10000.0, 0.7, 1.5)
+        };
+    }
+
+    static void fillWithNoise (juce::AudioBuffer<float>& buffer, Random& random)
+    {
+        for (int c = 0; c < buffer.getNumChannels(); ++c)
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                buffer.setSample (c, i, random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    /** Runs a channel through the stages one sample at a time, in double precision. */
+    static void filterReference (const std::vector<BiquadCoefficients>& stages, double* samples, int numSamples)
+    {
+        std::vector<double> z1 (stages.size()), z2 (stages.size());
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto x = samples[i];
+
+            for (size_t s = 0; s < stages.size(); ++s)
+            {
+                const auto& k = stages[s];
+                const auto y = k.b0 * x + z1[s];
+                z1[s] = k.b1 * x - k.a1 * y + z2[s];
+                z2[s] = k.b2 * x - k.a2 * y;
+                x = y;
+            }
+
+            samples[i] = x;
+        }
+    }
+
+    static float getPeakOfSine (AudioProcessor& processor, double frequency, int numSamples)
+    {
+        juce::AudioBuffer<float> buffer (2, numSamples);
+        MidiBuffer midiMessages;
+
+        for (int c = 0; c < 2; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                buffer.setSample (c, i, 0.25f * (float) std::sin (MathConstants<double>::twoPi * frequency * i / sampleRate));
+
+        processor.processBlock (buffer, midiMessages);
+
+        // Skipping over the first half, while the filters settle:
+        return buffer.getMagnitude (0, numSamples / 2, numSamples / 2) / 0.25f;
+    }
+
+    static void setParameter (AudioProcessor& processor, const String& parameterID, float value)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* p = dynamic_cast<AudioParameterFloat*> (parameter))
+                if (p->paramID == parameterID)
+                    p->operator= (value);
+    }
+
+    //==============================================================================
+    void testCoefficients()
+    {
+        beginTest ("Coefficients");
+
+        using JuceCoefficients = dsp::IIR::Coefficients<double>;
+
+        const auto expectSame = [this] (const BiquadCoefficients& ours, const JuceCoefficients::Ptr& theirs, const String& name)
+        {
+            const auto* values = theirs->coefficients.begin();
+
+            expectWithinAbsoluteError (ours.b0, values[0], 1.0e-12, name);
+            expectWithinAbsoluteError (ours.b1, values[1], 1.0e-12, name);
+            expectWithinAbsoluteError (ours.b2, values[2], 1.0e-12, name);
+            expectWithinAbsoluteError (ours.a1, values[3], 1.0e-12, name);
+            expectWithinAbsoluteError (ours.a2, values[4], 1.0e-12, name);
+        };
+
+        for (const auto frequency : { 30.0, 440.0, 9000.0 })
+        {
+            for (const auto gainFactor : { 0.1, 1.0, MathConstants<double>::pi })
+            {
+                const auto name = String (frequency) + " Hz, gain factor of " + String (gainFactor);
+
+                const auto peak = BiquadCoefficients::makePeakFilter (sampleRate, frequency, 2.0, gainFactor);
+                const auto lowShelf = BiquadCoefficients::makeLowShelf (sampleRate, frequency, 0.7, gainFactor);
+                const auto highShelf = BiquadCoefficients::makeHighShelf (sampleRate, frequency, 0.7, gainFactor);
+
+                expectSame (peak, JuceCoefficients::makePeakFilter (sampleRate, frequency, 2.0, gainFactor), "Peak at " + name);
+                expectSame (lowShelf, JuceCoefficients::makeLowShelf (sampleRate, frequency, 0.7, gainFactor), "Low shelf at " + name);
+                expectSame (highShelf, JuceCoefficients::makeHighShelf (sampleRate, frequency, 0.7, gainFactor), "High shelf at " + name);
+
+                expectWithinAbsoluteError (peak.getMagnitudeForFrequency (frequency, sampleRate), gainFactor, 1.0e-9, "Peak at " + name);
+                expectWithinAbsoluteError (lowShelf.getMagnitudeForFrequency (0.0, sampleRate), gainFactor, 1.0e-9, "Low shelf at " + name);
+                expectWithinAbsoluteError (highShelf.getMagnitudeForFrequency (sampleRate / 2.0, sampleRate), gainFactor, 1.0e-9, "High shelf at " + name);
+            }
+        }
+
+        // A gain factor of 0 should make a deep notch, instead of a filter full of NaNs:
+        const auto notch = BiquadCoefficients::makePeakFilter (sampleRate, 1000.0, 1.0, 0.0);
+        expect (std::isfinite (notch.b0) && std::isfinite (notch.a1) && std::isfinite (notch.a2));
+        expectLessThan (notch.getMagnitudeForFrequency (1000.0, sampleRate), 1.0e-5);
+    }
+
+    void testCascade()
+    {
+        beginTest ("Cascade");
+
+        Random random (1234);
+
+        // NB: In double precision, this should only be off by rounding; in single, the coefficients get rounded too.
+        for (const auto numChannels : { 1, 2, 3, 4, 5, 8, 11 })
+        {
+            checkCascade<double> (random, numChannels, 1.0e-9);
+            checkCascade<float> (random, numChannels, 1.0e-3);
+        }
+    }
+
+    template<typename SampleType>
+    void checkCascade (Random& random, int numChannels, double tolerance)
+    {
+        constexpr int numSamples = 8192;
+
+        const auto stages = createBands();
+
+        juce::AudioBuffer<float> noise (numChannels, numSamples);
+        fillWithNoise (noise, random);
+
+        juce::AudioBuffer<SampleType> buffer (numChannels, numSamples);
+        juce::AudioBuffer<double> expected (numChannels, numSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                buffer.setSample (c, i, (SampleType) noise.getSample (c, i));
+                expected.setSample (c, i, (double) noise.getSample (c, i));
+            }
+
+            filterReference (stages, expected.getWritePointer (c), numSamples);
+        }
+
+        BiquadCascade<SampleType> cascade;
+
+        for (size_t s = 0; s < stages.size(); ++s)
+            cascade.setCoefficients ((int) s, stages[s]);
+
+        // NB: Preparing jumps straight to the coefficients, so there's no glide to get in the way here.
+        cascade.prepare (sampleRate, (int) stages.size(), numChannels);
+
+        // Odd sized blocks, which end part of the way through the sub-blocks:
+        for (int start = 0; start < numSamples;)
+        {
+            const auto num = jmin (numSamples - start, 1 + random.nextInt (700));
+
+            std::vector<SampleType*> channels;
+
+            for (int c = 0; c < numChannels; ++c)
+                channels.push_back (buffer.getWritePointer (c, start));
+
+            cascade.process (channels.data(), numChannels, num);
+            start += num;
+        }
+
+        double largestError = 0.0;
+
+        for (int c = 0; c < numChannels; ++c)
+            for (int i = 0; i < numSamples; ++i)
+                largestError = jmax (largestError, std::abs ((double) buffer.getSample (c, i) - expected.getSample (c, i)));
+
+        expectLessThan (largestError, tolerance, String (numChannels) + (sizeof (SampleType) == sizeof (float) ? " channels, single precision" : " channels, double precision"));
+    }
+
+    void testGliding()
+    {
+        beginTest ("Gliding");
+
+        constexpr double frequency = 1000.0;
+        constexpr int numSamples = (int) sampleRate / 10;
+
+        BiquadCascade<double> cascade;
+        cascade.setCoefficients (0, BiquadCoefficients::makePeakFilter (sampleRate, frequency, 1.0, 1.0));
+        cascade.prepare (sampleRate, 1, 1);
+
+        std::vector<double> samples ((size_t) numSamples);
+
+        for (size_t i = 0; i < samples.size(); ++i)
+            samples[i] = std::sin (MathConstants<double>::twoPi * frequency * (double) i / sampleRate);
+
+        // Boosting the sine from a gain of 1 up to 2, a quarter of the way in:
+        constexpr int changeAt = numSamples / 4;
+        auto* channel = samples.data();
+
+        cascade.process (&channel, 1, changeAt);
+        cascade.setCoefficients (0, BiquadCoefficients::makePeakFilter (sampleRate, frequency, 1.0, 2.0));
+
+        channel += changeAt;
+        cascade.process (&channel, 1, numSamples - changeAt);
+
+        const auto getLevelAround = [&] (double ms)
+        {
+            const auto start = changeAt + (int) (ms * 0.001 * sampleRate);
+            double peak = 0.0;
+
+            for (int i = start; i < start + (int) (sampleRate / frequency); ++i)
+                peak = jmax (peak, std::abs (samples[(size_t) i]));
+
+            return peak;
+        };
+
+        // The level should ease up to its new one over the glide, instead of jumping:
+        const auto quarterOfTheWay = getLevelAround (5.0);
+        expectGreaterThan (quarterOfTheWay, 1.05);
+        expectLessThan (quarterOfTheWay, 1.6);
+        expectWithinAbsoluteError (getLevelAround (40.0), 2.0, 0.01);
+
+        double largestStep = 0.0;
+
+        for (size_t i = 1; i < samples.size(); ++i)
+            largestStep = jmax (largestStep, std::abs (samples[i] - samples[i - 1]));
+
+        // Which is no steeper than the loudest the sine ever gets:
+        expectLessThan (largestStep, 2.0 * MathConstants<double>::twoPi * frequency / sampleRate * 1.05);
+
+        // The glide takes as long no matter how the host splits up the audio:
+        const auto glideInBlocksOf = [&] (int blockSize)
+        {
+            BiquadCascade<double> splitCascade;
+            splitCascade.setCoefficients (0, BiquadCoefficients::makePeakFilter (sampleRate, frequency, 1.0, 1.0));
+            splitCascade.prepare (sampleRate, 1, 1);
+            splitCascade.setCoefficients (0, BiquadCoefficients::makePeakFilter (sampleRate, frequency, 1.0, 2.0));
+
+            std::vector<double> output ((size_t) numSamples);
+
+            for (size_t i = 0; i < output.size(); ++i)
+                output[i] = std::sin (MathConstants<double>::twoPi * frequency * (double) i / sampleRate);
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                auto* block = output.data() + start;
+                splitCascade.process (&block, 1, jmin (blockSize, numSamples - start));
+            }
+
+            return output;
+        };
+
+        const auto inWholeSubBlocks = glideInBlocksOf (BiquadCascade<double>::subBlockSize * 4);
+
+        for (const auto blockSize : { 1, 7, 33 })
+        {
+            const auto inOtherBlocks = glideInBlocksOf (blockSize);
+            double largestDifference = 0.0;
+
+            for (size_t i = 0; i < inOtherBlocks.size(); ++i)
+                largestDifference = jmax (largestDifference, std::abs (inOtherBlocks[i] - inWholeSubBlocks[i]));
+
+            // NB: Not exactly the same, since the filters' state gets snapped to zero at the end of every block.
+            expectLessThan (largestDifference, 1.0e-6, "Blocks of " + String (blockSize));
+        }
+    }
+
+    void testStability()
+    {
+        beginTest ("Stability");
+
+        Random random (1234);
+
+        constexpr int numChannels = 2;
+        constexpr int blockSize = 64;
+        constexpr int numBlocks = (int) sampleRate * 10 / blockSize;
+
+        BiquadCascade<float> cascade;
+        cascade.prepare (sampleRate, 5, numChannels);
+
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        float loudest = 0.0f;
+        bool allFinite = true;
+
+        // Throwing every stage somewhere new every block, so that they never stop gliding:
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int s = 0; s < 5; ++s)
+            {
+                const auto frequency = 20.0 * std::pow (1000.0, random.nextDouble());
+                const auto q = 0.1 + random.nextDouble() * 9.9;
+                const auto gainFactor = random.nextDouble() * MathConstants<double>::pi;
+
+                switch (s)
+                {
+                    case 0:     cascade.setCoefficients (s, BiquadCoefficients::makeLowShelf (sampleRate, frequency, q, gainFactor)); break;
+                    case 4:     cascade.setCoefficients (s, BiquadCoefficients::makeHighShelf (sampleRate, frequency, q, gainFactor)); break;
+                    default:    cascade.setCoefficients (s, BiquadCoefficients::makePeakFilter (sampleRate, frequency, q, gainFactor)); break;
+                }
+            }
+
+            fillWithNoise (buffer, random);
+            cascade.process (buffer.getArrayOfWritePointers(), numChannels, blockSize);
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const auto sample = buffer.getSample (c, i);
+                    allFinite = allFinite && std::isfinite (sample);
+                    loudest = jmax (loudest, std::abs (sample));
+                }
+            }
+        }
+
+        expect (allFinite);
+
+        // Five stages of up to a gain factor of pi each, with a bit of room for some overshoot:
+        expectLessThan (loudest, std::pow (MathConstants<float>::pi, 5.0f) * 2.0f);
+    }
+
+    void testProcessor()
+    {
+        beginTest ("Processor");
+
+        constexpr int numSamples = (int) sampleRate;
+
+        {
+            SimpleEQProcessor processor;
+            processor.prepareToPlay (sampleRate, numSamples);
+
+            // Every band starts off flat:
+            for (const auto frequency : { 20.0, 1000.0, 15000.0 })
+                expectWithinAbsoluteError (getPeakOfSine (processor, frequency, numSamples), 1.0, 0.001, String (frequency) + " Hz");
+
+            // The same, in double precision:
+            juce::AudioBuffer<double> buffer (2, 512);
+            MidiBuffer midiMessages;
+
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < 512; ++i)
+                    buffer.setSample (c, i, std::sin (i * 0.1));
+
+            juce::AudioBuffer<double> original (buffer);
+            processor.processBlock (buffer, midiMessages);
+
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < 512; ++i)
+                    expectWithinAbsoluteError (buffer.getSample (c, i), original.getSample (c, i), 1.0e-9);
+        }
+
+        // The shelves should shelve at the ends they're named after:
+        {
+            SimpleEQProcessor processor;
+            setParameter (processor, "gainLowShelf", 2.0f);
+            processor.prepareToPlay (sampleRate, numSamples);
+
+            expectWithinAbsoluteError (getPeakOfSine (processor, 5.0, numSamples), 2.0, 0.05, "Low shelf, low down");
+            expectWithinAbsoluteError (getPeakOfSine (processor, 5000.0, numSamples), 1.0, 0.01, "Low shelf, high up");
+        }
+
+        {
+            SimpleEQProcessor processor;
+            setParameter (processor, "gainHighShelf", 2.0f);
+            processor.prepareToPlay (sampleRate, numSamples);
+
+            expectWithinAbsoluteError (getPeakOfSine (processor, 100.0, numSamples), 1.0, 0.01, "High shelf, low down");
+            expectWithinAbsoluteError (getPeakOfSine (processor, 20000.0, numSamples), 2.0, 0.05, "High shelf, high up");
+        }
+
+        // Changing a band while playing should glide over to it:
+        {
+            SimpleEQProcessor processor;
+            processor.prepareToPlay (sampleRate, numSamples);
+
+            setParameter (processor, "gainBandPass2", 2.0f);
+            expectWithinAbsoluteError (getPeakOfSine (processor, MidiMessage::getMidiNoteInHertz (60), numSamples), 2.0, 0.01, "Boosted");
+        }
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQUnitTests)
+};
+
+#endif
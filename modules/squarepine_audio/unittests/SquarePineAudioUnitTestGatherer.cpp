@@ -0,0 +1,25 @@
+//==============================================================================
+OwnedArray<UnitTest> SquarePineAudioUnitTestGatherer::createTests()
+{
+    OwnedArray<UnitTest> tests;
+
+   #if SQUAREPINE_COMPILE_UNIT_TESTS
+    tests.add (new AudioBufferFIFOUnitTests());
+    tests.add (new BitCrusherUnitTests());
+    tests.add (new BroadcastAudioRingUnitTests());
+    tests.add (new ConvolutionUnitTests());
+    tests.add (new DistortionFunctionsUnitTests());
+    tests.add (new DitherUnitTests());
+    tests.add (new DynamicsUnitTests());
+    tests.add (new EffectProcessorChainUnitTests());
+    tests.add (new LevelsProcessorUnitTests());
+    tests.add (new LFOUnitTests());
+    tests.add (new NoiseGeneratorUnitTests());
+    tests.add (new OversamplerUnitTests());
+    tests.add (new ResamplerUnitTests());
+    tests.add (new SimpleEQUnitTests());
+    tests.add (new StretcherUnitTests());
+   #endif
+
+    return tests;
+}
@@ -0,0 +1,205 @@
+#if SQUAREPINE_COMPILE_UNIT_TESTS
+
+//==============================================================================
+class StretcherUnitTests final : public UnitTest
+{
+public:
+    StretcherUnitTests() :
+        UnitTest ("Stretcher", UnitTestCategories::audio)
+    {
+    }
+
+    void runTest() override
+    {
+        testLength();
+        testPitch();
+        testExtremes();
+       #if SQUAREPINE_COMPILE_BENCHMARKS
+        testPerformance();
+       #endif
+    }
+
+private:
+    //==============================================================================
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blockSize = 512;
+    static constexpr double frequency = 440.0;
+    static constexpr float amplitude = 0.5f;
+
+    /** Stretches a couple of seconds of a sine, including whatever remains at the end. */
+    static std::vector<float> stretchSine (double stretch, double pitch, int64& numInputSamples)
+    {
+        WsolaStretcher stretcher (2, sampleRate, blockSize, stretch, pitch);
+        juce::AudioBuffer<float> buffer (2, stretcher.getMaxInputLength() + blockSize);
+        std::vector<float> output;
+
+        const auto totalInputSamples = (int64) sampleRate * 2;
+        numInputSamples = 0;
+
+        while (numInputSamples < totalInputSamples)
+        {
+            const auto numInput = stretcher.getInputLength();
+
+            for (int c = 0; c < buffer.getNumChannels(); ++c)
+                for (int s = 0; s < numInput; ++s)
+                    buffer.setSample (c, s, amplitude * (float) std::sin (MathConstants<double>::twoPi * frequency * (double) (numInputSamples + s) / sampleRate));
+
+            stretcher.process (buffer);
+            numInputSamples += numInput;
+
+            output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+        }
+
+        for (int numRemaining; (numRemaining = stretcher.getRemainingSamples (buffer)) > 0;)
+            output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + numRemaining);
+
+        return output;
+    }
+
+    /** Counts the upward zero crossings of the middle half, away from the edges. */
+    static double measureFrequency (const std::vector<float>& samples)
+    {
+        const auto start = samples.size() / 4, end = samples.size() * 3 / 4;
+        int64 firstCrossing = -1, lastCrossing = -1;
+        int numCrossings = 0;
+
+        for (auto i = start + 1; i < end; ++i)
+        {
+            if (samples[i - 1] < 0.0f && samples[i] >= 0.0f)
+            {
+                if (firstCrossing < 0)
+                    firstCrossing = (int64) i;
+
+                lastCrossing = (int64) i;
+                ++numCrossings;
+            }
+        }
+
+        if (numCrossings < 2)
+            return 0.0;
+
+        return (double) (numCrossings - 1) * sampleRate / (double) (lastCrossing - firstCrossing);
+    }
+
+    /** @returns the largest jump between neighbouring samples of the middle half. */
+    static float measureLargestStep (const std::vector<float>& samples)
+    {
+        float largest = 0.0f;
+
+        for (auto i = samples.size() / 4 + 1; i < samples.size() * 3 / 4; ++i)
+            largest = jmax (largest, std::abs (samples[i] - samples[i - 1]));
+
+        return largest;
+    }
+
+    //==============================================================================
+    void testLength()
+    {
+        beginTest ("Output length follows the stretch");
+
+        for (const auto pitch : { 1.0, 1.5 })
+        {
+            for (const auto stretch : { 0.5, 1.0, 1.5, 2.0 })
+            {
+                int64 numInputSamples = 0;
+                const auto output = stretchSine (stretch, pitch, numInputSamples);
+                const auto expectedLength = (double) numInputSamples * stretch;
+
+                expectWithinAbsoluteError ((double) output.size(), expectedLength, 2.0,
+                                           "Stretch: " + String (stretch) + ", pitch: " + String (pitch));
+
+                // A sine that's been lined up properly never moves by more than its steepest slope:
+                const auto steepestSlope = amplitude * (float) (MathConstants<double>::twoPi * frequency * pitch / sampleRate);
+                expectLessThan (measureLargestStep (output), steepestSlope * 1.05f);
+            }
+        }
+    }
+
+    void testPitch()
+    {
+        beginTest ("Pitch is kept, or shifted");
+
+        for (const auto pitch : { 1.0, 1.5 })
+        {
+            int64 numInputSamples = 0;
+            const auto output = stretchSine (2.0, pitch, numInputSamples);
+
+            expectWithinAbsoluteError (measureFrequency (output), frequency * pitch, 1.0);
+        }
+    }
+
+    void testExtremes()
+    {
+        beginTest ("Extremes of the stretch and pitch");
+
+        const std::pair<double, double> factors[] =
+        {
+            { 0.1, 1.0 }, { 10.0, 1.0 }, { 1.0, 0.1 }, { 1.0, 10.0 },
+            { 0.1, 10.0 }, { 10.0, 0.1 }, { 0.1, 0.1 }, { 10.0, 10.0 }
+        };
+
+        Random random (1234);
+
+        for (const auto& f : factors)
+        {
+            WsolaStretcher stretcher (2, sampleRate, blockSize, f.first, f.second);
+            juce::AudioBuffer<float> buffer (2, stretcher.getMaxInputLength() + blockSize);
+
+            for (int i = 0; i < 400; ++i)
+            {
+                // Changing the output length as well, which may never need more than the maximum input:
+                const auto numInput = stretcher.getInputLength (1 + random.nextInt (blockSize));
+                expect (numInput <= stretcher.getMaxInputLength());
+
+                for (int c = 0; c < buffer.getNumChannels(); ++c)
+                    for (int s = 0; s < numInput; ++s)
+                        buffer.setSample (c, s, random.nextFloat() * 2.0f - 1.0f);
+
+                stretcher.process (buffer);
+
+                if (i == 200)
+                    stretcher.setStretchAndPitch (f.second, f.first, true);
+            }
+        }
+    }
+
+   #if SQUAREPINE_COMPILE_BENCHMARKS
+    void testPerformance()
+    {
+        beginTest ("Performance");
+
+        constexpr int numBlocks = 1000;
+        Random random (1234);
+
+        for (const auto numChannels : { 2, 8 })
+        {
+            for (const auto stretch : { 0.5, 0.8, 1.0, 1.25, 2.0 })
+            {
+                WsolaStretcher stretcher (numChannels, sampleRate, blockSize, stretch);
+                juce::AudioBuffer<float> buffer (numChannels, stretcher.getMaxInputLength() + blockSize);
+
+                for (int c = 0; c < numChannels; ++c)
+                    for (int s = 0; s < buffer.getNumSamples(); ++s)
+                        buffer.setSample (c, s, random.nextFloat() * 2.0f - 1.0f);
+
+                const auto startTicks = Time::getHighResolutionTicks();
+
+                for (int i = 0; i < numBlocks; ++i)
+                    stretcher.process (buffer);
+
+                const auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+                const auto audioSeconds = (double) (numBlocks * blockSize) / sampleRate;
+                const auto cpuPerChannel = 100.0 * seconds / (audioSeconds * numChannels);
+
+                logMessage (String (numChannels) + " channels, stretched by " + String (stretch)
+                            + ": " + String (cpuPerChannel, 3) + "% CPU per channel");
+            }
+        }
+    }
+   #endif
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StretcherUnitTests)
+};
+
+#endif
@@ -0,0 +1,156 @@
+//==============================================================================
+/** Lets the CPU know that this is a spin-wait, which saves power and frees up the core's other hyperthread. */
+static inline void pauseWhileSpinning() noexcept
+{
+   #if JUCE_INTEL && JUCE_MSVC
+    _mm_pause();
+   #elif JUCE_INTEL
+    __builtin_ia32_pause();
+   #elif JUCE_ARM && JUCE_MSVC
+    __yield();
+   #elif JUCE_ARM
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+//==============================================================================
+class RealtimeWorkerPool::Worker final : public Thread
+{
+public:
+    Worker (RealtimeWorkerPool& p, int index) :
+        Thread ("RealtimeWorker " + String (index + 1)),
+        pool (p)
+    {
+        startThread (10);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        napEvent.signal();
+        stopThread (3000);
+    }
+
+    void run() override
+    {
+        const ScopedNoDenormals snd;
+        uint32 lastBatch = 0;
+        auto lastBatchMs = Time::getMillisecondCounter();
+
+        while (! threadShouldExit())
+        {
+            const auto batch = static_cast<uint32> (pool.batchState.load (std::memory_order_acquire) >> 32);
+
+            if (batch != lastBatch)
+            {
+                lastBatch = batch;
+                pool.performJobs (batch);
+                lastBatchMs = Time::getMillisecondCounter();
+                continue;
+            }
+
+            if (Time::getMillisecondCounter() - lastBatchMs < spinMs)
+            {
+                Thread::yield();
+                continue;
+            }
+
+            // Nothing has come along in a while, so only check back every so often.
+            // NB: run() never wakes the workers up, since that would mean taking a lock on the realtime thread.
+            napEvent.wait (napMs);
+        }
+    }
+
+private:
+    // NB: Spinning for longer than the gap between the audio callbacks of even large buffers,
+    //     so that the workers don't nap in between them.
+    static constexpr uint32 spinMs = 50;
+    static constexpr int napMs = 5;
+
+    RealtimeWorkerPool& pool;
+    WaitableEvent napEvent;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+};
+
+//==============================================================================
+RealtimeWorkerPool::RealtimeWorkerPool (int numWorkers)
+{
+    if (numWorkers < 0)
+        numWorkers = SystemStats::getNumCpus() - 1;
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.add (new Worker (*this, i));
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    workers.clear();
+}
+
+//==============================================================================
+void RealtimeWorkerPool::run (Job job, void* context, int numJobs) noexcept
+{
+    jassert (job != nullptr);
+
+    if (job == nullptr || numJobs <= 0)
+        return;
+
+    if (numJobs == 1 || workers.isEmpty())
+    {
+        for (int i = 0; i < numJobs; ++i)
+            job (context, i);
+
+        return;
+    }
+
+    jassert (numJobs <= maxNumJobs);
+    numJobs = jmin (numJobs, maxNumJobs);
+
+    currentJob.store (job, std::memory_order_relaxed);
+    currentContext.store (context, std::memory_order_relaxed);
+    numJobsRemaining.store (numJobs, std::memory_order_relaxed);
+
+    // Starting a new batch at job index 0.
+    // NB: The number of jobs must be part of the state that the workers compare-and-swap,
+    //     otherwise a late worker could claim a job from a new batch based on the size of an old one.
+    const auto batch = static_cast<uint32> (batchState.load (std::memory_order_relaxed) >> 32) + 1;
+    batchState.store ((static_cast<uint64> (batch) << 32) | (static_cast<uint64> (numJobs) << 16));
+
+    // NB: This goes on until every job has been claimed, so any that the workers didn't get to in time get performed here.
+    performJobs (batch);
+
+    // Waiting for the other threads to finish whatever jobs they took, which are already underway:
+    constexpr int maxNumPauses = 1000;
+
+    for (int numSpins = 0; numJobsRemaining.load (std::memory_order_acquire) > 0; ++numSpins)
+    {
+        if (numSpins < maxNumPauses)
+            pauseWhileSpinning();
+        else
+            Thread::yield();
+    }
+}
+
+void RealtimeWorkerPool::performJobs (uint32 batch) noexcept
+{
+    for (;;)
+    {
+        auto state = batchState.load (std::memory_order_acquire);
+
+        if (static_cast<uint32> (state >> 32) != batch)
+            break;
+
+        const auto jobIndex = static_cast<int> (state & 0xffff);
+        const auto numJobs = static_cast<int> ((state >> 16) & 0xffff);
+
+        if (jobIndex >= numJobs)
+            break;
+
+        if (batchState.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel))
+        {
+            currentJob.load (std::memory_order_relaxed) (currentContext.load (std::memory_order_relaxed), jobIndex);
+            numJobsRemaining.fetch_sub (1, std::memory_order_release);
+        }
+    }
+}
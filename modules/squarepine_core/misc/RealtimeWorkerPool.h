@@ -0,0 +1,70 @@
+/** A small pool of threads that helps a realtime thread spread a batch of
+    short jobs across several cores, and then waits for all of them to finish.
+
+    This is meant for things like rendering independent parts of an audio graph
+    from within an audio callback:
+    - Starting a batch doesn't allocate, take any locks or wake any threads up:
+      the workers keep checking for new batches by themselves.
+    - The calling thread takes part in the batch instead of idling, and performs
+      whatever jobs the workers don't get to, so it only ever waits on the jobs
+      that are already underway.
+    - Workers keep checking for the next batch for a little while after finishing one,
+      so as to pick it up quickly, and only then start napping in between checks.
+      So after a pause, the calling thread may be left to perform a batch on its own.
+
+    @warning Only one thread may call run() at a time!
+*/
+class RealtimeWorkerPool final
+{
+public:
+    /** Constructor.
+
+        @param numWorkers The number of worker threads to create, which doesn't include
+                          the thread that calls run(). If this is less than 0,
+                          one worker per remaining CPU core will be created.
+    */
+    explicit RealtimeWorkerPool (int numWorkers = -1);
+
+    /** Destructor. */
+    ~RealtimeWorkerPool();
+
+    //==============================================================================
+    /** A job that gets called once per index, from any of the threads in the pool.
+
+        @param context  The context that was handed to run().
+        @param jobIndex The index of the job to perform, from 0 to the number of jobs.
+    */
+    using Job = void (*) (void* context, int jobIndex);
+
+    /** Performs a job for every index from 0 to numJobs, spreading them
+        across the workers and the calling thread.
+
+        This returns once all of the jobs have been performed.
+    */
+    void run (Job job, void* context, int numJobs) noexcept;
+
+    /** The largest number of jobs that can be performed in a single call to run(). */
+    static constexpr int maxNumJobs = 0xffff;
+
+    /** @returns the number of worker threads, which doesn't include the thread calling run(). */
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+private:
+    //==============================================================================
+    class Worker;
+
+    OwnedArray<Worker> workers;
+
+    // The upper 32 bits are the batch number, followed by 16 bits for
+    // the number of jobs in the batch, and 16 bits for the next job index.
+    std::atomic<uint64> batchState { 0 };
+    std::atomic<Job> currentJob { nullptr };
+    std::atomic<void*> currentContext { nullptr };
+    std::atomic<int> numJobsRemaining { 0 };
+
+    //==============================================================================
+    void performJobs (uint32 batch) noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeWorkerPool)
+};
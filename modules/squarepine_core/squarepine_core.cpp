@@ -32,6 +32,7 @@ namespace sp
     #include "misc/CodeBeautifiers.cpp"
     #include "misc/CommandHelpers.cpp"
     #include "misc/FPUFlags.cpp"
+    #include "misc/RealtimeWorkerPool.cpp"
     #include "networking/GoogleAnalyticsReporter.cpp"
     #include "networking/NetworkCache.cpp"
 
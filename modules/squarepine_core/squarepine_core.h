@@ -233,6 +233,7 @@ namespace sp
     #include "misc/CodeBeautifiers.h"
     #include "misc/CommandHelpers.h"
     #include "misc/FPUFlags.h"
+    #include "misc/RealtimeWorkerPool.h"
     #include "misc/Threading.h"
     #include "misc/Utilities.h"
     #include "networking/GoogleAnalyticsReporter.h"